@@ -2,3 +2,130 @@
 
 #define LOG_DIR "logs"
 #define TEXT_FILE_PATH "C:/Users/Saman/dev/AirKeyboardGUI/AirKeyboardGUI/Input/pg2701_cl.txt"
+
+// Write the frame container with unbuffered direct I/O so long sessions don't evict the page cache
+#define FRAME_LOG_DIRECT_IO 0
+
+// Interval at which the key-event log is forced to disk
+#define KEY_LOG_SYNC_INTERVAL_MS 2000
+
+// Capture latency that can't be measured from the host and is always subtracted:
+// USB keyboard polling, and exposure to delivery for the camera. Measure per device.
+#define KEY_LATENCY_FLOOR_US 4000
+#define CAMERA_LATENCY_FLOOR_US 33000
+
+// Window over which the timebase tracks the minimum delay of each source
+#define TIMEBASE_WINDOW_MS 10000
+
+// Presses further ahead of a frame than this are not recorded in its label
+#define LABEL_NEXT_PRESS_HORIZON_MS 2000
+
+// Replace the camera with generated NV12 frames: 0 = camera, 1 = color bars, 2 = moving gradient,
+// 3 = raw NV12 loop from SYNTHETIC_LOOP_FILE
+#define SYNTHETIC_FRAME_SOURCE 0
+#define SYNTHETIC_FRAME_RATE 30
+#define SYNTHETIC_FRAME_WIDTH 1920
+#define SYNTHETIC_FRAME_HEIGHT 1080
+#define SYNTHETIC_LOOP_FILE "loop.nv12"
+
+// Inject generated key events through the keyboard publisher and report per-consumer latency to
+// logs/key_storm_<id>.txt: 0 = off, 1 = steady, 2 = bursts, 3 = rollover, 4 = autorepeat
+#define KEY_STORM_PATTERN 0
+#define KEY_STORM_RATE 1000
+#define KEY_STORM_SECONDS 10
+// Start a logging session with the trigger keys first so KeyEventLogger is measured too
+#define KEY_STORM_START_SESSION 1
+
+// Budget for frames and buffers in flight. Above the soft budget the preview keeps only the newest
+// frame, halfway to the hard budget frames are dropped unless a session logs them, and at the hard
+// budget FrameLogger sheds frames and writes gap markers in their place. A drop in pressure is only logged
+// once memory is MEMORY_REPORT_HYSTERESIS_MB below the level's threshold, so hovering at one isn't logged every frame
+#define MEMORY_SOFT_BUDGET_MB 384
+#define MEMORY_HARD_BUDGET_MB 768
+#define MEMORY_REPORT_HYSTERESIS_MB 32
+
+// Session logger batching: a batch is flushed when it reaches any of its limits, 0 disables a limit.
+// With an adaptive flush time, batches are additionally sized from measured flush throughput so
+// that writing one takes about that long
+#define FRAME_LOG_BATCH_FRAMES 0
+#define FRAME_LOG_BATCH_MB 16
+#define FRAME_LOG_BATCH_AGE_MS 200
+#define FRAME_LOG_ADAPTIVE_FLUSH_MS 20
+#define KEY_LOG_BATCH_EVENTS 256
+#define KEY_LOG_BATCH_AGE_MS 50
+#define KEY_LOG_ADAPTIVE_FLUSH_MS 0
+
+// Frame conversion: with CUDA unavailable or FRAME_CONVERTER_FORCE_CPU set, frames are converted by
+// FRAME_CONVERTER_WORKERS CPU threads (0 = half the hardware threads). Finished frames are published
+// in capture order; a missing frame holds back at most FRAME_REORDER_CAPACITY frames (raised to cover
+// every frame the workers can have in flight) or FRAME_REORDER_TIMEOUT_MS before it is skipped
+#define FRAME_CONVERTER_WORKERS 0
+#define FRAME_CONVERTER_FORCE_CPU 0
+#define FRAME_REORDER_CAPACITY 16
+#define FRAME_REORDER_TIMEOUT_MS 200
+
+// Write frames identical to the previous frame, as some webcams repeat a buffer when the sensor misses
+// a frame, as header-only duplicate records instead of storing their pixels again
+#define FRAME_LOG_DEDUPLICATE 1
+
+// Store a CRC-32C in every frame record so session_verify can find corruption; key-event blocks always carry one
+#define FRAME_LOG_CHECKSUM 1
+
+// Store frames with the in-tree lossless codec, encoded by FRAME_LOG_COMPRESS_WORKERS threads
+// (0 = half the hardware threads) before they reach the writer
+#define FRAME_LOG_COMPRESS 1
+#define FRAME_LOG_COMPRESS_WORKERS 0
+
+// With compression, store a keyframe every FRAME_LOG_GOP_LENGTH frames and code the frames in between
+// against their predecessor; readers seeking to a frame decode from the keyframe before it. 1 stores
+// only keyframes
+#define FRAME_LOG_GOP_LENGTH 30
+
+// Write every FRAME_SNAPSHOT_INTERVAL-th frame of a session (by capture sequence) as a JPEG to the session's
+// snapshots directory, encoded in-tree at FRAME_SNAPSHOT_QUALITY (libjpeg scale) by FRAME_SNAPSHOT_WORKERS
+// threads (0 = half the hardware threads). 0 disables snapshots
+#define FRAME_SNAPSHOT_INTERVAL 30
+#define FRAME_SNAPSHOT_QUALITY 95
+#define FRAME_SNAPSHOT_WORKERS 0
+
+// Hand session frames to the post-processing worker through a shared-memory ring of FRAME_RING_SLOTS slots
+// holding frames of up to FRAME_RING_SLOT_MB each. With every slot in use the writer waits up to
+// FRAME_RING_FULL_WAIT_MS for the worker before dropping a frame (frames.bin keeps it). 0 slots makes the
+// worker tail frames.bin instead
+#define FRAME_RING_SLOTS 8
+#define FRAME_RING_SLOT_MB 8
+#define FRAME_RING_FULL_WAIT_MS 10
+
+// Analyze session frames in-process with PostProcessStage's built-in analyzers (luma statistics, skin mask) on
+// POSTPROCESS_WORKERS threads (0 = half the hardware threads), writing a row per frame to the session's
+// postprocess.csv. Frames beyond POSTPROCESS_MAX_QUEUED waiting for the stage are dropped. 0 disables the stage
+#define POSTPROCESS_ENABLED 1
+#define POSTPROCESS_WORKERS 0
+#define POSTPROCESS_MAX_QUEUED 60
+
+// Draw the hand landmarks the Python worker detects into the session's output.mp4; 0 exports the frames as captured
+#define POSTPROCESS_ANNOTATE_VIDEO 1
+
+// Disk space of LOG_DIR, managed by StorageManager on a background thread that checks free space every
+// STORAGE_POLL_MS. At session start it reserves STORAGE_RESERVE_SECONDS of the expected bitrate (measured from
+// the catalog's recent sessions, STORAGE_DEFAULT_MBPS before there are any) in a placeholder file it gives back as
+// the session needs the space and when it ends. To keep STORAGE_MIN_FREE_MB free besides the reservation, LOG_DIR under
+// STORAGE_QUOTA_GB and sessions younger than STORAGE_MAX_AGE_DAYS, it first thins the oldest sessions when
+// STORAGE_THIN_FIRST is set: legacy sessions of raw frames are compressed into frames.bin, as session_convert does,
+// when STORAGE_CONVERT_LEGACY is set, and the files that can be regenerated from frames.bin (snapshots and the frame
+// index) are removed. Only with STORAGE_EVICT_SESSIONS set does it then delete the oldest sessions, never the
+// STORAGE_KEEP_SESSIONS newest and never just to make room for the reservation. 0 disables a limit.
+// Below STORAGE_DEGRADE_FREE_MB of usable space snapshots and post-processing stop and FrameLogger keeps every other
+// frame; below STORAGE_SHED_FREE_MB it only writes gap markers, key events are logged either way
+#define STORAGE_POLL_MS 1000
+#define STORAGE_RESERVE_SECONDS 600
+#define STORAGE_DEFAULT_MBPS 20
+#define STORAGE_MIN_FREE_MB 4096
+#define STORAGE_QUOTA_GB 0
+#define STORAGE_MAX_AGE_DAYS 0
+#define STORAGE_THIN_FIRST 1
+#define STORAGE_CONVERT_LEGACY 1
+#define STORAGE_EVICT_SESSIONS 0
+#define STORAGE_KEEP_SESSIONS 3
+#define STORAGE_DEGRADE_FREE_MB 1024
+#define STORAGE_SHED_FREE_MB 256
@@ -1,21 +1,25 @@
 import argparse
+import ctypes
+import heapq
+import itertools
 import logging
 import os
 import sys
-from watchdog.observers import Observer
-from watchdog.events import FileSystemEventHandler
 from pathlib import Path
 import queue
 import struct
+import subprocess
 import time
 import threading
-import cv2
 import numpy as np
 import traceback
 import mediapipe as mp
-from mediapipe.framework.formats import landmark_pb2
 import random
-import pandas as pd
+
+try:
+    from crc32c import crc32c
+except ImportError:
+    crc32c = None
 
 logging.basicConfig(
     level=logging.INFO,
@@ -26,11 +30,272 @@ logging.basicConfig(
     ]
 )
 
-COLUMNS = [
-    'session_frame', 'timestamp', 'hand_index', 'hand_label',
-    'hand_score', 'landmark_index', 'x', 'y', 'z',
-    'world_x', 'world_y', 'world_z'
-]
+CONTAINER_NAME = 'frames.bin'
+
+# Versioned frame header (see types.h): magic, version, header size, pixel
+# format, flags, width, height, data size, checksum, sequence, capture,
+# processed and write timestamps in nanoseconds
+FRAME_MAGIC = 0x52464B41
+FRAME_HEADER_FORMAT = '<IHHIIIIIIQqqq'
+FRAME_HEADER_SIZE = struct.calcsize(FRAME_HEADER_FORMAT)
+
+# FrameHeader flags: header-only records of a shed frame, and of a frame
+# identical to the last record with pixel data
+FRAME_FLAG_SHED = 0x1
+FRAME_FLAG_DUPLICATE = 0x2
+
+# The header's checksum field holds the CRC-32C of the header, with the field
+# zeroed, followed by the frame data
+FRAME_FLAG_CHECKSUM = 0x4
+FRAME_CHECKSUM_OFFSET = 28
+
+# Frame data encoded with FrameLogger's lossless codec; the akcodec library
+# built next to this script decodes it
+FRAME_FLAG_COMPRESSED = 0x8
+
+# Compressed data coded against the previous record with pixel data
+FRAME_FLAG_DELTA = 0x10
+CODEC_LIBRARY = 'akcodec.dll' if os.name == 'nt' else 'libakcodec.so'
+
+# Streams the session as Y4M for the video encoder, built next to this script
+VIDEO_EXPORTER = 'y4m_export.exe' if os.name == 'nt' else 'y4m_export'
+
+# Reader of the shared-memory frame ring the application hands frames through,
+# built next to this script; see FrameRingReader.h
+RING_LIBRARY = 'akring.dll' if os.name == 'nt' else 'libakring.so'
+AK_RING_FRAME = 1
+AK_RING_TIMEOUT = 0
+AK_RING_CLOSED = -1
+PIXEL_FORMAT_BGR24 = 1
+
+# Hand landmarks are appended to landmarks.bin in blocks stored column by
+# column, see LandmarkFormat.h: file header (magic, version, points per hand),
+# then per block a header (magic, flags, hands, frames, first and last
+# sequence, checksum) and the sequence, capture time, points, world points,
+# score, hand index and hand label columns, padded to 8 bytes
+LANDMARK_FILE_NAME = 'landmarks.bin'
+LANDMARK_MAGIC = 0x4D4C4B41
+LANDMARK_VERSION = 1
+LANDMARK_FILE_HEADER_FORMAT = '<IHHQ'
+LANDMARK_BLOCK_MAGIC = 0x4B4C4B41
+LANDMARK_BLOCK_HEADER_FORMAT = '<IIIIQQII'
+LANDMARK_BLOCK_CHECKSUM = 0x1
+LANDMARK_POINTS = 21
+LANDMARK_HAND_LEFT = 0
+LANDMARK_HAND_RIGHT = 1
+
+# A block is written once this many frames are ready, or once a second has
+# passed with frames waiting
+LANDMARK_BLOCK_FRAMES = 64
+
+# Header of sessions recorded before the versioned header: millisecond
+# timestamp, width, height, data size
+LEGACY_HEADER_FORMAT = '<QIII'
+LEGACY_HEADER_SIZE = struct.calcsize(LEGACY_HEADER_FORMAT)
+
+# FrameLogger keeps several writes in flight, so the most recent part of the
+# container can still contain holes. Records this close to the end of the file
+# are only read once the logger has signalled the end of the session.
+TAIL_GUARD_BYTES = 64 * 1024 * 1024
+
+
+
+def load_codec():
+    """Loads the frame codec library next to this script, or returns None."""
+    path = Path(__file__).resolve().parent / CODEC_LIBRARY
+    try:
+        library = ctypes.CDLL(str(path))
+    except OSError:
+        return None
+
+    library.akDecodeFrame.argtypes = [
+        ctypes.c_char_p, ctypes.c_size_t, ctypes.c_void_p, ctypes.c_void_p,
+        ctypes.c_size_t]
+    library.akDecodeFrame.restype = ctypes.c_int
+    return library
+
+
+codec = load_codec()
+
+
+class RingFrame(ctypes.Structure):
+    """FrameRingFrame of FrameRingReader.h."""
+    _fields_ = [
+        ('header', ctypes.c_void_p),
+        ('data', ctypes.c_void_p),
+        ('data_size', ctypes.c_uint32),
+        ('pixel_format', ctypes.c_uint32),
+        ('width', ctypes.c_uint32),
+        ('height', ctypes.c_uint32),
+        ('sequence', ctypes.c_uint64),
+        ('capture_ns', ctypes.c_int64),
+    ]
+
+
+def load_ring_library():
+    """Loads the frame ring reader library next to this script, or returns None."""
+    path = Path(__file__).resolve().parent / RING_LIBRARY
+    try:
+        library = ctypes.CDLL(str(path))
+    except OSError:
+        return None
+
+    library.akRingOpen.argtypes = [ctypes.c_char_p]
+    library.akRingOpen.restype = ctypes.c_void_p
+    library.akRingAcquire.argtypes = [
+        ctypes.c_void_p, ctypes.c_uint32, ctypes.POINTER(RingFrame)]
+    library.akRingAcquire.restype = ctypes.c_int
+    library.akRingRelease.argtypes = [ctypes.c_void_p]
+    library.akRingRelease.restype = None
+    library.akRingFramesDropped.argtypes = [ctypes.c_void_p]
+    library.akRingFramesDropped.restype = ctypes.c_uint64
+    library.akRingClose.argtypes = [ctypes.c_void_p]
+    library.akRingClose.restype = None
+    return library
+
+
+def decode_frame(encoded, width, height, reference=None):
+    """Decodes a compressed record into BGR24 pixels, or returns None if it is damaged.
+
+    Delta records need the decoded pixels of the record before them as reference.
+    """
+    pixels = np.empty(width * height * 3, dtype=np.uint8)
+    reference_pointer = None
+    if reference is not None:
+        reference = np.frombuffer(reference, dtype=np.uint8)
+        reference_pointer = reference.ctypes.data
+    if not codec.akDecodeFrame(encoded, len(encoded), reference_pointer,
+                               pixels.ctypes.data, pixels.nbytes):
+        return None
+    return pixels
+
+
+def export_video(session_dir, output_path, annotate=False):
+    """Encodes the session's frames into output_path by piping the video exporter into ffmpeg.
+
+    With annotate, the exporter draws the hands of the session's landmarks.bin over their frames.
+    """
+    exporter = Path(__file__).resolve().parent / VIDEO_EXPORTER
+    if not exporter.exists():
+        logging.error(f"{VIDEO_EXPORTER} not found next to this script, no video exported.")
+        return False
+
+    command = [str(exporter), str(session_dir)]
+    landmark_path = Path(session_dir) / LANDMARK_FILE_NAME
+    if annotate and landmark_path.exists():
+        command += ['--landmarks', str(landmark_path)]
+
+    try:
+        export = subprocess.Popen(command, stdout=subprocess.PIPE)
+    except OSError as e:
+        logging.error(f"Failed to run {VIDEO_EXPORTER}: {e}")
+        return False
+
+    try:
+        encode = subprocess.run(
+            ['ffmpeg', '-y', '-f', 'yuv4mpegpipe', '-i', '-', '-c:v', 'libx264',
+             '-pix_fmt', 'yuv420p', str(output_path)], stdin=export.stdout)
+    except OSError as e:
+        logging.error(f"Failed to run ffmpeg: {e}")
+        export.kill()
+        return False
+    finally:
+        export.stdout.close()
+
+    # The exporter exits with 2 when it had to skip damaged frames, the video is still usable
+    if export.wait() not in (0, 2) or encode.returncode != 0:
+        logging.error(f"Video export to {output_path} failed.")
+        return False
+
+    logging.info(f"Video saved to {output_path}")
+    return True
+
+
+class LandmarkWriter:
+    """Appends the hands detected in each frame to landmarks.bin as frames finish.
+
+    Workers finish frames out of order, so a frame is held until every frame
+    submitted before it has finished too; blocks then hold frames in sequence
+    order, which the reader's lookups rely on.
+    """
+
+    def __init__(self, path):
+        self.path = path
+        self.file = open(path, 'wb')
+        self.file.write(struct.pack(LANDMARK_FILE_HEADER_FORMAT,
+                                    LANDMARK_MAGIC, LANDMARK_VERSION, LANDMARK_POINTS, 0))
+        self.file.flush()
+        self.lock = threading.Lock()
+        self.pending = set()  # Sequences submitted and not yet finished
+        self.finished = []  # Heap of finished frames waiting for earlier ones
+        self.ready = []  # Frames to write next, in sequence order
+        self.order = itertools.count()  # Keeps heap entries of equal sequence comparable
+        self.last_write = time.time()
+        self.frames_written = 0
+        self.hands_written = 0
+
+    def submit(self, sequence):
+        """Registers a frame handed to the workers, before any later one."""
+        with self.lock:
+            self.pending.add(sequence)
+
+    def finish(self, sequence, capture_ns, hands):
+        """Records a frame's hands, (index, label, score, points, world points) with (21, 3) point arrays."""
+        with self.lock:
+            self.pending.discard(sequence)
+            heapq.heappush(self.finished, (sequence, next(self.order), capture_ns, hands))
+
+            # Frames still queued come after every frame a worker holds
+            oldest = min(self.pending) if self.pending else None
+            while self.finished and (oldest is None or self.finished[0][0] < oldest):
+                self.ready.append(heapq.heappop(self.finished))
+
+            if len(self.ready) >= LANDMARK_BLOCK_FRAMES or (self.ready and time.time() - self.last_write >= 1):
+                self.write_block()
+
+    def write_block(self):
+        frames, self.ready = self.ready, []
+        hands = [(sequence, capture_ns, hand)
+                 for sequence, _, capture_ns, frame_hands in frames for hand in frame_hands]
+        count = len(hands)
+
+        columns = [
+            np.array([h[0] for h in hands], dtype='<u8'),
+            np.array([h[1] for h in hands], dtype='<i8'),
+            np.array([h[2][3] for h in hands], dtype='<f4').reshape(count, LANDMARK_POINTS * 3),
+            np.array([h[2][4] for h in hands], dtype='<f4').reshape(count, LANDMARK_POINTS * 3),
+            np.array([h[2][2] for h in hands], dtype='<f4'),
+            np.array([h[2][0] for h in hands], dtype='u1'),
+            np.array([h[2][1] for h in hands], dtype='u1'),
+        ]
+        data = b''.join(column.tobytes() for column in columns)
+        data += bytes(-len(data) % 8)
+
+        flags = LANDMARK_BLOCK_CHECKSUM if crc32c is not None else 0
+        header = struct.pack(LANDMARK_BLOCK_HEADER_FORMAT, LANDMARK_BLOCK_MAGIC, flags, count,
+                             len(frames), frames[0][0], frames[-1][0], 0, 0)
+        if crc32c is not None:
+            checksum = crc32c(data, crc32c(header))
+            header = struct.pack(LANDMARK_BLOCK_HEADER_FORMAT, LANDMARK_BLOCK_MAGIC, flags, count,
+                                 len(frames), frames[0][0], frames[-1][0], checksum, 0)
+
+        # Whole blocks are flushed so a reader opening the file mid-session only misses the one being written
+        self.file.write(header + data)
+        self.file.flush()
+        self.last_write = time.time()
+        self.frames_written += len(frames)
+        self.hands_written += count
+
+    def close(self):
+        """Writes every finished frame; frames that never finished have no entry."""
+        with self.lock:
+            while self.finished:
+                self.ready.append(heapq.heappop(self.finished))
+            if self.ready:
+                self.write_block()
+            self.file.close()
+        logging.info(
+            f"{self.hands_written} hands in {self.frames_written} frames saved to {self.path}")
 
 
 class HandLandmarker:
@@ -84,165 +349,79 @@ class HandLandmarker:
             f"Failed to detect landmarks after {max_retries} retries")
         return None
 
-    def draw_landmarks(self, results, rgb_frame):
-        # Draw landmarks on the frame
-        # Loop through the detected hands to visualize
-
-        annotated_image = rgb_frame.copy()
-
-        for idx in range(len(results.hand_landmarks)):
-            hand_landmarks = results.hand_landmarks[idx]
-
-            # Draw the hand landmarks
-            hand_landmarks_proto = landmark_pb2.NormalizedLandmarkList()
-            hand_landmarks_proto.landmark.extend([
-                landmark_pb2.NormalizedLandmark(
-                    x=landmark.x, y=landmark.y, z=landmark.z)
-                for landmark in hand_landmarks
-            ])
-
-            mp.solutions.drawing_utils.draw_landmarks(
-                annotated_image, hand_landmarks_proto, mp.solutions.hands.HAND_CONNECTIONS,
-                mp.solutions.drawing_styles.get_default_hand_landmarks_style(),
-                mp.solutions.drawing_styles.get_default_hand_connections_style()
-            )
-
-        return annotated_image
-
 
 class FramePostProcessor:
     def __init__(self, watch_dir, num_workers):
         self.watch_dir = Path(watch_dir)
-        self.queue = queue.Queue()
+        self.queue = queue.Queue(maxsize=128)  # Bounds frames held in memory
         self.num_workers = num_workers
         self.running = True
         self.start_timestamp = None
-        self.landmarks = pd.DataFrame(columns=COLUMNS)
+        self.landmarks = LandmarkWriter(self.watch_dir.parent / LANDMARK_FILE_NAME)
+        self.frames_processed = 0
+        self.count_lock = threading.Lock()
 
         self.hand_landmarker = HandLandmarker()
 
-    def parse_landmarks(self, results, session_frame, timestamp):
-        """
-        Parse MediaPipe HandLandmarkerResult into a row for CSV export.
-        """
-        rows = []
+    def submit(self, item):
+        """Queues a frame for the workers; frames must be submitted in sequence order."""
+        self.landmarks.submit(item[0])
+        self.queue.put(item)
 
+    def parse_hands(self, results):
+        """Returns (index, label, score, points, world points) of every hand in a HandLandmarkerResult."""
+        hands = []
         for h_idx in range(len(results.handedness)):
-            for l_idx, landmark in enumerate(results.hand_landmarks[h_idx]):
-                row = {
-                    'session_frame': session_frame,
-                    'timestamp': timestamp,
-                    'hand_index': h_idx,
-                    'hand_label': 'left' if h_idx == 0 else 'right',
-                    'hand_score': results.handedness[h_idx][0].score,
-                    'landmark_index': l_idx,
-                    'x': landmark.x,
-                    'y': landmark.y,
-                    'z': landmark.z,
-                    'world_x': results.hand_world_landmarks[h_idx][l_idx].x,
-                    'world_y': results.hand_world_landmarks[h_idx][l_idx].y,
-                    'world_z': results.hand_world_landmarks[h_idx][l_idx].z,
-                }
-                rows.append(row)
-
-        return pd.DataFrame(rows, columns=COLUMNS)
-
-    def log_landmarks(self, results, frame_path, timestamp):
-        # log landmarks to DataFrame
-        session_frame = frame_path.stem.split('_')[-1]
-
-        landmarks_df = self.parse_landmarks(
-            results, session_frame, timestamp)
-
-        self.landmarks = pd.concat(
-            [self.landmarks, landmarks_df], ignore_index=True)
-
-    def save_landmarks(self, output_path):
-        if not self.landmarks.empty:
-            output_file = Path(output_path).parent / 'landmarks.csv'
-            self.landmarks.to_csv(output_file, index=False)
-            logging.info(f"Landmarks saved to {output_file}")
-        else:
-            logging.info("No landmarks to save.")
-
-    def unpack_frame_file(self, frame_path):
-        # Read frame header and data
-        with open(frame_path, 'rb') as f:
-            # Read header: timestamp (8 bytes) + width (4 bytes) + height (4 bytes) data size (4 bytes)
-            header_data = f.read(20)
-            if len(header_data) < 20:
-                logging.error(f"Invalid file: {frame_path}")
-                return None, None, None, None
-
-            timestamp, width, height, data_size = struct.unpack(
-                '<QIII', header_data)
-
-            frame_data = f.read(data_size)
-
-            # check if framepath ends with 00000 without suffix
-            if frame_path.stem.endswith('_000000') and self.start_timestamp is None:
-                self.start_timestamp = timestamp
-
-            if len(frame_data) != data_size:
-                logging.error(
-                    f"Incomplete frame data: {frame_path}, expected {data_size} bytes, got {len(frame_data)} bytes.")
-                return None, None, None, None
-
-            return frame_data, timestamp, width, height
-
-    def process_frame(self, frame_path):
-        frame_path = Path(frame_path)
-        logging.info(f"Processing frame: {frame_path.name}")
+            category = results.handedness[h_idx][0]
+            label = LANDMARK_HAND_LEFT if category.category_name == 'Left' else LANDMARK_HAND_RIGHT
+            points = [(l.x, l.y, l.z) for l in results.hand_landmarks[h_idx]]
+            world_points = [(l.x, l.y, l.z) for l in results.hand_world_landmarks[h_idx]]
+            hands.append((h_idx, label, category.score, points, world_points))
+        return hands
+
+    def process_frame(self, item):
+        """Returns the hands detected in a frame, empty if there are none or detection failed."""
+        sequence, capture_ns, width, height, frame_data = item
+        frame_name = f"frame_{sequence:06d}"
+        logging.info(f"Processing frame: {frame_name}")
 
         try:
-            rgb_frame, timestamp, width, height = self.unpack_frame_file(
-                frame_path)
             rgb_frame = np.frombuffer(
-                rgb_frame, dtype=np.uint8).reshape((height, width, 3))
-
-            if rgb_frame is None or timestamp is None:
-                logging.error(f"Failed to unpack frame: {frame_path}")
-                return
+                frame_data, dtype=np.uint8).reshape((height, width, 3))
 
             # If first frame hasn't been processed yet, wait for it
             while self.start_timestamp is None:
                 time.sleep(0.033)
 
-            # Detect landmarks
-            relative_timestamp = timestamp - self.start_timestamp
-            frame_number = int(frame_path.stem.split('_')[-1])
+            # Detect landmarks, MediaPipe takes milliseconds
+            relative_timestamp = (capture_ns - self.start_timestamp) // 1_000_000
             results = self.hand_landmarker.detect_landmarks(
-                frame_number, rgb_frame, relative_timestamp)
+                sequence, rgb_frame, relative_timestamp)
             if not results or not results.hand_landmarks:
                 logging.warning(
-                    f"No landmarks detected for frame {frame_path.name}, skipping.")
-
-            if results and results.hand_landmarks:
-                self.log_landmarks(results, frame_path, timestamp)
+                    f"No landmarks detected for frame {frame_name}, skipping.")
 
-                rgb_frame = self.hand_landmarker.draw_landmarks(
-                    results, rgb_frame)
+            with self.count_lock:
+                self.frames_processed += 1
 
-            # Quality 95 preserves hand details well
-            cv2.imwrite(frame_path.with_suffix(".jpg"), rgb_frame, [
-                cv2.IMWRITE_JPEG_QUALITY, 95])
-
-            # Delete original raw file
-            os.remove(frame_path)
+            if results and results.hand_landmarks:
+                return self.parse_hands(results)
+            return []
 
         except Exception as e:
             logging.error(
-                f"Error processing frame {frame_path.name}: {e}")
+                f"Error processing frame {frame_name}: {e}")
             logging.error(traceback.format_exc())
-            return
+            return []
 
     def worker_thread(self):
         while self.running:
             try:
-                frame_path = self.queue.get(timeout=1)
-                if frame_path is None:
+                item = self.queue.get(timeout=1)
+                if item is None:
                     break
-                self.process_frame(frame_path)
+                hands = self.process_frame(item)
+                self.landmarks.finish(item[0], item[1], hands)
                 self.queue.task_done()
             except queue.Empty:
                 continue
@@ -270,33 +449,205 @@ class FramePostProcessor:
 
         logging.info("All worker threads have been stopped.")
 
-    def process_existing_frames(self):
-        raw_files = list(self.watch_dir.glob("*.raw"))
-        for frame_file in raw_files:
-            self.queue.put(str(frame_file))
-        logging.info(f"Queued {len(raw_files)} existing frames")
 
+class RingReader:
+    """Reads frames from the shared-memory ring the application publishes them to."""
 
-class FrameHandler(FileSystemEventHandler):
-    def __init__(self, converter):
+    def __init__(self, library, name, converter):
+        self.library = library
         self.converter = converter
+        self.frames = 0
+        self.ring = library.akRingOpen(name.encode())
+        if not self.ring:
+            raise RuntimeError(f"Failed to attach to frame ring {name}")
+
+    def run(self):
+        """Queue frames until the application closes the ring.
 
-    def on_created(self, event):
-        if not event.is_directory and event.src_path.endswith('.raw'):
-            time.sleep(0.01)
-            self.converter.queue.put(event.src_path)
+        Frames are copied out and released right away; a full queue blocks here, which
+        keeps the slots in use so the application sees the worker falling behind.
+        """
+        frame = RingFrame()
+        while True:
+            result = self.library.akRingAcquire(self.ring, 100, ctypes.byref(frame))
+            if result == AK_RING_CLOSED:
+                break
+            if result == AK_RING_TIMEOUT:
+                continue
+
+            pixel_format, width, height = frame.pixel_format, frame.width, frame.height
+            sequence, capture_ns = frame.sequence, frame.capture_ns
+            frame_data = ctypes.string_at(frame.data, frame.data_size)
+            self.library.akRingRelease(self.ring)
+
+            if pixel_format != PIXEL_FORMAT_BGR24 or len(frame_data) != width * height * 3:
+                continue
+
+            if self.frames == 0:
+                self.converter.start_timestamp = capture_ns
+
+            # Sequence numbers keep landmarks aligned with frames.bin and labels.bin across dropped frames
+            self.converter.submit(
+                (sequence, capture_ns, width, height, frame_data))
+            self.frames += 1
+
+    def close(self):
+        dropped = self.library.akRingFramesDropped(self.ring)
+        if dropped:
+            logging.warning(
+                f"The application dropped {dropped} frames the worker didn't keep up with.")
+        self.library.akRingClose(self.ring)
+        self.ring = None
+
+
+class ContainerTailer:
+    """Reads frame records from the session container as FrameLogger appends them."""
+
+    def __init__(self, container_path, converter):
+        self.container_path = Path(container_path)
+        self.converter = converter
+        self.offset = 0
+        self.frame_number = 0
+        self.duplicate_frames = 0
+        self.corrupt_frames = 0
+        self.undecodable_frames = 0
+        self.previous_pixels = None
+        self.file = None
+
+        if crc32c is None:
+            logging.warning(
+                "crc32c module not installed, frame checksums are not verified.")
+
+    def poll(self, final=False):
+        """Queue every complete record; unless final, stay TAIL_GUARD_BYTES behind the end."""
+        if self.file is None:
+            if not self.container_path.exists():
+                return
+            self.file = open(self.container_path, 'rb')
+
+        file_size = os.path.getsize(self.container_path)
+        limit = file_size if final else file_size - TAIL_GUARD_BYTES
+
+        while self.offset + LEGACY_HEADER_SIZE <= limit:
+            self.file.seek(self.offset)
+            header = self.read_header(limit - self.offset)
+            if header is None:
+                break
+
+            header_size, sequence, capture_ns, width, height, data_size, flags, header_bytes = header
+            record_end = self.offset + header_size + data_size
+            if record_end > limit:
+                break
+
+            # The camera repeated the previous frame, its landmarks are already known
+            if flags & FRAME_FLAG_DUPLICATE:
+                self.duplicate_frames += 1
+                self.frame_number += 1
+                self.offset = record_end
+                continue
+
+            # Header-only records mark frames FrameLogger shed under memory pressure
+            if data_size == 0:
+                self.offset = record_end
+                continue
+
+            frame_data = self.file.read(data_size)
+            if len(frame_data) != data_size:
+                logging.error(
+                    f"Incomplete frame data at offset {self.offset}, expected {data_size} bytes, got {len(frame_data)} bytes.")
+                break
+
+            if not self.checksum_matches(flags, header_bytes, frame_data):
+                logging.error(
+                    f"Frame at offset {self.offset} failed its checksum, skipping.")
+                self.corrupt_frames += 1
+                # The deltas after a damaged frame have no reference
+                self.previous_pixels = None
+                self.offset = record_end
+                continue
+
+            # Deltas need the frame before them, so records are decoded here in container order;
+            # ctypes releases the GIL, so the workers keep running meanwhile
+            if flags & FRAME_FLAG_COMPRESSED:
+                reference = self.previous_pixels if flags & FRAME_FLAG_DELTA else None
+                if reference is not None and len(reference) != width * height * 3:
+                    reference = None
+                pixels = None
+                if codec is not None and (reference is not None or not flags & FRAME_FLAG_DELTA):
+                    pixels = decode_frame(frame_data, width, height, reference)
+                self.previous_pixels = pixels
+                if pixels is None:
+                    self.undecodable_frames += 1
+                    self.offset = record_end
+                    continue
+                frame_data = pixels
+            else:
+                self.previous_pixels = frame_data
+
+            if self.frame_number == 0:
+                self.converter.start_timestamp = capture_ns
+
+            # Sequence numbers keep landmarks aligned with labels.bin; legacy records only have their position
+            self.converter.submit(
+                (self.frame_number if sequence is None else sequence, capture_ns, width, height, frame_data))
+            self.frame_number += 1
+            self.offset = record_end
+
+    def checksum_matches(self, flags, header_bytes, frame_data):
+        """False only if the record carries a checksum and it doesn't match."""
+        if crc32c is None or not flags & FRAME_FLAG_CHECKSUM:
+            return True
+
+        stored, = struct.unpack_from('<I', header_bytes, FRAME_CHECKSUM_OFFSET)
+        covered = (header_bytes[:FRAME_CHECKSUM_OFFSET] + bytes(4) +
+                   header_bytes[FRAME_CHECKSUM_OFFSET + 4:FRAME_HEADER_SIZE])
+        return crc32c(frame_data, crc32c(covered)) == stored
+
+    def read_header(self, available):
+        """Returns (header size, sequence or None, capture time in ns, width, height, data size, flags, header bytes) or None."""
+        peek = self.file.read(min(available, FRAME_HEADER_SIZE))
+        magic, version, header_size = struct.unpack_from('<IHH', peek)
+
+        if magic == FRAME_MAGIC and version >= 2 and header_size >= FRAME_HEADER_SIZE:
+            if header_size > available:
+                return None
+            fields = struct.unpack_from(FRAME_HEADER_FORMAT, peek)
+            flags, width, height, data_size = fields[4], fields[5], fields[6], fields[7]
+            sequence, capture_ns = fields[9], fields[10]
+            self.file.seek(self.offset + header_size)
+            return header_size, sequence, capture_ns, width, height, data_size, flags, peek
+
+        timestamp, width, height, data_size = struct.unpack_from(
+            LEGACY_HEADER_FORMAT, peek)
+        self.file.seek(self.offset + LEGACY_HEADER_SIZE)
+        return LEGACY_HEADER_SIZE, None, timestamp * 1_000_000, width, height, data_size, 0, peek
+
+    def close(self):
+        if self.file is not None:
+            self.file.close()
+            self.file = None
 
 
 def main():
     parser = argparse.ArgumentParser(
-        description='Convert raw NV12 frames to PNG format')
+        description='Detect hand landmarks in the frames of a recording session')
     parser.add_argument('watch_dir', help='Directory to watch for frame files')
     parser.add_argument('--workers', type=int, default=4,
                         help='Number of worker threads')
+    parser.add_argument('--ring',
+                        help='Name of the shared-memory frame ring to read frames from instead of frames.bin')
+    parser.add_argument('--once', action='store_true',
+                        help='Process the frames.bin of a finished session and exit, e.g. to compare rates with postprocess_bench')
+    parser.add_argument('--annotate', action='store_true',
+                        help='Draw the detected hand landmarks into output.mp4')
     args = parser.parse_args()
 
     logging.info(f"Starting frame converter with {args.workers} workers.")
 
+    # The application removes the watch directory at the end of a session
+    if args.once:
+        os.makedirs(args.watch_dir, exist_ok=True)
+
     if not os.path.exists(args.watch_dir):
         logging.error(f"Watch directory {args.watch_dir} does not exist.")
         sys.exit(1)
@@ -309,61 +660,110 @@ def main():
 
     converter = FramePostProcessor(args.watch_dir, num_workers=args.workers)
 
-    # Process any existing frames
-    converter.process_existing_frames()
-
     # Start worker threads
     converter.start_workers()
+    start = time.time()
+
+    if args.ring:
+        read_ring(args.ring, converter)
+    else:
+        tail_container(args.watch_dir, converter, once=args.once)
+
+    # Wait for queue to empty
+    logging.info(
+        f"Waiting for {converter.queue.qsize()} frames to finish processing...")
+    converter.queue.join()  # Block until all tasks are done
+
+    # Then stop workers
+    converter.stop_workers()
+    elapsed = time.time() - start
+    logging.info(
+        f"Processed {converter.frames_processed} frames in {elapsed:.1f} s, "
+        f"{converter.frames_processed / elapsed if elapsed > 0 else 0:.1f} fps on {args.workers} workers")
+    converter.landmarks.close()
+
+    logging.info("Shutdown complete")
+    return args
+
+
+def read_ring(name, converter):
+    """Processes the frames the application publishes to the ring until it closes it."""
+    library = load_ring_library()
+    if library is None:
+        raise RuntimeError(f"{RING_LIBRARY} not found next to this script, can't read frame ring {name}")
+
+    reader = RingReader(library, name, converter)
+    logging.info(f"Reading frames from ring {name}")
+    try:
+        reader.run()
+    except KeyboardInterrupt:
+        logging.info("\nShutting down...")
+    finally:
+        reader.close()
+    logging.info(f"Frame ring closed after {reader.frames} frames.")
+
 
-    # Set up file watcher
-    event_handler = FrameHandler(converter)
-    observer = Observer()
-    observer.schedule(event_handler, args.watch_dir, recursive=False)
-    observer.start()
+def tail_container(watch_dir, converter, once=False):
+    """Processes the frames FrameLogger appends to frames.bin until the shutdown signal file appears.
 
-    shutdown_signal_path = Path(args.watch_dir) / '.shutdown'
+    With once, the session is finished and its frames are read without waiting for the signal.
+    """
+    # Frames are read from the container FrameLogger writes next to the watch directory
+    tailer = ContainerTailer(
+        Path(watch_dir).parent / CONTAINER_NAME, converter)
+
+    shutdown_signal_path = Path(watch_dir) / '.shutdown'
 
     # Remove any existing shutdown signal
     if shutdown_signal_path.exists():
         shutdown_signal_path.unlink()
 
+    last_report = time.time()
     try:
-        while True:
+        while not once:
             # Check for shutdown signal
             if shutdown_signal_path.exists():
                 logging.info("Shutdown signal detected, finishing queue...")
                 break
 
-            time.sleep(1)
-            if converter.queue.qsize() > 0:
+            tailer.poll()
+            time.sleep(0.05)
+
+            if time.time() - last_report >= 1 and converter.queue.qsize() > 0:
                 logging.info(f"Queue size: {converter.queue.qsize()}")
+                last_report = time.time()
 
     except KeyboardInterrupt:
         logging.info("\nShutting down...")
 
-    # Graceful shutdown
-    observer.stop()
-    observer.join()
-
-    # Wait for queue to empty
-    logging.info(
-        f"Waiting for {converter.queue.qsize()} frames to finish processing...")
-    converter.queue.join()  # Block until all tasks are done
-
-    # Then stop workers
-    converter.stop_workers()
-    converter.save_landmarks(args.watch_dir)
+    # The logger has finished writing, read the remainder of the container
+    tailer.poll(final=True)
+    tailer.close()
+    if tailer.corrupt_frames:
+        logging.error(
+            f"Skipped {tailer.corrupt_frames} frames that failed their checksum.")
+    if tailer.undecodable_frames:
+        reason = "are damaged or follow a damaged frame" if codec else f"need {CODEC_LIBRARY} next to this script"
+        logging.error(
+            f"Skipped {tailer.undecodable_frames} compressed frames that {reason}.")
+    if tailer.duplicate_frames:
+        logging.info(
+            f"Skipped {tailer.duplicate_frames} frames identical to their predecessor.")
 
     # Clean up shutdown signal
     if shutdown_signal_path.exists():
         shutdown_signal_path.unlink()
 
-    logging.info("Shutdown complete")
-
 
 if __name__ == "__main__":
     try:
-        main()
+        args = main()
+        if args.once:
+            # The session's video was exported when it ended, only the recreated watch directory goes
+            if not any(Path(args.watch_dir).iterdir()):
+                Path(args.watch_dir).rmdir()
+            sys.exit(0)
+
         # Execute command in watch dir
         watch_dir = Path(sys.argv[1])
         if not watch_dir.exists():
@@ -374,12 +774,9 @@ if __name__ == "__main__":
             logging.error(f"Watch directory {watch_dir} is not a directory.")
             sys.exit(1)
 
-        os.chdir(watch_dir)
-
-        os.system(
-            'ffmpeg -i frame_%06d.jpg -c:v libx264 -pix_fmt yuv420p -r 30 ../output.mp4')
+        # Frames go from the container straight to the encoder, without intermediate images
+        export_video(watch_dir.parent, watch_dir.parent / 'output.mp4', annotate=args.annotate)
 
-        os.chdir(watch_dir.parent)
         # Remove the watch directory after processing even if its full
         if watch_dir.exists():
             for item in watch_dir.iterdir():
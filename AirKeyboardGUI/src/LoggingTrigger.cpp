@@ -1,12 +1,19 @@
 #include "LoggingTrigger.h"
 
+#include "metrics/PipelineMetrics.h"
+
 // Define static member
 LoggingTrigger* LoggingTrigger::instance = nullptr;
 
-LoggingTrigger::LoggingTrigger() : lastKeyTime(std::chrono::steady_clock::now()) {}
+LoggingTrigger::LoggingTrigger() : lastKeyTime(std::chrono::steady_clock::now()) {
+    trackQueue("trigger_queue", false, keyEventBytes);
+}
 
 void LoggingTrigger::update(std::shared_ptr<KeyEvent> ke) {
-    if (!ke || !ke->pressed) return;
+    if (!ke) return;
+    PipelineMetrics::getInstance().record(MetricStage::KEY_TRIGGER_UPDATE, ke->timestamp);
+
+    if (!ke->pressed) return;
 
     auto now = std::chrono::steady_clock::now();
 
@@ -20,14 +20,14 @@ void ThreadManager::startCapturing() {
     framePublisherFuture = framePublisherReady.get_future();  // Set up future before thread starts
 
     framePublisherThread = std::thread([this]() {
-        FramePublisher framePublisher{};
+        frameSource = createFrameSource();
 
         framePublisherReady.set_value();  // Signal that publisher is ready
 
-        const auto interval = std::chrono::milliseconds(33);
+        const auto interval = frameSource->getFrameInterval();
         auto next_time = std::chrono::steady_clock::now();
         while (running) {
-            framePublisher.captureFrame();
+            frameSource->captureFrame();
             next_time += interval;
             std::this_thread::sleep_until(next_time);
         }
@@ -38,15 +38,27 @@ void ThreadManager::startCapturing() {
 
         framePublisherFuture.wait();  // Wait for frame publisher to be ready
 
-        FramePublisher* framePublisher = FramePublisher::getInstance();
-        framePublisher->subscribe(&frameProcessor);
+        frameSource->subscribe(&frameProcessor);
 
         while (running) {
             frameProcessor.dequeue();
             std::this_thread::sleep_for(std::chrono::milliseconds(1));
         }
 
-        framePublisher->unsubscribe(&frameProcessor);
+        frameSource->unsubscribe(&frameProcessor);
+
+        if (frameProcessor.getFramesDroppedUnlogged() > 0) {
+            std::string message = "FrameProcessor: " + std::to_string(frameProcessor.getFramesDroppedUnlogged()) +
+                                  " unlogged frames dropped under memory pressure\n";
+            OutputDebugStringA(message.c_str());
+        }
+
+        if (frameProcessor.getFramesDroppedBusy() > 0 || frameProcessor.getSequencesSkipped() > 0) {
+            std::string message = "FrameProcessor: " + std::to_string(frameProcessor.getFramesDroppedBusy()) +
+                                  " frames dropped with all workers busy, " +
+                                  std::to_string(frameProcessor.getSequencesSkipped()) + " sequences skipped in reorder\n";
+            OutputDebugStringA(message.c_str());
+        }
     });
 
     keyEventPublisherThread = std::thread([this]() {
@@ -65,67 +77,189 @@ void ThreadManager::startCapturing() {
     });
 }
 
+std::unique_ptr<FrameSource> ThreadManager::createFrameSource() {
+    if (SYNTHETIC_FRAME_SOURCE == 0) {
+        return std::make_unique<FramePublisher>();
+    }
+
+    SyntheticSourceOptions options;
+    options.width = SYNTHETIC_FRAME_WIDTH;
+    options.height = SYNTHETIC_FRAME_HEIGHT;
+    options.fps = SYNTHETIC_FRAME_RATE;
+    options.pattern = static_cast<SyntheticPattern>(SYNTHETIC_FRAME_SOURCE - 1);
+    options.loopFile = SYNTHETIC_LOOP_FILE;
+    return std::make_unique<SyntheticFrameSource>(options);
+}
+
 void ThreadManager::startLogging() {
     // Identifier for the current logging session based on current time
-    std::string logSessionId = std::to_string(std::chrono::system_clock::now().time_since_epoch().count());
+    sessionStart = std::chrono::system_clock::now();
+    std::string logSessionId = std::to_string(sessionStart.time_since_epoch().count());
     std::filesystem::path baseUrl = std::filesystem::current_path() / LOG_DIR / logSessionId;
 
+    // Announced first, so the storage policy never takes the new directory for an old session
+    StorageManager::getInstance().beginSession(baseUrl);
+
     // Create the base directory for logging
     std::filesystem::create_directories(baseUrl);
+    sessionDir = baseUrl;
+
+    sessionSummary = {};
+    sessionSummary.sessionId = static_cast<UINT64>(sessionStart.time_since_epoch().count());
+    sessionSummary.startUnixMs =
+        std::chrono::duration_cast<std::chrono::milliseconds>(sessionStart.time_since_epoch()).count();
+
+    // Latency figures saved with the session should only cover the session
+    Timebase::getInstance().resetStatistics();
 
     static char g_debugBuffer[256];
     sprintf(g_debugBuffer, "AirKeyboardGUI: Starting logging session at %s\n", baseUrl.string().c_str());
     OutputDebugStringA(g_debugBuffer);
 
     keyLoggerThread = std::thread([this, baseUrl]() {
-        std::filesystem::path logFilePath = baseUrl / "key_events.csv";
+        std::filesystem::path logFilePath = baseUrl / "key_events.bin";
 
         KeyEventLogger keyEventLogger{logFilePath};
         KeyEventPublisher& keyEventPublisher = KeyEventPublisher::getInstance();
         keyEventPublisher.subscribe(&keyEventLogger);
 
         while (logging) {
-            // Wait for batch size or timeout
-            if (keyEventLogger.waitForBatch(std::chrono::milliseconds(500))) {
-                // We hit batch size - flush immediately
-                keyEventLogger.flush();
-            } else {
-                // Timeout - flush any pending messages
+            // The batch policy decides when to flush, the timeout only bounds how late the session end is noticed
+            if (keyEventLogger.waitForBatch(std::chrono::milliseconds(100))) {
                 keyEventLogger.flush();
             }
         }
 
         keyEventLogger.flush();
         keyEventPublisher.unsubscribe(&keyEventLogger);
+
+        sessionSummary.keyEvents = keyEventLogger.getEventsLogged();
+        sessionSummary.keysDropped = keyEventLogger.getEventsDropped();
     });
 
-    frameLoggerThread = std::thread([this, baseUrl]() {
-        std::filesystem::path logDir = baseUrl / "frames";
-        std::filesystem::create_directories(logDir);
+    frameLabelerThread = std::thread([this, baseUrl]() {
+        FrameLabeler frameLabeler{baseUrl / "labels.bin"};
+
+        KeyEventPublisher& keyEventPublisher = KeyEventPublisher::getInstance();
+        FrameProcessor& frameProcessor = FrameProcessor::getInstance();
+        keyEventPublisher.subscribe(&frameLabeler);
+        frameProcessor.subscribe(&frameLabeler);
 
-        FrameLogger frameLogger{logDir};
+        while (logging) {
+            frameLabeler.process();
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+
+        keyEventPublisher.unsubscribe(&frameLabeler);
+        frameProcessor.unsubscribe(&frameLabeler);
+        frameLabeler.close();
+    });
+
+    if (FRAME_SNAPSHOT_INTERVAL > 0) {
+        frameSnapshotThread = std::thread([this, baseUrl]() {
+            FrameSnapshotWriter snapshotWriter{baseUrl / "snapshots"};
+
+            FrameProcessor& frameProcessor = FrameProcessor::getInstance();
+            frameProcessor.subscribe(&snapshotWriter);
+
+            while (logging) {
+                if (snapshotWriter.waitForBatch(std::chrono::milliseconds(100))) {
+                    snapshotWriter.flush();
+                }
+            }
+
+            frameProcessor.unsubscribe(&snapshotWriter);
+            snapshotWriter.flush();
+        });
+    }
+
+    if (POSTPROCESS_ENABLED) {
+        postProcessThread = std::thread([this, baseUrl]() {
+            PostProcessStage postProcessStage{baseUrl / "postprocess.csv", PostProcessStage::builtinAnalyzers()};
+
+            FrameProcessor& frameProcessor = FrameProcessor::getInstance();
+            frameProcessor.subscribe(&postProcessStage);
+
+            while (logging) {
+                if (postProcessStage.waitForBatch(std::chrono::milliseconds(100))) {
+                    postProcessStage.flush();
+                }
+            }
+
+            frameProcessor.unsubscribe(&postProcessStage);
+            postProcessStage.flush();
+        });
+    }
+
+    std::filesystem::path logDir = baseUrl / "frames";
+    std::filesystem::create_directories(logDir);
+
+    // The worker attaches to the ring by name, so it must exist before the worker starts
+    std::string ringName;
+    if (FRAME_RING_SLOTS > 0) {
+        frameRing = std::make_unique<FrameRingWriter>("Local\\AirKeyboardFrameRing_" +
+                                                      std::to_string(GetCurrentProcessId()) + "_" + logSessionId);
+        if (frameRing->isOpen()) {
+            ringName = frameRing->getName();
+        } else {
+            frameRing.reset();
+        }
+    }
 
-        FramePostProcessor framePostProcessor{logDir.string()};
-        framePostProcessor.SpawnWorker();
+    framePostProcessor = std::make_unique<FramePostProcessor>(logDir.string(), ringName);
+    framePostProcessor->SpawnWorker();
+
+    if (frameRing) {
+        frameRingThread = std::thread([this]() {
+            FrameProcessor& frameProcessor = FrameProcessor::getInstance();
+            frameProcessor.subscribe(frameRing.get());
+
+            while (logging) {
+                if (frameRing->waitForBatch(std::chrono::milliseconds(100))) {
+                    frameRing->flush();
+                }
+            }
+
+            frameProcessor.unsubscribe(frameRing.get());
+            frameRing->flush();
+        });
+    }
+
+    frameLoggerThread = std::thread([this, baseUrl]() {
+        FrameLogger frameLogger{baseUrl / "frames.bin"};
 
         FrameProcessor& frameProcessor = FrameProcessor::getInstance();
 
         frameProcessor.subscribe(&frameLogger);
+        frameProcessor.setLoggingActive(true);
         while (logging) {
-            // Wait for batch size or timeout
-            if (frameLogger.waitForBatch(std::chrono::milliseconds(500))) {
-                // We hit batch size - flush immediately
-                frameLogger.flush();
-            } else {
-                // Timeout - flush any pending messages
+            // The batch policy decides when to flush, the timeout only bounds how late the session end is noticed
+            if (frameLogger.waitForBatch(std::chrono::milliseconds(100))) {
                 frameLogger.flush();
             }
         }
 
         frameLogger.flush();
+        frameProcessor.setLoggingActive(false);
         frameProcessor.unsubscribe(&frameLogger);
 
-        framePostProcessor.terminateWorker();
+        // The worker reads the container, so every write must land before it is told to finish
+        frameLogger.drain();
+
+        // Per-session frame counts, duplicates are frames the camera repeated and were stored as references
+        std::ofstream frameReport(baseUrl / "frame_log.txt");
+        frameReport << "frames " << frameLogger.getFrameCount() << "\n"
+                    << "duplicates " << frameLogger.getFramesDuplicate() << "\n"
+                    << "shed " << frameLogger.getFramesShed() << "\n"
+                    << "lost " << frameLogger.getFramesLost() << "\n"
+                    << "compression_ratio " << frameLogger.getCompressionRatio() << "\n"
+                    << "encode_mbps " << frameLogger.getEncodeMBps() << "\n";
+
+        sessionSummary.frames = frameLogger.getFrameCount();
+        sessionSummary.framesDuplicate = frameLogger.getFramesDuplicate();
+        sessionSummary.framesShed = frameLogger.getFramesShed();
+        sessionSummary.framesMissing = frameLogger.getFramesMissing();
+        sessionSummary.framesLost = frameLogger.getFramesLost();
     });
 }
 
@@ -137,6 +271,98 @@ void ThreadManager::stopLogging() {
     if (frameLoggerThread.joinable()) {
         frameLoggerThread.join();
     }
+
+    if (frameLabelerThread.joinable()) {
+        frameLabelerThread.join();
+    }
+
+    if (frameSnapshotThread.joinable()) {
+        frameSnapshotThread.join();
+    }
+
+    if (postProcessThread.joinable()) {
+        postProcessThread.join();
+    }
+
+    if (frameRingThread.joinable()) {
+        frameRingThread.join();
+    }
+
+    // frames.bin is complete once the logger thread has finished, closing the ring tells the worker to wrap up
+    if (frameRing) {
+        frameRing->close();
+
+        // How far the worker fell behind, dropped frames have no landmarks
+        FrameRingStats stats = frameRing->getStats();
+        std::ofstream ringReport(sessionDir / "frame_ring.txt");
+        ringReport << "published " << stats.framesPublished << "\n"
+                   << "dropped " << stats.framesDropped << "\n"
+                   << "peak_occupancy " << stats.peakOccupancy << "\n"
+                   << "wait_ms " << stats.waitMs << "\n";
+
+        sessionSummary.framesRingDropped = stats.framesDropped;
+    }
+
+    if (framePostProcessor) {
+        framePostProcessor->terminateWorker();
+        framePostProcessor.reset();
+    }
+    frameRing.reset();
+
+    // Store the clock alignment the session's timestamps were corrected with
+    Timebase::getInstance().save(sessionDir / "timebase.txt");
+
+    // Memory held per component at the end of the session, with peaks
+    std::ofstream memoryReport(sessionDir / "memory.txt");
+    memoryReport << MemoryAccountant::getInstance().formatReport();
+    memoryReport.close();
+
+    // Disk space left at the end of the session and what the storage policy removed to keep it
+    std::ofstream storageReport(sessionDir / "storage.txt");
+    storageReport << StorageManager::getInstance().formatReport();
+    storageReport.close();
+
+    // Last, so the sizes include everything the session wrote
+    sessionSummary.durationMs =
+        std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now() - sessionStart).count();
+    SessionCatalog::measureFiles(sessionDir, sessionSummary);
+    SessionCatalog::append(sessionDir.parent_path() / SESSION_CATALOG_NAME, sessionSummary);
+    StorageManager::getInstance().endSession();
+}
+
+void ThreadManager::runKeyStorm() {
+    PipelineMetrics& metrics = PipelineMetrics::getInstance();
+    metrics.reset();
+
+    auto start = std::chrono::steady_clock::now();
+    keyStorm->run();
+    double stormSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    UINT64 injected = keyStorm->getEventsInjected();
+
+    // The UI and trigger threads take one event per loop, give them a bounded time to catch up
+    auto drainDeadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (running && std::chrono::steady_clock::now() < drainDeadline &&
+           (metrics.getLatency(MetricStage::KEY_TEXT_UPDATE).getCount() < injected ||
+            metrics.getLatency(MetricStage::KEY_TRIGGER_UPDATE).getCount() < injected)) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    }
+
+    char summary[256];
+    sprintf(summary, "key storm: %s, %llu events in %.2f s (%.0f/s); unhandled events are still queued\n",
+            KeyStormGenerator::patternName(static_cast<KeyStormPattern>(KEY_STORM_PATTERN - 1)), injected,
+            stormSeconds, injected / stormSeconds);
+    std::string report = summary + metrics.formatReport();
+    OutputDebugStringA(report.c_str());
+
+    std::string reportId = std::to_string(std::chrono::system_clock::now().time_since_epoch().count());
+    std::filesystem::path reportPath = std::filesystem::current_path() / LOG_DIR / ("key_storm_" + reportId + ".txt");
+    std::filesystem::create_directories(reportPath.parent_path());
+    std::ofstream out(reportPath);
+    out << report;
+    if (!out) {
+        std::string message = "AirKeyboardGUI: failed to write " + reportPath.string() + "\n";
+        OutputDebugStringA(message.c_str());
+    }
 }
 
 ThreadManager::ThreadManager() {
@@ -145,6 +371,7 @@ ThreadManager::ThreadManager() {
 
 void ThreadManager::start() {
     running = true;
+    StorageManager::getInstance().start(std::filesystem::current_path() / LOG_DIR);
     keyEventPublisherFuture = keyEventPublisherReady.get_future();
 
     startCapturing();
@@ -200,6 +427,12 @@ void ThreadManager::start() {
         }
 
         frameProcessor.unsubscribe(&liveKeyboardView);
+
+        if (liveKeyboardView.getFramesSkipped() > 0) {
+            std::string message = "LiveKeyboardView: " + std::to_string(liveKeyboardView.getFramesSkipped()) +
+                                  " frames skipped under memory pressure\n";
+            OutputDebugStringA(message.c_str());
+        }
     });
 
     loggingTriggerThread = std::thread([this]() {
@@ -220,11 +453,35 @@ void ThreadManager::start() {
         }
         keyEventPublisher.unsubscribe(&logTrigger);
     });
+
+    if (KEY_STORM_PATTERN != 0) {
+        KeyStormOptions options;
+        options.pattern = static_cast<KeyStormPattern>(KEY_STORM_PATTERN - 1);
+        options.eventsPerSecond = KEY_STORM_RATE;
+        options.seconds = KEY_STORM_SECONDS;
+        options.startSession = KEY_STORM_START_SESSION;
+        keyStorm = std::make_unique<KeyStormGenerator>(options);
+
+        keyStormThread = std::thread([this]() {
+            keyEventPublisherFuture.wait();
+
+            // Let the UI and trigger threads subscribe before the first event
+            std::this_thread::sleep_for(std::chrono::seconds(1));
+            runKeyStorm();
+        });
+    }
 }
 
 void ThreadManager::stop() {
     running = false;
 
+    if (keyStorm) {
+        keyStorm->stop();
+    }
+    if (keyStormThread.joinable()) {
+        keyStormThread.join();
+    }
+
     if (framePublisherThread.joinable()) {
         framePublisherThread.join();
     }
@@ -243,4 +500,9 @@ void ThreadManager::stop() {
     if (loggingTriggerThread.joinable()) {
         loggingTriggerThread.join();
     }
+
+    // Released only after the processor thread has unsubscribed from it
+    frameSource.reset();
+
+    StorageManager::getInstance().stop();
 }
\ No newline at end of file
@@ -5,6 +5,7 @@
 #include <atomic>
 #include <chrono>
 #include <filesystem>
+#include <fstream>
 #include <future>
 #include <thread>
 
@@ -14,9 +15,20 @@
 #include "capture/FrameProcessor.h"
 #include "capture/FramePublisher.h"
 #include "capture/KeyEventPublisher.h"
+#include "capture/KeyStormGenerator.h"
+#include "capture/SyntheticFrameSource.h"
+#include "capture/Timebase.h"
+#include "logging/FrameLabeler.h"
 #include "logging/FrameLogger.h"
 #include "logging/FramePostProcessor.h"
+#include "logging/FrameSnapshotWriter.h"
 #include "logging/KeyEventLogger.h"
+#include "logging/SessionCatalog.h"
+#include "logging/StorageManager.h"
+#include "metrics/MemoryAccountant.h"
+#include "metrics/PipelineMetrics.h"
+#include "postprocess/PostProcessStage.h"
+#include "transport/FrameRingWriter.h"
 #include "ui/LiveKeyboardView.h"
 #include "ui/TextContainer.h"
 
@@ -50,15 +62,39 @@ private:
     /// Thread for frame logging (started/stopped with sessions)
     std::thread frameLoggerThread;
 
+    /// Thread publishing frames to the post-processing worker's ring (started/stopped with sessions)
+    std::thread frameRingThread;
+
+    /// Thread for JPEG frame snapshots (started/stopped with sessions, unless FRAME_SNAPSHOT_INTERVAL is 0)
+    std::thread frameSnapshotThread;
+
+    /// Thread running the in-process post-processing stage (started/stopped with sessions, unless POSTPROCESS_ENABLED is 0)
+    std::thread postProcessThread;
+
+    /// Thread joining key events and frames into per-frame labels (started/stopped with sessions)
+    std::thread frameLabelerThread;
+
     /// Thread for monitoring logging trigger sequences
     std::thread loggingTriggerThread;
 
+    /// Thread injecting a key event storm when KEY_STORM_PATTERN is set
+    std::thread keyStormThread;
+
     /// Flag indicating if core application threads should continue running
     std::atomic<bool> running = false;
 
     /// Flag indicating if logging session is currently active
     std::atomic<bool> logging = false;
 
+    /// Directory of the current or last logging session
+    std::filesystem::path sessionDir;
+
+    /// Wall-clock start of the current or last logging session
+    std::chrono::system_clock::time_point sessionStart;
+
+    /// Catalog entry of the current session, filled in by the logging threads as they finish
+    SessionCatalogEntry sessionSummary = {};
+
     /// Promise to signal when key event publisher is ready for subscriptions
     std::promise<void> keyEventPublisherReady;
 
@@ -71,6 +107,25 @@ private:
     /// Future to wait for frame publisher initialization
     std::future<void> framePublisherFuture;
 
+    /// Camera or synthetic frame source, created on the frame publisher thread
+    std::unique_ptr<FrameSource> frameSource;
+
+    /// Key event storm generator, only created when KEY_STORM_PATTERN is set
+    std::unique_ptr<KeyStormGenerator> keyStorm;
+
+    /// Shared-memory ring feeding the post-processing worker, only created when FRAME_RING_SLOTS is set
+    std::unique_ptr<FrameRingWriter> frameRing;
+
+    /// Post-processing worker of the current session
+    std::unique_ptr<FramePostProcessor> framePostProcessor;
+
+    /**
+     * @brief Creates the frame source selected by SYNTHETIC_FRAME_SOURCE.
+     * @return The camera's FramePublisher, or a SyntheticFrameSource
+     * @throws std::runtime_error if the source cannot be initialized
+     */
+    static std::unique_ptr<FrameSource> createFrameSource();
+
     /**
      * @brief Sets up event bus subscriptions for logging control.
      *
@@ -99,10 +154,20 @@ private:
      * @brief Stops current logging session and cleans up resources.
      *
      * Joins logging threads and ensures all data is properly flushed
-     * before terminating the session.
+     * before terminating the session, then closes the frame ring, waits
+     * for the post-processing worker, adds the session to the catalog and
+     * hands it to the storage policy.
      */
     void stopLogging();
 
+    /**
+     * @brief Runs the configured key storm and writes the latency report.
+     *
+     * Waits for the key consumers to work through what was sent, then writes
+     * per-stage latency and drop counts to the log directory.
+     */
+    void runKeyStorm();
+
 public:
     /**
      * @brief Constructs ThreadManager and sets up event subscriptions.
@@ -112,7 +177,8 @@ public:
     /**
      * @brief Starts all core application threads.
      *
-     * Initializes capture threads, UI threads, and logging trigger monitoring.
+     * Initializes capture threads, UI threads, logging trigger monitoring and
+     * the StorageManager monitor of LOG_DIR.
      * Sets up proper thread synchronization and message loop handling.
      */
     void start();
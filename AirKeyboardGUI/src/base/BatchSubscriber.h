@@ -1,5 +1,8 @@
 #pragma once
 
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
 #include <memory>
 #include <mutex>
 #include <queue>
@@ -8,32 +11,145 @@
 
 static constexpr size_t MAX_QUEUE_SIZE = 1000;  // ~33 seconds of frames
 
-template <typename MessageType, size_t batchSize>
+/**
+ * @brief When a BatchSubscriber considers its queued messages a batch.
+ *
+ * A batch is ready as soon as any enabled limit is reached; a limit of zero is
+ * disabled. Byte limits need the message size passed to the subscriber.
+ */
+struct BatchPolicy {
+    size_t maxItems = 100;                        ///< Queued messages that make a batch
+    size_t maxBytes = 0;                          ///< Queued bytes that make a batch
+    std::chrono::milliseconds maxAge{500};        ///< Age of the oldest queued message that makes a batch
+    std::chrono::milliseconds adaptiveFlushTime{0};  ///< Size batches so writing one takes about this long
+};
+
+template <typename MessageType>
 class BatchSubscriber : public Subscriber<MessageType> {
 protected:
     std::queue<std::shared_ptr<MessageType>> flushQueue;
     std::condition_variable cv;
 
+    /// Batch limits
+    BatchPolicy policy;
+
+    /// Bytes of the queued messages, zero without a message size
+    size_t queuedBytes = 0;
+
+    /// Enqueue time of the oldest queued message
+    std::chrono::steady_clock::time_point oldestQueued;
+
+    /// Adaptive batch size in bytes, or messages without a message size; zero until measured
+    double adaptiveLimit = 0;
+
+    /// Smoothed write throughput in the same unit as adaptiveLimit per second
+    double flushRate = 0;
+
+    /// Bytes, or messages without a message size, of the batch processBatch() is writing
+    size_t flushedUnits = 0;
+
     virtual void processBatch() = 0;
 
+    /**
+     * @brief Removes the oldest message of the batch being flushed and reports it as no longer queued.
+     *
+     * processBatch() takes its messages through this, so the queue account is
+     * settled without another pass over the batch.
+     */
+    std::shared_ptr<MessageType> takeFlushed() {
+        std::shared_ptr<MessageType> message = std::move(flushQueue.front());
+        flushQueue.pop();
+        this->accountQueued(message, false);
+        return message;
+    }
+
+    /**
+     * @brief Whether the queued messages make a batch. Requires queueLock.
+     */
+    bool batchReady() const {
+        if (this->msgQueue.empty()) return false;
+
+        size_t items = this->msgQueue.size();
+        if (policy.maxItems > 0 && items >= policy.maxItems) return true;
+        if (policy.maxBytes > 0 && this->messageBytes && queuedBytes >= policy.maxBytes) return true;
+
+        double units = static_cast<double>(this->messageBytes ? queuedBytes : items);
+        if (adaptiveLimit > 0 && units >= adaptiveLimit) return true;
+
+        return policy.maxAge.count() > 0 && std::chrono::steady_clock::now() - oldestQueued >= policy.maxAge;
+    }
+
+    /**
+     * @brief Sizes the next batches so writing one takes about policy.adaptiveFlushTime.
+     * @param units Bytes, or messages without a message size, in the written batch, usually flushedUnits
+     * @param elapsed Time the batch's write and flush calls took, without the work of preparing it
+     *
+     * Called by processBatch() of subclasses with adaptive batches. Small batches
+     * measure a lower throughput because of fixed per-write costs, so the size
+     * settles where writing a batch takes the target time.
+     */
+    void updateAdaptiveLimit(size_t units, std::chrono::steady_clock::duration elapsed) {
+        double seconds = std::chrono::duration<double>(elapsed).count();
+        if (policy.adaptiveFlushTime.count() <= 0 || units == 0 || seconds <= 0) return;
+
+        double rate = units / seconds;
+        flushRate = flushRate > 0 ? 0.8 * flushRate + 0.2 * rate : rate;
+
+        double limit = std::max(1.0, flushRate * std::chrono::duration<double>(policy.adaptiveFlushTime).count());
+        std::lock_guard<std::mutex> lock(this->queueLock);
+        adaptiveLimit = limit;
+    }
+
 public:
+    /**
+     * @brief Creates a subscriber with the given batch limits.
+     * @param policy Batch limits
+     * @param bytes Size of one message, needed for byte limits and adaptive sizing by bytes
+     */
+    BatchSubscriber(const BatchPolicy& policy = {}, size_t (*bytes)(const MessageType&) = nullptr) : policy(policy) {
+        if (bytes) {
+            this->messageBytes = bytes;
+        }
+    }
+
+    /**
+     * @brief Waits until the queued messages make a batch.
+     * @param timeout Longest time to wait, bounds how late the caller notices shutdown
+     * @return true if a batch is ready
+     */
     bool waitForBatch(std::chrono::milliseconds timeout) {
+        auto deadline = std::chrono::steady_clock::now() + timeout;
         std::unique_lock<std::mutex> lock(this->queueLock);
-        return cv.wait_for(lock, timeout, [this] {
-            return this->msgQueue.size() >= batchSize;
-        });
+
+        while (!batchReady()) {
+            // Wake when the oldest message reaches its age limit, enqueue can't notify about that
+            auto wake = deadline;
+            if (policy.maxAge.count() > 0 && !this->msgQueue.empty()) {
+                wake = std::min(wake, oldestQueued + std::chrono::duration_cast<std::chrono::steady_clock::duration>(policy.maxAge));
+            }
+
+            if (cv.wait_until(lock, wake) == std::cv_status::timeout && std::chrono::steady_clock::now() >= deadline) {
+                return batchReady();
+            }
+        }
+        return true;
     }
 
     void flush() {
+        size_t units = 0;
         {
             std::lock_guard<std::mutex> lock(this->queueLock);
+            units = this->messageBytes ? queuedBytes : this->msgQueue.size();
             this->msgQueue.swap(flushQueue);
+            queuedBytes = 0;
         }
 
         if (!flushQueue.empty()) {
+            flushedUnits = units;
             processBatch();
+
             // Clear the flush queue after processing
-            while (!flushQueue.empty()) flushQueue.pop();
+            while (!flushQueue.empty()) takeFlushed();
         }
     }
 
@@ -42,10 +158,22 @@ public:
         {
             std::lock_guard<std::mutex> lock(this->queueLock);
             if (this->msgQueue.size() >= MAX_QUEUE_SIZE) {
+                if (this->messageBytes && this->msgQueue.front()) {
+                    queuedBytes -= this->messageBytes(*this->msgQueue.front());
+                }
+                this->accountQueued(this->msgQueue.front(), false);
                 this->msgQueue.pop();  // If queue is too large, remove oldest message
             }
+
+            if (this->msgQueue.empty()) {
+                oldestQueued = std::chrono::steady_clock::now();
+            }
+            if (this->messageBytes && message) {
+                queuedBytes += this->messageBytes(*message);
+            }
             this->msgQueue.push(message);
-            shouldNotify = (this->msgQueue.size() >= batchSize);
+            this->accountQueued(message, true);
+            shouldNotify = batchReady();
         }
 
         if (shouldNotify) {
@@ -53,7 +181,15 @@ public:
         }
     }
 
+    /**
+     * @brief Current adaptive batch size, zero while not adaptive or not yet measured.
+     */
+    double getAdaptiveLimit() {
+        std::lock_guard<std::mutex> lock(this->queueLock);
+        return adaptiveLimit;
+    }
+
     ~BatchSubscriber() {
         flush();  // Ensure any remaining messages are processed before destruction
     }
-};
\ No newline at end of file
+};
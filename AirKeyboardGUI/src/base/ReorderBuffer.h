@@ -0,0 +1,219 @@
+#pragma once
+
+//clang-format off
+#include <windows.h>
+//clang-format on
+
+#include <algorithm>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <mutex>
+
+/**
+ * @brief Restores sequence order of items completed out of order by parallel workers.
+ *
+ * Producers announce each sequence number in order with expect(), then insert()
+ * the finished item, or skip() it when none will come, from any thread. Numbers
+ * expect() passes over, dropped before they reached the producer, are skipped
+ * at once rather than waited for.
+ * release() hands every item that is next in sequence to a callback, in order
+ * and one caller at a time, so the callback may publish directly.
+ *
+ * A missing item holds back everything after it until it arrives, until
+ * capacity items are waiting, or until the item after the gap has waited
+ * skipTimeout. The missing sequence numbers are then given up and an
+ * item that turns up afterwards is discarded as late.
+ */
+template <typename T>
+class ReorderBuffer {
+private:
+    /// A finished or skipped sequence number waiting for its predecessors
+    struct Entry {
+        std::shared_ptr<T> item;  ///< nullptr for skipped sequence numbers
+        std::chrono::steady_clock::time_point arrival;
+    };
+
+    /// Items waiting to be released, by sequence number
+    std::map<UINT64, Entry> pending;
+
+    /// Ranges of sequence numbers expect() passed over, by first number, to the number after the last
+    std::map<UINT64, UINT64> gaps;
+
+    /// Guards all state; held during release() so callbacks run in order
+    std::mutex bufferLock;
+
+    /// Waiting items beyond which a missing item is given up
+    const size_t capacity;
+
+    /// Longest time an item waits for a missing predecessor
+    const std::chrono::milliseconds skipTimeout;
+
+    /// Sequence number released next
+    UINT64 nextSequence = 0;
+
+    /// Whether expect() has set nextSequence
+    bool started = false;
+
+    /// Sequence number expect() is called with next unless some were dropped
+    UINT64 nextExpected = 0;
+
+    /// Whether expect() was called since the buffer was created or restarted
+    bool announced = false;
+
+    /// Sequence numbers given up on because they didn't arrive in time
+    UINT64 sequencesSkipped = 0;
+
+    /// Items discarded because they arrived after being given up on
+    UINT64 itemsLate = 0;
+
+    /// Items released
+    UINT64 itemsReleased = 0;
+
+public:
+    /**
+     * @brief Creates an empty buffer.
+     * @param capacity Items held behind a missing one before it is given up
+     * @param skipTimeout Time an item waits for a missing predecessor before it is given up
+     */
+    ReorderBuffer(size_t capacity, std::chrono::milliseconds skipTimeout)
+        : capacity(capacity > 0 ? capacity : 1), skipTimeout(skipTimeout) {}
+
+    /**
+     * @brief Announces the next sequence number handed to the workers.
+     *
+     * Must be called in sequence order; the first call sets where release() starts.
+     * Numbers between the previous call and this one are never waited for.
+     */
+    void expect(UINT64 sequence) {
+        std::lock_guard<std::mutex> lock(bufferLock);
+        if (!started) {
+            nextSequence = sequence;
+            started = true;
+        }
+
+        if (announced && sequence > nextExpected && nextExpected >= nextSequence) gaps[nextExpected] = sequence;
+        nextExpected = sequence + 1;
+        announced = true;
+    }
+
+    /**
+     * @brief Adds a finished item.
+     * @return false if the item is late and was discarded
+     */
+    bool insert(UINT64 sequence, std::shared_ptr<T> item) {
+        std::lock_guard<std::mutex> lock(bufferLock);
+        if (started && sequence < nextSequence) {
+            itemsLate++;
+            return false;
+        }
+
+        pending[sequence] = {std::move(item), std::chrono::steady_clock::now()};
+        return true;
+    }
+
+    /**
+     * @brief Marks a sequence number that will never be inserted, so nothing waits for it.
+     */
+    void skip(UINT64 sequence) {
+        std::lock_guard<std::mutex> lock(bufferLock);
+        if (started && sequence < nextSequence) return;
+
+        pending[sequence] = {nullptr, std::chrono::steady_clock::now()};
+    }
+
+    /**
+     * @brief Passes every releasable item to emit in sequence order.
+     * @param emit Called with each item, under the buffer's lock
+     * @return Number of items emitted
+     */
+    template <typename Emit>
+    size_t release(Emit&& emit) {
+        std::lock_guard<std::mutex> lock(bufferLock);
+        size_t emitted = 0;
+        auto now = std::chrono::steady_clock::now();
+
+        while (true) {
+            // Numbers that were never announced hold nothing back
+            while (!gaps.empty() && gaps.begin()->first <= nextSequence) {
+                nextSequence = std::max(nextSequence, gaps.begin()->second);
+                gaps.erase(gaps.begin());
+            }
+
+            if (pending.empty()) break;
+            auto head = pending.begin();
+
+            if (!started) {
+                nextSequence = head->first;
+                started = true;
+            }
+
+            if (head->first != nextSequence) {
+                // Give up on the missing items only when the buffer is full or has waited long enough
+                bool full = pending.size() >= capacity;
+                bool expired = now - head->second.arrival >= skipTimeout;
+                if (!full && !expired) break;
+
+                sequencesSkipped += head->first - nextSequence;
+                nextSequence = head->first;
+            }
+
+            std::shared_ptr<T> item = std::move(head->second.item);
+            pending.erase(head);
+            nextSequence++;
+
+            if (item) {
+                emit(std::move(item));
+                itemsReleased++;
+                emitted++;
+            }
+        }
+
+        return emitted;
+    }
+
+    /**
+     * @brief Drops the waiting items so the next expect() starts a new sequence.
+     *
+     * For producers that restart numbering; the counters keep accumulating.
+     */
+    void restart() {
+        std::lock_guard<std::mutex> lock(bufferLock);
+        pending.clear();
+        gaps.clear();
+        started = false;
+        announced = false;
+    }
+
+    /**
+     * @brief Number of items waiting for a missing predecessor.
+     */
+    size_t size() {
+        std::lock_guard<std::mutex> lock(bufferLock);
+        return pending.size();
+    }
+
+    /**
+     * @brief Number of sequence numbers given up on.
+     */
+    UINT64 getSequencesSkipped() {
+        std::lock_guard<std::mutex> lock(bufferLock);
+        return sequencesSkipped;
+    }
+
+    /**
+     * @brief Number of items discarded because they arrived after being given up on.
+     */
+    UINT64 getItemsLate() {
+        std::lock_guard<std::mutex> lock(bufferLock);
+        return itemsLate;
+    }
+
+    /**
+     * @brief Number of items released.
+     */
+    UINT64 getItemsReleased() {
+        std::lock_guard<std::mutex> lock(bufferLock);
+        return itemsReleased;
+    }
+};
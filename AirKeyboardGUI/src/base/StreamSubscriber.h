@@ -15,6 +15,7 @@ public:
             if (!this->msgQueue.empty()) {
                 message = this->msgQueue.front();
                 this->msgQueue.pop();
+                this->accountQueued(message, false);
             }
         }  // Lock released here
 
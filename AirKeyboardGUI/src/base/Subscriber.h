@@ -2,6 +2,9 @@
 #include <memory>
 #include <mutex>
 #include <queue>
+#include <string>
+
+#include "../metrics/MemoryAccountant.h"
 
 template <typename MessageType>
 class Subscriber {
@@ -9,9 +12,41 @@ protected:
     std::queue<std::shared_ptr<MessageType>> msgQueue;
     std::mutex queueLock;
 
+    /// Account queued messages are reported to, nullptr if the queue isn't tracked
+    MemoryAccount* queueAccount = nullptr;
+
+    /// Bytes a queued message is reported as
+    size_t (*messageBytes)(const MessageType&) = nullptr;
+
+    /**
+     * @brief Reports the queue's contents to a MemoryAccountant account from now on.
+     * @param name Account name
+     * @param budgeted Whether queued messages own memory nothing else accounts for
+     * @param bytes Size of one message
+     */
+    void trackQueue(const std::string& name, bool budgeted, size_t (*bytes)(const MessageType&)) {
+        queueAccount = MemoryAccountant::getInstance().getAccount(name, budgeted);
+        messageBytes = bytes;
+    }
+
+    /**
+     * @brief Reports a message entering (true) or leaving (false) the queue.
+     */
+    void accountQueued(const std::shared_ptr<MessageType>& message, bool queued) {
+        if (!queueAccount || !message) return;
+
+        INT64 bytes = static_cast<INT64>(messageBytes(*message));
+        if (queued) {
+            queueAccount->add(bytes);
+        } else {
+            queueAccount->remove(bytes);
+        }
+    }
+
 public:
     virtual void enqueue(std::shared_ptr<MessageType> message) {
         std::lock_guard<std::mutex> lock(queueLock);
         msgQueue.push(message);
+        accountQueued(message, true);
     }
 };
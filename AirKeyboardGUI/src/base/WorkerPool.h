@@ -0,0 +1,146 @@
+#pragma once
+
+//clang-format off
+#include <windows.h>
+//clang-format on
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Fixed set of threads that run the iterations of a loop in parallel.
+ *
+ * parallelFor() hands out indices one at a time to the pool threads and to the
+ * calling thread, and returns once every iteration has finished. Each call gets
+ * the index of the thread running it, below getThreadCount(), so callers can keep
+ * per-thread working state. One loop runs at a time; parallelFor() is meant to be
+ * called from a single thread.
+ */
+class WorkerPool {
+private:
+    /// Pool threads; the thread calling parallelFor() works alongside them
+    std::vector<std::thread> threads;
+
+    /// Guards the loop state below
+    std::mutex poolLock;
+
+    /// Wakes pool threads when a loop starts or the pool stops
+    std::condition_variable workCv;
+
+    /// Wakes the caller when the last iteration finishes
+    std::condition_variable doneCv;
+
+    /// Body of the running loop
+    std::function<void(size_t, unsigned int)> body;
+
+    /// Iterations of the running loop
+    size_t count = 0;
+
+    /// Next iteration to hand out
+    size_t next = 0;
+
+    /// Iterations finished
+    size_t finished = 0;
+
+    /// Incremented for every loop so sleeping threads can tell a new one started
+    UINT64 generation = 0;
+
+    /// Set when the pool is destroyed
+    bool stopping = false;
+
+    /**
+     * @brief Runs iterations of the current loop until none are left.
+     * @param lock Held on entry and exit, released while an iteration runs
+     */
+    void runIterations(std::unique_lock<std::mutex>& lock, unsigned int thread) {
+        while (next < count) {
+            size_t index = next++;
+            lock.unlock();
+            body(index, thread);
+            lock.lock();
+            if (++finished == count) doneCv.notify_one();
+        }
+    }
+
+    void threadLoop(unsigned int thread) {
+        std::unique_lock<std::mutex> lock(poolLock);
+        UINT64 seen = generation;
+        while (true) {
+            workCv.wait(lock, [&] { return stopping || generation != seen; });
+            if (stopping) return;
+
+            seen = generation;
+            runIterations(lock, thread);
+        }
+    }
+
+public:
+    /**
+     * @brief Starts the pool.
+     * @param threadCount Threads running iterations, including the caller of parallelFor(); at least 1
+     */
+    explicit WorkerPool(unsigned int threadCount) {
+        threadCount = std::max(1u, threadCount);
+        for (unsigned int i = 1; i < threadCount; i++) {
+            threads.emplace_back(&WorkerPool::threadLoop, this, i);
+        }
+    }
+
+    /**
+     * @brief Calls fn(index, thread) for every index below iterations and waits for all of them.
+     *
+     * The calling thread runs iterations as thread 0.
+     */
+    void parallelFor(size_t iterations, std::function<void(size_t, unsigned int)> fn) {
+        if (iterations == 0) return;
+
+        std::unique_lock<std::mutex> lock(poolLock);
+        body = std::move(fn);
+        count = iterations;
+        next = 0;
+        finished = 0;
+        generation++;
+        if (iterations > 1) workCv.notify_all();
+
+        runIterations(lock, 0);
+        doneCv.wait(lock, [&] { return finished == count; });
+
+        body = nullptr;
+        count = 0;
+    }
+
+    /**
+     * @brief Thread count for a configured worker setting.
+     * @param configured Workers from config.h, 0 for half the hardware threads
+     */
+    static unsigned int configuredThreads(unsigned int configured) {
+        if (configured > 0) return configured;
+        return std::max(1u, std::thread::hardware_concurrency() / 2);
+    }
+
+    /**
+     * @brief Threads running iterations, including the caller.
+     */
+    unsigned int getThreadCount() const {
+        return static_cast<unsigned int>(threads.size()) + 1;
+    }
+
+    ~WorkerPool() {
+        {
+            std::lock_guard<std::mutex> lock(poolLock);
+            stopping = true;
+        }
+        workCv.notify_all();
+        for (auto& thread : threads) {
+            thread.join();
+        }
+    }
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+};
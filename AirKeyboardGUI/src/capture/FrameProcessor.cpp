@@ -1,5 +1,33 @@
 #include "FrameProcessor.h"
 
+#include <algorithm>
+
+#include "../../config.h"
+#include "../base/WorkerPool.h"
+#include "../formats/FrameFormat.h"
+#include "FrameSource.h"
+#include "Nv12Converter.h"
+
+namespace {
+
+/**
+ * @brief Size of the NV12 frame a sample carries, from its AKSampleExtension_FrameSize.
+ * @return Bytes of the frame, 0 if the sample has no size
+ */
+size_t nv12Bytes(IMFSample* sample, UINT32& width, UINT32& height) {
+    width = 0;
+    height = 0;
+    if (FAILED(MFGetAttributeSize(sample, AKSampleExtension_FrameSize, &width, &height))) return 0;
+    return static_cast<size_t>(width) * height * 3 / 2;
+}
+
+size_t nv12Bytes(IMFSample* sample) {
+    UINT32 width, height;
+    return nv12Bytes(sample, width, height);
+}
+
+}  // namespace
+
 bool FrameProcessor::initializeCuda() {
     cudaError_t err = cudaSetDevice(0);
     if (err != cudaSuccess) {
@@ -14,17 +42,9 @@ bool FrameProcessor::initializeCuda() {
         return false;
     }
 
-    // Allocate device memory
-    size_t nv12Size = srcWidth * srcHeight * 3 / 2;
+    // Allocate device memory; the NV12 buffer is sized by the first frame
     size_t rgbCropSize = CROP_WIDTH * CROP_HEIGHT * 3;
 
-    err = cudaMalloc(&d_nv12, nv12Size);
-    if (err != cudaSuccess) {
-        OutputDebugStringA("Failed to allocate device memory for NV12\n");
-        cleanupCuda();
-        return false;
-    }
-
     err = cudaMalloc(&d_rgb, rgbCropSize);
     if (err != cudaSuccess) {
         OutputDebugStringA("Failed to allocate device memory for RGB\n");
@@ -40,10 +60,6 @@ bool FrameProcessor::initializeCuda() {
         return false;
     }
 
-    // Calculate crop position (bottom center)
-    cropX = (srcWidth - CROP_WIDTH) / 2;
-    cropY = srcHeight - CROP_HEIGHT;  // bottom
-
     cudaInitialized = true;
     return true;
 }
@@ -58,6 +74,7 @@ void FrameProcessor::cleanupCuda() {
     if (d_nv12) {
         cudaFree(d_nv12);
         d_nv12 = nullptr;
+        d_nv12Size = 0;
     }
 
     if (d_rgb) {
@@ -73,68 +90,206 @@ void FrameProcessor::cleanupCuda() {
     cudaInitialized = false;
 }
 
-void FrameProcessor::update(std::shared_ptr<IMFSample> sample) {
-    if (!sample || !cudaInitialized) return;
+unsigned int FrameProcessor::configuredWorkers() {
+    return WorkerPool::configuredThreads(FRAME_CONVERTER_WORKERS);
+}
 
+void FrameProcessor::startWorkers(unsigned int count) {
+    // Two samples per worker keep every worker busy without hiding a backlog
+    workQueueLimit = count * 2;
+    for (unsigned int i = 0; i < count; i++) {
+        workers.emplace_back(&FrameProcessor::workerLoop, this);
+    }
+}
+
+void FrameProcessor::workerLoop() {
+    while (true) {
+        std::pair<UINT64, std::shared_ptr<IMFSample>> work;
+        {
+            std::unique_lock<std::mutex> lock(workLock);
+            // Wake periodically so gaps that timed out are released even when no frames arrive
+            workCv.wait_for(lock, std::chrono::milliseconds(FRAME_REORDER_TIMEOUT_MS),
+                            [this]() { return stopping || !workQueue.empty(); });
+            if (stopping) return;
+
+            if (!workQueue.empty()) {
+                work = std::move(workQueue.front());
+                workQueue.pop_front();
+                workAccount->remove(static_cast<INT64>(nv12Bytes(work.second.get())));
+            }
+        }
+
+        if (work.second) {
+            std::shared_ptr<ProcessedFrame> frame = convertSample(work.second.get());
+            if (frame) {
+                reorderBuffer.insert(work.first, frame);
+            } else {
+                reorderBuffer.skip(work.first);
+            }
+        }
+
+        publishReady();
+    }
+}
+
+bool FrameProcessor::convertOnGpu(const BYTE* nv12, BYTE* rgb, int width, int height) {
+    size_t nv12Size = static_cast<size_t>(width) * height * 3 / 2;
+    if (nv12Size > d_nv12Size) {
+        if (d_nv12) cudaFree(d_nv12);
+        d_nv12Size = 0;
+        if (cudaMalloc(&d_nv12, nv12Size) != cudaSuccess) {
+            OutputDebugStringA("Failed to allocate device memory for NV12\n");
+            d_nv12 = nullptr;
+            return false;
+        }
+        d_nv12Size = nv12Size;
+    }
+
+    // Copy NV12 data to device
+    cudaError_t err = cudaMemcpyAsync(d_nv12, nv12, nv12Size, cudaMemcpyHostToDevice, stream);
+    if (err != cudaSuccess) {
+        OutputDebugStringA("Failed to copy NV12 data to device\n");
+        return false;
+    }
+
+    // Launch kernel for crop and RGB conversion, the crop is at the bottom center
+    launchNv12ToRgbCrop(d_nv12, d_rgb, width, height, (width - CROP_WIDTH) / 2, height - CROP_HEIGHT, stream);
+
+    // Copy result back to host
+    size_t rgbSize = CROP_WIDTH * CROP_HEIGHT * 3;
+    err = cudaMemcpyAsync(h_rgbCrop, d_rgb, rgbSize, cudaMemcpyDeviceToHost, stream);
+
+    // Wait for all operations to complete
+    cudaStreamSynchronize(stream);
+
+    if (err != cudaSuccess) {
+        OutputDebugStringA("Failed to copy RGB data from device\n");
+        return false;
+    }
+
+    memcpy(rgb, h_rgbCrop, rgbSize);
+    return true;
+}
+
+std::shared_ptr<ProcessedFrame> FrameProcessor::convertSample(IMFSample* sample) {
     // Get NV12 data from sample
     IMFMediaBuffer* buffer = nullptr;
     HRESULT hr = sample->ConvertToContiguousBuffer(&buffer);
-    if (FAILED(hr)) return;
+    if (FAILED(hr)) return nullptr;
 
     BYTE* nv12Data = nullptr;
     DWORD dataLength = 0;
     hr = buffer->Lock(&nv12Data, nullptr, &dataLength);
     if (FAILED(hr)) {
         buffer->Release();
-        return;
+        return nullptr;
+    }
+
+    // A sample without a size, smaller than the crop or shorter than its size says can't be cropped
+    UINT32 width, height;
+    size_t frameBytes = nv12Bytes(sample, width, height);
+    if (frameBytes == 0 || width < CROP_WIDTH || height < CROP_HEIGHT || dataLength < frameBytes) {
+        char message[128];
+        sprintf_s(message, "FrameProcessor: %ux%u sample of %lu bytes can't be cropped, dropped\n", width, height,
+                  static_cast<unsigned long>(dataLength));
+        OutputDebugStringA(message);
+        buffer->Unlock();
+        buffer->Release();
+        return nullptr;
     }
 
     UINT64 captureTime = 0;
-    sample->GetUINT64(MFSampleExtension_Timestamp, &captureTime);
+    sample->GetUINT64(AKSampleExtension_CaptureTime, &captureTime);
 
-    // Copy NV12 data to device
-    size_t nv12Size = srcWidth * srcHeight * 3 / 2;
-    cudaError_t err = cudaMemcpyAsync(d_nv12, nv12Data, nv12Size,
-                                      cudaMemcpyHostToDevice, stream);
+    UINT64 sequence = 0;
+    sample->GetUINT64(AKSampleExtension_Sequence, &sequence);
+
+    // Create ProcessedFrame, accounted until its last subscriber lets go of it
+    size_t rgbSize = CROP_WIDTH * CROP_HEIGHT * 3;
+    frameAccount->add(static_cast<INT64>(rgbSize));
+    MemoryAccount* account = frameAccount;
+    std::shared_ptr<ProcessedFrame> processedFrame(new ProcessedFrame(), [account, rgbSize](ProcessedFrame* frame) {
+        account->remove(static_cast<INT64>(rgbSize));
+        delete frame;
+    });
+    processedFrame->data = std::make_unique<BYTE[]>(rgbSize);
+
+    bool converted = true;
+    if (cudaInitialized) {
+        converted = convertOnGpu(nv12Data, processedFrame->data.get(), width, height);
+    } else {
+        convertNv12ToBgrCrop(nv12Data, processedFrame->data.get(), width, height, (width - CROP_WIDTH) / 2,
+                             height - CROP_HEIGHT, CROP_WIDTH, CROP_HEIGHT);
+    }
 
     buffer->Unlock();
     buffer->Release();
 
-    if (err != cudaSuccess) {
-        OutputDebugStringA("Failed to copy NV12 data to device\n");
-        return;
-    }
+    if (!converted) return nullptr;
 
-    // Launch kernel for crop and RGB conversion
-    launchNv12ToRgbCrop(d_nv12, d_rgb, srcWidth, srcHeight, cropX, cropY, stream);
+    LARGE_INTEGER processedTime;
+    QueryPerformanceCounter(&processedTime);
 
-    // Copy result back to host
-    size_t rgbSize = CROP_WIDTH * CROP_HEIGHT * 3;
-    err = cudaMemcpyAsync(h_rgbCrop, d_rgb, rgbSize, cudaMemcpyDeviceToHost, stream);
+    // Fill header
+    initFrameHeader(processedFrame->header, PIXEL_FORMAT_BGR24, CROP_WIDTH, CROP_HEIGHT, static_cast<UINT32>(rgbSize));
+    processedFrame->header.sequence = sequence;
+    processedFrame->header.captureNs = static_cast<INT64>(captureTime);
+    processedFrame->header.processedNs = qpcToNanoseconds(processedTime.QuadPart, frequency.QuadPart);
 
-    // Wait for all operations to complete
-    cudaStreamSynchronize(stream);
+    return processedFrame;
+}
 
-    if (err != cudaSuccess) {
-        OutputDebugStringA("Failed to copy RGB data from device\n");
+void FrameProcessor::publishReady() {
+    reorderBuffer.release([this](std::shared_ptr<ProcessedFrame> frame) {
+        publish(frame);
+    });
+}
+
+void FrameProcessor::update(std::shared_ptr<IMFSample> sample) {
+    if (!sample || (!cudaInitialized && workers.empty())) return;
+
+    UINT64 sequence = 0;
+    sample->GetUINT64(AKSampleExtension_Sequence, &sequence);
+    reorderBuffer.expect(sequence);
+
+    // Without a session the frame would only reach the preview, which is the first thing to give up
+    if (!loggingActive && MemoryAccountant::getInstance().getPressure() >= MemoryPressure::DROP_UNLOGGED) {
+        framesDroppedUnlogged++;
+        reorderBuffer.skip(sequence);
+        publishReady();
         return;
     }
 
-    // Create ProcessedFrame
-    auto processedFrame = std::make_shared<ProcessedFrame>();
+    if (cudaInitialized) {
+        std::shared_ptr<ProcessedFrame> frame = convertSample(sample.get());
+        if (frame) {
+            reorderBuffer.insert(sequence, frame);
+        } else {
+            reorderBuffer.skip(sequence);
+        }
+        publishReady();
+        return;
+    }
 
-    // Fill header
-    processedFrame->header.timestamp = (captureTime * 1000) / frequency.QuadPart;
-    processedFrame->header.width = CROP_WIDTH;
-    processedFrame->header.height = CROP_HEIGHT;
-    processedFrame->header.dataSize = static_cast<UINT32>(rgbSize);
+    bool queued = false;
+    {
+        std::lock_guard<std::mutex> lock(workLock);
+        if (workQueue.size() < workQueueLimit) {
+            workQueue.emplace_back(sequence, sample);
+            workAccount->add(static_cast<INT64>(nv12Bytes(sample.get())));
+            queued = true;
+        }
+    }
 
-    // Copy RGB data
-    processedFrame->data = std::make_unique<BYTE[]>(rgbSize);
-    memcpy(processedFrame->data.get(), h_rgbCrop, rgbSize);
+    if (queued) {
+        workCv.notify_one();
+    } else {
+        // Every worker is behind; dropping here keeps latency bounded instead of growing a backlog
+        framesDroppedBusy++;
+        reorderBuffer.skip(sequence);
+    }
 
-    // Publish the processed frame
-    publish(processedFrame);
+    publishReady();
 }
 
 FrameProcessor& FrameProcessor::getInstance() {
@@ -142,14 +297,71 @@ FrameProcessor& FrameProcessor::getInstance() {
     return instance;
 }
 
-FrameProcessor::FrameProcessor() {
+void FrameProcessor::setLoggingActive(bool active) {
+    loggingActive = active;
+}
+
+void FrameProcessor::restartSequence() {
+    reorderBuffer.restart();
+}
+
+UINT64 FrameProcessor::getFramesDroppedUnlogged() const {
+    return framesDroppedUnlogged;
+}
+
+UINT64 FrameProcessor::getFramesDroppedBusy() const {
+    return framesDroppedBusy;
+}
+
+UINT64 FrameProcessor::getSequencesSkipped() {
+    return reorderBuffer.getSequencesSkipped();
+}
+
+size_t FrameProcessor::getWorkerCount() const {
+    return workers.size();
+}
+
+FrameProcessor::FrameProcessor()
+    // Every sample queued or being converted may finish ahead of a slow one, which mustn't be given up for that
+    : reorderBuffer(std::max<size_t>(FRAME_REORDER_CAPACITY, configuredWorkers() * 3 + 1),
+                    std::chrono::milliseconds(FRAME_REORDER_TIMEOUT_MS)) {
     QueryPerformanceFrequency(&frequency);
 
-    if (!initializeCuda()) {
-        throw std::runtime_error("Failed to initialize CUDA for frame processing");
+    frameAccount = MemoryAccountant::getInstance().getAccount("processed_frames", true);
+    workAccount = MemoryAccountant::getInstance().getAccount("frame_converter_queue", true);
+
+    // Queued samples pin camera buffers no other account covers
+    trackQueue("frame_processor_queue", true, [](const IMFSample& sample) -> size_t {
+        // COM getters aren't const, reading the size attribute doesn't change the sample
+        return nv12Bytes(const_cast<IMFSample*>(&sample));
+    });
+
+    if (FRAME_CONVERTER_FORCE_CPU || !initializeCuda()) {
+        startWorkers(configuredWorkers());
+
+        char message[128];
+        sprintf_s(message, "FrameProcessor: converting on %zu CPU workers\n", workers.size());
+        OutputDebugStringA(message);
     }
 }
 
 FrameProcessor::~FrameProcessor() {
+    {
+        std::lock_guard<std::mutex> lock(workLock);
+        stopping = true;
+    }
+    workCv.notify_all();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+
+    // Samples still queued were never converted
+    size_t queuedBytes = 0;
+    for (auto& work : workQueue) {
+        queuedBytes += nv12Bytes(work.second.get());
+    }
+    workAccount->remove(static_cast<INT64>(queuedBytes), static_cast<INT64>(workQueue.size()));
+    workQueue.clear();
+
     cleanupCuda();
 }
\ No newline at end of file
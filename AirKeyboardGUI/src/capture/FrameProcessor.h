@@ -4,10 +4,18 @@
 #include <mfapi.h>
 #include <windows.h>
 
+#include <atomic>
+#include <condition_variable>
+#include <deque>
 #include <memory>
+#include <thread>
+#include <utility>
+#include <vector>
 
 #include "../base/Publisher.h"
+#include "../base/ReorderBuffer.h"
 #include "../base/StreamSubscriber.h"
+#include "../metrics/MemoryAccountant.h"
 #include "../types.h"
 
 // Forward declare CUDA function
@@ -23,6 +31,13 @@ extern "C" void launchNv12ToRgbCrop(
  *
  * Subscribes to IMFSample frames from FramePublisher, processes them using CUDA,
  * and publishes ProcessedFrame objects containing RGB data with metadata.
+ *
+ * The crop is taken from the bottom center of each sample at the size its
+ * AKSampleExtension_FrameSize carries; samples smaller than the crop are dropped.
+ *
+ * Without CUDA, or with FRAME_CONVERTER_FORCE_CPU, frames are converted by a
+ * pool of CPU workers instead. Either way frames pass through a ReorderBuffer
+ * keyed by capture sequence, so subscribers receive them in capture order.
  */
 class FrameProcessor : public StreamSubscriber<IMFSample>, public Publisher<ProcessedFrame> {
 public:
@@ -30,27 +45,58 @@ public:
     static constexpr int CROP_HEIGHT = 600;
 
 private:
-    // Source dimensions
-    const int srcWidth = 1920;
-    const int srcHeight = 1080;
-
     // CUDA resources
     cudaStream_t stream = nullptr;
     uint8_t* d_nv12 = nullptr;
     uint8_t* d_rgb = nullptr;
 
+    /// Bytes allocated at d_nv12, grown to the largest source frame seen
+    size_t d_nv12Size = 0;
+
     // CPU buffers (pinned memory for fast transfers)
     uint8_t* h_rgbCrop = nullptr;
 
-    // Crop position (bottom center)
-    int cropX;
-    int cropY;
-
     // Performance counter frequency for timestamp conversion
     LARGE_INTEGER frequency;
 
     bool cudaInitialized = false;
 
+    /// Restores capture order of frames finished by the workers
+    ReorderBuffer<ProcessedFrame> reorderBuffer;
+
+    /// CPU conversion workers, empty when converting with CUDA
+    std::vector<std::thread> workers;
+
+    /// Samples waiting for a worker, with their capture sequence
+    std::deque<std::pair<UINT64, std::shared_ptr<IMFSample>>> workQueue;
+
+    /// Guards workQueue and stopping
+    std::mutex workLock;
+
+    /// Signals queued work or shutdown to the workers
+    std::condition_variable workCv;
+
+    /// Set in the destructor to end the workers
+    bool stopping = false;
+
+    /// Samples waiting for a worker beyond which new samples are dropped
+    size_t workQueueLimit = 0;
+
+    /// Frames dropped because every worker was busy and the work queue was full
+    std::atomic<UINT64> framesDroppedBusy = 0;
+
+    /// Budgeted account of the samples waiting for a worker
+    MemoryAccount* workAccount = nullptr;
+
+    /// Whether a logging session is subscribed, frames are only dropped under pressure when not
+    std::atomic<bool> loggingActive = false;
+
+    /// Frames not converted because of memory pressure while nothing logged them
+    std::atomic<UINT64> framesDroppedUnlogged = 0;
+
+    /// Budgeted account of the published frames still referenced anywhere
+    MemoryAccount* frameAccount = nullptr;
+
     /**
      * @brief Initialize CUDA resources
      */
@@ -61,6 +107,39 @@ private:
      */
     void cleanupCuda();
 
+    /**
+     * @brief Number of CPU workers FRAME_CONVERTER_WORKERS resolves to.
+     */
+    static unsigned int configuredWorkers();
+
+    /**
+     * @brief Starts the CPU conversion workers.
+     */
+    void startWorkers(unsigned int count);
+
+    /**
+     * @brief Converts queued samples until the processor is destroyed.
+     */
+    void workerLoop();
+
+    /**
+     * @brief Runs the CUDA crop kernel on one frame.
+     * @param nv12 Contiguous NV12 frame of width x height
+     * @param rgb Destination of CROP_WIDTH * CROP_HEIGHT * 3 bytes
+     */
+    bool convertOnGpu(const BYTE* nv12, BYTE* rgb, int width, int height);
+
+    /**
+     * @brief Converts a sample with CUDA or on the calling CPU thread.
+     * @return The processed frame, or nullptr if the sample couldn't be converted
+     */
+    std::shared_ptr<ProcessedFrame> convertSample(IMFSample* sample);
+
+    /**
+     * @brief Publishes every frame the reorder buffer can release.
+     */
+    void publishReady();
+
     /**
      * @brief Process incoming frame from FramePublisher
      */
@@ -79,4 +158,39 @@ public:
      * @brief Singleton instance accessor
      */
     static FrameProcessor& getInstance();
+
+    /**
+     * @brief Tells the processor whether its frames are being logged.
+     *
+     * While nothing logs them, frames are dropped before conversion once memory
+     * pressure reaches MemoryPressure::DROP_UNLOGGED.
+     */
+    void setLoggingActive(bool active);
+
+    /**
+     * @brief Starts ordering from the next sample's sequence, for a new source that numbers from zero again.
+     *
+     * Call while no samples are being processed.
+     */
+    void restartSequence();
+
+    /**
+     * @brief Number of frames dropped under memory pressure while nothing logged them.
+     */
+    UINT64 getFramesDroppedUnlogged() const;
+
+    /**
+     * @brief Number of frames dropped because the CPU workers couldn't keep up.
+     */
+    UINT64 getFramesDroppedBusy() const;
+
+    /**
+     * @brief Number of capture sequences given up on by the reorder buffer.
+     */
+    UINT64 getSequencesSkipped();
+
+    /**
+     * @brief Number of CPU conversion workers, 0 when converting with CUDA.
+     */
+    size_t getWorkerCount() const;
 };
\ No newline at end of file
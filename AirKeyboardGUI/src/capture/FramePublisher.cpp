@@ -129,6 +129,13 @@ HRESULT FramePublisher::configureOutputFormat() {
     }
 
     mediaType->Release();
+
+    // The camera may settle on another size than requested, samples carry the one it delivers
+    IMFMediaType* currentType = nullptr;
+    if (SUCCEEDED(hr) && SUCCEEDED(sourceReader->GetCurrentMediaType(MF_SOURCE_READER_FIRST_VIDEO_STREAM, &currentType))) {
+        MFGetAttributeSize(currentType, MF_MT_FRAME_SIZE, &frameWidth, &frameHeight);
+        currentType->Release();
+    }
     return hr;
 }
 
@@ -192,7 +199,18 @@ void FramePublisher::captureFrame() {
         LARGE_INTEGER perfCounter;
         QueryPerformanceCounter(&perfCounter);
 
+        // ReadSample's time stamp has an unknown offset to QPC; the device timestamp, when the
+        // driver provides one, is QPC at exposure. Either way the Timebase maps it to the session clock.
+        UINT64 deviceTime = 0;
+        rawSample->GetUINT64(MFSampleExtension_DeviceTimestamp, &deviceTime);
+
+        Timebase& timebase = Timebase::getInstance();
+        INT64 captureNs = timebase.cameraCaptureTime(timestamp, deviceTime, timebase.fromQpc(perfCounter.QuadPart));
+
         rawSample->SetUINT64(MFSampleExtension_Timestamp, perfCounter.QuadPart);
+        rawSample->SetUINT64(AKSampleExtension_Sequence, nextSequence++);
+        rawSample->SetUINT64(AKSampleExtension_CaptureTime, static_cast<UINT64>(captureNs));
+        MFSetAttributeSize(rawSample, AKSampleExtension_FrameSize, frameWidth, frameHeight);
 
         auto sample = std::shared_ptr<IMFSample>(rawSample, [](IMFSample* p) {
             if (p) p->Release();
@@ -202,6 +220,10 @@ void FramePublisher::captureFrame() {
     }
 }
 
+std::chrono::nanoseconds FramePublisher::getFrameInterval() const {
+    return std::chrono::milliseconds(33);
+}
+
 FramePublisher* FramePublisher::getInstance() {
     if (!instance) {
         // throwing here because it's important to ensure the class is initialized on the correct thread.
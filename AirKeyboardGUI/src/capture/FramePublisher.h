@@ -12,7 +12,8 @@
 
 #include <stdexcept>
 
-#include "../base/Publisher.h"
+#include "FrameSource.h"
+#include "Timebase.h"
 
 #pragma comment(lib, "mf.lib")
 #pragma comment(lib, "mfplat.lib")
@@ -31,17 +32,20 @@ constexpr int DEFAULT_FRAME_HEIGHT = 1080;
  * and provides frame data to registered subscribers. Uses singleton pattern to ensure
  * only one camera capture instance exists per application.
  */
-class FramePublisher : public Publisher<IMFSample> {
+class FramePublisher : public FrameSource {
 private:
     /// MediaFoundation source reader for camera access
     IMFSourceReader* sourceReader;
 
-    /// Frame width (currently unused, for future expansion)
+    /// Width of the frames the camera delivers, tagged on every sample
     UINT32 frameWidth;
 
-    /// Frame height (currently unused, for future expansion)
+    /// Height of the frames the camera delivers
     UINT32 frameHeight;
 
+    /// Sequence number assigned to the next captured frame
+    UINT64 nextSequence = 0;
+
     /// Singleton instance pointer
     static FramePublisher* instance;
 
@@ -76,7 +80,8 @@ private:
      * @brief Configures video output format to NV12 with specified dimensions.
      * @return HRESULT indicating success or failure
      *
-     * Sets up NV12 format at DEFAULT_FRAME_WIDTH x DEFAULT_FRAME_HEIGHT resolution.
+     * Sets up NV12 format at DEFAULT_FRAME_WIDTH x DEFAULT_FRAME_HEIGHT resolution
+     * and reads back the size the camera settled on into frameWidth and frameHeight.
      */
     HRESULT configureOutputFormat();
 
@@ -93,10 +98,16 @@ public:
      * @brief Captures a single frame from camera and publishes to subscribers.
      *
      * Performs synchronous frame capture, adds performance counter timestamp,
-     * and publishes frame data to all registered subscribers. Handles various
-     * stream states including end-of-stream and stream ticks.
+     * capture sequence number and latency-corrected capture time, and publishes
+     * frame data to all registered subscribers. Handles various stream states
+     * including end-of-stream and stream ticks.
+     */
+    void captureFrame() override;
+
+    /**
+     * @brief The camera delivers 30 frames per second.
      */
-    void captureFrame();
+    std::chrono::nanoseconds getFrameInterval() const override;
 
     /**
      * @brief Gets the singleton instance of FramePublisher.
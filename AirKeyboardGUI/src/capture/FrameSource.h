@@ -0,0 +1,49 @@
+#pragma once
+
+//clang-format off
+#include <windows.h>
+//clang-format on
+
+#include <mfapi.h>
+#include <mfobjects.h>
+
+#include <chrono>
+
+#include "../base/Publisher.h"
+
+/// Sample attribute carrying the capture sequence number assigned by the frame source
+// {7B1E5C8A-3F2D-4C61-9A0E-5D4B2F8C1E73}
+static const GUID AKSampleExtension_Sequence = {0x7b1e5c8a, 0x3f2d, 0x4c61, {0x9a, 0x0e, 0x5d, 0x4b, 0x2f, 0x8c, 0x1e, 0x73}};
+
+/// Sample attribute carrying the latency-corrected capture time in session-clock nanoseconds
+// {C41F7E02-6B8D-4A39-B5E1-2D7093F6A4C8}
+static const GUID AKSampleExtension_CaptureTime = {0xc41f7e02, 0x6b8d, 0x4a39, {0xb5, 0xe1, 0x2d, 0x70, 0x93, 0xf6, 0xa4, 0xc8}};
+
+/// Sample attribute carrying the frame's width and height, packed like MF_MT_FRAME_SIZE; set with MFSetAttributeSize
+// {5E92A3D4-1C7B-4F08-8E6A-3B0D9C41F2A7}
+static const GUID AKSampleExtension_FrameSize = {0x5e92a3d4, 0x1c7b, 0x4f08, {0x8e, 0x6a, 0x3b, 0x0d, 0x9c, 0x41, 0xf2, 0xa7}};
+
+/**
+ * @brief Producer of NV12 IMFSamples for FrameProcessor.
+ *
+ * Every source publishes contiguous NV12 samples tagged with
+ * MFSampleExtension_Timestamp (QPC ticks at arrival), AKSampleExtension_Sequence,
+ * AKSampleExtension_CaptureTime and AKSampleExtension_FrameSize. FrameProcessor
+ * crops each sample by the size it carries, so a source may publish any size of
+ * at least FrameProcessor::CROP_WIDTH x CROP_HEIGHT. The capture thread calls
+ * captureFrame() once per getFrameInterval().
+ */
+class FrameSource : public Publisher<IMFSample> {
+public:
+    /**
+     * @brief Produces at most one frame and publishes it to subscribers.
+     */
+    virtual void captureFrame() = 0;
+
+    /**
+     * @brief Time between captureFrame() calls the source is designed for.
+     */
+    virtual std::chrono::nanoseconds getFrameInterval() const = 0;
+
+    virtual ~FrameSource() = default;
+};
@@ -17,21 +17,41 @@ LRESULT KeyEventPublisher::handleKeyboardHook(int nCode, WPARAM wParam, LPARAM l
 
         KBDLLHOOKSTRUCT* kb = (KBDLLHOOKSTRUCT*)lParam;
 
-        bool pressed = (wParam == WM_KEYDOWN || wParam == WM_SYSKEYDOWN);
+        Timebase& timebase = Timebase::getInstance();
+        INT64 captureNs = timebase.keyCaptureTime(kb->time, timebase.fromQpc(perfCounter.QuadPart));
 
-        std::shared_ptr<KeyEvent> ke = std::make_shared<KeyEvent>(KeyEvent{
-            static_cast<USHORT>(kb->vkCode),
-            static_cast<USHORT>(kb->scanCode),
-            pressed,
-            perfCounter.QuadPart});
+        bool pressed = (wParam == WM_KEYDOWN || wParam == WM_SYSKEYDOWN);
 
-        publish(ke);
+        publishKeyEvent(static_cast<USHORT>(kb->vkCode), static_cast<USHORT>(kb->scanCode), pressed,
+                        perfCounter.QuadPart, captureNs);
     }
 
     // Always call next hook to maintain system functionality
     return CallNextHookEx(hookHandle, nCode, wParam, lParam);
 }
 
+void KeyEventPublisher::publishKeyEvent(USHORT vkey, USHORT scanCode, bool pressed, LONGLONG qpc, INT64 captureNs) {
+    std::shared_ptr<KeyEvent> ke = std::make_shared<KeyEvent>(KeyEvent{
+        vkey,
+        scanCode,
+        pressed,
+        qpc,
+        0,
+        captureNs});
+
+    // Number and publish under one lock, or an injected N+1 can reach subscribers before the hook's N
+    std::lock_guard<std::mutex> lock(sequenceLock);
+    ke->sequence = nextSequence++;
+    publish(ke);
+}
+
+void KeyEventPublisher::injectKeyEvent(USHORT vkey, USHORT scanCode, bool pressed) {
+    LARGE_INTEGER perfCounter;
+    QueryPerformanceCounter(&perfCounter);
+
+    publishKeyEvent(vkey, scanCode, pressed, perfCounter.QuadPart, Timebase::getInstance().fromQpc(perfCounter.QuadPart));
+}
+
 KeyEventPublisher::KeyEventPublisher() : Publisher(), hookHandle(nullptr) {
     // Install low-level keyboard hook
     hookHandle = SetWindowsHookEx(
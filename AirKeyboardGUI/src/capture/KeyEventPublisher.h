@@ -4,12 +4,15 @@
 #include <windows.h>
 //clang-format on
 
+#include <atomic>
 #include <memory>
+#include <mutex>
 #include <stdexcept>
 #include <vector>
 
 #include "../base/Publisher.h"
 #include "../types.h"
+#include "Timebase.h"
 #include "cassert"
 
 /**
@@ -24,6 +27,12 @@ private:
     /// Handle to the installed keyboard hook
     HHOOK hookHandle;
 
+    /// Sequence number assigned to the next published event
+    UINT64 nextSequence = 0;
+
+    /// Held across numbering and publishing, so subscribers receive hook and injected events in sequence order
+    std::mutex sequenceLock;
+
     /// Singleton instance pointer
     static std::unique_ptr<KeyEventPublisher> instance;
 
@@ -46,11 +55,19 @@ private:
      * @param lParam Pointer to KBDLLHOOKSTRUCT with key data
      * @return Result passed to next hook in chain
      *
-     * Extracts keyboard data, adds performance counter timestamp,
-     * creates KeyEvent object, and publishes to subscribers.
+     * Extracts keyboard data, adds performance counter timestamp, sequence
+     * number and latency-corrected capture time, creates KeyEvent object, and
+     * publishes to subscribers.
      */
     LRESULT handleKeyboardHook(int nCode, WPARAM wParam, LPARAM lParam);
 
+    /**
+     * @brief Assigns the next sequence number and publishes a key event.
+     * @param qpc Performance counter value at arrival
+     * @param captureNs Capture time on the session clock
+     */
+    void publishKeyEvent(USHORT vkey, USHORT scanCode, bool pressed, LONGLONG qpc, INT64 captureNs);
+
     /**
      * @brief Private constructor for singleton pattern.
      * @throws std::runtime_error if keyboard hook installation fails
@@ -75,6 +92,17 @@ public:
      */
     static KeyEventPublisher& getInstance();
 
+    /**
+     * @brief Publishes a generated key event as if the hook had received it.
+     * @param vkey Virtual key code
+     * @param scanCode Hardware scan code
+     * @param pressed true for key down, false for key up
+     *
+     * The event is numbered in the same sequence as hook events and captured
+     * now, without latency correction. Safe to call from any thread.
+     */
+    void injectKeyEvent(USHORT vkey, USHORT scanCode, bool pressed);
+
     /// Deleted copy constructor to enforce singleton pattern
     KeyEventPublisher(const KeyEventPublisher&) = delete;
 
@@ -0,0 +1,155 @@
+#include "KeyStormGenerator.h"
+
+#include <cmath>
+#include <stdexcept>
+#include <thread>
+
+namespace {
+
+/// Keys LoggingTrigger reacts to by default: three presses of space
+constexpr USHORT TRIGGER_KEY = VK_SPACE;
+constexpr int TRIGGER_PRESSES = 3;
+
+}  // namespace
+
+USHORT KeyStormGenerator::takeLetter() {
+    USHORT vkey = static_cast<USHORT>('A' + nextLetter);
+    nextLetter = (nextLetter + 1) % 26;
+    return vkey;
+}
+
+KeyStormGenerator::Step KeyStormGenerator::nextStep() {
+    Step step = {interval, 0, true};
+
+    switch (options.pattern) {
+        case KeyStormPattern::STEADY:
+            break;
+
+        case KeyStormPattern::BURST:
+            // Back to back within a burst, the gap before the first event of the next one
+            step.delay = stepIndex > 0 && stepIndex % options.burstLength == 0
+                             ? std::chrono::duration_cast<std::chrono::nanoseconds>(options.burstGap)
+                             : std::chrono::nanoseconds(0);
+            break;
+
+        case KeyStormPattern::ROLLOVER:
+            if (heldKeys.size() < options.rolloverKeys) {
+                step.vkey = takeLetter();
+                heldKeys.push_back(step.vkey);
+            } else {
+                step.vkey = heldKeys.front();
+                step.pressed = false;
+                heldKeys.pop_front();
+            }
+            stepIndex++;
+            return step;
+
+        case KeyStormPattern::AUTOREPEAT:
+            if (heldKeys.empty()) {
+                step.vkey = takeLetter();
+                heldKeys.push_back(step.vkey);
+                repeatsSent = 0;
+            } else if (repeatsSent < options.repeatsPerKey) {
+                // Repeats are key-downs without a key-up, the way Windows delivers them
+                if (repeatsSent == 0) {
+                    step.delay = std::chrono::duration_cast<std::chrono::nanoseconds>(options.repeatDelay);
+                }
+                step.vkey = heldKeys.front();
+                repeatsSent++;
+            } else {
+                step.vkey = heldKeys.front();
+                step.pressed = false;
+                heldKeys.pop_front();
+            }
+            stepIndex++;
+            return step;
+    }
+
+    // STEADY and BURST alternate press and release of one key at a time
+    if (heldKeys.empty()) {
+        step.vkey = takeLetter();
+        heldKeys.push_back(step.vkey);
+    } else {
+        step.vkey = heldKeys.front();
+        step.pressed = false;
+        heldKeys.pop_front();
+    }
+    stepIndex++;
+    return step;
+}
+
+void KeyStormGenerator::inject(USHORT vkey, bool pressed) {
+    USHORT scanCode = static_cast<USHORT>(MapVirtualKeyW(vkey, MAPVK_VK_TO_VSC));
+    KeyEventPublisher::getInstance().injectKeyEvent(vkey, scanCode, pressed);
+    eventsInjected++;
+}
+
+void KeyStormGenerator::pressTrigger() {
+    for (int i = 0; i < TRIGGER_PRESSES; i++) {
+        inject(TRIGGER_KEY, true);
+        inject(TRIGGER_KEY, false);
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    }
+
+    // LoggingTrigger handles one event per loop; give it and the session threads time to start
+    std::this_thread::sleep_for(std::chrono::seconds(1));
+}
+
+void KeyStormGenerator::run() {
+    running = true;
+
+    if (options.startSession) {
+        pressTrigger();
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    const auto end = start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                                 std::chrono::duration<double>(options.seconds));
+    auto nextTime = start;
+
+    while (running && std::chrono::steady_clock::now() < end) {
+        Step step = nextStep();
+        nextTime += step.delay;
+        std::this_thread::sleep_until(nextTime);  // Returns at once when behind schedule
+        inject(step.vkey, step.pressed);
+    }
+
+    while (!heldKeys.empty()) {
+        inject(heldKeys.front(), false);
+        heldKeys.pop_front();
+    }
+
+    running = false;
+}
+
+void KeyStormGenerator::stop() {
+    running = false;
+}
+
+UINT64 KeyStormGenerator::getEventsInjected() const {
+    return eventsInjected;
+}
+
+const char* KeyStormGenerator::patternName(KeyStormPattern pattern) {
+    switch (pattern) {
+        case KeyStormPattern::STEADY:
+            return "steady";
+        case KeyStormPattern::BURST:
+            return "burst";
+        case KeyStormPattern::ROLLOVER:
+            return "rollover";
+        case KeyStormPattern::AUTOREPEAT:
+            return "autorepeat";
+        default:
+            return "unknown";
+    }
+}
+
+KeyStormGenerator::KeyStormGenerator(const KeyStormOptions& options)
+    : options(options),
+      interval(std::chrono::nanoseconds(static_cast<INT64>(std::llround(1e9 / options.eventsPerSecond)))) {
+    if (options.eventsPerSecond <= 0 || options.seconds <= 0 || options.burstLength == 0 ||
+        options.rolloverKeys == 0) {
+        throw std::runtime_error("Invalid key storm configuration");
+    }
+}
@@ -0,0 +1,127 @@
+#pragma once
+
+//clang-format off
+#include <windows.h>
+//clang-format on
+
+#include <atomic>
+#include <chrono>
+#include <deque>
+
+#include "KeyEventPublisher.h"
+
+/**
+ * @brief Shape of the key event stream produced by KeyStormGenerator.
+ */
+enum class KeyStormPattern {
+    STEADY = 0,     ///< Press and release of rotating letters at a fixed rate
+    BURST = 1,      ///< Bursts of back-to-back events separated by idle gaps
+    ROLLOVER = 2,   ///< Several keys held at once, oldest released as the next is pressed
+    AUTOREPEAT = 3  ///< Held keys repeating their key-down like the typematic repeat
+};
+
+/**
+ * @brief Configuration of a KeyStormGenerator.
+ */
+struct KeyStormOptions {
+    KeyStormPattern pattern = KeyStormPattern::STEADY;  ///< Stream shape
+    double eventsPerSecond = 1000;                      ///< Event rate; bursts are sent back to back
+    double seconds = 10;                                ///< Duration of the storm
+    UINT32 burstLength = 200;                           ///< Events per burst
+    std::chrono::milliseconds burstGap{250};            ///< Idle time between bursts
+    UINT32 rolloverKeys = 6;                            ///< Keys held at once for ROLLOVER
+    std::chrono::milliseconds repeatDelay{500};         ///< Hold time before the first repeat
+    UINT32 repeatsPerKey = 30;                          ///< Repeated key-downs before a key is released
+    bool startSession = false;                          ///< Press the logging trigger before the storm
+};
+
+/**
+ * @brief Injects synthetic key events through KeyEventPublisher.
+ *
+ * Events take the same path as hook events, so every subscriber of the
+ * publisher sees them and PipelineMetrics measures each consumer under load.
+ * Only letters are generated so the storm itself never toggles the logging
+ * trigger. Events are scheduled on a fixed timeline; when the thread wakes
+ * late, the overdue events are sent back to back rather than skipped.
+ */
+class KeyStormGenerator {
+private:
+    /// One scheduled key transition
+    struct Step {
+        std::chrono::nanoseconds delay;  ///< Time since the previous step
+        USHORT vkey;
+        bool pressed;
+    };
+
+    /// Configuration
+    KeyStormOptions options;
+
+    /// Spacing of consecutive events at the configured rate
+    std::chrono::nanoseconds interval;
+
+    /// Number of steps generated so far
+    UINT64 stepIndex = 0;
+
+    /// Letter pressed by the next new key-down
+    UINT32 nextLetter = 0;
+
+    /// Keys currently held, oldest first
+    std::deque<USHORT> heldKeys;
+
+    /// Repeats sent for the held key in AUTOREPEAT
+    UINT32 repeatsSent = 0;
+
+    /// Events injected so far
+    std::atomic<UINT64> eventsInjected = 0;
+
+    /// Cleared by stop() to end run() early
+    std::atomic<bool> running = false;
+
+    /**
+     * @brief Next letter key in rotation.
+     */
+    USHORT takeLetter();
+
+    /**
+     * @brief Produces the next transition of the configured pattern.
+     */
+    Step nextStep();
+
+    /**
+     * @brief Sends one key transition through the publisher.
+     */
+    void inject(USHORT vkey, bool pressed);
+
+    /**
+     * @brief Presses the logging trigger key the number of times LoggingTrigger expects.
+     */
+    void pressTrigger();
+
+public:
+    /**
+     * @brief Creates a generator; nothing is sent until run().
+     */
+    KeyStormGenerator(const KeyStormOptions& options = {});
+
+    /**
+     * @brief Sends the storm, blocking for its duration or until stop().
+     *
+     * Held keys are released at the end so consumers aren't left with stuck keys.
+     */
+    void run();
+
+    /**
+     * @brief Ends run() after the current event.
+     */
+    void stop();
+
+    /**
+     * @brief Number of events injected so far.
+     */
+    UINT64 getEventsInjected() const;
+
+    /**
+     * @brief Lowercase name of a pattern, used in reports.
+     */
+    static const char* patternName(KeyStormPattern pattern);
+};
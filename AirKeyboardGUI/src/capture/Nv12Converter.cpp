@@ -0,0 +1,36 @@
+#include "Nv12Converter.h"
+
+namespace {
+
+inline BYTE clampByte(int value) {
+    return static_cast<BYTE>(value < 0 ? 0 : (value > 255 ? 255 : value));
+}
+
+}  // namespace
+
+void convertNv12ToBgrCrop(const BYTE* nv12, BYTE* bgr, int srcWidth, int srcHeight, int cropX, int cropY, int cropWidth,
+                          int cropHeight) {
+    const BYTE* uvPlane = nv12 + static_cast<size_t>(srcWidth) * srcHeight;
+
+    for (int y = 0; y < cropHeight; y++) {
+        // Flipped vertically, so output rows walk the source upwards
+        int srcY = srcHeight - 1 - (cropY + y);
+        const BYTE* yRow = nv12 + static_cast<size_t>(srcY) * srcWidth;
+        const BYTE* uvRow = uvPlane + static_cast<size_t>(srcY / 2) * srcWidth;
+        BYTE* out = bgr + static_cast<size_t>(y) * cropWidth * 3;
+
+        for (int x = 0; x < cropWidth; x++) {
+            // Flipped horizontally
+            int srcX = srcWidth - 1 - (cropX + x);
+
+            int c = yRow[srcX] - 16;
+            int d = uvRow[srcX & ~1] - 128;
+            int e = uvRow[(srcX & ~1) + 1] - 128;
+
+            out[0] = clampByte((298 * c + 516 * d + 128) >> 8);
+            out[1] = clampByte((298 * c - 100 * d - 208 * e + 128) >> 8);
+            out[2] = clampByte((298 * c + 409 * e + 128) >> 8);
+            out += 3;
+        }
+    }
+}
@@ -0,0 +1,18 @@
+#pragma once
+
+//clang-format off
+#include <windows.h>
+//clang-format on
+
+/**
+ * @brief CPU equivalent of the CUDA crop kernel in FrameProcessor.cu.
+ *
+ * Crops cropWidth x cropHeight pixels at (cropX, cropY) from a contiguous NV12
+ * frame, flipped horizontally and vertically like the kernel, and converts them
+ * to BGR24 with the same integer BT.601 math, so both paths produce identical bytes.
+ *
+ * @param nv12 Source frame, srcWidth * srcHeight * 3 / 2 bytes
+ * @param bgr Destination, cropWidth * cropHeight * 3 bytes
+ */
+void convertNv12ToBgrCrop(const BYTE* nv12, BYTE* bgr, int srcWidth, int srcHeight, int cropX, int cropY, int cropWidth,
+                          int cropHeight);
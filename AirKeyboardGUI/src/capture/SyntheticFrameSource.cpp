@@ -0,0 +1,242 @@
+#include "SyntheticFrameSource.h"
+
+#include <atomic>
+#include <cmath>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+
+namespace {
+
+/// 75% color bars in BT.601 limited range: white, yellow, cyan, green, magenta, red, blue, black
+constexpr BYTE BAR_Y[8] = {180, 162, 131, 112, 84, 65, 35, 16};
+constexpr BYTE BAR_U[8] = {128, 44, 156, 72, 184, 100, 212, 128};
+constexpr BYTE BAR_V[8] = {128, 142, 44, 58, 198, 212, 114, 128};
+
+}  // namespace
+
+void SyntheticFrameSource::loadLoop() {
+    std::error_code ec;
+    UINT64 fileSize = std::filesystem::file_size(options.loopFile, ec);
+    loopFrameCount = ec ? 0 : static_cast<size_t>(fileSize / frameSize);
+
+    std::ifstream in(options.loopFile, std::ios::binary);
+    if (loopFrameCount > 0 && in) {
+        loopFrames.resize(loopFrameCount * frameSize);
+        in.read(reinterpret_cast<char*>(loopFrames.data()), loopFrames.size());
+        if (in) return;
+    }
+
+    std::string message = "SyntheticFrameSource: " + options.loopFile.string() +
+                          " holds no complete NV12 frame of the configured size, using the moving gradient\n";
+    OutputDebugStringA(message.c_str());
+
+    loopFrames.clear();
+    loopFrameCount = 0;
+    options.pattern = SyntheticPattern::MOVING_GRADIENT;
+}
+
+void SyntheticFrameSource::prefill(BYTE* nv12) {
+    const UINT32 width = options.width;
+    const UINT32 height = options.height;
+    BYTE* uvPlane = nv12 + static_cast<size_t>(width) * height;
+
+    switch (options.pattern) {
+        case SyntheticPattern::COLOR_BARS:
+            for (UINT32 x = 0; x < width; x++) {
+                nv12[x] = BAR_Y[x * 8 / width];
+            }
+            for (UINT32 y = 1; y < height; y++) {
+                memcpy(nv12 + static_cast<size_t>(y) * width, nv12, width);
+            }
+
+            for (UINT32 x = 0; x < width; x += 2) {
+                uvPlane[x] = BAR_U[x * 8 / width];
+                uvPlane[x + 1] = BAR_V[x * 8 / width];
+            }
+            for (UINT32 y = 1; y < height / 2; y++) {
+                memcpy(uvPlane + static_cast<size_t>(y) * width, uvPlane, width);
+            }
+            break;
+
+        case SyntheticPattern::MOVING_GRADIENT:
+            // Luma is rewritten every frame, chroma stays neutral
+            memset(uvPlane, 128, static_cast<size_t>(width) * height / 2);
+            break;
+
+        case SyntheticPattern::RECORDED_LOOP:
+            break;  // Every frame is copied whole
+    }
+}
+
+void SyntheticFrameSource::fillFrame(BYTE* nv12, UINT64 frameIndex) {
+    const UINT32 width = options.width;
+
+    switch (options.pattern) {
+        case SyntheticPattern::COLOR_BARS:
+            break;  // Static, only the stamp changes
+
+        case SyntheticPattern::MOVING_GRADIENT: {
+            // A 256-pixel ramp moving 4 pixels per frame; each row is a window into gradientRow
+            size_t shift = static_cast<size_t>(frameIndex * 4);
+            for (UINT32 y = 0; y < options.height; y++) {
+                memcpy(nv12 + static_cast<size_t>(y) * width, gradientRow.data() + ((y + shift) & 0xFF), width);
+            }
+            break;
+        }
+
+        case SyntheticPattern::RECORDED_LOOP:
+            memcpy(nv12, loopFrames.data() + (frameIndex % loopFrameCount) * frameSize, frameSize);
+            break;
+    }
+}
+
+void SyntheticFrameSource::stampSequence(BYTE* nv12, UINT64 sequence) {
+    const UINT32 width = options.width;
+    const UINT32 stampWidth = 64 * STAMP_BLOCK;
+    const UINT32 x0 = width > stampWidth ? (width - stampWidth) / 2 : 0;
+    const UINT32 y0 = options.height - STAMP_BLOCK;
+
+    for (UINT32 bit = 0; bit < 64; bit++) {
+        UINT32 x = x0 + bit * STAMP_BLOCK;
+        if (x + STAMP_BLOCK > width) break;
+
+        BYTE value = (sequence >> bit) & 1 ? 235 : 16;
+        for (UINT32 y = y0; y < options.height; y++) {
+            memset(nv12 + static_cast<size_t>(y) * width + x, value, STAMP_BLOCK);
+        }
+    }
+}
+
+void SyntheticFrameSource::captureFrame() {
+    UINT64 sequence = nextSequence++;
+
+    // A sample only the pool references has been released by every subscriber
+    Slot* slot = nullptr;
+    for (size_t i = 0; i < slots.size(); i++) {
+        size_t index = (nextSlot + i) % slots.size();
+        if (slots[index].sample.use_count() == 1) {
+            slot = &slots[index];
+            nextSlot = index + 1;
+            break;
+        }
+    }
+
+    if (!slot) {
+        framesDropped++;  // The skipped sequence number shows the drop downstream
+        return;
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+
+    BYTE* nv12 = nullptr;
+    if (FAILED(slot->buffer->Lock(&nv12, nullptr, nullptr))) {
+        framesDropped++;
+        return;
+    }
+    fillFrame(nv12, sequence);
+    stampSequence(nv12, sequence);
+    slot->buffer->Unlock();
+
+    LARGE_INTEGER perfCounter;
+    QueryPerformanceCounter(&perfCounter);
+    INT64 captureNs = Timebase::getInstance().fromQpc(perfCounter.QuadPart);
+
+    // Synthetic frames have no capture latency, the arrival time is the capture time
+    IMFSample* sample = slot->sample.get();
+    sample->SetSampleTime(captureNs / 100);
+    sample->SetUINT64(MFSampleExtension_Timestamp, perfCounter.QuadPart);
+    sample->SetUINT64(AKSampleExtension_Sequence, sequence);
+    sample->SetUINT64(AKSampleExtension_CaptureTime, static_cast<UINT64>(captureNs));
+
+    publish(slot->sample);
+}
+
+std::chrono::nanoseconds SyntheticFrameSource::getFrameInterval() const {
+    return std::chrono::nanoseconds(static_cast<INT64>(std::llround(1e9 / options.fps)));
+}
+
+UINT64 SyntheticFrameSource::getFramesProduced() const {
+    return nextSequence - framesDropped;
+}
+
+UINT64 SyntheticFrameSource::getFramesDropped() const {
+    return framesDropped;
+}
+
+SyntheticFrameSource::SyntheticFrameSource(const SyntheticSourceOptions& options)
+    : options(options), frameSize(static_cast<size_t>(options.width) * options.height * 3 / 2) {
+    // NV12 subsamples chroma by two in both directions
+    if (options.width == 0 || options.height == 0 || options.width % 2 != 0 || options.height % 2 != 0 ||
+        options.fps <= 0 || options.poolSize == 0) {
+        throw std::runtime_error("Invalid synthetic frame source configuration");
+    }
+
+    if (this->options.pattern == SyntheticPattern::RECORDED_LOOP) {
+        loadLoop();
+    }
+
+    gradientRow.resize(static_cast<size_t>(options.width) + 256);
+    for (size_t i = 0; i < gradientRow.size(); i++) {
+        gradientRow[i] = static_cast<BYTE>(i & 0xFF);
+    }
+
+    HRESULT hr = MFStartup(MF_VERSION, MFSTARTUP_LITE);
+    if (FAILED(hr)) {
+        throw std::runtime_error("Failed to initialize MediaFoundation for synthetic frames");
+    }
+
+    // Fixed size; queued samples are budgeted by FrameProcessor's queue
+    poolAccount = MemoryAccountant::getInstance().getAccount("synthetic_frame_pool", false);
+    slots.resize(options.poolSize);
+    for (Slot& slot : slots) {
+        IMFSample* sample = nullptr;
+        hr = MFCreateSample(&sample);
+        if (SUCCEEDED(hr)) {
+            hr = MFCreateAlignedMemoryBuffer(static_cast<DWORD>(frameSize), MF_16_BYTE_ALIGNMENT, &slot.buffer);
+        }
+        if (SUCCEEDED(hr)) {
+            hr = sample->AddBuffer(slot.buffer);
+        }
+        if (SUCCEEDED(hr)) {
+            hr = slot.buffer->SetCurrentLength(static_cast<DWORD>(frameSize));
+        }
+        if (SUCCEEDED(hr)) {
+            hr = MFSetAttributeSize(sample, AKSampleExtension_FrameSize, options.width, options.height);
+        }
+
+        // The one shared_ptr per sample is made here; frames publish copies of it
+        if (sample) {
+            slot.sample = std::shared_ptr<IMFSample>(sample, [](IMFSample* p) {
+                if (p) p->Release();
+            });
+        }
+
+        if (FAILED(hr)) {
+            OutputDebugStringA("SyntheticFrameSource: failed to create pooled sample\n");
+            throw std::runtime_error("Failed to create synthetic frame pool");
+        }
+
+        BYTE* nv12 = nullptr;
+        if (SUCCEEDED(slot.buffer->Lock(&nv12, nullptr, nullptr))) {
+            prefill(nv12);
+            slot.buffer->Unlock();
+        }
+        poolAccount->add(static_cast<INT64>(frameSize));
+    }
+}
+
+SyntheticFrameSource::~SyntheticFrameSource() {
+    shutdown();
+
+    for (Slot& slot : slots) {
+        slot.sample.reset();
+        if (slot.buffer) {
+            slot.buffer->Release();
+            slot.buffer = nullptr;
+            poolAccount->remove(static_cast<INT64>(frameSize));
+        }
+    }
+    slots.clear();
+
+    MFShutdown();
+}
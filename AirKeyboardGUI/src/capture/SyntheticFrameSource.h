@@ -0,0 +1,146 @@
+#pragma once
+
+//clang-format off
+#include <windows.h>
+//clang-format on
+
+#include <mfapi.h>
+#include <mfidl.h>
+
+#include <filesystem>
+#include <memory>
+#include <vector>
+
+#include "../metrics/MemoryAccountant.h"
+#include "FrameSource.h"
+#include "Timebase.h"
+
+/**
+ * @brief Image content produced by SyntheticFrameSource.
+ */
+enum class SyntheticPattern {
+    COLOR_BARS = 0,       ///< Static 75% color bars
+    MOVING_GRADIENT = 1,  ///< Diagonal luma ramp that moves every frame
+    RECORDED_LOOP = 2     ///< Raw NV12 frames from a file, played in a loop
+};
+
+/**
+ * @brief Configuration of a SyntheticFrameSource.
+ */
+struct SyntheticSourceOptions {
+    UINT32 width = 1920;                                        ///< Frame width, even
+    UINT32 height = 1080;                                       ///< Frame height, even
+    double fps = 30;                                            ///< Frame rate captureFrame() is paced at
+    SyntheticPattern pattern = SyntheticPattern::MOVING_GRADIENT;  ///< Image content
+    std::filesystem::path loopFile;                             ///< Raw NV12 file for RECORDED_LOOP
+    size_t poolSize = 8;                                        ///< Samples in flight before frames are dropped
+};
+
+/**
+ * @brief Camera-free frame source producing NV12 test content.
+ *
+ * All samples and buffers are created up front. captureFrame() picks a pooled
+ * sample no subscriber still holds, fills it in place and publishes a copy of
+ * the pool's shared_ptr, so producing a frame allocates nothing. When every
+ * sample is still in use the frame is dropped, as a camera would drop it.
+ *
+ * Each frame carries its sequence number as 64 black or white 8x8 blocks on
+ * its bottom row, inside FrameProcessor's crop, so drops and reordering can be
+ * checked from the logged pixels.
+ */
+class SyntheticFrameSource : public FrameSource {
+private:
+    /// Side of one sequence-stamp block in pixels
+    static constexpr UINT32 STAMP_BLOCK = 8;
+
+    /// A pooled sample and its single buffer
+    struct Slot {
+        std::shared_ptr<IMFSample> sample;  ///< Pool's reference; use_count() == 1 means free
+        IMFMediaBuffer* buffer = nullptr;   ///< Owned by sample
+    };
+
+    /// Configuration
+    SyntheticSourceOptions options;
+
+    /// Size of one NV12 frame in bytes
+    size_t frameSize;
+
+    /// Pooled samples
+    std::vector<Slot> slots;
+
+    /// Slot to try first on the next frame
+    size_t nextSlot = 0;
+
+    /// Luma ramp twice as wide as a frame, rows of the gradient are windows into it
+    std::vector<BYTE> gradientRow;
+
+    /// Frames of the recorded loop, back to back
+    std::vector<BYTE> loopFrames;
+
+    /// Number of frames in loopFrames
+    size_t loopFrameCount = 0;
+
+    /// Sequence number assigned to the next frame
+    UINT64 nextSequence = 0;
+
+    /// Frames not produced because every pooled sample was still in use
+    UINT64 framesDropped = 0;
+
+    /// Account the pool's memory is reported to
+    MemoryAccount* poolAccount = nullptr;
+
+    /**
+     * @brief Loads the loop file, falling back to the moving gradient if it is unusable.
+     */
+    void loadLoop();
+
+    /**
+     * @brief Writes the pattern's static content into a newly created slot buffer.
+     */
+    void prefill(BYTE* nv12);
+
+    /**
+     * @brief Writes the content of one frame into a slot buffer.
+     */
+    void fillFrame(BYTE* nv12, UINT64 frameIndex);
+
+    /**
+     * @brief Writes the sequence number into the bottom row of the luma plane.
+     */
+    void stampSequence(BYTE* nv12, UINT64 sequence);
+
+public:
+    /**
+     * @brief Creates the sample pool and pattern data.
+     * @throws std::runtime_error if the dimensions are invalid or MediaFoundation fails
+     */
+    SyntheticFrameSource(const SyntheticSourceOptions& options = {});
+
+    /**
+     * @brief Fills the next free pooled sample and publishes it, or drops the frame.
+     */
+    void captureFrame() override;
+
+    /**
+     * @brief 1 / options.fps.
+     */
+    std::chrono::nanoseconds getFrameInterval() const override;
+
+    /**
+     * @brief Number of frames produced so far.
+     */
+    UINT64 getFramesProduced() const;
+
+    /**
+     * @brief Number of frames dropped because the pool was exhausted.
+     */
+    UINT64 getFramesDropped() const;
+
+    /**
+     * @brief Releases the pool and shuts MediaFoundation down.
+     */
+    ~SyntheticFrameSource();
+
+    SyntheticFrameSource(const SyntheticFrameSource&) = delete;
+    SyntheticFrameSource& operator=(const SyntheticFrameSource&) = delete;
+};
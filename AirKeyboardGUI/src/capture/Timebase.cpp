@@ -0,0 +1,173 @@
+#include "Timebase.h"
+
+#include <algorithm>
+#include <fstream>
+
+#include "../types.h"
+
+INT64 LatencyEstimator::correct(INT64 sourceNs, INT64 arrivalNs) {
+    INT64 delay = arrivalNs - sourceNs;
+
+    if (!primed) {
+        currentMin = previousMin = delay;
+        windowStart = arrivalNs;
+        primed = true;
+    } else if (arrivalNs - windowStart >= windowNs) {
+        previousMin = currentMin;
+        currentMin = delay;
+        windowStart = arrivalNs;
+    } else {
+        currentMin = std::min(currentMin, delay);
+    }
+
+    INT64 excess = delay - std::min(currentMin, previousMin);
+    excess = excess > resolutionNs ? excess - resolutionNs : 0;
+
+    INT64 latency = floorNs + excess;
+    INT64 captureNs = arrivalNs - latency;
+
+    if (samples == 0) {
+        minLatencyNs = maxLatencyNs = latency;
+    } else {
+        minLatencyNs = std::min(minLatencyNs, latency);
+        maxLatencyNs = std::max(maxLatencyNs, latency);
+    }
+    sumLatencyNs += static_cast<double>(latency);
+    samples++;
+
+    return captureNs;
+}
+
+INT64 LatencyEstimator::observe(INT64 captureNs, INT64 arrivalNs) {
+    INT64 latency = arrivalNs - captureNs;
+
+    if (samples == 0) {
+        minLatencyNs = maxLatencyNs = latency;
+    } else {
+        minLatencyNs = std::min(minLatencyNs, latency);
+        maxLatencyNs = std::max(maxLatencyNs, latency);
+    }
+    sumLatencyNs += static_cast<double>(latency);
+    samples++;
+
+    return captureNs;
+}
+
+INT64 LatencyEstimator::getOffset() const {
+    return primed ? std::min(currentMin, previousMin) : 0;
+}
+
+void LatencyEstimator::resetStatistics() {
+    samples = 0;
+    sumLatencyNs = 0;
+    minLatencyNs = 0;
+    maxLatencyNs = 0;
+}
+
+LatencyEstimator::LatencyEstimator(INT64 floorNs, INT64 resolutionNs, INT64 windowNs)
+    : floorNs(floorNs), resolutionNs(resolutionNs), windowNs(windowNs) {}
+
+Timebase& Timebase::getInstance() {
+    static Timebase instance;
+    return instance;
+}
+
+INT64 Timebase::now() const {
+    LARGE_INTEGER counter;
+    QueryPerformanceCounter(&counter);
+    return qpcToNanoseconds(counter.QuadPart, frequency.QuadPart);
+}
+
+INT64 Timebase::fromQpc(INT64 ticks) const {
+    return qpcToNanoseconds(ticks, frequency.QuadPart);
+}
+
+INT64 Timebase::getFrequency() const {
+    return frequency.QuadPart;
+}
+
+INT64 Timebase::keyCaptureTime(DWORD messageTimeMs, INT64 arrivalNs) {
+    // The message time is the low 32 bits of GetTickCount64, unwrap it against the current tick
+    ULONGLONG tick = GetTickCount64();
+    DWORD ageMs = static_cast<DWORD>(tick) - messageTimeMs;
+    INT64 sourceNs = static_cast<INT64>(tick - ageMs) * 1000000;
+
+    std::lock_guard<std::mutex> lock(estimatorsLock);
+    return estimators[static_cast<size_t>(TimeSource::KEYBOARD)].correct(sourceNs, arrivalNs);
+}
+
+INT64 Timebase::cameraCaptureTime(LONGLONG sampleTime, UINT64 deviceTime, INT64 arrivalNs) {
+    std::lock_guard<std::mutex> lock(estimatorsLock);
+    LatencyEstimator& estimator = estimators[static_cast<size_t>(TimeSource::CAMERA)];
+
+    // Drivers behind the frame server stamp exposure with QPC in 100 ns units, which is
+    // already the session clock. Otherwise the sample time has an unknown offset to estimate.
+    cameraDeviceClock = deviceTime != 0;
+    if (cameraDeviceClock) {
+        return estimator.observe(static_cast<INT64>(deviceTime) * 100, arrivalNs);
+    }
+    return estimator.correct(static_cast<INT64>(sampleTime) * 100, arrivalNs);
+}
+
+void Timebase::resetStatistics() {
+    std::lock_guard<std::mutex> lock(estimatorsLock);
+    for (auto& estimator : estimators) {
+        estimator.resetStatistics();
+    }
+}
+
+bool Timebase::save(const std::filesystem::path& filePath) const {
+    std::ofstream out(filePath);
+    if (!out) {
+        std::string message = "Timebase: failed to write " + filePath.string() + "\n";
+        OutputDebugStringA(message.c_str());
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(estimatorsLock);
+
+    // Session time = source time + offset - floor, plus any delay above the window minimum
+    out << "clock=qpc_ns\n";
+    out << "qpc_frequency=" << frequency.QuadPart << "\n";
+
+    const char* names[] = {"keyboard", "camera"};
+    for (size_t i = 0; i < static_cast<size_t>(TimeSource::COUNT); i++) {
+        const LatencyEstimator& estimator = estimators[i];
+        std::string prefix = names[i];
+
+        if (i == static_cast<size_t>(TimeSource::KEYBOARD)) {
+            out << prefix << ".source_clock=tick_count_ms\n";
+        } else {
+            out << prefix << ".source_clock=" << (cameraDeviceClock ? "device_qpc" : "sample_time") << "\n";
+        }
+        out << prefix << ".offset_ns=" << estimator.getOffset() << "\n";
+        out << prefix << ".latency_floor_ns=" << estimator.getFloor() << "\n";
+        out << prefix << ".resolution_ns=" << estimator.getResolution() << "\n";
+        out << prefix << ".samples=" << estimator.getSamples() << "\n";
+        out << prefix << ".latency_mean_ns=" << static_cast<INT64>(estimator.getMeanLatency()) << "\n";
+        out << prefix << ".latency_min_ns=" << estimator.getMinLatency() << "\n";
+        out << prefix << ".latency_max_ns=" << estimator.getMaxLatency() << "\n";
+    }
+
+    return static_cast<bool>(out);
+}
+
+Timebase::Timebase() {
+    QueryPerformanceFrequency(&frequency);
+
+    // GetTickCount advances once per clock interrupt, typically every 15.6 ms
+    DWORD adjustment = 0;
+    DWORD increment = 0;
+    BOOL adjustmentDisabled = FALSE;
+    INT64 tickResolutionNs = 15625000;
+    if (GetSystemTimeAdjustment(&adjustment, &increment, &adjustmentDisabled) && increment > 0) {
+        tickResolutionNs = static_cast<INT64>(increment) * 100;
+    }
+
+    const INT64 windowNs = static_cast<INT64>(TIMEBASE_WINDOW_MS) * 1000000;
+
+    estimators[static_cast<size_t>(TimeSource::KEYBOARD)] =
+        LatencyEstimator(static_cast<INT64>(KEY_LATENCY_FLOOR_US) * 1000, tickResolutionNs, windowNs);
+    estimators[static_cast<size_t>(TimeSource::CAMERA)] =
+        LatencyEstimator(static_cast<INT64>(CAMERA_LATENCY_FLOOR_US) * 1000, 0, windowNs);
+}
@@ -0,0 +1,181 @@
+#pragma once
+
+//clang-format off
+#include <windows.h>
+//clang-format on
+
+#include <filesystem>
+#include <mutex>
+
+#include "../../config.h"
+
+/**
+ * @brief Input streams whose timestamps the Timebase aligns.
+ */
+enum class TimeSource {
+    KEYBOARD = 0,  ///< Low-level keyboard hook, source clock is the GetTickCount message time
+    CAMERA = 1,    ///< MediaFoundation camera, source clock is the device or sample time
+    COUNT
+};
+
+/**
+ * @brief Estimates the delay between a source clock and the session clock.
+ *
+ * Each sample pairs the time a source says something happened with the time it
+ * reached us. Their difference is the source's clock offset plus its delivery
+ * delay. The minimum over a sliding window is taken as the offset plus the
+ * fastest possible delivery, so anything above it is extra delay for that
+ * sample. A configured floor stands in for the delay that is never observable
+ * from the host, e.g. exposure to readout or USB polling.
+ *
+ * Source timestamps coarser than their resolution are not trusted below it:
+ * only delay above the resolution is subtracted, so quantization noise does
+ * not move events around.
+ */
+class LatencyEstimator {
+private:
+    /// Delay that is always present but not observable, in nanoseconds
+    INT64 floorNs = 0;
+
+    /// Granularity of the source clock in nanoseconds
+    INT64 resolutionNs = 0;
+
+    /// Length of each minimum-tracking window in nanoseconds
+    INT64 windowNs = 0;
+
+    /// Start of the current window on the session clock
+    INT64 windowStart = 0;
+
+    /// Smallest arrival minus source time seen in the current and previous windows
+    INT64 currentMin = 0;
+    INT64 previousMin = 0;
+
+    /// Whether any sample has been seen
+    bool primed = false;
+
+    // Statistics of the latency applied since the last reset
+    UINT64 samples = 0;
+    double sumLatencyNs = 0;
+    INT64 minLatencyNs = 0;
+    INT64 maxLatencyNs = 0;
+
+public:
+    LatencyEstimator() = default;
+
+    /**
+     * @param floorNs Delay always present but not observable from the host
+     * @param resolutionNs Granularity of the source clock
+     * @param windowNs Length of the minimum-tracking window; the offset follows drift at this rate
+     */
+    LatencyEstimator(INT64 floorNs, INT64 resolutionNs, INT64 windowNs);
+
+    /**
+     * @brief Adds a sample and returns its estimated capture time.
+     * @param sourceNs Time the source reports, in nanoseconds of its own clock
+     * @param arrivalNs Time the sample reached the application on the session clock
+     * @return Capture time on the session clock
+     */
+    INT64 correct(INT64 sourceNs, INT64 arrivalNs);
+
+    /**
+     * @brief Adds a sample whose source time is already on the session clock.
+     * @return The source time, unchanged
+     */
+    INT64 observe(INT64 captureNs, INT64 arrivalNs);
+
+    /**
+     * @brief Current source-to-session offset: session time = source time + offset - floor.
+     */
+    INT64 getOffset() const;
+
+    INT64 getFloor() const { return floorNs; }
+    INT64 getResolution() const { return resolutionNs; }
+    UINT64 getSamples() const { return samples; }
+    double getMeanLatency() const { return samples > 0 ? sumLatencyNs / samples : 0; }
+    INT64 getMinLatency() const { return minLatencyNs; }
+    INT64 getMaxLatency() const { return maxLatencyNs; }
+
+    /**
+     * @brief Clears the latency statistics, keeping the offset estimate.
+     */
+    void resetStatistics();
+};
+
+/**
+ * @brief Singleton that maps every input stream onto one nanosecond clock.
+ *
+ * The session clock is QueryPerformanceCounter converted to nanoseconds, the
+ * same clock FrameHeader and KeyEventRecord timestamps use. Publishers stamp
+ * arrival with now() and pass their source's own timestamp to the matching
+ * capture-time method, which removes the source's estimated capture latency.
+ * save() writes the offsets and latency figures used to the session directory
+ * so the alignment can be audited or redone offline.
+ */
+class Timebase {
+private:
+    /// QueryPerformanceFrequency of this host
+    LARGE_INTEGER frequency;
+
+    /// One estimator per TimeSource
+    LatencyEstimator estimators[static_cast<size_t>(TimeSource::COUNT)];
+
+    /// Whether the last camera sample carried a QPC device timestamp
+    bool cameraDeviceClock = false;
+
+    /// Guards the estimators; publishers run on different threads
+    mutable std::mutex estimatorsLock;
+
+    Timebase();
+
+public:
+    /**
+     * @brief Singleton instance accessor
+     */
+    static Timebase& getInstance();
+
+    /**
+     * @brief Current time on the session clock in nanoseconds.
+     */
+    INT64 now() const;
+
+    /**
+     * @brief Converts a QueryPerformanceCounter value to the session clock.
+     */
+    INT64 fromQpc(INT64 ticks) const;
+
+    /**
+     * @brief QueryPerformanceFrequency of this host.
+     */
+    INT64 getFrequency() const;
+
+    /**
+     * @brief Estimates when a key event happened.
+     * @param messageTimeMs KBDLLHOOKSTRUCT::time, the GetTickCount time of the event
+     * @param arrivalNs Session time the hook received the event
+     */
+    INT64 keyCaptureTime(DWORD messageTimeMs, INT64 arrivalNs);
+
+    /**
+     * @brief Estimates when a camera frame was exposed.
+     * @param sampleTime Sample time from IMFSourceReader::ReadSample, in 100 ns units
+     * @param deviceTime QPC device timestamp in 100 ns units, or 0 when the driver provides none
+     * @param arrivalNs Session time ReadSample returned the frame
+     */
+    INT64 cameraCaptureTime(LONGLONG sampleTime, UINT64 deviceTime, INT64 arrivalNs);
+
+    /**
+     * @brief Clears latency statistics, called when a logging session starts.
+     */
+    void resetStatistics();
+
+    /**
+     * @brief Writes the clock alignment of every source as key=value lines.
+     * @param filePath Destination, normally timebase.txt in the session directory
+     * @return false if the file could not be written
+     */
+    bool save(const std::filesystem::path& filePath) const;
+
+    Timebase(const Timebase&) = delete;  // Delete copy constructor to enforce singleton pattern
+
+    Timebase& operator=(const Timebase&) = delete;  // Delete assignment operator to enforce singleton pattern
+};
@@ -0,0 +1,114 @@
+// C entry points of the akcodec library, so tools outside the C++ build, like
+// frame_postprocessor.py or training data loaders, can read compressed sessions.
+
+#include <cstring>
+#include <filesystem>
+#include <string>
+
+#include "../replay/FrameSeeker.h"
+#include "LosslessCodec.h"
+
+#ifdef _WIN32
+#define CODEC_EXPORT extern "C" __declspec(dllexport)
+#else
+#define CODEC_EXPORT extern "C" __attribute__((visibility("default")))
+#endif
+
+/**
+ * @brief Reads the dimensions of an encoded frame.
+ * @return 1 on success, 0 if data is not an encoded frame
+ */
+CODEC_EXPORT int akReadFrameInfo(const BYTE* data, size_t size, UINT32* width, UINT32* height) {
+    LosslessFrameHeader header;
+    if (!data || !readLosslessHeader(data, size, header)) return 0;
+
+    if (width) *width = header.width;
+    if (height) *height = header.height;
+    return 1;
+}
+
+/**
+ * @brief Decodes an encoded frame into width * height * 3 bytes of BGR24.
+ * @param reference Decoded previous frame for records flagged FRAME_FLAG_DELTA, otherwise NULL; may be out
+ * @return 1 on success, 0 if the data is damaged, out is too small or the reference missing
+ */
+CODEC_EXPORT int akDecodeFrame(const BYTE* data, size_t size, const BYTE* reference, BYTE* out, size_t outSize) {
+    // Each calling thread keeps its working buffers
+    thread_local LosslessDecoder decoder;
+    if (!data || !out) return 0;
+    return decoder.decode(data, size, out, outSize, reference) ? 1 : 0;
+}
+
+/**
+ * @brief Opens a frame container for random access.
+ * @param path UTF-8 path of frames.bin
+ * @return Handle for the other akContainer functions, NULL if it can't be read
+ */
+CODEC_EXPORT void* akOpenContainer(const char* path) {
+    if (!path) return nullptr;
+
+    auto* seeker = new FrameSeeker();
+    std::u8string utf8(reinterpret_cast<const char8_t*>(path));
+    if (!seeker->open(std::filesystem::path(utf8))) {
+        delete seeker;
+        return nullptr;
+    }
+    return seeker;
+}
+
+/**
+ * @brief Number of frames that can be read from an open container.
+ */
+CODEC_EXPORT size_t akContainerFrameCount(void* container) {
+    return container ? static_cast<FrameSeeker*>(container)->getFrameCount() : 0;
+}
+
+/**
+ * @brief Describes a frame of an open container; any output may be NULL.
+ * @param size Receives the size of the frame's pixels once read
+ * @return 1 on success, 0 if index is out of range
+ */
+CODEC_EXPORT int akContainerFrameInfo(void* container, size_t index, UINT32* width, UINT32* height, UINT32* pixelFormat,
+                                      size_t* size, UINT64* sequence, INT64* captureNs) {
+    if (!container) return 0;
+
+    FrameSeeker* seeker = static_cast<FrameSeeker*>(container);
+    const FrameIndexEntry* entry = seeker->getEntry(index);
+    if (!entry) return 0;
+
+    const FrameHeader& header = entry->header;
+    if (width) *width = header.width;
+    if (height) *height = header.height;
+    if (pixelFormat) *pixelFormat = header.pixelFormat;
+    if (size) {
+        // Duplicates have the pixels of the record they repeat
+        const FrameHeader& source = seeker->getEntry(entry->source)->header;
+        *size = (source.flags & FRAME_FLAG_COMPRESSED) ? static_cast<size_t>(source.width) * source.height * 3
+                                                       : source.dataSize;
+    }
+    if (sequence) *sequence = header.sequence;
+    if (captureNs) *captureNs = header.captureNs;
+    return 1;
+}
+
+/**
+ * @brief Reads the pixels of a frame of an open container, decoding from the keyframe before it as needed.
+ * @return 1 on success, 0 if index is out of range, a record is damaged or out is too small
+ */
+CODEC_EXPORT int akContainerReadFrame(void* container, size_t index, BYTE* out, size_t outSize) {
+    if (!container || !out) return 0;
+
+    // Reused by every read on this thread
+    thread_local std::vector<BYTE> pixels;
+    if (!static_cast<FrameSeeker*>(container)->readFrame(index, pixels) || pixels.size() > outSize) return 0;
+
+    memcpy(out, pixels.data(), pixels.size());
+    return 1;
+}
+
+/**
+ * @brief Closes a container opened with akOpenContainer().
+ */
+CODEC_EXPORT void akCloseContainer(void* container) {
+    delete static_cast<FrameSeeker*>(container);
+}
@@ -0,0 +1,199 @@
+#include "I420Converter.h"
+
+#include <intrin.h>
+
+#include <algorithm>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#include <tmmintrin.h>
+#define I420_X86 1
+#endif
+
+namespace {
+
+/// Integer BT.601 weights scaled by 256; each chroma row sums to 0
+struct YuvWeights {
+    short yr, yg, yb, yOffset;
+    short ub, ur, ug;
+    short vr, vg, vb;
+};
+
+constexpr YuvWeights LIMITED_WEIGHTS = {66, 129, 25, 16, 112, -38, -74, 112, -94, -18};
+constexpr YuvWeights FULL_WEIGHTS = {77, 150, 29, 0, 128, -43, -85, 128, -107, -21};
+
+inline BYTE lumaOf(const BYTE* pixel, const YuvWeights& w) {
+    return static_cast<BYTE>(((w.yr * pixel[2] + w.yg * pixel[1] + w.yb * pixel[0] + 128) >> 8) + w.yOffset);
+}
+
+/**
+ * @brief Converts pixels [first, width) of a pair of rows; first must be even.
+ *
+ * row1 and y1 may equal row0 and y0 for the last row of an odd height.
+ */
+void convertRowPairScalar(const BYTE* row0, const BYTE* row1, BYTE* y0, BYTE* y1, BYTE* u, BYTE* v, UINT32 first,
+                          UINT32 width, const YuvWeights& w) {
+    for (UINT32 x = first; x < width; x += 2) {
+        // An odd width repeats the last column into the chroma average
+        UINT32 x1 = std::min(x + 1, width - 1);
+        const BYTE* p00 = row0 + x * 3;
+        const BYTE* p01 = row0 + x1 * 3;
+        const BYTE* p10 = row1 + x * 3;
+        const BYTE* p11 = row1 + x1 * 3;
+
+        y0[x] = lumaOf(p00, w);
+        y1[x] = lumaOf(p10, w);
+        y0[x1] = lumaOf(p01, w);
+        y1[x1] = lumaOf(p11, w);
+
+        int b = (p00[0] + p01[0] + p10[0] + p11[0] + 2) >> 2;
+        int g = (p00[1] + p01[1] + p10[1] + p11[1] + 2) >> 2;
+        int r = (p00[2] + p01[2] + p10[2] + p11[2] + 2) >> 2;
+        u[x / 2] = static_cast<BYTE>(std::min(255, ((w.ub * b + w.ur * r + w.ug * g + 128) >> 8) + 128));
+        v[x / 2] = static_cast<BYTE>(std::min(255, ((w.vr * r + w.vg * g + w.vb * b + 128) >> 8) + 128));
+    }
+}
+
+#if I420_X86
+
+bool cpuHasSsse3() {
+    int info[4] = {};
+    __cpuid(info, 1);
+    return (info[2] & (1 << 9)) != 0;
+}
+
+/// pshufb masks gathering each channel of 16 BGR24 pixels out of their three 16-byte loads
+struct DeinterleaveMasks {
+    __m128i channel[3][3];
+
+    DeinterleaveMasks() {
+        for (int c = 0; c < 3; c++) {
+            for (int part = 0; part < 3; part++) {
+                alignas(16) char mask[16];
+                for (int i = 0; i < 16; i++) {
+                    int source = 3 * i + c - 16 * part;
+                    mask[i] = (source >= 0 && source < 16) ? static_cast<char>(source) : static_cast<char>(0x80);
+                }
+                channel[c][part] = _mm_load_si128(reinterpret_cast<const __m128i*>(mask));
+            }
+        }
+    }
+};
+
+inline __m128i gatherChannel(__m128i a0, __m128i a1, __m128i a2, const __m128i* masks) {
+    return _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(a0, masks[0]), _mm_shuffle_epi8(a1, masks[1])),
+                        _mm_shuffle_epi8(a2, masks[2]));
+}
+
+/// Luma of 8 pixels widened to 16 bits; the weighted sum stays below 2^16, so unsigned lanes don't overflow
+inline __m128i luma8(__m128i b, __m128i g, __m128i r, const YuvWeights& w) {
+    __m128i sum = _mm_add_epi16(_mm_add_epi16(_mm_mullo_epi16(r, _mm_set1_epi16(w.yr)), _mm_mullo_epi16(g, _mm_set1_epi16(w.yg))),
+                                _mm_add_epi16(_mm_mullo_epi16(b, _mm_set1_epi16(w.yb)), _mm_set1_epi16(128)));
+    return _mm_add_epi16(_mm_srli_epi16(sum, 8), _mm_set1_epi16(w.yOffset));
+}
+
+inline __m128i luma16(__m128i b, __m128i g, __m128i r, const YuvWeights& w) {
+    __m128i zero = _mm_setzero_si128();
+    __m128i lo = luma8(_mm_unpacklo_epi8(b, zero), _mm_unpacklo_epi8(g, zero), _mm_unpacklo_epi8(r, zero), w);
+    __m128i hi = luma8(_mm_unpackhi_epi8(b, zero), _mm_unpackhi_epi8(g, zero), _mm_unpackhi_epi8(r, zero), w);
+    return _mm_packus_epi16(lo, hi);
+}
+
+/// Rounded average of the 2x2 blocks of 16 pixels of two rows, as 8 16-bit lanes
+inline __m128i average2x2(__m128i row0, __m128i row1) {
+    __m128i ones = _mm_set1_epi8(1);
+    __m128i sum = _mm_add_epi16(_mm_maddubs_epi16(row0, ones), _mm_maddubs_epi16(row1, ones));
+    return _mm_srli_epi16(_mm_add_epi16(sum, _mm_set1_epi16(2)), 2);
+}
+
+/**
+ * @brief One chroma component of 8 averaged samples.
+ *
+ * The weights sum to 0, so the weighted sum fits the signed lanes, but adding the
+ * rounding term may not at full range; (x + 128) >> 8 equals ((x >> 1) + 64) >> 7.
+ */
+inline __m128i chroma8(__m128i first, __m128i second, __m128i third, short firstWeight, short secondWeight,
+                       short thirdWeight) {
+    __m128i sum = _mm_add_epi16(_mm_add_epi16(_mm_mullo_epi16(first, _mm_set1_epi16(firstWeight)),
+                                              _mm_mullo_epi16(second, _mm_set1_epi16(secondWeight))),
+                                _mm_mullo_epi16(third, _mm_set1_epi16(thirdWeight)));
+    __m128i rounded = _mm_srai_epi16(_mm_add_epi16(_mm_srai_epi16(sum, 1), _mm_set1_epi16(64)), 7);
+    __m128i value = _mm_add_epi16(rounded, _mm_set1_epi16(128));
+    return _mm_packus_epi16(value, value);
+}
+
+/**
+ * @brief Converts the pixels of a pair of rows in blocks of 16.
+ * @return Pixels converted, the rest is left to convertRowPairScalar()
+ */
+UINT32 convertRowPairSsse3(const BYTE* row0, const BYTE* row1, BYTE* y0, BYTE* y1, BYTE* u, BYTE* v, UINT32 width,
+                           const DeinterleaveMasks& masks, const YuvWeights& w) {
+    UINT32 x = 0;
+    for (; x + 16 <= width; x += 16) {
+        const __m128i* p0 = reinterpret_cast<const __m128i*>(row0 + x * 3);
+        const __m128i* p1 = reinterpret_cast<const __m128i*>(row1 + x * 3);
+        __m128i a0 = _mm_loadu_si128(p0);
+        __m128i a1 = _mm_loadu_si128(p0 + 1);
+        __m128i a2 = _mm_loadu_si128(p0 + 2);
+        __m128i c0 = _mm_loadu_si128(p1);
+        __m128i c1 = _mm_loadu_si128(p1 + 1);
+        __m128i c2 = _mm_loadu_si128(p1 + 2);
+
+        __m128i b0 = gatherChannel(a0, a1, a2, masks.channel[0]);
+        __m128i g0 = gatherChannel(a0, a1, a2, masks.channel[1]);
+        __m128i r0 = gatherChannel(a0, a1, a2, masks.channel[2]);
+        __m128i b1 = gatherChannel(c0, c1, c2, masks.channel[0]);
+        __m128i g1 = gatherChannel(c0, c1, c2, masks.channel[1]);
+        __m128i r1 = gatherChannel(c0, c1, c2, masks.channel[2]);
+
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(y0 + x), luma16(b0, g0, r0, w));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(y1 + x), luma16(b1, g1, r1, w));
+
+        __m128i b = average2x2(b0, b1);
+        __m128i g = average2x2(g0, g1);
+        __m128i r = average2x2(r0, r1);
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(u + x / 2), chroma8(b, r, g, w.ub, w.ur, w.ug));
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(v + x / 2), chroma8(r, g, b, w.vr, w.vg, w.vb));
+    }
+    return x;
+}
+
+#endif
+
+}  // namespace
+
+size_t i420FrameSize(UINT32 width, UINT32 height) {
+    size_t chromaWidth = (static_cast<size_t>(width) + 1) / 2;
+    size_t chromaHeight = (static_cast<size_t>(height) + 1) / 2;
+    return static_cast<size_t>(width) * height + 2 * chromaWidth * chromaHeight;
+}
+
+void convertBgrToI420(const BYTE* bgr, UINT32 width, UINT32 height, BYTE* i420, YuvRange range) {
+    const YuvWeights& weights = range == YuvRange::FULL ? FULL_WEIGHTS : LIMITED_WEIGHTS;
+    size_t chromaWidth = (static_cast<size_t>(width) + 1) / 2;
+    size_t chromaHeight = (static_cast<size_t>(height) + 1) / 2;
+    BYTE* yPlane = i420;
+    BYTE* uPlane = yPlane + static_cast<size_t>(width) * height;
+    BYTE* vPlane = uPlane + chromaWidth * chromaHeight;
+
+#if I420_X86
+    static const bool ssse3 = cpuHasSsse3();
+    static const DeinterleaveMasks masks;
+#endif
+
+    for (UINT32 y = 0; y < height; y += 2) {
+        // An odd height repeats the last row into the chroma average
+        UINT32 y1 = std::min(y + 1, height - 1);
+        const BYTE* row0 = bgr + static_cast<size_t>(y) * width * 3;
+        const BYTE* row1 = bgr + static_cast<size_t>(y1) * width * 3;
+        BYTE* luma0 = yPlane + static_cast<size_t>(y) * width;
+        BYTE* luma1 = yPlane + static_cast<size_t>(y1) * width;
+        BYTE* u = uPlane + (y / 2) * chromaWidth;
+        BYTE* v = vPlane + (y / 2) * chromaWidth;
+
+        UINT32 converted = 0;
+#if I420_X86
+        if (ssse3) converted = convertRowPairSsse3(row0, row1, luma0, luma1, u, v, width, masks, weights);
+#endif
+        convertRowPairScalar(row0, row1, luma0, luma1, u, v, converted, width, weights);
+    }
+}
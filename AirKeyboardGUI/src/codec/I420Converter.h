@@ -0,0 +1,32 @@
+#pragma once
+
+//clang-format off
+#include <windows.h>
+//clang-format on
+
+/**
+ * @brief Value range of converted samples.
+ */
+enum class YuvRange {
+    LIMITED,  ///< BT.601 studio range, Y 16..235 and chroma 16..240, as video encoders expect
+    FULL      ///< BT.601 full range, every component 0..255, as JPEG (JFIF) expects
+};
+
+/**
+ * @brief Size of a width x height frame in planar 4:2:0: a full Y plane, then U and V planes of half the
+ * width and height, rounded up.
+ */
+size_t i420FrameSize(UINT32 width, UINT32 height);
+
+/**
+ * @brief Converts a BGR24 frame to planar 4:2:0 (I420).
+ *
+ * Limited range is the inverse of the integer BT.601 math in Nv12Converter. U and
+ * V are taken from the average of each 2x2 block, so samples sit centered between
+ * the pixels. Uses SSSE3 when the CPU has it and scalar code otherwise; both
+ * produce the same bytes.
+ *
+ * @param bgr Source, width * height * 3 bytes
+ * @param i420 Destination, i420FrameSize() bytes
+ */
+void convertBgrToI420(const BYTE* bgr, UINT32 width, UINT32 height, BYTE* i420, YuvRange range = YuvRange::LIMITED);
@@ -0,0 +1,558 @@
+#include "JpegEncoder.h"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <cstring>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#include <emmintrin.h>
+#define JPEG_SSE2 1
+#endif
+
+#include "I420Converter.h"
+
+namespace {
+
+/// Natural (row-major) index of each coefficient in zigzag order
+constexpr BYTE ZIGZAG[64] = {0,  1,  8,  16, 9,  2,  3,  10, 17, 24, 32, 25, 18, 11, 4,  5,  12, 19, 26, 33, 40, 48,
+                             41, 34, 27, 20, 13, 6,  7,  14, 21, 28, 35, 42, 49, 56, 57, 50, 43, 36, 29, 22, 15, 23,
+                             30, 37, 44, 51, 58, 59, 52, 45, 38, 31, 39, 46, 53, 60, 61, 54, 47, 55, 62, 63};
+
+/// Annex K.1 luminance quantization table at quality 50, natural order
+constexpr BYTE BASE_LUMA_QUANT[64] = {16, 11, 10, 16, 24,  40,  51,  61,  12, 12, 14, 19, 26,  58,  60,  55,
+                                      14, 13, 16, 24, 40,  57,  69,  56,  14, 17, 22, 29, 51,  87,  80,  62,
+                                      18, 22, 37, 56, 68,  109, 103, 77,  24, 35, 55, 64, 81,  104, 113, 92,
+                                      49, 64, 78, 87, 103, 121, 120, 101, 72, 92, 95, 98, 112, 100, 103, 99};
+
+/// Annex K.1 chrominance quantization table at quality 50, natural order
+constexpr BYTE BASE_CHROMA_QUANT[64] = {17, 18, 24, 47, 99, 99, 99, 99, 18, 21, 26, 66, 99, 99, 99, 99,
+                                        24, 26, 56, 99, 99, 99, 99, 99, 47, 66, 99, 99, 99, 99, 99, 99,
+                                        99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99,
+                                        99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99};
+
+/// Annex K.3 Huffman tables: codes per length 1..16, then the symbols in code order
+constexpr BYTE DC_LUMA_BITS[16] = {0, 1, 5, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0};
+constexpr BYTE DC_LUMA_VALUES[12] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11};
+constexpr BYTE DC_CHROMA_BITS[16] = {0, 3, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0};
+constexpr BYTE DC_CHROMA_VALUES[12] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11};
+
+constexpr BYTE AC_LUMA_BITS[16] = {0, 2, 1, 3, 3, 2, 4, 3, 5, 5, 4, 4, 0, 0, 1, 0x7d};
+constexpr BYTE AC_LUMA_VALUES[162] = {
+    0x01, 0x02, 0x03, 0x00, 0x04, 0x11, 0x05, 0x12, 0x21, 0x31, 0x41, 0x06, 0x13, 0x51, 0x61, 0x07, 0x22, 0x71, 0x14,
+    0x32, 0x81, 0x91, 0xa1, 0x08, 0x23, 0x42, 0xb1, 0xc1, 0x15, 0x52, 0xd1, 0xf0, 0x24, 0x33, 0x62, 0x72, 0x82, 0x09,
+    0x0a, 0x16, 0x17, 0x18, 0x19, 0x1a, 0x25, 0x26, 0x27, 0x28, 0x29, 0x2a, 0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3a,
+    0x43, 0x44, 0x45, 0x46, 0x47, 0x48, 0x49, 0x4a, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59, 0x5a, 0x63, 0x64, 0x65,
+    0x66, 0x67, 0x68, 0x69, 0x6a, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78, 0x79, 0x7a, 0x83, 0x84, 0x85, 0x86, 0x87, 0x88,
+    0x89, 0x8a, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97, 0x98, 0x99, 0x9a, 0xa2, 0xa3, 0xa4, 0xa5, 0xa6, 0xa7, 0xa8, 0xa9,
+    0xaa, 0xb2, 0xb3, 0xb4, 0xb5, 0xb6, 0xb7, 0xb8, 0xb9, 0xba, 0xc2, 0xc3, 0xc4, 0xc5, 0xc6, 0xc7, 0xc8, 0xc9, 0xca,
+    0xd2, 0xd3, 0xd4, 0xd5, 0xd6, 0xd7, 0xd8, 0xd9, 0xda, 0xe1, 0xe2, 0xe3, 0xe4, 0xe5, 0xe6, 0xe7, 0xe8, 0xe9, 0xea,
+    0xf1, 0xf2, 0xf3, 0xf4, 0xf5, 0xf6, 0xf7, 0xf8, 0xf9, 0xfa};
+
+constexpr BYTE AC_CHROMA_BITS[16] = {0, 2, 1, 2, 4, 4, 3, 4, 7, 5, 4, 4, 0, 1, 2, 0x77};
+constexpr BYTE AC_CHROMA_VALUES[162] = {
+    0x00, 0x01, 0x02, 0x03, 0x11, 0x04, 0x05, 0x21, 0x31, 0x06, 0x12, 0x41, 0x51, 0x07, 0x61, 0x71, 0x13, 0x22, 0x32,
+    0x81, 0x08, 0x14, 0x42, 0x91, 0xa1, 0xb1, 0xc1, 0x09, 0x23, 0x33, 0x52, 0xf0, 0x15, 0x62, 0x72, 0xd1, 0x0a, 0x16,
+    0x24, 0x34, 0xe1, 0x25, 0xf1, 0x17, 0x18, 0x19, 0x1a, 0x26, 0x27, 0x28, 0x29, 0x2a, 0x35, 0x36, 0x37, 0x38, 0x39,
+    0x3a, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48, 0x49, 0x4a, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59, 0x5a, 0x63, 0x64,
+    0x65, 0x66, 0x67, 0x68, 0x69, 0x6a, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78, 0x79, 0x7a, 0x82, 0x83, 0x84, 0x85, 0x86,
+    0x87, 0x88, 0x89, 0x8a, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97, 0x98, 0x99, 0x9a, 0xa2, 0xa3, 0xa4, 0xa5, 0xa6, 0xa7,
+    0xa8, 0xa9, 0xaa, 0xb2, 0xb3, 0xb4, 0xb5, 0xb6, 0xb7, 0xb8, 0xb9, 0xba, 0xc2, 0xc3, 0xc4, 0xc5, 0xc6, 0xc7, 0xc8,
+    0xc9, 0xca, 0xd2, 0xd3, 0xd4, 0xd5, 0xd6, 0xd7, 0xd8, 0xd9, 0xda, 0xe2, 0xe3, 0xe4, 0xe5, 0xe6, 0xe7, 0xe8, 0xe9,
+    0xea, 0xf2, 0xf3, 0xf4, 0xf5, 0xf6, 0xf7, 0xf8, 0xf9, 0xfa};
+
+/// Worst case of one entropy-coded block, every coefficient escaped and every byte stuffed
+constexpr size_t MAX_BLOCK_BYTES = 512;
+
+/// Code and length of every symbol of a Huffman table
+struct HuffmanCodes {
+    UINT16 code[256] = {};
+    BYTE length[256] = {};
+
+    HuffmanCodes(const BYTE* bits, const BYTE* values) {
+        // Annex C: codes of each length follow the last code of the previous length, shifted left
+        UINT16 next = 0;
+        size_t symbol = 0;
+        for (int size = 1; size <= 16; size++) {
+            for (int i = 0; i < bits[size - 1]; i++) {
+                code[values[symbol]] = next++;
+                length[values[symbol]] = static_cast<BYTE>(size);
+                symbol++;
+            }
+            next <<= 1;
+        }
+    }
+};
+
+/// Huffman codes of the luma and chroma components
+struct HuffmanTables {
+    HuffmanCodes dc[2] = {{DC_LUMA_BITS, DC_LUMA_VALUES}, {DC_CHROMA_BITS, DC_CHROMA_VALUES}};
+    HuffmanCodes ac[2] = {{AC_LUMA_BITS, AC_LUMA_VALUES}, {AC_CHROMA_BITS, AC_CHROMA_VALUES}};
+};
+
+/// Scale of AAN DCT output k relative to the true coefficient, divided by sqrt(8)
+constexpr float AAN_SCALE[8] = {1.0f,         1.387039845f, 1.306562965f, 1.175875602f,
+                                1.0f,         0.785694958f, 0.541196100f, 0.275899379f};
+
+/**
+ * @brief Writes entropy-coded bits, stuffing a zero byte after every 0xFF.
+ *
+ * The caller makes room in out before each block; bits are kept right-aligned in a 64-bit buffer.
+ */
+class BitWriter {
+private:
+    std::vector<BYTE>& out;
+    size_t length;
+    UINT64 buffer = 0;
+    int count = 0;
+
+    void emitByte(BYTE value) {
+        out[length++] = value;
+        if (value == 0xFF) out[length++] = 0;
+    }
+
+    void emitWord(UINT32 word) {
+        // Whole words without a 0xFF byte, the common case, skip the per-byte checks
+        UINT32 inverted = ~word;
+        if (((inverted - 0x01010101u) & ~inverted & 0x80808080u) == 0) {
+            out[length] = static_cast<BYTE>(word >> 24);
+            out[length + 1] = static_cast<BYTE>(word >> 16);
+            out[length + 2] = static_cast<BYTE>(word >> 8);
+            out[length + 3] = static_cast<BYTE>(word);
+            length += 4;
+            return;
+        }
+        for (int shift = 24; shift >= 0; shift -= 8) {
+            emitByte(static_cast<BYTE>(word >> shift));
+        }
+    }
+
+public:
+    BitWriter(std::vector<BYTE>& out) : out(out), length(out.size()) {}
+
+    /**
+     * @brief Makes room for bytes more output.
+     */
+    void reserve(size_t bytes) {
+        if (out.size() < length + bytes) out.resize(std::max(out.size() * 2, length + bytes));
+    }
+
+    /// Appends the low bits of value, at most 32 at a time
+    void put(UINT32 value, int bits) {
+        buffer = (buffer << bits) | value;
+        count += bits;
+        if (count >= 32) {
+            count -= 32;
+            emitWord(static_cast<UINT32>(buffer >> count));
+        }
+    }
+
+    /**
+     * @brief Pads the last byte with ones and trims out to the written data.
+     */
+    void finish() {
+        int padding = (8 - count % 8) % 8;
+        put((1u << padding) - 1, padding);
+        while (count >= 8) {
+            count -= 8;
+            emitByte(static_cast<BYTE>(buffer >> count));
+        }
+        out.resize(length);
+    }
+};
+
+/// Number of bits of a coefficient's magnitude, its JPEG size category
+inline int magnitudeBits(int value) {
+    UINT32 magnitude = static_cast<UINT32>(value < 0 ? -value : value);
+    return 32 - std::countl_zero(magnitude);
+}
+
+/// Low bits of a coefficient as JPEG stores them: the value, or value - 1 if negative
+inline UINT32 magnitudeCode(int value, int bits) {
+    return static_cast<UINT32>(value < 0 ? value - 1 : value) & ((1u << bits) - 1);
+}
+
+/**
+ * @brief Loads an 8x8 block of a plane as floats shifted to -128..127.
+ *
+ * Blocks over the right or bottom edge repeat the last column or row.
+ */
+void loadBlock(const BYTE* plane, UINT32 planeWidth, UINT32 planeHeight, UINT32 x, UINT32 y, float* block) {
+#if JPEG_SSE2
+    if (x + 8 <= planeWidth && y + 8 <= planeHeight) {
+        __m128i zero = _mm_setzero_si128();
+        __m128 offset = _mm_set1_ps(128.0f);
+        for (int row = 0; row < 8; row++) {
+            __m128i pixels = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(plane + static_cast<size_t>(y + row) * planeWidth + x));
+            __m128i wide = _mm_unpacklo_epi8(pixels, zero);
+            _mm_store_ps(block + row * 8, _mm_sub_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(wide, zero)), offset));
+            _mm_store_ps(block + row * 8 + 4, _mm_sub_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(wide, zero)), offset));
+        }
+        return;
+    }
+#endif
+
+    for (UINT32 row = 0; row < 8; row++) {
+        const BYTE* line = plane + static_cast<size_t>(std::min(y + row, planeHeight - 1)) * planeWidth;
+        for (UINT32 column = 0; column < 8; column++) {
+            block[row * 8 + column] = line[std::min(x + column, planeWidth - 1)] - 128.0f;
+        }
+    }
+}
+
+#if JPEG_SSE2
+/**
+ * @brief AAN forward DCT along the first index of 8 vectors, i.e. down 4 columns at once.
+ *
+ * Outputs are scaled by AAN_SCALE, which the quantizer divisors compensate for.
+ */
+inline void dct8(__m128* d) {
+    __m128 tmp0 = _mm_add_ps(d[0], d[7]);
+    __m128 tmp7 = _mm_sub_ps(d[0], d[7]);
+    __m128 tmp1 = _mm_add_ps(d[1], d[6]);
+    __m128 tmp6 = _mm_sub_ps(d[1], d[6]);
+    __m128 tmp2 = _mm_add_ps(d[2], d[5]);
+    __m128 tmp5 = _mm_sub_ps(d[2], d[5]);
+    __m128 tmp3 = _mm_add_ps(d[3], d[4]);
+    __m128 tmp4 = _mm_sub_ps(d[3], d[4]);
+
+    // Even part
+    __m128 tmp10 = _mm_add_ps(tmp0, tmp3);
+    __m128 tmp13 = _mm_sub_ps(tmp0, tmp3);
+    __m128 tmp11 = _mm_add_ps(tmp1, tmp2);
+    __m128 tmp12 = _mm_sub_ps(tmp1, tmp2);
+
+    d[0] = _mm_add_ps(tmp10, tmp11);
+    d[4] = _mm_sub_ps(tmp10, tmp11);
+
+    __m128 z1 = _mm_mul_ps(_mm_add_ps(tmp12, tmp13), _mm_set1_ps(0.707106781f));
+    d[2] = _mm_add_ps(tmp13, z1);
+    d[6] = _mm_sub_ps(tmp13, z1);
+
+    // Odd part
+    tmp10 = _mm_add_ps(tmp4, tmp5);
+    tmp11 = _mm_add_ps(tmp5, tmp6);
+    tmp12 = _mm_add_ps(tmp6, tmp7);
+
+    __m128 z5 = _mm_mul_ps(_mm_sub_ps(tmp10, tmp12), _mm_set1_ps(0.382683433f));
+    __m128 z2 = _mm_add_ps(_mm_mul_ps(tmp10, _mm_set1_ps(0.541196100f)), z5);
+    __m128 z4 = _mm_add_ps(_mm_mul_ps(tmp12, _mm_set1_ps(1.306562965f)), z5);
+    __m128 z3 = _mm_mul_ps(tmp11, _mm_set1_ps(0.707106781f));
+
+    __m128 z11 = _mm_add_ps(tmp7, z3);
+    __m128 z13 = _mm_sub_ps(tmp7, z3);
+
+    d[5] = _mm_add_ps(z13, z2);
+    d[3] = _mm_sub_ps(z13, z2);
+    d[1] = _mm_add_ps(z11, z4);
+    d[7] = _mm_sub_ps(z11, z4);
+}
+
+/**
+ * @brief 2-D DCT and quantization of a block.
+ *
+ * The DCT runs down the columns, transposes and runs down the columns again, so
+ * the result is transposed: frequency (u, v) ends up at index v * 8 + u, the
+ * layout divisors and the zigzag scan use.
+ *
+ * @param block Level-shifted samples in row-major order, overwritten
+ * @param divisors Reciprocal quantizers in transposed order
+ * @param coefficients Receives the quantized coefficients in transposed order
+ */
+void transformBlock(float* block, const float* divisors, INT16* coefficients) {
+    __m128 left[8];
+    __m128 right[8];
+    for (int i = 0; i < 8; i++) {
+        left[i] = _mm_load_ps(block + i * 8);
+        right[i] = _mm_load_ps(block + i * 8 + 4);
+    }
+
+    dct8(left);
+    dct8(right);
+
+    // Transposing swaps the off-diagonal 4x4 quarters and transposes each of them
+    _MM_TRANSPOSE4_PS(left[0], left[1], left[2], left[3]);
+    _MM_TRANSPOSE4_PS(right[0], right[1], right[2], right[3]);
+    _MM_TRANSPOSE4_PS(left[4], left[5], left[6], left[7]);
+    _MM_TRANSPOSE4_PS(right[4], right[5], right[6], right[7]);
+    for (int i = 0; i < 4; i++) {
+        std::swap(right[i], left[i + 4]);
+    }
+
+    dct8(left);
+    dct8(right);
+
+    // cvtps rounds to nearest, the quantizer's rounding; baseline Huffman tables end at magnitude 1023
+    __m128i limit = _mm_set1_epi16(1023);
+    __m128i negativeLimit = _mm_set1_epi16(-1023);
+    for (int i = 0; i < 8; i++) {
+        __m128i low = _mm_cvtps_epi32(_mm_mul_ps(left[i], _mm_load_ps(divisors + i * 8)));
+        __m128i high = _mm_cvtps_epi32(_mm_mul_ps(right[i], _mm_load_ps(divisors + i * 8 + 4)));
+        __m128i quantized = _mm_max_epi16(_mm_min_epi16(_mm_packs_epi32(low, high), limit), negativeLimit);
+        _mm_store_si128(reinterpret_cast<__m128i*>(coefficients + i * 8), quantized);
+    }
+}
+#else
+/**
+ * @brief AAN forward DCT of 8 samples stride apart, the same operations dct8 applies to every lane.
+ *
+ * Outputs are scaled by AAN_SCALE, which the quantizer divisors compensate for.
+ */
+inline void dct8(float* d, int stride) {
+    float tmp0 = d[0] + d[7 * stride];
+    float tmp7 = d[0] - d[7 * stride];
+    float tmp1 = d[stride] + d[6 * stride];
+    float tmp6 = d[stride] - d[6 * stride];
+    float tmp2 = d[2 * stride] + d[5 * stride];
+    float tmp5 = d[2 * stride] - d[5 * stride];
+    float tmp3 = d[3 * stride] + d[4 * stride];
+    float tmp4 = d[3 * stride] - d[4 * stride];
+
+    // Even part
+    float tmp10 = tmp0 + tmp3;
+    float tmp13 = tmp0 - tmp3;
+    float tmp11 = tmp1 + tmp2;
+    float tmp12 = tmp1 - tmp2;
+
+    d[0] = tmp10 + tmp11;
+    d[4 * stride] = tmp10 - tmp11;
+
+    float z1 = (tmp12 + tmp13) * 0.707106781f;
+    d[2 * stride] = tmp13 + z1;
+    d[6 * stride] = tmp13 - z1;
+
+    // Odd part
+    tmp10 = tmp4 + tmp5;
+    tmp11 = tmp5 + tmp6;
+    tmp12 = tmp6 + tmp7;
+
+    float z5 = (tmp10 - tmp12) * 0.382683433f;
+    float z2 = tmp10 * 0.541196100f + z5;
+    float z4 = tmp12 * 1.306562965f + z5;
+    float z3 = tmp11 * 0.707106781f;
+
+    float z11 = tmp7 + z3;
+    float z13 = tmp7 - z3;
+
+    d[5 * stride] = z13 + z2;
+    d[3 * stride] = z13 - z2;
+    d[stride] = z11 + z4;
+    d[7 * stride] = z11 - z4;
+}
+
+/**
+ * @brief 2-D DCT and quantization of a block, producing the same coefficients as the SSE2 version.
+ * @param block Level-shifted samples in row-major order, overwritten
+ * @param divisors Reciprocal quantizers in transposed order
+ * @param coefficients Receives the quantized coefficients in transposed order
+ */
+void transformBlock(float* block, const float* divisors, INT16* coefficients) {
+    for (int column = 0; column < 8; column++) {
+        dct8(block + column, 8);
+    }
+    for (int row = 0; row < 8; row++) {
+        dct8(block + row * 8, 1);
+    }
+
+    // lrint rounds to nearest like cvtps; baseline Huffman tables end at magnitude 1023
+    for (int v = 0; v < 8; v++) {
+        for (int u = 0; u < 8; u++) {
+            long quantized = std::lrint(block[v * 8 + u] * divisors[u * 8 + v]);
+            coefficients[u * 8 + v] = static_cast<INT16>(std::clamp(quantized, -1023L, 1023L));
+        }
+    }
+}
+#endif
+
+/**
+ * @brief Huffman-codes a block of quantized coefficients.
+ * @param coefficients Quantized coefficients in transposed order
+ * @param lastDc DC coefficient of the component's previous block, updated
+ */
+void encodeBlock(BitWriter& writer, const INT16* coefficients, int& lastDc, const HuffmanCodes& dc,
+                 const HuffmanCodes& ac) {
+    // Zigzag order in a transposed block
+    static const auto transposedZigzag = [] {
+        std::array<BYTE, 64> order{};
+        for (int i = 0; i < 64; i++) {
+            order[i] = static_cast<BYTE>((ZIGZAG[i] % 8) * 8 + ZIGZAG[i] / 8);
+        }
+        return order;
+    }();
+
+    alignas(16) INT16 scan[64];
+    for (int i = 0; i < 64; i++) {
+        scan[i] = coefficients[transposedZigzag[i]];
+    }
+
+    int diff = scan[0] - lastDc;
+    lastDc = scan[0];
+    int bits = magnitudeBits(diff);
+    writer.put((static_cast<UINT32>(dc.code[bits]) << bits) | magnitudeCode(diff, bits), dc.length[bits] + bits);
+
+    // Bit i set for every nonzero AC coefficient, so runs of zeros are skipped with a bit scan
+    UINT64 nonzero = 0;
+#if JPEG_SSE2
+    __m128i zero = _mm_setzero_si128();
+    for (int i = 0; i < 64; i += 16) {
+        __m128i first = _mm_cmpeq_epi16(_mm_load_si128(reinterpret_cast<const __m128i*>(scan + i)), zero);
+        __m128i second = _mm_cmpeq_epi16(_mm_load_si128(reinterpret_cast<const __m128i*>(scan + i + 8)), zero);
+        UINT64 zeros = static_cast<UINT32>(_mm_movemask_epi8(_mm_packs_epi16(first, second)));
+        nonzero |= (~zeros & 0xFFFF) << i;
+    }
+#else
+    for (int i = 0; i < 64; i++) {
+        if (scan[i] != 0) nonzero |= 1ULL << i;
+    }
+#endif
+    nonzero &= ~1ULL;
+
+    int last = 0;
+    while (nonzero) {
+        int index = std::countr_zero(nonzero);
+        nonzero &= nonzero - 1;
+
+        int run = index - last - 1;
+        while (run >= 16) {
+            writer.put(ac.code[0xF0], ac.length[0xF0]);
+            run -= 16;
+        }
+
+        int value = scan[index];
+        bits = magnitudeBits(value);
+        int symbol = (run << 4) | bits;
+        writer.put((static_cast<UINT32>(ac.code[symbol]) << bits) | magnitudeCode(value, bits), ac.length[symbol] + bits);
+        last = index;
+    }
+
+    if (last != 63) writer.put(ac.code[0x00], ac.length[0x00]);
+}
+
+void putMarker(std::vector<BYTE>& out, BYTE marker, size_t length) {
+    out.push_back(0xFF);
+    out.push_back(marker);
+    out.push_back(static_cast<BYTE>(length >> 8));
+    out.push_back(static_cast<BYTE>(length));
+}
+
+void putHuffmanTable(std::vector<BYTE>& out, BYTE tableClassAndId, const BYTE* bits, const BYTE* values) {
+    size_t count = 0;
+    for (int i = 0; i < 16; i++) {
+        count += bits[i];
+    }
+    out.push_back(tableClassAndId);
+    out.insert(out.end(), bits, bits + 16);
+    out.insert(out.end(), values, values + count);
+}
+
+}  // namespace
+
+void JpegEncoder::buildTables(int quality) {
+    // libjpeg's quality scaling of the Annex K tables
+    int scale = quality < 50 ? 5000 / quality : 200 - 2 * quality;
+    const BYTE* bases[2] = {BASE_LUMA_QUANT, BASE_CHROMA_QUANT};
+
+    for (int table = 0; table < 2; table++) {
+        BYTE natural[64];
+        for (int i = 0; i < 64; i++) {
+            natural[i] = static_cast<BYTE>(std::clamp((bases[table][i] * scale + 50) / 100, 1, 255));
+        }
+        for (int i = 0; i < 64; i++) {
+            quantTables[table][i] = natural[ZIGZAG[i]];
+        }
+
+        // Index v * 8 + u holds frequency (u, v); the DCT output still carries its AAN scale and a factor of 8
+        for (int v = 0; v < 8; v++) {
+            for (int u = 0; u < 8; u++) {
+                scaledDivisors[table][v * 8 + u] = 1.0f / (natural[u * 8 + v] * AAN_SCALE[u] * AAN_SCALE[v] * 8.0f);
+            }
+        }
+    }
+    tableQuality = quality;
+}
+
+void JpegEncoder::writeHeaders(std::vector<BYTE>& out, UINT32 width, UINT32 height) const {
+    // Start of image, then a JFIF header without thumbnail at 1:1 pixel aspect
+    out.push_back(0xFF);
+    out.push_back(0xD8);
+    putMarker(out, 0xE0, 16);
+    const BYTE jfif[] = {'J', 'F', 'I', 'F', 0, 1, 1, 0, 0, 1, 0, 1, 0, 0};
+    out.insert(out.end(), jfif, jfif + sizeof(jfif));
+
+    putMarker(out, 0xDB, 2 + 2 * 65);
+    for (int table = 0; table < 2; table++) {
+        out.push_back(static_cast<BYTE>(table));
+        out.insert(out.end(), quantTables[table], quantTables[table] + 64);
+    }
+
+    // Baseline frame: Y sampled 2x2 against Cb and Cr
+    putMarker(out, 0xC0, 17);
+    const BYTE frame[] = {8, static_cast<BYTE>(height >> 8), static_cast<BYTE>(height), static_cast<BYTE>(width >> 8),
+                          static_cast<BYTE>(width), 3, 1, 0x22, 0, 2, 0x11, 1, 3, 0x11, 1};
+    out.insert(out.end(), frame, frame + sizeof(frame));
+
+    putMarker(out, 0xC4, 2 + 4 * 17 + 2 * 12 + 2 * 162);
+    putHuffmanTable(out, 0x00, DC_LUMA_BITS, DC_LUMA_VALUES);
+    putHuffmanTable(out, 0x10, AC_LUMA_BITS, AC_LUMA_VALUES);
+    putHuffmanTable(out, 0x01, DC_CHROMA_BITS, DC_CHROMA_VALUES);
+    putHuffmanTable(out, 0x11, AC_CHROMA_BITS, AC_CHROMA_VALUES);
+
+    putMarker(out, 0xDA, 12);
+    const BYTE scan[] = {3, 1, 0x00, 2, 0x11, 3, 0x11, 0, 63, 0};
+    out.insert(out.end(), scan, scan + sizeof(scan));
+}
+
+bool JpegEncoder::encode(const BYTE* bgr, UINT32 width, UINT32 height, int quality, std::vector<BYTE>& out) {
+    if (!bgr || width == 0 || height == 0 || width > 0xFFFF || height > 0xFFFF) return false;
+
+    static const HuffmanTables huffman;
+
+    quality = std::clamp(quality, 1, 100);
+    if (quality != tableQuality) buildTables(quality);
+
+    planes.resize(i420FrameSize(width, height));
+    convertBgrToI420(bgr, width, height, planes.data(), YuvRange::FULL);
+
+    UINT32 chromaWidth = (width + 1) / 2;
+    UINT32 chromaHeight = (height + 1) / 2;
+    const BYTE* yPlane = planes.data();
+    const BYTE* uPlane = yPlane + static_cast<size_t>(width) * height;
+    const BYTE* vPlane = uPlane + static_cast<size_t>(chromaWidth) * chromaHeight;
+
+    out.clear();
+    writeHeaders(out, width, height);
+
+    BitWriter writer(out);
+    alignas(16) float block[64];
+    alignas(16) INT16 coefficients[64];
+    int lastDc[3] = {};
+
+    // Each 16x16 MCU holds four luma blocks followed by one block of each chroma plane
+    UINT32 mcuColumns = (width + 15) / 16;
+    UINT32 mcuRows = (height + 15) / 16;
+    for (UINT32 mcuY = 0; mcuY < mcuRows; mcuY++) {
+        writer.reserve(static_cast<size_t>(mcuColumns) * 6 * MAX_BLOCK_BYTES);
+
+        for (UINT32 mcuX = 0; mcuX < mcuColumns; mcuX++) {
+            for (UINT32 i = 0; i < 4; i++) {
+                loadBlock(yPlane, width, height, mcuX * 16 + (i & 1) * 8, mcuY * 16 + (i >> 1) * 8, block);
+                transformBlock(block, scaledDivisors[0], coefficients);
+                encodeBlock(writer, coefficients, lastDc[0], huffman.dc[0], huffman.ac[0]);
+            }
+
+            loadBlock(uPlane, chromaWidth, chromaHeight, mcuX * 8, mcuY * 8, block);
+            transformBlock(block, scaledDivisors[1], coefficients);
+            encodeBlock(writer, coefficients, lastDc[1], huffman.dc[1], huffman.ac[1]);
+
+            loadBlock(vPlane, chromaWidth, chromaHeight, mcuX * 8, mcuY * 8, block);
+            transformBlock(block, scaledDivisors[1], coefficients);
+            encodeBlock(writer, coefficients, lastDc[2], huffman.dc[1], huffman.ac[1]);
+        }
+    }
+
+    writer.finish();
+    out.push_back(0xFF);
+    out.push_back(0xD9);
+    return true;
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+//clang-format off
+#include <windows.h>
+//clang-format on
+
+#include <vector>
+
+/// Quality snapshots are encoded at unless configured otherwise, high enough to keep finger edges sharp
+constexpr int JPEG_DEFAULT_QUALITY = 95;
+
+/**
+ * @brief Baseline JPEG (JFIF) encoder for BGR24 frames.
+ *
+ * Frames are converted to full-range YCbCr 4:2:0 with convertBgrToI420(), then
+ * each 8x8 block goes through a float AAN forward DCT on SSE, quantization with
+ * the Annex K tables scaled like libjpeg's quality setting, and Huffman coding
+ * with the standard Annex K tables, so a quality means the same as in libjpeg
+ * and OpenCV. The output decodes with any JPEG reader.
+ *
+ * Keeps its working buffers between frames; not thread-safe, use one encoder per thread.
+ */
+class JpegEncoder {
+private:
+    int tableQuality = 0;                     /// Quality the tables below were built for, 0 before the first frame
+    BYTE quantTables[2][64];                  /// Luma and chroma quantizers in zigzag order, as stored in the file
+    alignas(16) float scaledDivisors[2][64];  /// Reciprocal quantizers with the DCT scaling folded in, in DCT output order
+    std::vector<BYTE> planes;                 /// Frame being encoded in full-range I420
+
+    /**
+     * @brief Builds the quantization tables for a quality of 1..100.
+     */
+    void buildTables(int quality);
+
+    /**
+     * @brief Appends the markers and tables in front of the entropy-coded data.
+     */
+    void writeHeaders(std::vector<BYTE>& out, UINT32 width, UINT32 height) const;
+
+public:
+    /**
+     * @brief Encodes a BGR24 frame.
+     * @param quality 1..100 on libjpeg's scale, clamped
+     * @param out Receives the JPEG file
+     * @return false if the frame is empty or larger than 65535 pixels in either dimension
+     */
+    bool encode(const BYTE* bgr, UINT32 width, UINT32 height, int quality, std::vector<BYTE>& out);
+};
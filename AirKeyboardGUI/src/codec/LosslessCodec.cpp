@@ -0,0 +1,617 @@
+#include "LosslessCodec.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#include <emmintrin.h>
+#define LOSSLESS_SSE2 1
+#endif
+
+namespace {
+
+/// Unary prefixes this long are followed by the sample's 8 bits instead of its remainder
+constexpr int ESCAPE_LENGTH = 24;
+
+/// Block parameter marking a block of zero residuals, which has no further bits
+constexpr UINT32 ZERO_BLOCK = 8;
+
+/// Block parameter marking a block that codes only its nonzero residuals, see encodeResiduals()
+constexpr UINT32 SPARSE_BLOCK = 9;
+
+/// Bits of every block's parameter
+constexpr int PARAMETER_BITS = 4;
+
+/// Bits of the nonzero count of a sparse block, which has fewer than LOSSLESS_BLOCK_SIZE
+constexpr int SPARSE_COUNT_BITS = 6;
+
+/// Rice parameter of the distances between the nonzero residuals of a sparse block
+constexpr int SPARSE_GAP_PARAMETER = 2;
+
+/**
+ * @brief Median edge detector: picks the left or upper neighbour across an edge, else the gradient.
+ *
+ * Written as the gradient clamped between the neighbours, which is the same
+ * choice without branches that mispredict on noisy frames.
+ */
+inline BYTE predictMed(BYTE left, BYTE up, BYTE upLeft) {
+    int high = std::max(left, up);
+    int low = std::min(left, up);
+    return static_cast<BYTE>(std::clamp(left + up - upLeft, low, high));
+}
+
+/// Maps residuals around zero to small codes: 0, -1, 1, -2, ... become 0, 1, 2, 3, ...
+inline UINT32 zigzag(BYTE residual) {
+    INT8 value = static_cast<INT8>(residual);
+    return static_cast<BYTE>((value << 1) ^ (value >> 7));
+}
+
+inline BYTE unzigzag(UINT32 code) {
+    return static_cast<BYTE>((code >> 1) ^ (0u - (code & 1)));
+}
+
+/**
+ * @brief Extracts plane p of the G, B-G, R-G decorrelation from interleaved BGR24.
+ *
+ * Green carries most of the detail; blue and red relative to it are mostly flat.
+ */
+void extractPlane(const BYTE* bgr, size_t pixels, int p, BYTE* plane) {
+    if (p == 0) {
+        for (size_t i = 0; i < pixels; i++) {
+            plane[i] = bgr[i * 3 + 1];
+        }
+        return;
+    }
+
+    // B-G for plane 1, R-G for plane 2
+    size_t channel = p == 1 ? 0 : 2;
+    for (size_t i = 0; i < pixels; i++) {
+        plane[i] = static_cast<BYTE>(bgr[i * 3 + channel] - bgr[i * 3 + 1]);
+    }
+}
+
+/**
+ * @brief Computes the difference of every sample to the same sample of the reference frame.
+ */
+void predictTemporal(const BYTE* plane, const BYTE* reference, size_t pixels, BYTE* residuals) {
+    for (size_t i = 0; i < pixels; i++) {
+        residuals[i] = static_cast<BYTE>(plane[i] - reference[i]);
+    }
+}
+
+/**
+ * @brief Computes the prediction residual of every sample of a plane.
+ */
+void predictPlane(const BYTE* plane, UINT32 width, UINT32 height, BYTE* residuals) {
+    // The first row only has left neighbours, the first column only upper ones
+    residuals[0] = plane[0];
+    for (UINT32 x = 1; x < width; x++) {
+        residuals[x] = static_cast<BYTE>(plane[x] - plane[x - 1]);
+    }
+
+    for (UINT32 y = 1; y < height; y++) {
+        const BYTE* row = plane + static_cast<size_t>(y) * width;
+        const BYTE* up = row - width;
+        BYTE* out = residuals + static_cast<size_t>(y) * width;
+
+        out[0] = static_cast<BYTE>(row[0] - up[0]);
+        UINT32 x = 1;
+
+#if LOSSLESS_SSE2
+        // Every neighbour is an original sample, so a whole row can be predicted at once
+        for (; x + 16 <= width; x += 16) {
+            __m128i value = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + x));
+            __m128i left = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + x - 1));
+            __m128i upper = _mm_loadu_si128(reinterpret_cast<const __m128i*>(up + x));
+            __m128i upLeft = _mm_loadu_si128(reinterpret_cast<const __m128i*>(up + x - 1));
+
+            __m128i high = _mm_max_epu8(left, upper);
+            __m128i low = _mm_min_epu8(left, upper);
+            __m128i gradient = _mm_sub_epi8(_mm_add_epi8(left, upper), upLeft);
+
+            __m128i aboveHigh = _mm_cmpeq_epi8(_mm_max_epu8(upLeft, high), upLeft);
+            __m128i belowLow = _mm_cmpeq_epi8(_mm_min_epu8(upLeft, low), upLeft);
+
+            __m128i prediction = _mm_or_si128(_mm_and_si128(belowLow, high), _mm_andnot_si128(belowLow, gradient));
+            prediction = _mm_or_si128(_mm_and_si128(aboveHigh, low), _mm_andnot_si128(aboveHigh, prediction));
+
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + x), _mm_sub_epi8(value, prediction));
+        }
+#endif
+
+        for (; x < width; x++) {
+            out[x] = static_cast<BYTE>(row[x] - predictMed(row[x - 1], up[x], up[x - 1]));
+        }
+    }
+}
+
+/**
+ * @brief Rebuilds a plane from its residuals.
+ */
+void reconstructPlane(const BYTE* residuals, UINT32 width, UINT32 height, BYTE* plane) {
+    plane[0] = residuals[0];
+    for (UINT32 x = 1; x < width; x++) {
+        plane[x] = static_cast<BYTE>(residuals[x] + plane[x - 1]);
+    }
+
+    for (UINT32 y = 1; y < height; y++) {
+        BYTE* row = plane + static_cast<size_t>(y) * width;
+        const BYTE* up = row - width;
+        const BYTE* in = residuals + static_cast<size_t>(y) * width;
+
+        // Each sample depends on the previous one; keeping it in a register shortens that chain
+        BYTE left = static_cast<BYTE>(in[0] + up[0]);
+        row[0] = left;
+        for (UINT32 x = 1; x < width; x++) {
+            left = static_cast<BYTE>(in[x] + predictMed(left, up[x], up[x - 1]));
+            row[x] = left;
+        }
+    }
+}
+
+/**
+ * @brief Rebuilds a plane whose blocks were predicted either spatially or from the reference plane.
+ * @param temporal Per block of LOSSLESS_BLOCK_SIZE samples, nonzero if it was predicted from reference
+ */
+void reconstructPlaneMixed(const BYTE* residuals, const BYTE* temporal, const BYTE* reference, UINT32 width,
+                           UINT32 height, BYTE* plane) {
+    for (UINT32 y = 0; y < height; y++) {
+        size_t rowStart = static_cast<size_t>(y) * width;
+        BYTE* row = plane + rowStart;
+        const BYTE* up = row - width;
+
+        for (UINT32 x = 0; x < width; x++) {
+            size_t i = rowStart + x;
+            BYTE prediction;
+            if (temporal[i / LOSSLESS_BLOCK_SIZE]) {
+                prediction = reference[i];
+            } else if (y == 0) {
+                prediction = x == 0 ? 0 : row[x - 1];
+            } else if (x == 0) {
+                prediction = up[0];
+            } else {
+                prediction = predictMed(row[x - 1], up[x], up[x - 1]);
+            }
+            row[x] = static_cast<BYTE>(residuals[i] + prediction);
+        }
+    }
+}
+
+/// Packs codes least significant bit first
+class BitWriter {
+private:
+    BYTE* out;
+    size_t capacity;
+    size_t position = 0;
+    UINT64 pending = 0;
+    int pendingBits = 0;
+
+public:
+    BitWriter(BYTE* out, size_t capacity) : out(out), capacity(capacity) {}
+
+    /**
+     * @brief Appends the low count bits of value, count at most 32.
+     */
+    void put(UINT32 value, int count) {
+        pending |= static_cast<UINT64>(value) << pendingBits;
+        pendingBits += count;
+        if (pendingBits >= 32) {
+            if (position + 4 <= capacity) {
+                UINT32 word = static_cast<UINT32>(pending);
+                memcpy(out + position, &word, sizeof(word));
+            }
+            position += 4;
+            pending >>= 32;
+            pendingBits -= 32;
+        }
+    }
+
+    /**
+     * @brief Writes the remaining bits.
+     * @return Bytes written, or more than the capacity if the output didn't fit
+     */
+    size_t finish() {
+        while (pendingBits > 0) {
+            if (position < capacity) {
+                out[position] = static_cast<BYTE>(pending);
+            }
+            position++;
+            pending >>= 8;
+            pendingBits -= 8;
+        }
+        pendingBits = 0;
+        return position;
+    }
+
+    size_t size() const {
+        return position;
+    }
+};
+
+/// Reads codes written by BitWriter; bits past the end read as zero
+class BitReader {
+private:
+    const BYTE* data;
+    size_t size;
+    size_t position = 0;
+    UINT64 buffer = 0;
+    int bufferBits = 0;
+
+public:
+    BitReader(const BYTE* data, size_t size) : data(data), size(size) {}
+
+    /**
+     * @brief Makes at least 32 bits available to peek().
+     */
+    void refill() {
+        while (bufferBits <= 32) {
+            UINT64 word = 0;
+            if (position + 4 <= size) {
+                UINT32 value;
+                memcpy(&value, data + position, sizeof(value));
+                word = value;
+            } else {
+                for (size_t i = 0; position + i < size && i < 4; i++) {
+                    word |= static_cast<UINT64>(data[position + i]) << (8 * i);
+                }
+            }
+            buffer |= word << bufferBits;
+            bufferBits += 32;
+            position += 4;
+        }
+    }
+
+    UINT32 peek() const {
+        return static_cast<UINT32>(buffer);
+    }
+
+    void skip(int count) {
+        buffer >>= count;
+        bufferBits -= count;
+    }
+
+    UINT32 get(int count) {
+        UINT32 value = static_cast<UINT32>(buffer) & ((1u << count) - 1);
+        skip(count);
+        return value;
+    }
+
+    /**
+     * @brief Whether reading went past the end of the data.
+     */
+    bool overran() const {
+        // position counts whole words read ahead, bufferBits of which are still unread
+        return position * 8 - bufferBits > size * 8;
+    }
+};
+
+/**
+ * @brief Bits of the Rice code of a value below 256.
+ */
+inline UINT32 riceLength(UINT32 code, int k) {
+    UINT32 quotient = code >> k;
+    return quotient >= ESCAPE_LENGTH ? ESCAPE_LENGTH + 8 : quotient + 1 + k;
+}
+
+/**
+ * @brief Writes the Rice code of a value below 256.
+ */
+inline void putRice(BitWriter& writer, UINT32 code, int k) {
+    int quotient = static_cast<int>(code >> k);
+    if (quotient >= ESCAPE_LENGTH) {
+        writer.put((1u << ESCAPE_LENGTH) - 1, ESCAPE_LENGTH);
+        writer.put(code, 8);
+    } else {
+        // quotient ones, a terminating zero, then the k low bits
+        UINT32 remainder = code & ((1u << k) - 1);
+        writer.put(((1u << quotient) - 1) | (remainder << (quotient + 1)), quotient + 1 + k);
+    }
+}
+
+/**
+ * @brief Reads a Rice code; at least 32 bits must be buffered.
+ */
+inline UINT32 getRice(BitReader& reader, int k) {
+    int quotient = std::countr_one(reader.peek());
+    if (quotient >= ESCAPE_LENGTH) {
+        reader.skip(ESCAPE_LENGTH);
+        return reader.get(8);
+    }
+    reader.skip(quotient + 1);
+    return (static_cast<UINT32>(quotient) << k) | reader.get(k);
+}
+
+/**
+ * @brief The Rice parameter that makes the remainder about as large as the average of count codes.
+ */
+inline int riceParameter(UINT32 sum, UINT32 count) {
+    int k = 0;
+    while (k < 7 && (count << (k + 1)) <= sum) k++;
+    return k;
+}
+
+/**
+ * @brief Rice-codes the residuals of a plane.
+ * @param temporal Residuals of the prediction from the reference frame, or nullptr; every block
+ *                 then starts with a bit selecting the cheaper of the two
+ * @param usedTemporal Set if any block selected the temporal residuals, or nullptr
+ * @return Bytes written, or more than capacity if the plane doesn't shrink
+ *
+ * Blocks with few nonzero residuals, common where the reference predicts a static
+ * background, code only those: the zeros skipped before each and its value.
+ */
+size_t encodeResiduals(const BYTE* residuals, const BYTE* temporal, size_t count, BYTE* out, size_t capacity,
+                       bool* usedTemporal = nullptr) {
+    BitWriter writer(out, capacity);
+
+    for (size_t start = 0; start < count; start += LOSSLESS_BLOCK_SIZE) {
+        // Give up as soon as the plane would be larger than stored raw
+        if (writer.size() > capacity) return writer.size();
+
+        size_t end = std::min(count, start + LOSSLESS_BLOCK_SIZE);
+        UINT32 codes[LOSSLESS_BLOCK_SIZE];
+        UINT32 sum = 0;
+        for (size_t i = start; i < end; i++) {
+            codes[i - start] = zigzag(residuals[i]);
+            sum += codes[i - start];
+        }
+
+        // The sum of the codes approximates the coded size, so it picks the predictor too
+        if (temporal) {
+            UINT32 temporalCodes[LOSSLESS_BLOCK_SIZE];
+            UINT32 temporalSum = 0;
+            for (size_t i = start; i < end; i++) {
+                temporalCodes[i - start] = zigzag(temporal[i]);
+                temporalSum += temporalCodes[i - start];
+            }
+
+            bool useTemporal = temporalSum < sum;
+            writer.put(useTemporal ? 1 : 0, 1);
+            if (useTemporal) {
+                memcpy(codes, temporalCodes, sizeof(codes));
+                sum = temporalSum;
+                if (usedTemporal) *usedTemporal = true;
+            }
+        }
+
+        if (sum == 0) {
+            writer.put(ZERO_BLOCK, PARAMETER_BITS);
+            continue;
+        }
+
+        UINT32 length = static_cast<UINT32>(end - start);
+        int k = riceParameter(sum, length);
+
+        // Compare the exact sizes of the dense and the sparse coding; nonzero codes are coded minus one
+        UINT32 denseBits = 0;
+        UINT32 nonzero = 0;
+        for (UINT32 i = 0; i < length; i++) {
+            denseBits += riceLength(codes[i], k);
+            nonzero += codes[i] != 0;
+        }
+
+        int sparseK = 0;
+        UINT32 sparseBits = UINT32_MAX;
+        if (nonzero < LOSSLESS_BLOCK_SIZE) {
+            sparseK = riceParameter(sum - nonzero, nonzero);
+            sparseBits = SPARSE_COUNT_BITS + 3;
+            UINT32 gap = 0;
+            for (UINT32 i = 0; i < length; i++) {
+                if (codes[i] == 0) {
+                    gap++;
+                    continue;
+                }
+                sparseBits += riceLength(gap, SPARSE_GAP_PARAMETER) + riceLength(codes[i] - 1, sparseK);
+                gap = 0;
+            }
+        }
+
+        if (sparseBits < denseBits) {
+            writer.put(SPARSE_BLOCK, PARAMETER_BITS);
+            writer.put(nonzero, SPARSE_COUNT_BITS);
+            writer.put(sparseK, 3);
+
+            UINT32 gap = 0;
+            for (UINT32 i = 0; i < length; i++) {
+                if (codes[i] == 0) {
+                    gap++;
+                    continue;
+                }
+                putRice(writer, gap, SPARSE_GAP_PARAMETER);
+                putRice(writer, codes[i] - 1, sparseK);
+                gap = 0;
+            }
+            continue;
+        }
+
+        writer.put(k, PARAMETER_BITS);
+        for (UINT32 i = 0; i < length; i++) {
+            putRice(writer, codes[i], k);
+        }
+    }
+
+    return writer.finish();
+}
+
+/**
+ * @brief Decodes the residuals of a plane.
+ * @param temporal Receives the predictor bit of every block of a plane coded with a reference, or nullptr
+ * @return false if the data is damaged
+ */
+bool decodeResiduals(const BYTE* data, size_t size, BYTE* residuals, size_t count, BYTE* temporal) {
+    BitReader reader(data, size);
+
+    for (size_t start = 0; start < count; start += LOSSLESS_BLOCK_SIZE) {
+        size_t end = std::min(count, start + LOSSLESS_BLOCK_SIZE);
+
+        reader.refill();
+        if (temporal) {
+            temporal[start / LOSSLESS_BLOCK_SIZE] = static_cast<BYTE>(reader.get(1));
+        }
+        UINT32 k = reader.get(PARAMETER_BITS);
+        if (k == ZERO_BLOCK) {
+            memset(residuals + start, 0, end - start);
+            continue;
+        }
+
+        if (k == SPARSE_BLOCK) {
+            memset(residuals + start, 0, end - start);
+            UINT32 nonzero = reader.get(SPARSE_COUNT_BITS);
+            int sparseK = static_cast<int>(reader.get(3));
+
+            size_t position = start;
+            for (UINT32 n = 0; n < nonzero; n++) {
+                reader.refill();
+                position += getRice(reader, SPARSE_GAP_PARAMETER);
+                reader.refill();
+                UINT32 code = getRice(reader, sparseK) + 1;
+                if (position >= end || code > 255) return false;
+
+                residuals[position++] = unzigzag(code);
+            }
+            continue;
+        }
+        if (k > 7) return false;
+
+        for (size_t i = start; i < end; i++) {
+            reader.refill();
+            UINT32 code = getRice(reader, static_cast<int>(k));
+            if (code > 255) return false;
+
+            residuals[i] = unzigzag(code);
+        }
+    }
+
+    return !reader.overran();
+}
+
+}  // namespace
+
+size_t losslessMaxEncodedSize(UINT32 width, UINT32 height) {
+    return sizeof(LosslessFrameHeader) + static_cast<size_t>(width) * height * 3;
+}
+
+bool readLosslessHeader(const BYTE* data, size_t size, LosslessFrameHeader& header) {
+    if (size < sizeof(header)) return false;
+    memcpy(&header, data, sizeof(header));
+
+    // Version 1 frames are the same without temporal planes
+    if (header.magic != LOSSLESS_MAGIC || header.version < 1 || header.version > LOSSLESS_VERSION) return false;
+
+    UINT64 payload = 0;
+    for (UINT32 planeBytes : header.planeBytes) {
+        payload += planeBytes;
+    }
+    return payload <= size - sizeof(header);
+}
+
+bool losslessNeedsReference(const LosslessFrameHeader& header) {
+    return (header.planeFlags & LOSSLESS_TEMPORAL_PLANES) != 0;
+}
+
+size_t LosslessEncoder::encode(const BYTE* bgr, UINT32 width, UINT32 height, std::vector<BYTE>& out,
+                               const BYTE* reference) {
+    size_t pixels = static_cast<size_t>(width) * height;
+    plane.resize(pixels);
+    residuals.resize(pixels);
+    if (reference) {
+        referencePlane.resize(pixels);
+        temporalResiduals.resize(pixels);
+    }
+
+    out.resize(losslessMaxEncodedSize(width, height));
+
+    LosslessFrameHeader header = {};
+    header.magic = LOSSLESS_MAGIC;
+    header.version = LOSSLESS_VERSION;
+    header.width = width;
+    header.height = height;
+
+    size_t offset = sizeof(header);
+    for (int p = 0; p < 3; p++) {
+        extractPlane(bgr, pixels, p, plane.data());
+        predictPlane(plane.data(), width, height, residuals.data());
+
+        // Against a static background the previous frame predicts far better than the neighbours,
+        // while a moving hand is better predicted spatially, so the choice is made per block
+        const BYTE* temporal = nullptr;
+        if (reference) {
+            extractPlane(reference, pixels, p, referencePlane.data());
+            predictTemporal(plane.data(), referencePlane.data(), pixels, temporalResiduals.data());
+            temporal = temporalResiduals.data();
+        }
+
+        bool usedTemporal = false;
+        size_t written = encodeResiduals(residuals.data(), temporal, pixels, out.data() + offset, pixels, &usedTemporal);
+
+        // A plane with every block predicted spatially is coded again without the predictor bits,
+        // so the frame only needs its reference, and becomes a delta, when a block actually used it
+        if (temporal && !usedTemporal) {
+            written = encodeResiduals(residuals.data(), nullptr, pixels, out.data() + offset, pixels);
+        }
+
+        if (written >= pixels) {
+            memcpy(out.data() + offset, plane.data(), pixels);
+            written = pixels;
+            header.planeFlags |= LOSSLESS_RAW_PLANE << p;
+        } else if (usedTemporal) {
+            header.planeFlags |= LOSSLESS_TEMPORAL_PLANE << p;
+        }
+
+        header.planeBytes[p] = static_cast<UINT32>(written);
+        offset += written;
+    }
+
+    memcpy(out.data(), &header, sizeof(header));
+    out.resize(offset);
+    return offset;
+}
+
+bool LosslessDecoder::decode(const BYTE* data, size_t size, BYTE* bgr, size_t bgrSize, const BYTE* reference) {
+    LosslessFrameHeader header;
+    if (!readLosslessHeader(data, size, header)) return false;
+    if (losslessNeedsReference(header) && !reference) return false;
+
+    size_t pixels = static_cast<size_t>(header.width) * header.height;
+    if (pixels == 0 || bgrSize < pixels * 3) return false;
+
+    for (auto& plane : planes) {
+        plane.resize(pixels);
+    }
+    residuals.resize(pixels);
+    if (reference) {
+        referencePlane.resize(pixels);
+        temporalBlocks.resize((pixels + LOSSLESS_BLOCK_SIZE - 1) / LOSSLESS_BLOCK_SIZE);
+    }
+
+    const BYTE* planeData = data + sizeof(header);
+    for (int p = 0; p < 3; p++) {
+        BYTE* plane = planes[p].data();
+        if (header.planeFlags & (LOSSLESS_RAW_PLANE << p)) {
+            if (header.planeBytes[p] != pixels) return false;
+            memcpy(plane, planeData, pixels);
+        } else if (header.planeFlags & (LOSSLESS_TEMPORAL_PLANE << p)) {
+            if (!decodeResiduals(planeData, header.planeBytes[p], residuals.data(), pixels, temporalBlocks.data())) {
+                return false;
+            }
+            extractPlane(reference, pixels, p, referencePlane.data());
+            reconstructPlaneMixed(residuals.data(), temporalBlocks.data(), referencePlane.data(), header.width,
+                                  header.height, plane);
+        } else {
+            if (!decodeResiduals(planeData, header.planeBytes[p], residuals.data(), pixels, nullptr)) return false;
+            reconstructPlane(residuals.data(), header.width, header.height, plane);
+        }
+        planeData += header.planeBytes[p];
+    }
+
+    // reference may be bgr itself, so it is only overwritten once every plane is decoded
+    for (size_t i = 0; i < pixels; i++) {
+        BYTE g = planes[0][i];
+        bgr[i * 3] = static_cast<BYTE>(planes[1][i] + g);
+        bgr[i * 3 + 1] = g;
+        bgr[i * 3 + 2] = static_cast<BYTE>(planes[2][i] + g);
+    }
+
+    return true;
+}
@@ -0,0 +1,133 @@
+#pragma once
+
+//clang-format off
+#include <windows.h>
+//clang-format on
+
+#include <vector>
+
+/**
+ * Lossless codec for the BGR24 frames FrameLogger stores.
+ *
+ * Encoding decorrelates the colour channels into G, B-G and R-G planes, predicts
+ * every sample from its left, upper and upper-left neighbours with the median
+ * edge detector of LOCO-I and Rice-codes the prediction residuals in blocks of
+ * LOSSLESS_BLOCK_SIZE, each with its own parameter. Planes that don't shrink are
+ * stored as they are, so an encoded frame is never more than a header larger
+ * than the raw one.
+ *
+ * Given a reference frame, usually the previous one, every block of residuals
+ * may instead hold the differences to the same samples of the reference, when
+ * that is cheaper; decoding such a frame needs the same reference.
+ *
+ * The residuals are computed 16 samples at a time with SSE2; decoding has to
+ * reconstruct sample by sample.
+ */
+
+/// "AKLC" in little-endian byte order
+constexpr UINT32 LOSSLESS_MAGIC = 0x434C4B41;
+
+/// Current bitstream version; version 1 had no temporal planes
+constexpr UINT16 LOSSLESS_VERSION = 2;
+
+/// LosslessFrameHeader::planeFlags bit, shifted by the plane index, of a plane stored uncoded
+constexpr UINT16 LOSSLESS_RAW_PLANE = 0x1;
+
+/// LosslessFrameHeader::planeFlags bit, shifted by the plane index, of a plane whose blocks may use the reference frame
+constexpr UINT16 LOSSLESS_TEMPORAL_PLANE = 0x8;
+
+/// Every temporal plane bit
+constexpr UINT16 LOSSLESS_TEMPORAL_PLANES = LOSSLESS_TEMPORAL_PLANE * 0x7;
+
+/// Residuals sharing one Rice parameter
+constexpr UINT32 LOSSLESS_BLOCK_SIZE = 64;
+
+#pragma pack(push, 1)
+typedef struct {
+    UINT32 magic;          // LOSSLESS_MAGIC
+    UINT16 version;        // LOSSLESS_VERSION
+    UINT16 planeFlags;     // LOSSLESS_RAW_PLANE and LOSSLESS_TEMPORAL_PLANE bits of each plane
+    UINT32 width;          // Frame width
+    UINT32 height;         // Frame height
+    UINT32 planeBytes[3];  // Encoded size of the G, B-G and R-G planes, in that order after the header
+} LosslessFrameHeader;
+#pragma pack(pop)
+
+static_assert(sizeof(LosslessFrameHeader) == 28, "LosslessFrameHeader layout changed");
+
+/**
+ * @brief Largest encoding of a width x height BGR24 frame.
+ */
+size_t losslessMaxEncodedSize(UINT32 width, UINT32 height);
+
+/**
+ * @brief Reads the header of an encoded frame.
+ * @return false if data is not a complete, consistent encoded frame
+ */
+bool readLosslessHeader(const BYTE* data, size_t size, LosslessFrameHeader& header);
+
+/**
+ * @brief Whether decoding a frame needs the reference frame it was encoded against.
+ */
+bool losslessNeedsReference(const LosslessFrameHeader& header);
+
+/**
+ * @brief Encodes BGR24 frames, reusing its working buffers between frames.
+ *
+ * Not thread-safe; use one encoder per thread.
+ */
+class LosslessEncoder {
+private:
+    /// Decorrelated plane being coded
+    std::vector<BYTE> plane;
+
+    /// Same plane of the reference frame
+    std::vector<BYTE> referencePlane;
+
+    /// Spatial prediction residuals of the plane being coded
+    std::vector<BYTE> residuals;
+
+    /// Temporal prediction residuals of the plane being coded
+    std::vector<BYTE> temporalResiduals;
+
+public:
+    /**
+     * @brief Encodes one frame.
+     * @param bgr width * height * 3 bytes of interleaved blue, green, red
+     * @param out Receives the encoded frame, resized to fit
+     * @param reference Frame of the same size planes may be coded against, or nullptr; a frame no block
+     *                  of which was predicted from it doesn't need it to decode
+     * @return Size of the encoded frame
+     */
+    size_t encode(const BYTE* bgr, UINT32 width, UINT32 height, std::vector<BYTE>& out, const BYTE* reference = nullptr);
+};
+
+/**
+ * @brief Decodes frames written by LosslessEncoder, reusing its working buffers between frames.
+ *
+ * Not thread-safe; use one decoder per thread.
+ */
+class LosslessDecoder {
+private:
+    /// Reconstructed G, B-G and R-G planes
+    std::vector<BYTE> planes[3];
+
+    /// Same plane of the reference frame
+    std::vector<BYTE> referencePlane;
+
+    /// Decoded residuals of the plane being reconstructed
+    std::vector<BYTE> residuals;
+
+    /// Whether each block of the plane being reconstructed was predicted from the reference
+    std::vector<BYTE> temporalBlocks;
+
+public:
+    /**
+     * @brief Decodes one frame.
+     * @param bgr Receives width * height * 3 bytes
+     * @param bgrSize Size of the buffer at bgr
+     * @param reference Decoded reference frame, required if losslessNeedsReference(); may be bgr itself
+     * @return false if the data is damaged, the buffer too small or the reference missing
+     */
+    bool decode(const BYTE* data, size_t size, BYTE* bgr, size_t bgrSize, const BYTE* reference = nullptr);
+};
@@ -0,0 +1,169 @@
+#include "Checksum.h"
+
+#include <intrin.h>
+
+#include <cstring>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#include <nmmintrin.h>
+#define CHECKSUM_X86 1
+#endif
+
+namespace {
+
+/// Reflected CRC-32C polynomial
+constexpr UINT32 CRC32C_POLYNOMIAL = 0x82F63B78;
+
+/// Lookup tables for slice-by-8: entries[k][b] is the CRC of byte b followed by k zero bytes
+struct Crc32cTables {
+    UINT32 entries[8][256];
+
+    Crc32cTables() {
+        for (UINT32 i = 0; i < 256; i++) {
+            UINT32 crc = i;
+            for (int bit = 0; bit < 8; bit++) {
+                crc = (crc >> 1) ^ ((crc & 1) ? CRC32C_POLYNOMIAL : 0);
+            }
+            entries[0][i] = crc;
+        }
+
+        for (UINT32 i = 0; i < 256; i++) {
+            for (int k = 1; k < 8; k++) {
+                entries[k][i] = (entries[k - 1][i] >> 8) ^ entries[0][entries[k - 1][i] & 0xFF];
+            }
+        }
+    }
+};
+
+UINT32 crc32cSliceBy8(UINT32 crc, const BYTE* data, size_t size) {
+    static const Crc32cTables tables;
+    const auto& t = tables.entries;
+
+    while (size >= 8) {
+        UINT32 low;
+        UINT32 high;
+        memcpy(&low, data, sizeof(low));
+        memcpy(&high, data + 4, sizeof(high));
+        low ^= crc;
+
+        crc = t[7][low & 0xFF] ^ t[6][(low >> 8) & 0xFF] ^ t[5][(low >> 16) & 0xFF] ^ t[4][low >> 24] ^
+              t[3][high & 0xFF] ^ t[2][(high >> 8) & 0xFF] ^ t[1][(high >> 16) & 0xFF] ^ t[0][high >> 24];
+        data += 8;
+        size -= 8;
+    }
+
+    while (size > 0) {
+        crc = t[0][(crc ^ *data++) & 0xFF] ^ (crc >> 8);
+        size--;
+    }
+    return crc;
+}
+
+#if CHECKSUM_X86
+
+bool cpuHasCrcInstruction() {
+    int info[4] = {};
+    __cpuid(info, 1);
+    return (info[2] & (1 << 20)) != 0;  // SSE4.2
+}
+
+UINT32 crc32cHardware(UINT32 crc, const BYTE* data, size_t size) {
+#if defined(_M_X64) || defined(__x86_64__)
+    UINT64 crc64 = crc;
+    while (size >= sizeof(UINT64)) {
+        UINT64 word;
+        memcpy(&word, data, sizeof(word));
+        crc64 = _mm_crc32_u64(crc64, word);
+        data += sizeof(word);
+        size -= sizeof(word);
+    }
+    UINT32 crc32 = static_cast<UINT32>(crc64);
+#else
+    // The 64-bit form only exists in 64-bit mode
+    UINT32 crc32 = crc;
+    while (size >= sizeof(UINT32)) {
+        UINT32 word;
+        memcpy(&word, data, sizeof(word));
+        crc32 = _mm_crc32_u32(crc32, word);
+        data += sizeof(word);
+        size -= sizeof(word);
+    }
+#endif
+
+    while (size > 0) {
+        crc32 = _mm_crc32_u8(crc32, *data++);
+        size--;
+    }
+    return crc32;
+}
+
+#elif defined(_M_ARM64)
+
+bool cpuHasCrcInstruction() {
+    // Optional before ARMv8.1
+    return IsProcessorFeaturePresent(PF_ARM_V8_CRC32_INSTRUCTIONS_AVAILABLE) != FALSE;
+}
+
+UINT32 crc32cHardware(UINT32 crc, const BYTE* data, size_t size) {
+    while (size >= sizeof(UINT64)) {
+        UINT64 word;
+        memcpy(&word, data, sizeof(word));
+        crc = __crc32cd(crc, word);
+        data += sizeof(word);
+        size -= sizeof(word);
+    }
+
+    while (size > 0) {
+        crc = __crc32cb(crc, *data++);
+        size--;
+    }
+    return crc;
+}
+
+#else
+
+bool cpuHasCrcInstruction() {
+    return false;
+}
+
+UINT32 crc32cHardware(UINT32 crc, const BYTE* data, size_t size) {
+    return crc32cSliceBy8(crc, data, size);
+}
+
+#endif
+
+}  // namespace
+
+UINT32 crc32c(UINT32 crc, const void* data, size_t size) {
+    static const bool hardware = cpuHasCrcInstruction();
+    const BYTE* bytes = static_cast<const BYTE*>(data);
+
+    crc = ~crc;
+    crc = hardware ? crc32cHardware(crc, bytes, size) : crc32cSliceBy8(crc, bytes, size);
+    return ~crc;
+}
+
+UINT32 sampledFrameHash(const FrameHeader& header, const BYTE* data) {
+    if (!data || header.dataSize == 0 || header.height == 0) {
+        return 0;
+    }
+
+    // A stride of dataSize / height is a row of packed formats and samples planar formats just as evenly
+    size_t rowBytes = header.dataSize / header.height;
+    UINT32 hash = crc32c(0, &header.dataSize, sizeof(header.dataSize));
+    for (UINT32 row = 0; row < header.height; row += FRAME_HASH_ROW_STEP) {
+        hash = crc32c(hash, data + row * rowBytes, rowBytes);
+    }
+    return hash;
+}
+
+UINT32 frameRecordChecksum(const FrameHeader& header, const BYTE* data) {
+    FrameHeader covered = header;
+    covered.checksum = 0;
+
+    UINT32 crc = crc32c(0, &covered, sizeof(covered));
+    if (data && header.dataSize > 0) {
+        crc = crc32c(crc, data, header.dataSize);
+    }
+    return crc;
+}
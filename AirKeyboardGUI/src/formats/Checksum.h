@@ -0,0 +1,35 @@
+#pragma once
+
+//clang-format off
+#include <windows.h>
+//clang-format on
+
+#include "../types.h"
+
+/**
+ * @brief Extends a CRC-32C (Castagnoli) checksum over a block of bytes.
+ * @param crc Checksum of the preceding bytes, 0 to start
+ * @return Checksum of the preceding bytes followed by data
+ *
+ * Uses the SSE4.2 or ARMv8 CRC32 instructions when the CPU has them and a
+ * slice-by-8 lookup otherwise; all produce the same value.
+ */
+UINT32 crc32c(UINT32 crc, const void* data, size_t size);
+
+/// Rows skipped between the rows sampledFrameHash() reads
+constexpr UINT32 FRAME_HASH_ROW_STEP = 4;
+
+/**
+ * @brief Hashes every FRAME_HASH_ROW_STEP-th row of a frame's pixel data.
+ *
+ * Cheap enough to run on every frame; equal hashes only make frames candidates
+ * for being identical, callers compare the data to be sure.
+ */
+UINT32 sampledFrameHash(const FrameHeader& header, const BYTE* data);
+
+/**
+ * @brief Checksum stored in FrameHeader::checksum when FRAME_FLAG_CHECKSUM is set.
+ *
+ * Covers the header, with its checksum field zeroed, followed by dataSize bytes of data.
+ */
+UINT32 frameRecordChecksum(const FrameHeader& header, const BYTE* data);
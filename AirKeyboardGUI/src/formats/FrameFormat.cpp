@@ -0,0 +1,47 @@
+#include "FrameFormat.h"
+
+bool parseFrameHeader(const BYTE* data, size_t available, FrameHeader& header, size_t& headerSize) {
+    if (available >= sizeof(UINT32) + 2 * sizeof(UINT16)) {
+        UINT32 magic;
+        UINT16 version;
+        UINT16 size;
+        memcpy(&magic, data, sizeof(magic));
+        memcpy(&version, data + 4, sizeof(version));
+        memcpy(&size, data + 6, sizeof(size));
+
+        // A legacy millisecond timestamp could match the magic by chance, so the
+        // version and size must be plausible too
+        if (magic == FRAME_MAGIC && version >= FRAME_FORMAT_VERSION && size >= sizeof(FrameHeader)) {
+            if (available < size) {
+                return false;
+            }
+            memcpy(&header, data, sizeof(FrameHeader));
+            headerSize = size;
+            return true;
+        }
+    }
+
+    if (available < FRAME_HEADER_V1_SIZE) {
+        return false;
+    }
+
+    FrameHeaderV1 legacy;
+    memcpy(&legacy, data, sizeof(legacy));
+
+    initFrameHeader(header, PIXEL_FORMAT_BGR24, legacy.width, legacy.height, legacy.dataSize);
+    header.sequence = FRAME_SEQUENCE_UNKNOWN;
+    header.captureNs = static_cast<INT64>(legacy.timestamp) * 1000000;
+    headerSize = FRAME_HEADER_V1_SIZE;
+    return true;
+}
+
+void initFrameHeader(FrameHeader& header, PixelFormat pixelFormat, UINT32 width, UINT32 height, UINT32 dataSize) {
+    header = {};
+    header.magic = FRAME_MAGIC;
+    header.version = FRAME_FORMAT_VERSION;
+    header.headerSize = sizeof(FrameHeader);
+    header.pixelFormat = pixelFormat;
+    header.width = width;
+    header.height = height;
+    header.dataSize = dataSize;
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <windows.h>
+
+#include "../types.h"
+
+/**
+ * Reading support for frame records, i.e. a header followed by dataSize bytes
+ * of pixel data, as stored in the session container and legacy frame files.
+ *
+ * Two header layouts exist. Current files use the versioned 64-byte FrameHeader
+ * from types.h, which starts with FRAME_MAGIC. Sessions recorded before it use
+ * FrameHeaderV1: a 20-byte header holding a millisecond timestamp and no
+ * sequence number. parseFrameHeader() accepts both and always returns a FrameHeader.
+ */
+
+/// Size of the legacy frame header
+constexpr size_t FRAME_HEADER_V1_SIZE = 20;
+
+#pragma pack(push, 1)
+typedef struct {
+    UINT64 timestamp;  // Frame timestamp in milliseconds
+    UINT32 width;      // Frame width
+    UINT32 height;     // Frame height
+    UINT32 dataSize;   // Size of frame data in bytes
+} FrameHeaderV1;
+#pragma pack(pop)
+
+static_assert(sizeof(FrameHeaderV1) == FRAME_HEADER_V1_SIZE, "FrameHeaderV1 layout changed");
+
+/// Sequence value given to legacy frames, which carry none
+constexpr UINT64 FRAME_SEQUENCE_UNKNOWN = ~0ULL;
+
+/**
+ * @brief Decodes a frame header of either version.
+ * @param data Bytes at the start of the frame record
+ * @param available Number of readable bytes at data
+ * @param header Receives the header; legacy fields are converted to nanoseconds
+ * @param headerSize Receives the number of bytes the header occupies on disk
+ * @return false if the bytes are not a complete, plausible header
+ */
+bool parseFrameHeader(const BYTE* data, size_t available, FrameHeader& header, size_t& headerSize);
+
+/**
+ * @brief Fills in the fields every current frame header shares.
+ * @param header Header to initialize; all other fields are zeroed
+ */
+void initFrameHeader(FrameHeader& header, PixelFormat pixelFormat, UINT32 width, UINT32 height, UINT32 dataSize);
@@ -0,0 +1,51 @@
+#pragma once
+
+//clang-format off
+#include <windows.h>
+//clang-format on
+
+/**
+ * On-disk layout of frames.idx, the frame index SessionReader keeps next to a
+ * session's frames.bin.
+ *
+ * The file holds a FrameIndexHeader followed by one FrameIndexRecord per record
+ * of the container, in container order. The index covers the first
+ * containerSize bytes of frames.bin; a container that has grown since is
+ * indexed from there on, and one that is shorter or whose last indexed record
+ * no longer matches is indexed again from the start.
+ */
+
+/// "AKFI" in little-endian byte order
+constexpr UINT32 FRAME_INDEX_MAGIC = 0x49464B41;
+
+/// Current format version
+constexpr UINT16 FRAME_INDEX_VERSION = 1;
+
+/// FrameIndexHeader::flags bit set when capture times never decrease in container order
+constexpr UINT32 FRAME_INDEX_TIME_ORDERED = 0x1;
+
+/// FrameIndexRecord::sourceOffset of records without pixels to show
+constexpr UINT64 FRAME_INDEX_NO_SOURCE = ~0ULL;
+
+#pragma pack(push, 1)
+typedef struct {
+    UINT32 magic;          // FRAME_INDEX_MAGIC
+    UINT16 version;        // FRAME_INDEX_VERSION
+    UINT16 recordSize;     // sizeof(FrameIndexRecord), lets readers skip fields they don't know
+    UINT64 containerSize;  // Bytes of frames.bin the records cover, up to the end of the last one
+    UINT64 recordCount;    // Records following the header
+    UINT32 checksum;       // CRC-32C of the records
+    UINT32 flags;          // FRAME_INDEX_* bits
+} FrameIndexHeader;
+
+typedef struct {
+    INT64 captureNs;       // FrameHeader::captureNs of the record
+    UINT64 sequence;       // FrameHeader::sequence of the record
+    UINT64 offset;         // Offset of the record's header in frames.bin
+    UINT64 sourceOffset;   // Offset of the record holding the pixels: itself, the record a duplicate
+                           // repeats, or FRAME_INDEX_NO_SOURCE for gap markers
+} FrameIndexRecord;
+#pragma pack(pop)
+
+static_assert(sizeof(FrameIndexHeader) == 32, "FrameIndexHeader layout changed");
+static_assert(sizeof(FrameIndexRecord) == 32, "FrameIndexRecord layout changed");
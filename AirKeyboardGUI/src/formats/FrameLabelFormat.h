@@ -0,0 +1,53 @@
+#pragma once
+
+//clang-format off
+#include <windows.h>
+//clang-format on
+
+/**
+ * On-disk layout of labels.bin, the per-frame keyboard label index.
+ *
+ * The file starts with a FrameLabelHeader followed by one fixed-size
+ * FrameLabelRecord per logged frame, sorted by frame sequence number with
+ * non-decreasing capture times; the writer drops a frame that would break
+ * either order. Record i is at sizeof(FrameLabelHeader) + i * recordSize, so a
+ * reader can binary search by sequence or capture time without an external index.
+ */
+
+/// "AKLB" in little-endian byte order
+constexpr UINT32 FRAME_LABEL_MAGIC = 0x424C4B41;
+
+/// Current format version
+constexpr UINT16 FRAME_LABEL_VERSION = 1;
+
+/// Value of a FrameLabelRecord time field when there is no such key event
+constexpr INT32 LABEL_TIME_NONE = -1;
+
+/// Value of a FrameLabelRecord key field when there is no such key event
+constexpr UINT8 LABEL_KEY_NONE = 0;
+
+#pragma pack(push, 1)
+typedef struct {
+    UINT32 magic;              // FRAME_LABEL_MAGIC
+    UINT16 version;            // FRAME_LABEL_VERSION
+    UINT16 recordSize;         // sizeof(FrameLabelRecord), lets readers skip fields they don't know
+    INT32 nextPressHorizonUs;  // Presses further ahead than this are recorded as LABEL_TIME_NONE
+    UINT32 reserved;           // Zero
+} FrameLabelHeader;
+
+typedef struct {
+    UINT64 frameSequence;     // FrameHeader::sequence of the labeled frame
+    INT64 captureNs;          // FrameHeader::captureNs of the labeled frame
+    UINT64 heldKeys[4];       // Bit v set if virtual key v was held down at capture time
+    INT32 sinceLastPressUs;   // Time since the most recent press, or LABEL_TIME_NONE
+    INT32 sinceLastReleaseUs; // Time since the most recent release, or LABEL_TIME_NONE
+    INT32 untilNextPressUs;   // Time until the next press, or LABEL_TIME_NONE
+    UINT8 lastPressKey;       // Virtual key of the most recent press, or LABEL_KEY_NONE
+    UINT8 lastReleaseKey;     // Virtual key of the most recent release, or LABEL_KEY_NONE
+    UINT8 nextPressKey;       // Virtual key of the next press, or LABEL_KEY_NONE
+    UINT8 reserved;           // Zero
+} FrameLabelRecord;
+#pragma pack(pop)
+
+static_assert(sizeof(FrameLabelHeader) == 16, "FrameLabelHeader layout changed");
+static_assert(sizeof(FrameLabelRecord) == 64, "FrameLabelRecord layout changed");
@@ -0,0 +1,85 @@
+#include "KeyEventLogFormat.h"
+
+#include <cstring>
+
+#include "Checksum.h"
+
+namespace {
+
+/**
+ * @brief Offset of the next block magic after offset, or size if there is none.
+ */
+size_t findNextBlock(const BYTE* data, size_t size, size_t offset) {
+    for (size_t i = offset + 1; i + sizeof(UINT32) <= size; i++) {
+        UINT32 magic;
+        memcpy(&magic, data + i, sizeof(magic));
+        if (magic == KEY_BLOCK_MAGIC) return i;
+    }
+    return size;
+}
+
+void appendRecords(const BYTE* data, size_t count, size_t recordSize, std::vector<KeyEventRecord>& records) {
+    // Records may be larger than KeyEventRecord in newer versions
+    for (size_t i = 0; i < count; i++) {
+        KeyEventRecord record;
+        memcpy(&record, data + i * recordSize, sizeof(record));
+        records.push_back(record);
+    }
+}
+
+}  // namespace
+
+UINT32 keyBlockChecksum(const KeyEventBlockHeader& block, const BYTE* records, size_t recordBytes) {
+    KeyEventBlockHeader covered = block;
+    covered.checksum = 0;
+
+    UINT32 crc = crc32c(0, &covered, sizeof(covered));
+    return crc32c(crc, records, recordBytes);
+}
+
+bool parseKeyEventLog(const BYTE* data, size_t size, KeyEventLogHeader& header, std::vector<KeyEventRecord>& records,
+                      std::vector<CorruptRange>* corrupt) {
+    if (size < sizeof(header)) return false;
+
+    memcpy(&header, data, sizeof(header));
+    if (header.magic != KEY_LOG_MAGIC || header.recordSize < sizeof(KeyEventRecord)) return false;
+
+    size_t offset = sizeof(header);
+
+    if (header.version < 2) {
+        size_t count = (size - offset) / header.recordSize;
+        appendRecords(data + offset, count, header.recordSize, records);
+
+        // A partial record at the end is the only damage a version 1 log can show
+        size_t end = offset + count * header.recordSize;
+        if (end < size && corrupt) {
+            corrupt->push_back({end, size - end});
+        }
+        return true;
+    }
+
+    while (offset < size) {
+        if (size - offset >= sizeof(KeyEventBlockHeader)) {
+            KeyEventBlockHeader block;
+            memcpy(&block, data + offset, sizeof(block));
+
+            size_t recordBytes = static_cast<size_t>(block.recordCount) * header.recordSize;
+            const BYTE* blockRecords = data + offset + sizeof(block);
+            if (block.magic == KEY_BLOCK_MAGIC && recordBytes <= size - offset - sizeof(block) &&
+                keyBlockChecksum(block, blockRecords, recordBytes) == block.checksum) {
+                appendRecords(blockRecords, block.recordCount, header.recordSize, records);
+                offset += sizeof(block) + recordBytes;
+                continue;
+            }
+        }
+
+        // Damaged or truncated block, resume at the next one that checks out
+        size_t next = findNextBlock(data, size, offset);
+        if (corrupt) {
+            corrupt->push_back({offset, next - offset});
+        }
+        offset = next;
+    }
+
+    return true;
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <windows.h>
+
+#include <vector>
+
+/**
+ * On-disk layout of key_events.bin, the binary key-event log.
+ *
+ * The file starts with a KeyEventLogHeader followed by fixed-size KeyEventRecords
+ * in publish order. Records keep the raw QueryPerformanceCounter value at hook
+ * time together with the frequency from the header, so no precision is lost,
+ * next to the latency-corrected event time. They carry the publisher sequence
+ * number so dropped events show up as gaps.
+ *
+ * From version 2 the records are grouped into blocks, one per write, each led
+ * by a KeyEventBlockHeader carrying a CRC-32C of the block. Version 1 files hold
+ * the records directly after the file header. parseKeyEventLog() reads both.
+ */
+
+/// "AKKE" in little-endian byte order
+constexpr UINT32 KEY_LOG_MAGIC = 0x454B4B41;
+
+/// Current format version
+constexpr UINT16 KEY_LOG_VERSION = 2;
+
+/// "AKKB" in little-endian byte order, marks a KeyEventBlockHeader
+constexpr UINT32 KEY_BLOCK_MAGIC = 0x424B4B41;
+
+/// KeyEventRecord::flags bit set for key presses
+constexpr UINT8 KEY_RECORD_PRESSED = 0x01;
+
+#pragma pack(push, 1)
+typedef struct {
+    UINT32 magic;         // KEY_LOG_MAGIC
+    UINT16 version;       // KEY_LOG_VERSION
+    UINT16 recordSize;    // sizeof(KeyEventRecord), lets readers skip fields they don't know
+    INT64 qpcFrequency;   // QueryPerformanceFrequency of the recording host
+    UINT64 reserved;      // Zero
+} KeyEventLogHeader;
+
+typedef struct {
+    UINT32 magic;         // KEY_BLOCK_MAGIC
+    UINT32 recordCount;   // Records following the block header
+    UINT32 checksum;      // CRC-32C of this header with checksum zeroed, followed by the records
+    UINT32 reserved;      // Zero
+} KeyEventBlockHeader;
+
+typedef struct {
+    UINT64 sequence;      // Publisher sequence number
+    INT64 timestampNs;    // Estimated event time on the session clock, see timebase.txt
+    INT64 qpcTicks;       // Raw QueryPerformanceCounter value at hook time
+    UINT16 vkey;          // Virtual key code
+    UINT16 scanCode;      // Scan code of the key
+    UINT8 flags;          // KEY_RECORD_* bits
+    UINT8 reserved[3];    // Zero
+} KeyEventRecord;
+#pragma pack(pop)
+
+static_assert(sizeof(KeyEventLogHeader) == 24, "KeyEventLogHeader layout changed");
+static_assert(sizeof(KeyEventBlockHeader) == 16, "KeyEventBlockHeader layout changed");
+static_assert(sizeof(KeyEventRecord) == 32, "KeyEventRecord layout changed");
+
+/// Byte range of a file that failed its checksum or couldn't be parsed
+struct CorruptRange {
+    UINT64 offset;  ///< First damaged byte
+    UINT64 size;    ///< Bytes skipped
+};
+
+/**
+ * @brief Computes KeyEventBlockHeader::checksum.
+ * @param block Block header; its checksum field is ignored
+ * @param records recordCount records of recordSize bytes
+ */
+UINT32 keyBlockChecksum(const KeyEventBlockHeader& block, const BYTE* records, size_t recordBytes);
+
+/**
+ * @brief Decodes a key-event log of either version held in memory.
+ * @param data Contents of the file
+ * @param header Receives the file header
+ * @param records Receives every record of the blocks that passed their checksum
+ * @param corrupt Receives the ranges skipped as damaged or truncated, may be nullptr
+ * @return false if data doesn't start with a key-event log header
+ */
+bool parseKeyEventLog(const BYTE* data, size_t size, KeyEventLogHeader& header, std::vector<KeyEventRecord>& records,
+                      std::vector<CorruptRange>* corrupt = nullptr);
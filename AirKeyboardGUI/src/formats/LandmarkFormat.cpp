@@ -0,0 +1,17 @@
+#include "LandmarkFormat.h"
+
+#include "Checksum.h"
+
+UINT64 landmarkColumnBytes(UINT32 handCount, UINT16 pointCount) {
+    // Sequence, capture time, both point sets, score, index and label of every hand
+    UINT64 handBytes = 8 + 8 + 2 * static_cast<UINT64>(pointCount) * 3 * sizeof(float) + sizeof(float) + 1 + 1;
+    return (handCount * handBytes + 7) & ~static_cast<UINT64>(7);
+}
+
+UINT32 landmarkBlockChecksum(const LandmarkBlockHeader& block, const BYTE* columns, size_t columnBytes) {
+    LandmarkBlockHeader covered = block;
+    covered.checksum = 0;
+
+    UINT32 crc = crc32c(0, &covered, sizeof(covered));
+    return crc32c(crc, columns, columnBytes);
+}
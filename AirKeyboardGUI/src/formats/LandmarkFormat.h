@@ -0,0 +1,80 @@
+#pragma once
+
+//clang-format off
+#include <windows.h>
+//clang-format on
+
+/**
+ * On-disk layout of landmarks.bin, the hand landmarks the post-processing
+ * worker detects.
+ *
+ * The file starts with a LandmarkFileHeader followed by blocks appended as the
+ * worker goes, each a LandmarkBlockHeader and the block's hands stored column
+ * by column, like a row group of a columnar file:
+ *
+ *   UINT64 sequence[handCount]     FrameHeader::sequence of the hand's frame
+ *   INT64  captureNs[handCount]    FrameHeader::captureNs of the hand's frame
+ *   float  points[handCount][pointCount * 3]       x, y in image fractions, z relative to the wrist
+ *   float  worldPoints[handCount][pointCount * 3]  x, y, z in metres around the hand's centre
+ *   float  score[handCount]        Handedness confidence
+ *   UINT8  handIndex[handCount]    Position of the hand in the detector's result
+ *   UINT8  handLabel[handCount]    LANDMARK_HAND_*
+ *
+ * followed by zeros up to a multiple of 8 bytes, so every block and column is
+ * aligned in a mapped file. Hands are sorted by sequence, within and across
+ * blocks; frames analyzed without finding hands only count in frameCount.
+ */
+
+/// "AKLM" in little-endian byte order
+constexpr UINT32 LANDMARK_MAGIC = 0x4D4C4B41;
+
+/// Current format version
+constexpr UINT16 LANDMARK_VERSION = 1;
+
+/// "AKLK" in little-endian byte order, marks a LandmarkBlockHeader
+constexpr UINT32 LANDMARK_BLOCK_MAGIC = 0x4B4C4B41;
+
+/// Landmarks per hand of the MediaPipe hand model
+constexpr UINT16 LANDMARK_POINTS = 21;
+
+/// LandmarkBlockHeader::flags bit set when checksum holds the block's CRC-32C
+constexpr UINT32 LANDMARK_BLOCK_CHECKSUM = 0x1;
+
+/// Values of the handLabel column
+constexpr UINT8 LANDMARK_HAND_LEFT = 0;
+constexpr UINT8 LANDMARK_HAND_RIGHT = 1;
+
+#pragma pack(push, 1)
+typedef struct {
+    UINT32 magic;        // LANDMARK_MAGIC
+    UINT16 version;      // LANDMARK_VERSION
+    UINT16 pointCount;   // Landmarks per hand, LANDMARK_POINTS
+    UINT64 reserved;     // Zero
+} LandmarkFileHeader;
+
+typedef struct {
+    UINT32 magic;          // LANDMARK_BLOCK_MAGIC
+    UINT32 flags;          // LANDMARK_BLOCK_* bits
+    UINT32 handCount;      // Hands in the block, the length of every column
+    UINT32 frameCount;     // Frames the block covers, with or without hands
+    UINT64 firstSequence;  // Sequence of the first frame covered
+    UINT64 lastSequence;   // Sequence of the last frame covered
+    UINT32 checksum;       // CRC-32C of this header with checksum zeroed, followed by the columns
+    UINT32 reserved;       // Zero
+} LandmarkBlockHeader;
+#pragma pack(pop)
+
+static_assert(sizeof(LandmarkFileHeader) == 16, "LandmarkFileHeader layout changed");
+static_assert(sizeof(LandmarkBlockHeader) == 40, "LandmarkBlockHeader layout changed");
+
+/**
+ * @brief Bytes of the columns following a block header, padding included.
+ */
+UINT64 landmarkColumnBytes(UINT32 handCount, UINT16 pointCount);
+
+/**
+ * @brief Computes LandmarkBlockHeader::checksum.
+ * @param block Block header; its checksum field is ignored
+ * @param columns landmarkColumnBytes() bytes of columns
+ */
+UINT32 landmarkBlockChecksum(const LandmarkBlockHeader& block, const BYTE* columns, size_t columnBytes);
@@ -0,0 +1,61 @@
+#include "SessionCatalogFormat.h"
+
+#include <cstring>
+
+#include "Checksum.h"
+
+namespace {
+
+/**
+ * @brief Offset of the next entry magic after offset, or size if there is none.
+ */
+size_t findNextEntry(const BYTE* data, size_t size, size_t offset) {
+    for (size_t i = offset + 1; i + sizeof(UINT32) <= size; i++) {
+        UINT32 magic;
+        memcpy(&magic, data + i, sizeof(magic));
+        if (magic == SESSION_ENTRY_MAGIC) return i;
+    }
+    return size;
+}
+
+}  // namespace
+
+UINT32 sessionEntryChecksum(const BYTE* entry, size_t entrySize) {
+    // The checksum field sits between the magic and the rest and counts as zero
+    const UINT32 zero = 0;
+    UINT32 crc = crc32c(0, entry, sizeof(UINT32));
+    crc = crc32c(crc, &zero, sizeof(zero));
+    return crc32c(crc, entry + 2 * sizeof(UINT32), entrySize - 2 * sizeof(UINT32));
+}
+
+bool parseSessionCatalog(const BYTE* data, size_t size, SessionCatalogHeader& header,
+                         std::vector<SessionCatalogEntry>& entries, std::vector<CorruptRange>* corrupt) {
+    if (size < sizeof(header)) return false;
+
+    memcpy(&header, data, sizeof(header));
+    if (header.magic != SESSION_CATALOG_MAGIC || header.entrySize < sizeof(SessionCatalogEntry)) return false;
+
+    size_t offset = sizeof(header);
+    while (offset < size) {
+        if (size - offset >= header.entrySize) {
+            // Entries of newer versions append fields, which their checksum covers too
+            SessionCatalogEntry entry;
+            memcpy(&entry, data + offset, sizeof(entry));
+            if (entry.magic == SESSION_ENTRY_MAGIC &&
+                sessionEntryChecksum(data + offset, header.entrySize) == entry.checksum) {
+                entries.push_back(entry);
+                offset += header.entrySize;
+                continue;
+            }
+        }
+
+        // Damaged or torn entry, resume at the next one that checks out
+        size_t next = findNextEntry(data, size, offset);
+        if (corrupt) {
+            corrupt->push_back({offset, next - offset});
+        }
+        offset = next;
+    }
+
+    return true;
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+//clang-format off
+#include <windows.h>
+//clang-format on
+
+#include <vector>
+
+#include "KeyEventLogFormat.h"
+
+/**
+ * On-disk layout of catalog.bin, the list of the sessions recorded in LOG_DIR.
+ *
+ * The file starts with a SessionCatalogHeader followed by one SessionCatalogEntry
+ * per session, appended when the session closes. Entries are fixed-size and
+ * carry their own CRC-32C, so a torn append only loses that entry and readers
+ * resume at the next entry magic. A session can have several entries, e.g. a
+ * backfilled one and one written later, or one appended when the session was
+ * thinned or evicted; the last one counts.
+ */
+
+/// Name of the catalog in LOG_DIR
+constexpr const char* SESSION_CATALOG_NAME = "catalog.bin";
+
+/// "AKSC" in little-endian byte order
+constexpr UINT32 SESSION_CATALOG_MAGIC = 0x43534B41;
+
+/// Current format version
+constexpr UINT16 SESSION_CATALOG_VERSION = 1;
+
+/// "AKSE" in little-endian byte order, starts every SessionCatalogEntry
+constexpr UINT32 SESSION_ENTRY_MAGIC = 0x45534B41;
+
+/// SessionCatalogEntry::flags bit set when the entry was derived from the session's files after the fact
+constexpr UINT32 SESSION_ENTRY_BACKFILLED = 0x1;
+
+/// SessionCatalogEntry::flags bit set when StorageManager removed the session's regenerable files
+constexpr UINT32 SESSION_ENTRY_THINNED = 0x2;
+
+/// SessionCatalogEntry::flags bit set when StorageManager deleted the session; its sizes are then zero
+constexpr UINT32 SESSION_ENTRY_EVICTED = 0x4;
+
+#pragma pack(push, 1)
+typedef struct {
+    UINT32 magic;      // SESSION_CATALOG_MAGIC
+    UINT16 version;    // SESSION_CATALOG_VERSION
+    UINT16 entrySize;  // sizeof(SessionCatalogEntry), lets readers skip fields they don't know
+    UINT64 reserved;   // Zero
+} SessionCatalogHeader;
+
+typedef struct {
+    UINT32 magic;              // SESSION_ENTRY_MAGIC
+    UINT32 checksum;           // CRC-32C of the entry's entrySize bytes with checksum zeroed
+    UINT64 sessionId;          // Name of the session directory, system_clock ticks at its start
+    INT64 startUnixMs;         // Start of the session, milliseconds since 1970-01-01 UTC
+    INT64 durationMs;          // Time from start to stop
+    UINT64 frames;             // Frames stored with pixel data
+    UINT64 framesDuplicate;    // Frames stored as repeats of the frame before
+    UINT64 framesShed;         // Frames replaced by gap markers under memory or disk pressure
+    UINT64 framesMissing;      // Frames missing from the capture sequence numbers
+    UINT64 framesRingDropped;  // Frames the post-processing worker didn't get
+    UINT64 keyEvents;          // Key events logged
+    UINT64 keysDropped;        // Key events missing from the sequence numbers
+    UINT64 frameBytes;         // Size of frames.bin
+    UINT64 keyBytes;           // Size of key_events.bin
+    UINT64 totalBytes;         // Size of every file of the session
+    UINT32 flags;              // SESSION_ENTRY_* bits
+    UINT64 framesLost;         // Frames not stored because frames.bin couldn't be written, zero in older entries
+    UINT32 reserved;           // Zero
+} SessionCatalogEntry;
+#pragma pack(pop)
+
+static_assert(sizeof(SessionCatalogHeader) == 16, "SessionCatalogHeader layout changed");
+static_assert(sizeof(SessionCatalogEntry) == 128, "SessionCatalogEntry layout changed");
+
+/**
+ * @brief Computes SessionCatalogEntry::checksum.
+ * @param entry Entry as stored; its checksum field is ignored
+ * @param entrySize SessionCatalogHeader::entrySize of the catalog
+ */
+UINT32 sessionEntryChecksum(const BYTE* entry, size_t entrySize);
+
+/**
+ * @brief Decodes a catalog held in memory.
+ * @param data Contents of the file
+ * @param entries Receives every entry that passed its checksum, in file order
+ * @param corrupt Receives the ranges skipped as damaged or truncated, may be nullptr
+ * @return false if data doesn't start with a catalog header
+ */
+bool parseSessionCatalog(const BYTE* data, size_t size, SessionCatalogHeader& header,
+                         std::vector<SessionCatalogEntry>& entries, std::vector<CorruptRange>* corrupt = nullptr);
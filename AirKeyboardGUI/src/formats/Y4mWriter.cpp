@@ -0,0 +1,47 @@
+#include "Y4mWriter.h"
+
+#include <cstring>
+
+#include "../codec/I420Converter.h"
+
+namespace {
+
+/// Line starting every frame of the stream
+constexpr char FRAME_MARKER[] = "FRAME\n";
+constexpr size_t FRAME_MARKER_SIZE = sizeof(FRAME_MARKER) - 1;
+
+}  // namespace
+
+bool Y4mWriter::writeHeader() {
+    // Chroma is averaged over 2x2 blocks, which Y4M calls 420jpeg; the range is BT.601 limited like the capture path
+    char header[128];
+    int length = snprintf(header, sizeof(header), "YUV4MPEG2 W%u H%u F%u:%u Ip A1:1 C420jpeg XCOLORRANGE=LIMITED\n", width,
+                          height, rateNumerator, rateDenominator);
+    headerWritten = fwrite(header, 1, length, output) == static_cast<size_t>(length);
+    return headerWritten;
+}
+
+bool Y4mWriter::writeFrame(const BYTE* bgr) {
+    if (!headerWritten && !writeHeader()) return false;
+
+    convertBgrToI420(bgr, width, height, frame.data() + FRAME_MARKER_SIZE);
+    framesWritten++;
+    return fwrite(frame.data(), 1, frame.size(), output) == frame.size();
+}
+
+bool Y4mWriter::repeatFrame() {
+    if (framesWritten == 0) return false;
+
+    framesWritten++;
+    return fwrite(frame.data(), 1, frame.size(), output) == frame.size();
+}
+
+UINT64 Y4mWriter::getFramesWritten() const {
+    return framesWritten;
+}
+
+Y4mWriter::Y4mWriter(FILE* output, UINT32 width, UINT32 height, UINT32 rateNumerator, UINT32 rateDenominator)
+    : output(output), width(width), height(height), rateNumerator(rateNumerator), rateDenominator(rateDenominator) {
+    frame.resize(FRAME_MARKER_SIZE + i420FrameSize(width, height));
+    memcpy(frame.data(), FRAME_MARKER, FRAME_MARKER_SIZE);
+}
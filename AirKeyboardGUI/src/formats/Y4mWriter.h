@@ -0,0 +1,57 @@
+#pragma once
+
+//clang-format off
+#include <windows.h>
+//clang-format on
+
+#include <cstdio>
+#include <vector>
+
+/**
+ * @brief Streams BGR24 frames into a YUV4MPEG2 (Y4M) video.
+ *
+ * Y4M is a stream header line followed by one "FRAME" line and the raw planar
+ * 4:2:0 pixels per frame, which every video encoder reads, e.g.
+ * `ffmpeg -f yuv4mpegpipe -i -`. Nothing is buffered beyond the current frame,
+ * so the output can be a file or a pipe.
+ */
+class Y4mWriter {
+private:
+    FILE* output;                /// Stream the video is written to, not owned
+    UINT32 width;                /// Frame width in pixels
+    UINT32 height;               /// Frame height in pixels
+    UINT32 rateNumerator;        /// Frame rate numerator of the stream header
+    UINT32 rateDenominator;      /// Frame rate denominator of the stream header
+    bool headerWritten = false;  /// Whether the stream header has been written
+    std::vector<BYTE> frame;     /// "FRAME" line followed by the last converted frame
+    UINT64 framesWritten = 0;    /// Frames written so far, repeats included
+
+    /**
+     * @brief Writes the stream header before the first frame.
+     */
+    bool writeHeader();
+
+public:
+    /**
+     * @brief Describes the video; nothing is written before the first frame.
+     * @param output Open binary stream, which stays open after the writer is gone
+     */
+    Y4mWriter(FILE* output, UINT32 width, UINT32 height, UINT32 rateNumerator, UINT32 rateDenominator);
+
+    /**
+     * @brief Converts a width x height BGR24 frame to 4:2:0 and appends it.
+     * @return false if the output failed
+     */
+    bool writeFrame(const BYTE* bgr);
+
+    /**
+     * @brief Appends the last written frame again, to keep the video in time over missing frames.
+     * @return false if no frame was written yet or the output failed
+     */
+    bool repeatFrame();
+
+    /**
+     * @brief Frames written so far, repeats included.
+     */
+    UINT64 getFramesWritten() const;
+};
@@ -0,0 +1,58 @@
+#include "AlignedBufferPool.h"
+
+BYTE* AlignedBufferPool::acquire() {
+    std::lock_guard<std::mutex> lock(poolLock);
+    if (freeBuffers.empty()) {
+        return nullptr;
+    }
+
+    BYTE* buffer = freeBuffers.back();
+    freeBuffers.pop_back();
+    return buffer;
+}
+
+void AlignedBufferPool::release(BYTE* buffer) {
+    if (!buffer) return;
+
+    std::lock_guard<std::mutex> lock(poolLock);
+    freeBuffers.push_back(buffer);
+}
+
+size_t AlignedBufferPool::getBufferSize() const {
+    return bufferSize;
+}
+
+size_t AlignedBufferPool::available() {
+    std::lock_guard<std::mutex> lock(poolLock);
+    return freeBuffers.size();
+}
+
+AlignedBufferPool::AlignedBufferPool(size_t bufferSize, size_t bufferCount)
+    : bufferSize(bufferSize), account(MemoryAccountant::getInstance().getAccount("aligned_buffer_pool", true)) {
+    // Reserved up front so only VirtualAlloc can fail inside the loop
+    allBuffers.reserve(bufferCount);
+    freeBuffers.reserve(bufferCount);
+
+    for (size_t i = 0; i < bufferCount; i++) {
+        BYTE* buffer = static_cast<BYTE*>(VirtualAlloc(nullptr, bufferSize, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE));
+        if (!buffer) {
+            // The destructor doesn't run for a throwing constructor, free what was allocated so far
+            for (BYTE* allocated : allBuffers) {
+                VirtualFree(allocated, 0, MEM_RELEASE);
+            }
+            throw std::runtime_error("Failed to allocate aligned I/O buffer");
+        }
+        allBuffers.push_back(buffer);
+        freeBuffers.push_back(buffer);
+    }
+
+    account->add(static_cast<INT64>(bufferSize * bufferCount), static_cast<INT64>(bufferCount));
+}
+
+AlignedBufferPool::~AlignedBufferPool() {
+    for (BYTE* buffer : allBuffers) {
+        VirtualFree(buffer, 0, MEM_RELEASE);
+    }
+
+    account->remove(static_cast<INT64>(bufferSize * allBuffers.size()), static_cast<INT64>(allBuffers.size()));
+}
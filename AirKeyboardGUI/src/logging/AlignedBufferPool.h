@@ -0,0 +1,74 @@
+#pragma once
+
+//clang-format off
+#include <windows.h>
+//clang-format on
+
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+#include "../metrics/MemoryAccountant.h"
+
+/**
+ * @brief Fixed pool of equally sized buffers aligned for unbuffered I/O.
+ *
+ * Buffers are allocated once with VirtualAlloc, which returns page-aligned memory
+ * and therefore satisfies the sector alignment FILE_FLAG_NO_BUFFERING requires.
+ * acquire() and release() only move pointers between lists, so steady-state
+ * logging performs no heap allocation.
+ */
+class AlignedBufferPool {
+private:
+    /// Size of each buffer in bytes
+    const size_t bufferSize;
+
+    /// Every buffer owned by the pool, released in the destructor
+    std::vector<BYTE*> allBuffers;
+
+    /// Buffers currently available to acquire()
+    std::vector<BYTE*> freeBuffers;
+
+    /// Guards freeBuffers
+    std::mutex poolLock;
+
+    /// Budgeted account the pool's memory is reported to
+    MemoryAccount* account;
+
+public:
+    /**
+     * @brief Allocates the pool.
+     * @param bufferSize Size of each buffer in bytes
+     * @param bufferCount Number of buffers to allocate
+     */
+    AlignedBufferPool(size_t bufferSize, size_t bufferCount);
+
+    /**
+     * @brief Takes a buffer from the pool.
+     * @return Aligned buffer, or nullptr if every buffer is in use
+     */
+    BYTE* acquire();
+
+    /**
+     * @brief Returns a buffer obtained from acquire() to the pool.
+     */
+    void release(BYTE* buffer);
+
+    /**
+     * @brief Size of each buffer in bytes.
+     */
+    size_t getBufferSize() const;
+
+    /**
+     * @brief Number of buffers currently available.
+     */
+    size_t available();
+
+    /**
+     * @brief Frees every buffer. Buffers must have been released beforehand.
+     */
+    ~AlignedBufferPool();
+
+    AlignedBufferPool(const AlignedBufferPool&) = delete;
+    AlignedBufferPool& operator=(const AlignedBufferPool&) = delete;
+};
@@ -0,0 +1,299 @@
+#include "AsyncFileWriter.h"
+
+bool AsyncFileWriter::openFile(bool requestDirectIo) {
+    if (requestDirectIo) {
+        file = CreateFileW(filePath.wstring().c_str(), GENERIC_WRITE, FILE_SHARE_READ, nullptr,
+                           CREATE_ALWAYS, FILE_FLAG_NO_BUFFERING | FILE_FLAG_WRITE_THROUGH, nullptr);
+
+        if (file != INVALID_HANDLE_VALUE) {
+            FILE_STORAGE_INFO storageInfo = {};
+            if (GetFileInformationByHandleEx(file, FileStorageInfo, &storageInfo, sizeof(storageInfo))) {
+                sectorSize = std::max<size_t>(storageInfo.PhysicalBytesPerSectorForPerformance,
+                                              storageInfo.LogicalBytesPerSector);
+            } else {
+                sectorSize = 4096;  // Safe for every disk that reports nothing
+            }
+
+            // Probe with one aligned sector: some file systems and network shares accept the
+            // flag at open time but reject unbuffered writes
+            bool probeOk = false;
+            if (sectorSize > 0 && sectorSize <= bufferSize && bufferSize % sectorSize == 0) {
+                BYTE* probe = bufferPool->acquire();
+                memset(probe, 0, sectorSize);
+                DWORD probeWritten = 0;
+                probeOk = WriteFile(file, probe, static_cast<DWORD>(sectorSize), &probeWritten, nullptr) &&
+                          probeWritten == sectorSize;
+                bufferPool->release(probe);
+            }
+
+            if (probeOk) {
+                directIo = true;
+                carriedTail.resize(sectorSize);
+                return true;
+            }
+
+            CloseHandle(file);
+            file = INVALID_HANDLE_VALUE;
+        }
+
+        std::string message = "AsyncFileWriter: direct I/O not supported for " + filePath.string() +
+                              ", falling back to buffered writes\n";
+        OutputDebugStringA(message.c_str());
+    }
+
+    directIo = false;
+    sectorSize = 1;
+    file = CreateFileW(filePath.wstring().c_str(), GENERIC_WRITE, FILE_SHARE_READ, nullptr,
+                       CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    return file != INVALID_HANDLE_VALUE;
+}
+
+void AsyncFileWriter::submitStaging() {
+    size_t writeSize = stagingSize;
+    size_t tailSize = 0;
+
+    if (directIo) {
+        // Pad to a whole sector and keep the partial sector so the next buffer can rewrite it
+        tailSize = stagingSize % sectorSize;
+        if (tailSize > 0) {
+            writeSize = stagingSize - tailSize + sectorSize;
+            memset(stagingBuffer + stagingSize, 0, writeSize - stagingSize);
+            memcpy(carriedTail.data(), stagingBuffer + stagingSize - tailSize, tailSize);
+        }
+    }
+
+    std::unique_lock<std::mutex> lock(jobsLock);
+
+    auto now = std::chrono::steady_clock::now();
+    if (firstSubmit == std::chrono::steady_clock::time_point{}) {
+        firstSubmit = now;
+    }
+
+    UINT64 serial = ++lastSerial;
+    pendingJobs.push(WriteJob{stagingBuffer, writeSize, stagingOffset, now, serial, carriedFromSerial});
+    outstandingJobs++;
+    if (tailSize > 0) {
+        paddedWritesInFlight.insert(serial);
+    }
+    jobsAvailable.notify_one();
+
+    stagingOffset += stagingSize - tailSize;
+    stagingBuffer = nullptr;
+
+    while (!(stagingBuffer = bufferPool->acquire())) {
+        appendStalls++;
+        jobsCompleted.wait(lock);
+    }
+
+    lock.unlock();
+
+    if (tailSize > 0) {
+        memcpy(stagingBuffer, carriedTail.data(), tailSize);
+    }
+    stagingSize = tailSize;
+    carriedSize = tailSize;
+    carriedFromSerial = tailSize > 0 ? serial : 0;
+}
+
+void AsyncFileWriter::workerLoop() {
+    while (true) {
+        WriteJob job;
+        {
+            std::unique_lock<std::mutex> lock(jobsLock);
+            jobsAvailable.wait(lock, [this] { return stopping || !pendingJobs.empty(); });
+            if (pendingJobs.empty()) {
+                return;  // Stopping and nothing left to write
+            }
+
+            job = pendingJobs.front();
+            pendingJobs.pop();
+
+            double queueDelayMs = std::chrono::duration<double, std::milli>(
+                                      std::chrono::steady_clock::now() - job.submitted)
+                                      .count();
+            totalQueueDelayMs += queueDelayMs;
+            maxQueueDelayMs = std::max(maxQueueDelayMs, queueDelayMs);
+
+            // The padded write this job overlaps must land first, or its zero padding
+            // would overwrite the carried sector
+            if (job.dependsOn != 0) {
+                jobsCompleted.wait(lock, [this, &job] { return !paddedWritesInFlight.contains(job.dependsOn); });
+            }
+        }
+
+        auto writeStart = std::chrono::steady_clock::now();
+        bool ok = writeJob(job);
+        double writeSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - writeStart).count();
+
+        bufferPool->release(job.buffer);
+        {
+            std::lock_guard<std::mutex> lock(jobsLock);
+            if (ok) {
+                bytesWritten += job.size;
+                writesCompleted++;
+                totalWriteSeconds += writeSeconds;
+            } else {
+                writeErrors++;
+            }
+            paddedWritesInFlight.erase(job.serial);
+            lastComplete = std::chrono::steady_clock::now();
+            outstandingJobs--;
+        }
+        jobsCompleted.notify_all();
+    }
+}
+
+bool AsyncFileWriter::writeJob(const WriteJob& job) {
+    size_t written = 0;
+    while (written < job.size) {
+        UINT64 offset = job.offset + written;
+
+        // Positioned write: the OVERLAPPED offset lets several threads share the handle
+        OVERLAPPED overlapped = {};
+        overlapped.Offset = static_cast<DWORD>(offset & 0xFFFFFFFF);
+        overlapped.OffsetHigh = static_cast<DWORD>(offset >> 32);
+
+        DWORD chunk = static_cast<DWORD>(std::min<size_t>(job.size - written, 0x40000000));
+        DWORD chunkWritten = 0;
+        if (!WriteFile(file, job.buffer + written, chunk, &chunkWritten, &overlapped) || chunkWritten == 0) {
+            if (!failed.exchange(true)) {
+                std::string message = "AsyncFileWriter: write failed at offset " + std::to_string(offset) +
+                                      ", error " + std::to_string(GetLastError()) + "\n";
+                OutputDebugStringA(message.c_str());
+            }
+            return false;
+        }
+        written += chunkWritten;
+    }
+    return true;
+}
+
+bool AsyncFileWriter::isOpen() const {
+    return file != INVALID_HANDLE_VALUE;
+}
+
+bool AsyncFileWriter::hasFailed() const {
+    return failed;
+}
+
+bool AsyncFileWriter::isDirectIo() const {
+    return directIo;
+}
+
+void AsyncFileWriter::append(const void* data, size_t size) {
+    if (!isOpen()) return;
+
+    const BYTE* src = static_cast<const BYTE*>(data);
+    while (size > 0) {
+        size_t chunk = std::min(size, bufferSize - stagingSize);
+        memcpy(stagingBuffer + stagingSize, src, chunk);
+        stagingSize += chunk;
+        src += chunk;
+        size -= chunk;
+
+        if (stagingSize == bufferSize) {
+            submitStaging();
+        }
+    }
+}
+
+void AsyncFileWriter::flush() {
+    // A buffer holding nothing but the carried sector has already been written
+    if (isOpen() && stagingSize > carriedSize) {
+        submitStaging();
+    }
+}
+
+void AsyncFileWriter::drain() {
+    flush();
+
+    std::unique_lock<std::mutex> lock(jobsLock);
+    jobsCompleted.wait(lock, [this] { return outstandingJobs == 0; });
+}
+
+void AsyncFileWriter::close() {
+    if (!isOpen()) return;
+
+    drain();
+    UINT64 logicalSize = size();
+
+    {
+        std::lock_guard<std::mutex> lock(jobsLock);
+        stopping = true;
+    }
+    jobsAvailable.notify_all();
+
+    for (auto& worker : workers) {
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+    workers.clear();
+
+    if (directIo) {
+        // Trim the padding of the last partial sector
+        FILE_END_OF_FILE_INFO endOfFile = {};
+        endOfFile.EndOfFile.QuadPart = static_cast<LONGLONG>(logicalSize);
+        SetFileInformationByHandle(file, FileEndOfFileInfo, &endOfFile, sizeof(endOfFile));
+    }
+
+    CloseHandle(file);
+    file = INVALID_HANDLE_VALUE;
+
+    bufferPool->release(stagingBuffer);
+    stagingBuffer = nullptr;
+}
+
+UINT64 AsyncFileWriter::size() const {
+    return stagingOffset + stagingSize;
+}
+
+AsyncWriterStats AsyncFileWriter::getStats() const {
+    std::lock_guard<std::mutex> lock(jobsLock);
+
+    AsyncWriterStats stats;
+    stats.bytesWritten = bytesWritten;
+    stats.writesCompleted = writesCompleted;
+    stats.writeErrors = writeErrors;
+    stats.appendStalls = appendStalls;
+    stats.writeSeconds = totalWriteSeconds;
+    stats.directIo = directIo;
+
+    if (writesCompleted > 0) {
+        stats.elapsedSeconds = std::chrono::duration<double>(lastComplete - firstSubmit).count();
+        if (stats.elapsedSeconds > 0) {
+            stats.throughputMBps = (bytesWritten / (1024.0 * 1024.0)) / stats.elapsedSeconds;
+        }
+    }
+
+    UINT64 started = writesCompleted + writeErrors;
+    if (started > 0) {
+        stats.avgQueueDelayMs = totalQueueDelayMs / started;
+    }
+    stats.maxQueueDelayMs = maxQueueDelayMs;
+
+    return stats;
+}
+
+AsyncFileWriter::AsyncFileWriter(const std::filesystem::path& filePath, const AsyncWriterOptions& options)
+    : filePath(filePath), bufferSize(options.bufferSize), maxInFlight(std::max<size_t>(options.maxInFlight, 1)) {
+    // One buffer per in-flight write plus the one being filled
+    bufferPool = std::make_unique<AlignedBufferPool>(bufferSize, maxInFlight + 1);
+
+    if (!openFile(options.directIo)) {
+        std::string message = "AsyncFileWriter: failed to open " + filePath.string() +
+                              ", error " + std::to_string(GetLastError()) + "\n";
+        OutputDebugStringA(message.c_str());
+        return;
+    }
+
+    stagingBuffer = bufferPool->acquire();
+
+    for (size_t i = 0; i < maxInFlight; i++) {
+        workers.emplace_back([this]() { workerLoop(); });
+    }
+}
+
+AsyncFileWriter::~AsyncFileWriter() {
+    close();
+}
@@ -0,0 +1,244 @@
+#pragma once
+
+//clang-format off
+#include <windows.h>
+//clang-format on
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "AlignedBufferPool.h"
+
+/**
+ * @brief Configuration of an AsyncFileWriter.
+ */
+struct AsyncWriterOptions {
+    size_t bufferSize = 8 * 1024 * 1024;  ///< Size of each staging buffer; records are coalesced up to this size
+    size_t maxInFlight = 4;               ///< Number of writes allowed to execute concurrently
+    bool directIo = false;                ///< Bypass the page cache with FILE_FLAG_NO_BUFFERING when supported
+};
+
+/**
+ * @brief Snapshot of AsyncFileWriter throughput and queueing statistics.
+ */
+struct AsyncWriterStats {
+    UINT64 bytesWritten = 0;     ///< Bytes that reached the file, including direct-I/O padding
+    UINT64 writesCompleted = 0;  ///< Number of coalesced writes completed
+    UINT64 writeErrors = 0;      ///< Number of writes that failed
+    UINT64 appendStalls = 0;     ///< Times append() had to wait for a free buffer
+    double elapsedSeconds = 0;   ///< Time from first submission to last completion
+    double throughputMBps = 0;   ///< Achieved throughput over elapsedSeconds
+    double writeSeconds = 0;     ///< Time the completed writes spent in WriteFile, summed over writer threads
+    double avgQueueDelayMs = 0;  ///< Mean time a write waited before a worker picked it up
+    double maxQueueDelayMs = 0;  ///< Worst time a write waited before a worker picked it up
+    bool directIo = false;       ///< Whether the file is written unbuffered
+};
+
+/**
+ * @brief Append-only file writer that keeps several large writes in flight.
+ *
+ * Callers append records of any size. Records are copied into large staging
+ * buffers, so contiguous records are coalesced into a single write. Full buffers
+ * are handed to a small pool of writer threads that issue positioned writes
+ * concurrently. append() only blocks when every staging buffer is in flight,
+ * which bounds memory use and pushes back on the caller when the disk falls behind.
+ *
+ * In direct-I/O mode the file bypasses the page cache, so long sessions do not
+ * evict everything else on the host. Every write is then a whole number of
+ * sectors at a sector-aligned offset: a partial buffer is padded, and its last
+ * partial sector is carried into the next buffer and rewritten. The padding is
+ * trimmed when the file is closed. If the volume rejects unbuffered writes the
+ * writer silently falls back to buffered mode.
+ */
+class AsyncFileWriter {
+private:
+    /// A coalesced write waiting for or being executed by a writer thread
+    struct WriteJob {
+        BYTE* buffer;
+        size_t size;
+        UINT64 offset;
+        std::chrono::steady_clock::time_point submitted;
+        UINT64 serial;     ///< Submission order of this write
+        UINT64 dependsOn;  ///< Serial of the padded write whose last sector this one rewrites, or 0
+    };
+
+    /// Handle of the output file
+    HANDLE file = INVALID_HANDLE_VALUE;
+
+    /// Path of the output file, kept for diagnostics and reopening
+    std::filesystem::path filePath;
+
+    /// Size of each staging buffer in bytes
+    const size_t bufferSize;
+
+    /// Maximum number of writes executing concurrently
+    const size_t maxInFlight;
+
+    /// Whether the file was opened with FILE_FLAG_NO_BUFFERING
+    bool directIo = false;
+
+    /// Write granularity in direct-I/O mode (1 when buffered)
+    size_t sectorSize = 1;
+
+    /// Aligned staging buffers: one per in-flight write plus the one being filled
+    std::unique_ptr<AlignedBufferPool> bufferPool;
+
+    /// Buffer currently being filled by append()
+    BYTE* stagingBuffer = nullptr;
+
+    /// Number of bytes used in the staging buffer
+    size_t stagingSize = 0;
+
+    /// File offset at which the staging buffer will be written
+    UINT64 stagingOffset = 0;
+
+    /// Last partial sector of the previous padded write, carried into the next buffer
+    std::vector<BYTE> carriedTail;
+
+    /// Number of carried bytes at the start of the staging buffer
+    size_t carriedSize = 0;
+
+    /// Serial of the padded write the carried bytes came from, or 0
+    UINT64 carriedFromSerial = 0;
+
+    /// Serial of the most recently submitted write
+    UINT64 lastSerial = 0;
+
+    /// Writes waiting for a writer thread
+    std::queue<WriteJob> pendingJobs;
+
+    /// Number of writes submitted but not yet completed
+    size_t outstandingJobs = 0;
+
+    /// Serials of padded writes not yet completed; a write overlapping one of them must wait
+    std::set<UINT64> paddedWritesInFlight;
+
+    /// Guards pendingJobs, outstandingJobs, paddedWritesInFlight and the statistics
+    mutable std::mutex jobsLock;
+
+    /// Signals writer threads that a job is available or the writer is closing
+    std::condition_variable jobsAvailable;
+
+    /// Signals appenders that a buffer was returned or a job completed
+    std::condition_variable jobsCompleted;
+
+    /// Writer threads executing positioned writes
+    std::vector<std::thread> workers;
+
+    /// Flag telling writer threads to exit once the queue is empty
+    bool stopping = false;
+
+    /// Flag set after the first failed write so the error is only reported once
+    std::atomic<bool> failed = false;
+
+    // Statistics, guarded by jobsLock
+    UINT64 bytesWritten = 0;
+    UINT64 writesCompleted = 0;
+    UINT64 writeErrors = 0;
+    UINT64 appendStalls = 0;
+    double totalQueueDelayMs = 0;
+    double totalWriteSeconds = 0;
+    double maxQueueDelayMs = 0;
+    std::chrono::steady_clock::time_point firstSubmit;
+    std::chrono::steady_clock::time_point lastComplete;
+
+    /**
+     * @brief Opens the output file, probing whether unbuffered writes are supported.
+     * @return true if the file is open in the requested or fallback mode
+     */
+    bool openFile(bool requestDirectIo);
+
+    /**
+     * @brief Queues the staging buffer for writing and acquires a fresh one.
+     *
+     * Blocks while all buffers are in flight. In direct-I/O mode a partial buffer
+     * is padded to a whole sector and its last partial sector is carried over.
+     */
+    void submitStaging();
+
+    /**
+     * @brief Writer thread body: executes queued jobs until the writer closes.
+     */
+    void workerLoop();
+
+    /**
+     * @brief Writes a whole job at its file offset.
+     * @return true if every byte was written
+     */
+    bool writeJob(const WriteJob& job);
+
+public:
+    /**
+     * @brief Creates (truncating) the output file and starts the writer threads.
+     * @param filePath File to write
+     * @param options Buffer size, write concurrency and I/O mode
+     */
+    AsyncFileWriter(const std::filesystem::path& filePath, const AsyncWriterOptions& options = {});
+
+    /**
+     * @brief Checks whether the output file was opened successfully.
+     */
+    bool isOpen() const;
+
+    /**
+     * @brief Checks whether any write has failed since the file was opened.
+     */
+    bool hasFailed() const;
+
+    /**
+     * @brief Checks whether the file is written with unbuffered direct I/O.
+     */
+    bool isDirectIo() const;
+
+    /**
+     * @brief Appends bytes to the end of the file.
+     * @param data Bytes to append
+     * @param size Number of bytes
+     *
+     * The data is copied, so the caller may release it as soon as this returns.
+     */
+    void append(const void* data, size_t size);
+
+    /**
+     * @brief Submits any partially filled staging buffer without waiting for it.
+     */
+    void flush();
+
+    /**
+     * @brief Submits pending data and waits until every write has completed.
+     */
+    void drain();
+
+    /**
+     * @brief Drains, stops the writer threads, trims direct-I/O padding and closes the file.
+     */
+    void close();
+
+    /**
+     * @brief Total number of bytes appended so far, written or not.
+     */
+    UINT64 size() const;
+
+    /**
+     * @brief Returns a snapshot of the throughput and queueing statistics.
+     */
+    AsyncWriterStats getStats() const;
+
+    /**
+     * @brief Closes the file, waiting for outstanding writes.
+     */
+    ~AsyncFileWriter();
+
+    AsyncFileWriter(const AsyncFileWriter&) = delete;
+    AsyncFileWriter& operator=(const AsyncFileWriter&) = delete;
+};
@@ -0,0 +1,224 @@
+#include "FrameLabeler.h"
+
+#include <algorithm>
+#include <climits>
+#include <cstring>
+
+void FrameLabeler::takeMessages() {
+    std::queue<std::shared_ptr<KeyEvent>> keyEvents;
+    {
+        std::lock_guard<std::mutex> lock(Subscriber<KeyEvent>::queueLock);
+        Subscriber<KeyEvent>::msgQueue.swap(keyEvents);
+    }
+
+    while (!keyEvents.empty()) {
+        const KeyEvent& keyEvent = *keyEvents.front();
+
+        // Latency correction can reorder events by a few milliseconds, keep the queue sorted
+        auto position = pendingKeys.end();
+        while (position != pendingKeys.begin() && std::prev(position)->captureNs > keyEvent.captureNs) {
+            --position;
+        }
+        pendingKeys.insert(position, keyEvent);
+
+        latestKeyNs = std::max(latestKeyNs, keyEvent.captureNs);
+        keyEvents.pop();
+    }
+
+    std::queue<std::shared_ptr<ProcessedFrame>> frames;
+    {
+        std::lock_guard<std::mutex> lock(Subscriber<ProcessedFrame>::queueLock);
+        Subscriber<ProcessedFrame>::msgQueue.swap(frames);
+    }
+
+    while (!frames.empty()) {
+        const FrameHeader& header = frames.front()->header;
+
+        // Processing workers can finish frames out of order, keep the queue sorted by sequence
+        auto position = pendingFrames.end();
+        while (position != pendingFrames.begin() && std::prev(position)->sequence > header.sequence) {
+            --position;
+        }
+        pendingFrames.insert(position, PendingFrame{header.sequence, header.captureNs});
+        frames.pop();
+    }
+}
+
+void FrameLabeler::applyKey(const KeyEvent& keyEvent) {
+    UINT8 key = static_cast<UINT8>(keyEvent.vkey & 0xFF);
+    UINT64& word = heldKeys[key / 64];
+    UINT64 bit = 1ULL << (key % 64);
+
+    if (keyEvent.pressed) {
+        if (!(word & bit)) {
+            resolveAwaiting(keyEvent.captureNs, key);
+            lastPressNs = keyEvent.captureNs;
+            lastPressKey = key;
+        }
+        word |= bit;
+    } else {
+        word &= ~bit;
+        lastReleaseNs = keyEvent.captureNs;
+        lastReleaseKey = key;
+    }
+}
+
+FrameLabelRecord FrameLabeler::labelFrame(const PendingFrame& frame) const {
+    FrameLabelRecord record = {};
+    record.frameSequence = frame.sequence;
+    record.captureNs = frame.captureNs;
+    memcpy(record.heldKeys, heldKeys, sizeof(heldKeys));
+
+    record.lastPressKey = lastPressKey;
+    record.sinceLastPressUs = lastPressKey != LABEL_KEY_NONE ? toMicroseconds(frame.captureNs - lastPressNs) : LABEL_TIME_NONE;
+    record.lastReleaseKey = lastReleaseKey;
+    record.sinceLastReleaseUs = lastReleaseKey != LABEL_KEY_NONE ? toMicroseconds(frame.captureNs - lastReleaseNs) : LABEL_TIME_NONE;
+
+    record.untilNextPressUs = LABEL_TIME_NONE;
+    record.nextPressKey = LABEL_KEY_NONE;
+    return record;
+}
+
+void FrameLabeler::resolveAwaiting(INT64 pressNs, UINT8 key) {
+    while (!awaitingNextPress.empty() && awaitingNextPress.front().captureNs < pressNs) {
+        FrameLabelRecord& record = awaitingNextPress.front();
+        if (pressNs - record.captureNs <= nextPressHorizonNs) {
+            record.untilNextPressUs = toMicroseconds(pressNs - record.captureNs);
+            record.nextPressKey = key;
+        }
+        stageRecord(record);
+        awaitingNextPress.pop_front();
+    }
+}
+
+void FrameLabeler::advance(INT64 watermark) {
+    while (!pendingFrames.empty() && pendingFrames.front().captureNs <= watermark) {
+        const PendingFrame& frame = pendingFrames.front();
+
+        while (!pendingKeys.empty() && pendingKeys.front().captureNs <= frame.captureNs) {
+            applyKey(pendingKeys.front());
+            pendingKeys.pop_front();
+        }
+
+        awaitingNextPress.push_back(labelFrame(frame));
+        pendingFrames.pop_front();
+    }
+
+    // Keys past the newest frame can't be applied yet, but the first new press among
+    // them is the next press for every frame still waiting
+    UINT64 held[4];
+    memcpy(held, heldKeys, sizeof(held));
+    for (const KeyEvent& keyEvent : pendingKeys) {
+        UINT8 key = static_cast<UINT8>(keyEvent.vkey & 0xFF);
+        UINT64 bit = 1ULL << (key % 64);
+        if (keyEvent.pressed && !(held[key / 64] & bit)) {
+            resolveAwaiting(keyEvent.captureNs, key);
+            break;
+        }
+        if (keyEvent.pressed) {
+            held[key / 64] |= bit;
+        } else {
+            held[key / 64] &= ~bit;
+        }
+    }
+
+    // No press can arrive within the horizon of frames this old
+    while (!awaitingNextPress.empty() && watermark - awaitingNextPress.front().captureNs > nextPressHorizonNs) {
+        stageRecord(awaitingNextPress.front());
+        awaitingNextPress.pop_front();
+    }
+}
+
+void FrameLabeler::stageRecord(const FrameLabelRecord& record) {
+    if ((framesLabeled > 0 && record.frameSequence <= lastSequence) || record.captureNs < lastCaptureNs) {
+        framesOutOfOrder++;
+        return;
+    }
+    lastSequence = record.frameSequence;
+    lastCaptureNs = record.captureNs;
+
+    writeBuffer.push_back(record);
+    framesLabeled++;
+
+    if (writeBuffer.size() == WRITE_BUFFER_RECORDS) {
+        writeBufferedRecords();
+    }
+}
+
+void FrameLabeler::writeBufferedRecords() {
+    if (writeBuffer.empty() || labelFile == INVALID_HANDLE_VALUE) {
+        writeBuffer.clear();
+        return;
+    }
+
+    DWORD bytes = static_cast<DWORD>(writeBuffer.size() * sizeof(FrameLabelRecord));
+    DWORD written = 0;
+    if (!WriteFile(labelFile, writeBuffer.data(), bytes, &written, nullptr) || written != bytes) {
+        std::string message = "FrameLabeler: write failed, error " + std::to_string(GetLastError()) + "\n";
+        OutputDebugStringA(message.c_str());
+    }
+
+    writeBuffer.clear();
+}
+
+INT32 FrameLabeler::toMicroseconds(INT64 ns) {
+    return static_cast<INT32>(std::clamp<INT64>(ns / 1000, 0, INT_MAX));
+}
+
+void FrameLabeler::process() {
+    takeMessages();
+    advance(std::max(latestKeyNs, Timebase::getInstance().now() - KEY_ARRIVAL_SLACK_NS));
+    writeBufferedRecords();
+}
+
+void FrameLabeler::close() {
+    if (labelFile == INVALID_HANDLE_VALUE) return;
+
+    takeMessages();
+    advance(LLONG_MAX);
+
+    // Whatever is still waiting has no press within the recording
+    while (!awaitingNextPress.empty()) {
+        stageRecord(awaitingNextPress.front());
+        awaitingNextPress.pop_front();
+    }
+    writeBufferedRecords();
+
+    CloseHandle(labelFile);
+    labelFile = INVALID_HANDLE_VALUE;
+
+    std::string message = "FrameLabeler: " + std::to_string(framesLabeled) + " frames labeled, " +
+                          std::to_string(framesOutOfOrder) + " dropped out of order\n";
+    OutputDebugStringA(message.c_str());
+}
+
+UINT64 FrameLabeler::getFramesLabeled() const {
+    return framesLabeled;
+}
+
+FrameLabeler::FrameLabeler(const std::filesystem::path& filePath, std::chrono::milliseconds nextPressHorizon)
+    : labelFilePath(filePath), nextPressHorizonNs(std::chrono::duration_cast<std::chrono::nanoseconds>(nextPressHorizon).count()) {
+    writeBuffer.reserve(WRITE_BUFFER_RECORDS);
+
+    labelFile = CreateFileW(labelFilePath.wstring().c_str(), GENERIC_WRITE, FILE_SHARE_READ, nullptr,
+                            CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (labelFile == INVALID_HANDLE_VALUE) {
+        std::string message = "FrameLabeler: failed to open " + labelFilePath.string() +
+                              ", error " + std::to_string(GetLastError()) + "\n";
+        OutputDebugStringA(message.c_str());
+        return;
+    }
+
+    FrameLabelHeader header = {};
+    header.magic = FRAME_LABEL_MAGIC;
+    header.version = FRAME_LABEL_VERSION;
+    header.recordSize = sizeof(FrameLabelRecord);
+    header.nextPressHorizonUs = toMicroseconds(nextPressHorizonNs);
+
+    DWORD written = 0;
+    WriteFile(labelFile, &header, sizeof(header), &written, nullptr);
+}
+
+FrameLabeler::~FrameLabeler() {
+    close();
+}
@@ -0,0 +1,177 @@
+#pragma once
+
+//clang-format off
+#include <windows.h>
+//clang-format on
+
+#include <chrono>
+#include <climits>
+#include <deque>
+#include <filesystem>
+#include <queue>
+#include <string>
+#include <vector>
+
+#include "../../config.h"
+#include "../base/Subscriber.h"
+#include "../capture/Timebase.h"
+#include "../formats/FrameLabelFormat.h"
+#include "../types.h"
+
+/**
+ * @brief Streaming join of key events and frames into per-frame keyboard labels.
+ *
+ * FrameLabeler subscribes to both KeyEventPublisher and FrameProcessor and writes
+ * one FrameLabelRecord per frame to labels.bin: the keys held at capture time,
+ * and the time since the last press and release. The time until the next press
+ * is only known later, so labeled frames wait until a press arrives or the
+ * horizon passes, then are written in frame order.
+ *
+ * Both streams are joined on their session-clock capture times. Frames reach
+ * the labeler much later than key events, so key events are only applied up to
+ * the newest frame. A frame is labeled once every key event up to its capture
+ * time must have arrived: either a later key event was seen or the key hook's
+ * worst-case delivery delay has passed.
+ */
+class FrameLabeler : public Subscriber<KeyEvent>, public Subscriber<ProcessedFrame> {
+private:
+    /// Longest time a key event may take from capture to reaching the labeler
+    static constexpr INT64 KEY_ARRIVAL_SLACK_NS = 250000000;
+
+    /// Number of records the write buffer holds before it is written out
+    static constexpr size_t WRITE_BUFFER_RECORDS = 1024;
+
+    /// A frame waiting for the key events up to its capture time
+    struct PendingFrame {
+        UINT64 sequence;
+        INT64 captureNs;
+    };
+
+    /// Path of the label file
+    std::filesystem::path labelFilePath;
+
+    /// Handle of the open label file
+    HANDLE labelFile = INVALID_HANDLE_VALUE;
+
+    /// Presses further ahead of a frame than this are not recorded
+    INT64 nextPressHorizonNs;
+
+    /// Key events not yet applied, sorted by capture time
+    std::deque<KeyEvent> pendingKeys;
+
+    /// Frames not yet labeled, sorted by sequence
+    std::deque<PendingFrame> pendingFrames;
+
+    /// Labeled frames waiting for the next press
+    std::deque<FrameLabelRecord> awaitingNextPress;
+
+    /// Preallocated staging buffer for finished records
+    std::vector<FrameLabelRecord> writeBuffer;
+
+    /// Bit v set while virtual key v is held down
+    UINT64 heldKeys[4] = {};
+
+    /// Capture time and key of the most recent applied press and release
+    INT64 lastPressNs = 0;
+    INT64 lastReleaseNs = 0;
+    UINT8 lastPressKey = LABEL_KEY_NONE;
+    UINT8 lastReleaseKey = LABEL_KEY_NONE;
+
+    /// Capture time of the newest key event received
+    INT64 latestKeyNs = 0;
+
+    /// Number of records written
+    UINT64 framesLabeled = 0;
+
+    /// Sequence and capture time of the last staged record, which later records must not precede
+    UINT64 lastSequence = 0;
+    INT64 lastCaptureNs = LLONG_MIN;
+
+    /// Number of frames dropped because they arrived after a later frame was written
+    UINT64 framesOutOfOrder = 0;
+
+    /**
+     * @brief Moves newly published key events and frames into the pending queues.
+     */
+    void takeMessages();
+
+    /**
+     * @brief Updates the held-key state with one key event.
+     *
+     * A press of a key not already held resolves every frame captured before it.
+     * Auto-repeat presses of a held key are not new presses.
+     */
+    void applyKey(const KeyEvent& keyEvent);
+
+    /**
+     * @brief Builds the label of a frame from the current held-key state.
+     */
+    FrameLabelRecord labelFrame(const PendingFrame& frame) const;
+
+    /**
+     * @brief Finishes the frames captured before a press and stages them for writing.
+     * @param pressNs Capture time of the press
+     * @param key Virtual key pressed
+     */
+    void resolveAwaiting(INT64 pressNs, UINT8 key);
+
+    /**
+     * @brief Labels frames and finishes records as far as the watermark allows.
+     * @param watermark Session time up to which every key event has arrived
+     */
+    void advance(INT64 watermark);
+
+    /**
+     * @brief Stages a finished record and writes the buffer when it is full.
+     *
+     * A record preceding the last staged one in sequence or capture time is
+     * dropped, so the file stays sorted for binary search.
+     */
+    void stageRecord(const FrameLabelRecord& record);
+
+    /**
+     * @brief Writes the staged records to the label file and empties the buffer.
+     */
+    void writeBufferedRecords();
+
+    /**
+     * @brief Converts a positive interval to clamped microseconds.
+     */
+    static INT32 toMicroseconds(INT64 ns);
+
+public:
+    /**
+     * @brief Creates (truncating) the label file and writes its header.
+     * @param filePath Path of labels.bin in the session directory
+     * @param nextPressHorizon Presses further ahead of a frame than this are recorded as none
+     */
+    FrameLabeler(const std::filesystem::path& filePath,
+                 std::chrono::milliseconds nextPressHorizon = std::chrono::milliseconds(LABEL_NEXT_PRESS_HORIZON_MS));
+
+    /**
+     * @brief Joins everything received so far and writes the finished labels.
+     *
+     * Called periodically from the labeler thread.
+     */
+    void process();
+
+    /**
+     * @brief Labels every remaining frame, writes all records and closes the file.
+     *
+     * Call after unsubscribing from both publishers.
+     */
+    void close();
+
+    /**
+     * @brief Number of label records written so far.
+     */
+    UINT64 getFramesLabeled() const;
+
+    /**
+     * @brief Destructor closes the label file if close() was not called.
+     */
+    ~FrameLabeler();
+
+    FrameLabeler(const FrameLabeler&) = delete;
+    FrameLabeler& operator=(const FrameLabeler&) = delete;
+};
@@ -1,42 +1,305 @@
 #include "FrameLogger.h"
 
-void FrameLogger::writeFrameToDisk(ProcessedFrame* frame) {
-    if (!frame || !frame->data) return;
+#include <algorithm>
+#include <cstring>
 
-    size_t requiredSize = sizeof(FrameHeader) + frame->header.dataSize;
+#include "../formats/Checksum.h"
 
-    std::stringstream fileName;
-    fileName << logDirectory.string() << "/frame_" << std::setw(6) << std::setfill('0') << frameCount++ << ".raw";
+namespace {
 
-    std::ofstream file(fileName.str(), std::ios::binary);
-    if (!file.is_open()) {
-        return;  // TODO? Handle error appropriately
+/**
+ * @brief Whether the codec can store a frame: BGR24 with its pixels.
+ */
+bool isEncodable(const ProcessedFrame& frame) {
+    return frame.data && frame.header.pixelFormat == PIXEL_FORMAT_BGR24 &&
+           frame.header.dataSize == static_cast<size_t>(frame.header.width) * frame.header.height * 3;
+}
+
+}  // namespace
+
+bool FrameLogger::isDuplicate(const ProcessedFrame& frame, UINT32 hash) const {
+    if (!lastStored || hash != lastStoredHash) return false;
+
+    const FrameHeader& previous = lastStored->header;
+    if (previous.dataSize != frame.header.dataSize || previous.width != frame.header.width ||
+        previous.height != frame.header.height || previous.pixelFormat != frame.header.pixelFormat) {
+        return false;
     }
 
-    file.write(reinterpret_cast<const char*>(&frame->header), sizeof(FrameHeader));
+    // The hash only samples rows, so confirm the frames are identical
+    return memcmp(lastStored->data.get(), frame.data.get(), frame.header.dataSize) == 0;
+}
+
+bool FrameLogger::checkDuplicate(const std::shared_ptr<ProcessedFrame>& frame) {
+    if (!FRAME_LOG_DEDUPLICATE || !frame || !frame->data || (frame->header.flags & FRAME_FLAG_SHED)) return false;
+
+    UINT32 hash = sampledFrameHash(frame->header, frame->data.get());
+    if (isDuplicate(*frame, hash)) {
+        framesDuplicate++;
+        return true;
+    }
+
+    lastStoredHash = hash;
+    return false;
+}
+
+std::shared_ptr<ProcessedFrame> FrameLogger::chooseReference(const std::shared_ptr<ProcessedFrame>& frame) {
+    if (!compressPool) return nullptr;
+
+    // Anything the codec can't code against the previous frame starts a new group
+    const FrameHeader* previous = lastStored ? &lastStored->header : nullptr;
+    bool keyframe = gopPosition == 0 || !previous || !isEncodable(*frame) || !isEncodable(*lastStored) ||
+                    previous->width != frame->header.width || previous->height != frame->header.height;
+
+    gopPosition = keyframe ? 1 : gopPosition + 1;
+    if (gopPosition >= FRAME_LOG_GOP_LENGTH) gopPosition = 0;
+
+    return keyframe ? nullptr : lastStored;
+}
+
+void FrameLogger::compressBatch() {
+    if (batchEncoded.size() < batch.size()) batchEncoded.resize(batch.size());
+
+    compressPool->parallelFor(batch.size(), [this](size_t index, unsigned int thread) {
+        const std::shared_ptr<ProcessedFrame>& frame = batch[index];
+        std::vector<BYTE>& encoded = batchEncoded[index];
+        encoded.clear();
+
+        // Anything the codec can't store is stored as it is
+        if (batchDuplicate[index] || !frame || !isEncodable(*frame)) return;
+
+        // References are raw frames, so frames of a group encode independently of each other
+        const std::shared_ptr<ProcessedFrame>& reference = batchReference[index];
+        auto start = std::chrono::steady_clock::now();
+        encoders[thread].encode(frame->data.get(), frame->header.width, frame->header.height, encoded,
+                                reference ? reference->data.get() : nullptr);
+        auto elapsed = std::chrono::steady_clock::now() - start;
+
+        encodeNs += std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+        bytesBeforeCompression += frame->header.dataSize;
+        bytesAfterCompression += encoded.size();
+    });
+
+    // The buffers keep their capacity for the next batch, so account for it
+    codecAccount->setCapacity(batchEncoded);
+}
+
+void FrameLogger::writeFrameToDisk(const std::shared_ptr<ProcessedFrame>& frame, bool duplicate,
+                                   const std::vector<BYTE>* encoded) {
+    bool marker = frame && (frame->header.flags & FRAME_FLAG_SHED);
+    if (!frame || (!frame->data && !marker)) return;
+
+    // Past a failed write the container has a hole, so the rest of the session is counted as lost
+    if (!writer.isOpen() || writer.hasFailed()) {
+        if (!writerLossReported) {
+            writerLossReported = true;
+            std::string message = "FrameLogger: " + containerPath.string() +
+                                  (writer.isOpen() ? " failed to write" : " is not open") + ", frames are lost from here on\n";
+            OutputDebugStringA(message.c_str());
+            StorageManager::getInstance().reportWriteFailure();
+        }
+
+        // Gap markers are counted as shed already
+        if (!marker) framesLost++;
+        return;
+    }
+
+    // The session starts mid-stream, so only gaps after the first record count
+    if (expectedSequence != 0 && frame->header.sequence > expectedSequence) {
+        framesMissing += frame->header.sequence - expectedSequence;
+    }
+    expectedSequence = frame->header.sequence + 1;
+
+    // The header is shared with other subscribers, so stamp a copy
+    FrameHeader header = frame->header;
+    LARGE_INTEGER writeTime;
+    QueryPerformanceCounter(&writeTime);
+    header.writeNs = qpcToNanoseconds(writeTime.QuadPart, frequency.QuadPart);
+
+    const BYTE* data = frame->data.get();
+    if (duplicate) {
+        // Readers take the pixels from the last record that has them
+        header.flags |= FRAME_FLAG_DUPLICATE;
+        header.dataSize = 0;
+    } else if (encoded && !encoded->empty()) {
+        header.flags |= FRAME_FLAG_COMPRESSED;
+        header.dataSize = static_cast<UINT32>(encoded->size());
+        data = encoded->data();
+
+        // The encoder only uses the reference where it helps, a frame that ended up without is a keyframe
+        LosslessFrameHeader codecHeader;
+        if (readLosslessHeader(data, encoded->size(), codecHeader) && losslessNeedsReference(codecHeader)) {
+            header.flags |= FRAME_FLAG_DELTA;
+            framesDelta++;
+        }
+    }
+
+    // Lets session_verify find records damaged in transit; computed after writeNs so the whole header is covered
+    if (FRAME_LOG_CHECKSUM) {
+        header.flags |= FRAME_FLAG_CHECKSUM;
+        header.checksum = frameRecordChecksum(header, data);
+    }
+
+    writer.append(&header, sizeof(FrameHeader));
+
+    if (marker || duplicate) return;
 
     // Write frame data
-    file.write(reinterpret_cast<const char*>(frame->data.get()), frame->header.dataSize);
+    writer.append(data, header.dataSize);
 
-    file.close();
+    frameCount++;
+}
+
+void FrameLogger::enqueue(std::shared_ptr<ProcessedFrame> frame) {
+    // Short of disk space every other frame goes first, keeping the recording's timeline even
+    StoragePressure storage = StorageManager::getInstance().getPressure();
+    bool shed = MemoryAccountant::getInstance().getPressure() >= MemoryPressure::SHED_LOGGING ||
+                storage >= StoragePressure::SHED_FRAMES ||
+                (storage >= StoragePressure::DEGRADE_CAPTURE && frame && (frame->header.sequence & 1));
+
+    if (frame && shed) {
+        auto marker = std::make_shared<ProcessedFrame>();
+        marker->header = frame->header;
+        marker->header.flags |= FRAME_FLAG_SHED;
+        marker->header.dataSize = 0;
+
+        framesShed++;
+        BatchSubscriber::enqueue(marker);
+        return;
+    }
+
+    BatchSubscriber::enqueue(frame);
 }
 
 void FrameLogger::processBatch() {
-    UINT32 batchFrameCount = 0;
     while (!flushQueue.empty()) {
-        std::shared_ptr<ProcessedFrame> frame = flushQueue.front();
+        batch.push_back(takeFlushed());
+    }
+
+    // Duplicates and deltas refer to the record before them, so they are decided in order before encoding in parallel
+    batchDuplicate.resize(batch.size());
+    batchReference.resize(batch.size());
+    for (size_t i = 0; i < batch.size(); i++) {
+        const std::shared_ptr<ProcessedFrame>& frame = batch[i];
+        batchDuplicate[i] = checkDuplicate(frame);
+        batchReference[i] = nullptr;
+
+        bool stored = frame && frame->data && !(frame->header.flags & FRAME_FLAG_SHED) && !batchDuplicate[i];
+        if (!stored) continue;
+
+        batchReference[i] = chooseReference(frame);
+        lastStored = frame;
+    }
+
+    if (compressPool) compressBatch();
+
+    UINT64 containerBytes = writer.size();
+    for (size_t i = 0; i < batch.size(); i++) {
+        writeFrameToDisk(batch[i], batchDuplicate[i], compressPool ? &batchEncoded[i] : nullptr);
+    }
+    batch.clear();
+    batchReference.clear();
+
+    // Hand the partial buffer to the writer so the batch reaches disk without waiting for more frames
+    writer.flush();
 
-        writeFrameToDisk(frame.get());
-        batchFrameCount++;
-        flushQueue.pop();
+    // The writer threads finish the batch later, so it is charged at the disk time per byte of their recent writes
+    if (policy.adaptiveFlushTime.count() > 0) {
+        AsyncWriterStats stats = writer.getStats();
+        UINT64 bytes = stats.bytesWritten - lastWriterStats.bytesWritten;
+        double seconds = stats.writeSeconds - lastWriterStats.writeSeconds;
+        if (bytes > 0 && seconds > 0) {
+            double batchSeconds = (writer.size() - containerBytes) * (seconds / bytes);
+            updateAdaptiveLimit(flushedUnits, std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                                                  std::chrono::duration<double>(batchSeconds)));
+            lastWriterStats = stats;
+        }
     }
 }
 
-FrameLogger::FrameLogger(const std::filesystem::path& logDir)
-    : logDirectory(logDir), startTime(std::chrono::steady_clock::now()) {
+void FrameLogger::drain() {
+    writer.drain();
+}
+
+size_t FrameLogger::getFrameCount() const {
+    return frameCount;
+}
+
+UINT64 FrameLogger::getFramesShed() const {
+    return framesShed;
+}
+
+UINT64 FrameLogger::getFramesDuplicate() const {
+    return framesDuplicate;
+}
+
+UINT64 FrameLogger::getFramesMissing() const {
+    return framesMissing;
+}
+
+UINT64 FrameLogger::getFramesLost() const {
+    return framesLost;
+}
+
+UINT64 FrameLogger::getFramesDelta() const {
+    return framesDelta;
+}
+
+double FrameLogger::getCompressionRatio() const {
+    UINT64 after = bytesAfterCompression;
+    return after > 0 ? static_cast<double>(bytesBeforeCompression) / after : 0.0;
+}
+
+double FrameLogger::getEncodeMBps() const {
+    UINT64 ns = encodeNs;
+    return ns > 0 ? bytesBeforeCompression / (1024.0 * 1024.0) / (ns / 1e9) : 0.0;
+}
+
+AsyncWriterStats FrameLogger::getWriterStats() const {
+    return writer.getStats();
+}
+
+AsyncWriterOptions FrameLogger::writerOptions() {
+    AsyncWriterOptions options;
+    options.directIo = FRAME_LOG_DIRECT_IO;
+    return options;
+}
+
+BatchPolicy FrameLogger::batchPolicy() {
+    BatchPolicy policy;
+    policy.maxItems = FRAME_LOG_BATCH_FRAMES;
+    policy.maxBytes = static_cast<size_t>(FRAME_LOG_BATCH_MB) * 1024 * 1024;
+    policy.maxAge = std::chrono::milliseconds(FRAME_LOG_BATCH_AGE_MS);
+    policy.adaptiveFlushTime = std::chrono::milliseconds(FRAME_LOG_ADAPTIVE_FLUSH_MS);
+    return policy;
+}
+
+FrameLogger::FrameLogger(const std::filesystem::path& filePath)
+    : BatchSubscriber(batchPolicy(), processedFrameBytes),
+      containerPath(filePath), writer(filePath, writerOptions()), startTime(std::chrono::steady_clock::now()) {
     QueryPerformanceFrequency(&frequency);
+    trackQueue("frame_logger_queue", false, processedFrameBytes);
+
+    if (FRAME_LOG_COMPRESS) {
+        compressPool = std::make_unique<WorkerPool>(WorkerPool::configuredThreads(FRAME_LOG_COMPRESS_WORKERS));
+        encoders.resize(compressPool->getThreadCount());
+        codecAccount = MemoryAccountant::getInstance().getAccount("frame_logger_codec", true);
+    }
 }
 
 FrameLogger::~FrameLogger() {
     flush();
-}
\ No newline at end of file
+    writer.close();
+    lastStored.reset();
+
+    if (codecAccount) {
+        codecAccount->remove(codecAccount->getBytes(), 0);
+    }
+
+    AsyncWriterStats stats = writer.getStats();
+    char message[400];
+    sprintf_s(message, "FrameLogger: %zu frames, %llu duplicates, %llu shed, %llu lost (%s), %.1f MB at %.1f MB/s, queue delay avg %.2f ms max %.2f ms, %llu stalls, %llu deltas, compression %.2fx at %.1f MB/s per thread\n",
+              frameCount, framesDuplicate.load(), framesShed.load(), framesLost.load(), stats.directIo ? "direct" : "buffered", stats.bytesWritten / (1024.0 * 1024.0), stats.throughputMBps,
+              stats.avgQueueDelayMs, stats.maxQueueDelayMs, stats.appendStalls, framesDelta, getCompressionRatio(), getEncodeMBps());
+    OutputDebugStringA(message);
+}
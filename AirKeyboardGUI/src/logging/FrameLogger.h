@@ -2,62 +2,199 @@
 
 #include <mfapi.h>
 
+#include <atomic>
 #include <chrono>
 #include <filesystem>
-#include <fstream>
-#include <iomanip>
-#include <sstream>
+#include <memory>
+#include <string>
 #include <vector>
 
+#include "../../config.h"
 #include "../base/BatchSubscriber.h"
+#include "../base/WorkerPool.h"
+#include "../codec/LosslessCodec.h"
+#include "../metrics/MemoryAccountant.h"
 #include "../types.h"
+#include "AsyncFileWriter.h"
+#include "StorageManager.h"
 
 /**
  * @brief Batch processor that logs video frames to disk in binary format.
  *
- * FrameLogger receives IMFSample objects containing video frame data and writes
- * them to individual .raw files with metadata headers. Processes frames in batches
- * for improved I/O performance and maintains session information.
+ * FrameLogger receives ProcessedFrame objects and appends them, header followed by
+ * pixel data, to a single session container file. Writes go through an
+ * AsyncFileWriter, so contiguous frames are coalesced into large writes that run
+ * off the logger thread and the batch queue drains as fast as frames can be copied.
+ *
+ * With FRAME_LOG_COMPRESS set, the frames of a batch are encoded with the
+ * lossless codec on a worker pool before they are appended, in order. Every
+ * FRAME_LOG_GOP_LENGTH frames is a keyframe; the frames between are coded
+ * against the frame stored before them.
  */
-class FrameLogger : public BatchSubscriber<ProcessedFrame, 100> {
+class FrameLogger : public BatchSubscriber<ProcessedFrame> {
 private:
-    std::filesystem::path logDirectory;  /// Directory path where frame files will be written
+    std::filesystem::path containerPath;  /// Path of the session frame container
+
+    AsyncFileWriter writer;  /// Asynchronous writer for the frame container
+
+    size_t frameCount = 0;                                        /// Number of frames appended to the container
+    std::atomic<UINT64> framesShed = 0;                           /// Frames replaced by gap markers under memory or disk pressure
+    std::atomic<UINT64> framesDuplicate = 0;                      /// Frames written as references to the previous frame
+    std::atomic<UINT64> framesMissing = 0;                        /// Frames missing from the capture sequence numbers
+    std::atomic<UINT64> framesLost = 0;                           /// Frames not stored because the writer was closed or had failed
+    bool writerLossReported = false;                              /// Whether the closed or failed writer has been reported
+    UINT64 expectedSequence = 0;                                  /// Sequence number the next record should carry, 0 before the first
+    std::shared_ptr<ProcessedFrame> lastStored;                   /// Most recent frame written with pixel data
+    UINT32 lastStoredHash = 0;                                    /// sampledFrameHash() of lastStored
+    std::unique_ptr<WorkerPool> compressPool;                     /// Threads encoding the frames of a batch
+    std::vector<LosslessEncoder> encoders;                        /// Encoder of every compressPool thread
+    std::vector<std::shared_ptr<ProcessedFrame>> batch;           /// Frames of the batch being written
+    std::vector<char> batchDuplicate;                             /// Whether each frame of batch duplicates its predecessor
+    std::vector<std::shared_ptr<ProcessedFrame>> batchReference;  /// Frame each frame of batch is coded against, or nullptr
+    UINT32 gopPosition = 0;                                       /// Frames stored since the last keyframe
+    UINT64 framesDelta = 0;                                       /// Frames stored coded against their predecessor
+    std::vector<std::vector<BYTE>> batchEncoded;                  /// Encoded data of each frame of batch, reused between batches
+    MemoryAccount* codecAccount = nullptr;                        /// Capacity of batchEncoded
+    std::atomic<UINT64> bytesBeforeCompression = 0;               /// Pixel bytes of the frames encoded so far
+    std::atomic<UINT64> bytesAfterCompression = 0;                /// Encoded bytes of the frames encoded so far
+    std::atomic<UINT64> encodeNs = 0;                             /// Thread time spent encoding so far
+    AsyncWriterStats lastWriterStats;                             /// Writer statistics when the previous batch was sized
+    std::chrono::steady_clock::time_point startTime;              /// Session start time for duration tracking
+    LARGE_INTEGER frequency;                                      /// Performance counter frequency for timestamp conversion
+
+    /**
+     * @brief Builds the container writer configuration from config.h.
+     */
+    static AsyncWriterOptions writerOptions();
 
-    size_t frameCount = 0;                            /// Counter for generating sequential frame filenames
-    std::chrono::steady_clock::time_point startTime;  /// Session start time for duration tracking
-    LARGE_INTEGER frequency;                          /// Performance counter frequency for timestamp conversion
+    /**
+     * @brief Builds the batch limits from config.h.
+     */
+    static BatchPolicy batchPolicy();
 
     /**
-     * @brief Writes a single frame sample to disk as binary file.
-     * @param sample MediaFoundation sample containing frame data
+     * @brief Whether a frame's pixels are identical to the last frame written with pixel data.
+     * @param hash sampledFrameHash() of the frame
+     */
+    bool isDuplicate(const ProcessedFrame& frame, UINT32 hash) const;
+
+    /**
+     * @brief Decides whether a frame is stored as a duplicate of lastStored.
      *
-     * Extracts frame data, creates header with timing information,
-     * and writes both header and raw frame data to sequentially numbered file.
+     * Must be called in container order. Always false unless FRAME_LOG_DEDUPLICATE is set.
      */
-    void writeFrameToDisk(ProcessedFrame* frame);
+    bool checkDuplicate(const std::shared_ptr<ProcessedFrame>& frame);
 
     /**
-     * @brief Processes accumulated batch of frames by writing to disk.
+     * @brief Picks the frame a frame stored with pixels is coded against, nullptr for a keyframe.
      *
-     * Inherited from BatchSubscriber. Drains the flush queue and writes
-     * each frame to individual files with proper cleanup.
+     * Must be called in container order, before the frame becomes lastStored.
+     */
+    std::shared_ptr<ProcessedFrame> chooseReference(const std::shared_ptr<ProcessedFrame>& frame);
+
+    /**
+     * @brief Encodes the pixel data of every frame in batch that is stored with it.
+     */
+    void compressBatch();
+
+    /**
+     * @brief Appends a single frame record to the container.
+     * @param frame Processed frame to log
+     * @param duplicate Write a header-only duplicate record, see checkDuplicate()
+     * @param encoded Encoded pixel data to store instead of the raw pixels, or nullptr
+     *
+     * Copies header and pixel data into the writer's staging buffer; the actual
+     * disk write happens asynchronously. Gap markers and duplicates are written header only,
+     * and encoded data that needs its reference frame is flagged FRAME_FLAG_DELTA.
+     */
+    void writeFrameToDisk(const std::shared_ptr<ProcessedFrame>& frame, bool duplicate, const std::vector<BYTE>* encoded);
+
+    /**
+     * @brief Processes accumulated batch of frames by appending them to the container.
+     *
+     * Inherited from BatchSubscriber. Drains the flush queue, then submits the
+     * partially filled staging buffer so readers tailing the container see the batch.
      */
     void processBatch() override;
 
 public:
     /**
-     * @brief Constructs FrameLogger with specified output directory.
-     * @param logDir Directory path where frame files will be written
+     * @brief Constructs FrameLogger writing to the specified container file.
+     * @param filePath Path of the frame container to create
      *
-     * Creates session metadata file with timestamp and format information.
      * Initializes performance counter frequency for timing calculations.
      */
-    FrameLogger(const std::filesystem::path& logDir);
+    FrameLogger(const std::filesystem::path& filePath);
+
+    /**
+     * @brief Queues a frame, or a gap marker in its place at the hard memory budget or short of disk space.
+     * @param frame Shared pointer to the published frame
+     *
+     * The marker is the frame's header with FRAME_FLAG_SHED set and no data, so
+     * the container records which frame is missing and why. Under
+     * StoragePressure::DEGRADE_CAPTURE only frames with odd sequence numbers are
+     * replaced, under StoragePressure::SHED_FRAMES all of them.
+     */
+    void enqueue(std::shared_ptr<ProcessedFrame> frame) override;
+
+    /**
+     * @brief Waits until every frame appended so far has been written to the container.
+     */
+    void drain();
+
+    /**
+     * @brief Number of frames appended to the container so far.
+     */
+    size_t getFrameCount() const;
+
+    /**
+     * @brief Number of frames replaced by gap markers under memory or disk pressure so far.
+     */
+    UINT64 getFramesShed() const;
+
+    /**
+     * @brief Number of frames written as duplicates of the previous frame so far.
+     */
+    UINT64 getFramesDuplicate() const;
+
+    /**
+     * @brief Number of frames missing from the capture sequence numbers so far.
+     *
+     * Counts the frames dropped before they reached the logger, by the camera or
+     * FrameProcessor; frames shed here are gap markers and don't count.
+     */
+    UINT64 getFramesMissing() const;
+
+    /**
+     * @brief Number of frames not stored because the container wasn't open or a write to it had failed.
+     */
+    UINT64 getFramesLost() const;
+
+    /**
+     * @brief Number of frames stored coded against their predecessor so far.
+     */
+    UINT64 getFramesDelta() const;
+
+    /**
+     * @brief Raw pixel bytes divided by stored bytes of the frames compressed so far, 0 before the first.
+     */
+    double getCompressionRatio() const;
+
+    /**
+     * @brief Encoding throughput of a single compression thread in raw MB per second.
+     */
+    double getEncodeMBps() const;
+
+    /**
+     * @brief Returns the throughput and queueing statistics of the container writer.
+     */
+    AsyncWriterStats getWriterStats() const;
 
     /**
      * @brief Destructor ensures all pending frames are written to disk.
      *
-     * Calls flush() to process any remaining frames in the batch queue.
+     * Calls flush() to process any remaining frames in the batch queue, waits for
+     * outstanding writes and reports the achieved write throughput and compression.
      */
     ~FrameLogger();
-};
\ No newline at end of file
+};
@@ -1,7 +1,9 @@
 #include "FramePostProcessor.h"
 
-FramePostProcessor::FramePostProcessor(const std::string& dir)
-    : watch_dir(dir) {
+#include "../../config.h"
+
+FramePostProcessor::FramePostProcessor(const std::string& dir, const std::string& ring)
+    : watch_dir(dir), ring_name(ring) {
     ZeroMemory(&process_info, sizeof(process_info));
     ZeroMemory(&startup_info, sizeof(startup_info));
     startup_info.cb = sizeof(startup_info);
@@ -11,6 +13,12 @@ FramePostProcessor::FramePostProcessor(const std::string& dir)
 
 bool FramePostProcessor::SpawnWorker() {
     std::string command = "python frame_postprocessor.py \"" + watch_dir + "\" --workers 8";
+    if (!ring_name.empty()) {
+        command += " --ring \"" + ring_name + "\"";
+    }
+    if (POSTPROCESS_ANNOTATE_VIDEO) {
+        command += " --annotate";
+    }
 
     OutputDebugStringA(("Running command: " + command + "\n").c_str());
 
@@ -46,11 +54,16 @@ bool FramePostProcessor::SpawnWorker() {
 
 void FramePostProcessor::terminateWorker() {
     if (process_active && process_info.hProcess) {
-        // Create a shutdown signal file
-        std::ofstream shutdown_signal(watch_dir + "/.shutdown");
-        shutdown_signal.close();
+        if (ring_name.empty()) {
+            // Create a shutdown signal file
+            std::ofstream shutdown_signal(watch_dir + "/.shutdown");
+            shutdown_signal.close();
 
-        OutputDebugStringA("Signaled Python worker to shutdown...\n");
+            OutputDebugStringA("Signaled Python worker to shutdown...\n");
+        } else {
+            // The closed ring is the signal, the worker exits after reading the frames left in it
+            OutputDebugStringA("Waiting for Python worker to finish the frame ring...\n");
+        }
 
         // Wait for process to exit gracefully (up to 30 seconds)
         DWORD wait_result = WaitForSingleObject(process_info.hProcess, 30000);
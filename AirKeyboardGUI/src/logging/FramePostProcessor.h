@@ -16,9 +16,10 @@
 /**
  * @brief Manages external Python process for post-processing video frames.
  *
- * FramePostProcessor spawns and manages a Python worker process that monitors
- * a directory for .raw frame files, processes them (e.g., hand detection),
- * and handles graceful shutdown with signal files.
+ * FramePostProcessor spawns and manages a Python worker process that processes
+ * the session's frames (e.g., hand detection). Given a frame ring, the worker
+ * reads frames from shared memory and finishes when the ring is closed;
+ * otherwise it tails frames.bin and is shut down with a signal file.
  */
 class FramePostProcessor {
 private:
@@ -31,6 +32,9 @@ private:
     /// Directory path that Python worker monitors for frame files
     std::string watch_dir;
 
+    /// Name of the FrameRingWriter ring the worker reads frames from, empty to tail frames.bin
+    std::string ring_name;
+
     /// Flag indicating whether Python process is currently active
     bool process_active = false;
 
@@ -38,10 +42,11 @@ public:
     /**
      * @brief Constructs FramePostProcessor with target directory.
      * @param dir Directory path for Python worker to monitor
+     * @param ring Name of the frame ring to pass to the worker, empty to have it tail frames.bin
      *
      * Initializes process structures and sets up monitoring directory.
      */
-    FramePostProcessor(const std::string& dir);
+    FramePostProcessor(const std::string& dir, const std::string& ring = "");
 
     /**
      * @brief Spawns Python worker process to monitor frame directory.
@@ -55,8 +60,9 @@ public:
     /**
      * @brief Gracefully terminates Python worker process.
      *
-     * Creates shutdown signal file, waits for graceful exit (30 seconds),
-     * then forces termination if necessary. Cleans up process handles.
+     * Creates shutdown signal file unless the worker reads a ring, which must be
+     * closed first; waits for graceful exit (30 seconds), then forces
+     * termination if necessary. Cleans up process handles.
      */
     void terminateWorker();
 
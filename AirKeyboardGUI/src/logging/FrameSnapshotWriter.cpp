@@ -0,0 +1,114 @@
+#include "FrameSnapshotWriter.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+
+bool FrameSnapshotWriter::isSnapshot(const ProcessedFrame& frame) {
+    return FRAME_SNAPSHOT_INTERVAL > 0 && frame.header.sequence % FRAME_SNAPSHOT_INTERVAL == 0;
+}
+
+void FrameSnapshotWriter::writeSnapshot(const ProcessedFrame& frame, unsigned int thread) {
+    const FrameHeader& header = frame.header;
+    if (!frame.data || header.pixelFormat != PIXEL_FORMAT_BGR24 ||
+        header.dataSize != static_cast<size_t>(header.width) * header.height * 3) {
+        return;
+    }
+
+    std::vector<BYTE>& jpeg = encoded[thread];
+    auto start = std::chrono::steady_clock::now();
+    bool ok = encoders[thread].encode(frame.data.get(), header.width, header.height, FRAME_SNAPSHOT_QUALITY, jpeg);
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    encodeNs += std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+
+    char name[48];
+    sprintf_s(name, "snapshot_%06llu.jpg", header.sequence);
+    std::ofstream file;
+    if (ok) {
+        file.open(outputDir / name, std::ios::binary);
+        file.write(reinterpret_cast<const char*>(jpeg.data()), jpeg.size());
+    }
+
+    if (!ok || !file) {
+        if (writeFailures++ == 0) {
+            std::string message = "FrameSnapshotWriter: failed to write " + (outputDir / name).string() + "\n";
+            OutputDebugStringA(message.c_str());
+        }
+        return;
+    }
+
+    framesWritten++;
+    bytesWritten += jpeg.size();
+}
+
+void FrameSnapshotWriter::enqueue(std::shared_ptr<ProcessedFrame> frame) {
+    if (!frame || !isSnapshot(*frame)) return;
+
+    // frames.bin has these frames, the memory and disk space are better spent keeping it complete
+    if (MemoryAccountant::getInstance().getPressure() >= MemoryPressure::SHED_LOGGING ||
+        StorageManager::getInstance().getPressure() >= StoragePressure::DEGRADE_CAPTURE) {
+        framesSkipped++;
+        return;
+    }
+
+    BatchSubscriber::enqueue(frame);
+}
+
+void FrameSnapshotWriter::processBatch() {
+    while (!flushQueue.empty()) {
+        batch.push_back(takeFlushed());
+    }
+
+    encodePool->parallelFor(batch.size(), [this](size_t index, unsigned int thread) {
+        if (batch[index]) writeSnapshot(*batch[index], thread);
+    });
+    batch.clear();
+
+    // The buffers keep their capacity for the next batch, so account for it
+    encodeAccount->setCapacity(encoded);
+}
+
+UINT64 FrameSnapshotWriter::getFramesWritten() const {
+    return framesWritten;
+}
+
+UINT64 FrameSnapshotWriter::getFramesSkipped() const {
+    return framesSkipped;
+}
+
+double FrameSnapshotWriter::getEncodeFps() const {
+    UINT64 ns = encodeNs;
+    return ns > 0 ? framesWritten / (ns / 1e9) : 0.0;
+}
+
+BatchPolicy FrameSnapshotWriter::batchPolicy() {
+    // Batches of about one frame per encoding thread keep every thread busy without holding frames long
+    BatchPolicy policy;
+    policy.maxItems = WorkerPool::configuredThreads(FRAME_SNAPSHOT_WORKERS);
+    policy.maxAge = std::chrono::milliseconds(FRAME_LOG_BATCH_AGE_MS);
+    return policy;
+}
+
+FrameSnapshotWriter::FrameSnapshotWriter(const std::filesystem::path& directory)
+    : BatchSubscriber(batchPolicy(), processedFrameBytes), outputDir(directory) {
+    std::filesystem::create_directories(outputDir);
+    trackQueue("frame_snapshot_queue", false, processedFrameBytes);
+
+    encodePool = std::make_unique<WorkerPool>(WorkerPool::configuredThreads(FRAME_SNAPSHOT_WORKERS));
+    encoders.resize(encodePool->getThreadCount());
+    encoded.resize(encodePool->getThreadCount());
+    encodeAccount = MemoryAccountant::getInstance().getAccount("frame_snapshot_jpeg", true);
+}
+
+FrameSnapshotWriter::~FrameSnapshotWriter() {
+    flush();
+
+    encodeAccount->remove(encodeAccount->getBytes(), 0);
+
+    char message[256];
+    sprintf_s(message, "FrameSnapshotWriter: %llu snapshots at quality %d, %.1f MB, %llu skipped, %llu failed, %.1f fps per thread\n",
+              framesWritten.load(), FRAME_SNAPSHOT_QUALITY, bytesWritten / (1024.0 * 1024.0), framesSkipped.load(),
+              writeFailures.load(), getEncodeFps());
+    OutputDebugStringA(message);
+}
@@ -0,0 +1,108 @@
+#pragma once
+
+//clang-format off
+#include <windows.h>
+//clang-format on
+
+#include <atomic>
+#include <filesystem>
+#include <memory>
+#include <vector>
+
+#include "../../config.h"
+#include "../base/BatchSubscriber.h"
+#include "../base/WorkerPool.h"
+#include "../codec/JpegEncoder.h"
+#include "../metrics/MemoryAccountant.h"
+#include "../types.h"
+#include "StorageManager.h"
+
+/**
+ * @brief Batch processor that writes JPEG snapshots of processed frames.
+ *
+ * Takes every FRAME_SNAPSHOT_INTERVAL-th frame straight from FrameProcessor,
+ * by capture sequence, and writes it as snapshot_<sequence>.jpg at
+ * FRAME_SNAPSHOT_QUALITY. The frames of a batch are encoded with the in-tree
+ * JpegEncoder on a worker pool, one encoder per thread, and each thread writes
+ * the files it encoded.
+ *
+ * Snapshots are a convenience copy of what frames.bin stores losslessly, so
+ * under memory pressure frames are dropped here before the session logger
+ * has to shed any.
+ */
+class FrameSnapshotWriter : public BatchSubscriber<ProcessedFrame> {
+private:
+    std::filesystem::path outputDir;  /// Directory the snapshots are written to
+
+    std::unique_ptr<WorkerPool> encodePool;              /// Threads encoding and writing the frames of a batch
+    std::vector<JpegEncoder> encoders;                   /// Encoder of every encodePool thread
+    std::vector<std::vector<BYTE>> encoded;              /// Output buffer of every encodePool thread
+    std::vector<std::shared_ptr<ProcessedFrame>> batch;  /// Frames of the batch being written
+    MemoryAccount* encodeAccount = nullptr;              /// Capacity of the output buffers
+    std::atomic<UINT64> framesWritten = 0;               /// Snapshots written so far
+    std::atomic<UINT64> framesSkipped = 0;               /// Frames on the interval dropped under memory or disk pressure
+    std::atomic<UINT64> writeFailures = 0;               /// Snapshots that could not be encoded or written
+    std::atomic<UINT64> bytesWritten = 0;                /// JPEG bytes written so far
+    std::atomic<UINT64> encodeNs = 0;                    /// Thread time spent encoding so far
+
+    /**
+     * @brief Builds the batch limits from config.h.
+     */
+    static BatchPolicy batchPolicy();
+
+    /**
+     * @brief Whether a frame falls on the snapshot interval.
+     */
+    static bool isSnapshot(const ProcessedFrame& frame);
+
+    /**
+     * @brief Encodes one frame and writes it to its file.
+     * @param thread Index of the encodePool thread running it
+     */
+    void writeSnapshot(const ProcessedFrame& frame, unsigned int thread);
+
+    /**
+     * @brief Encodes and writes the frames of the batch in parallel.
+     *
+     * Inherited from BatchSubscriber.
+     */
+    void processBatch() override;
+
+public:
+    /**
+     * @brief Constructs FrameSnapshotWriter writing to the specified directory.
+     * @param directory Directory to create and write the snapshots to
+     */
+    FrameSnapshotWriter(const std::filesystem::path& directory);
+
+    /**
+     * @brief Queues a frame if it falls on the snapshot interval.
+     * @param frame Shared pointer to the published frame
+     *
+     * Frames off the interval are never queued, so they are not held until the batch is flushed.
+     */
+    void enqueue(std::shared_ptr<ProcessedFrame> frame) override;
+
+    /**
+     * @brief Number of snapshots written so far.
+     */
+    UINT64 getFramesWritten() const;
+
+    /**
+     * @brief Number of snapshots dropped under memory pressure so far.
+     */
+    UINT64 getFramesSkipped() const;
+
+    /**
+     * @brief Frames a single encoding thread encodes per second, 0 before the first.
+     */
+    double getEncodeFps() const;
+
+    /**
+     * @brief Destructor writes the remaining snapshots.
+     *
+     * Calls flush() to process any frames left in the batch queue and reports
+     * the snapshot count, size and encoding speed.
+     */
+    ~FrameSnapshotWriter();
+};
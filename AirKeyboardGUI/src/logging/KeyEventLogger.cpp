@@ -1,28 +1,140 @@
 #include "KeyEventLogger.h"
 
-void KeyEventLogger::processBatch() {
-    std::ofstream logFile(logFilePath, std::ios::app);
-    if (!logFile.is_open()) {
+#include <algorithm>
+#include <cstring>
+
+#include "../metrics/PipelineMetrics.h"
+
+void KeyEventLogger::writeBufferedRecords() {
+    if (writeBuffer.empty() || logFile == INVALID_HANDLE_VALUE) {
+        writeBuffer.clear();
         return;
     }
 
+    size_t recordBytes = writeBuffer.size() * sizeof(KeyEventRecord);
+    BYTE* records = blockBuffer.data() + sizeof(KeyEventBlockHeader);
+    memcpy(records, writeBuffer.data(), recordBytes);
+
+    KeyEventBlockHeader block = {};
+    block.magic = KEY_BLOCK_MAGIC;
+    block.recordCount = static_cast<UINT32>(writeBuffer.size());
+    block.checksum = keyBlockChecksum(block, records, recordBytes);
+    memcpy(blockBuffer.data(), &block, sizeof(block));
+
+    DWORD bytes = static_cast<DWORD>(sizeof(block) + recordBytes);
+    DWORD written = 0;
+    auto start = std::chrono::steady_clock::now();
+    if (!WriteFile(logFile, blockBuffer.data(), bytes, &written, nullptr) || written != bytes) {
+        std::string message = "KeyEventLogger: write failed, error " + std::to_string(GetLastError()) + "\n";
+        OutputDebugStringA(message.c_str());
+    }
+    writeTime += std::chrono::steady_clock::now() - start;
+
+    // Every staged event is on its way to disk as of now
+    LARGE_INTEGER perfCounter;
+    QueryPerformanceCounter(&perfCounter);
+    PipelineMetrics& metrics = PipelineMetrics::getInstance();
+    for (const KeyEventRecord& record : writeBuffer) {
+        metrics.recordLatency(MetricStage::KEY_LOG_FLUSH,
+                              qpcToNanoseconds(perfCounter.QuadPart - record.qpcTicks, frequency.QuadPart));
+    }
+
+    writeBuffer.clear();
+}
+
+void KeyEventLogger::processBatch() {
     while (!flushQueue.empty()) {
-        auto keyEvent = flushQueue.front();
-        flushQueue.pop();
+        auto keyEvent = takeFlushed();
+
+        // The session starts mid-stream, so only gaps after the first logged event count
+        if (eventsLogged > 0 && keyEvent->sequence > expectedSequence) {
+            eventsDropped += keyEvent->sequence - expectedSequence;
+            PipelineMetrics::getInstance().recordDropped(MetricStage::KEY_LOG_FLUSH, keyEvent->sequence - expectedSequence);
+        }
+        // A late event below the watermark was already counted as dropped, don't move back and count its successors again
+        expectedSequence = std::max(expectedSequence, keyEvent->sequence + 1);
 
-        // Convert timestamp to milliseconds
-        LONGLONG timestampMs = (keyEvent->timestamp * 1000) / frequency.QuadPart;
+        KeyEventRecord record = {};
+        record.sequence = keyEvent->sequence;
+        record.timestampNs = keyEvent->captureNs;
+        record.qpcTicks = keyEvent->timestamp;
+        record.vkey = keyEvent->vkey;
+        record.scanCode = keyEvent->scanCode;
+        record.flags = keyEvent->pressed ? KEY_RECORD_PRESSED : 0;
+        writeBuffer.push_back(record);
+        eventsLogged++;
 
-        // CSV format: timestamp,vkey,scancode,pressed
-        logFile << timestampMs << ","
-                << keyEvent->vkey << ","
-                << keyEvent->scanCode << ","
-                << (keyEvent->pressed ? "1" : "0") << "\n";
+        if (writeBuffer.size() == WRITE_BUFFER_RECORDS) {
+            writeBufferedRecords();
+        }
     }
 
-    logFile.flush();
+    writeBufferedRecords();
+
+    auto now = std::chrono::steady_clock::now();
+    if (now - lastSync >= syncInterval) {
+        FlushFileBuffers(logFile);
+        lastSync = now;
+        writeTime += std::chrono::steady_clock::now() - now;
+    }
+
+    updateAdaptiveLimit(flushedUnits, writeTime);
+    writeTime = {};
 }
 
-KeyEventLogger::KeyEventLogger(const std::filesystem::path& filePath) : logFilePath(filePath) {
+UINT64 KeyEventLogger::getEventsLogged() const {
+    return eventsLogged;
+}
+
+UINT64 KeyEventLogger::getEventsDropped() const {
+    return eventsDropped;
+}
+
+BatchPolicy KeyEventLogger::batchPolicy() {
+    BatchPolicy policy;
+    policy.maxItems = KEY_LOG_BATCH_EVENTS;
+    policy.maxAge = std::chrono::milliseconds(KEY_LOG_BATCH_AGE_MS);
+    policy.adaptiveFlushTime = std::chrono::milliseconds(KEY_LOG_ADAPTIVE_FLUSH_MS);
+    return policy;
+}
+
+KeyEventLogger::KeyEventLogger(const std::filesystem::path& filePath, std::chrono::milliseconds syncInterval)
+    : BatchSubscriber(batchPolicy(), keyEventBytes),
+      logFilePath(filePath), syncInterval(syncInterval), lastSync(std::chrono::steady_clock::now()) {
     QueryPerformanceFrequency(&frequency);
-}
\ No newline at end of file
+    writeBuffer.reserve(WRITE_BUFFER_RECORDS);
+    blockBuffer.resize(sizeof(KeyEventBlockHeader) + WRITE_BUFFER_RECORDS * sizeof(KeyEventRecord));
+    trackQueue("key_logger_queue", false, keyEventBytes);
+
+    logFile = CreateFileW(logFilePath.wstring().c_str(), GENERIC_WRITE, FILE_SHARE_READ, nullptr,
+                          CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (logFile == INVALID_HANDLE_VALUE) {
+        std::string message = "KeyEventLogger: failed to open " + logFilePath.string() +
+                              ", error " + std::to_string(GetLastError()) + "\n";
+        OutputDebugStringA(message.c_str());
+        return;
+    }
+
+    KeyEventLogHeader header = {};
+    header.magic = KEY_LOG_MAGIC;
+    header.version = KEY_LOG_VERSION;
+    header.recordSize = sizeof(KeyEventRecord);
+    header.qpcFrequency = frequency.QuadPart;
+
+    DWORD written = 0;
+    WriteFile(logFile, &header, sizeof(header), &written, nullptr);
+}
+
+KeyEventLogger::~KeyEventLogger() {
+    flush();
+
+    if (logFile != INVALID_HANDLE_VALUE) {
+        FlushFileBuffers(logFile);
+        CloseHandle(logFile);
+        logFile = INVALID_HANDLE_VALUE;
+    }
+
+    std::string message = "KeyEventLogger: " + std::to_string(eventsLogged) + " events logged, " +
+                          std::to_string(eventsDropped) + " dropped\n";
+    OutputDebugStringA(message.c_str());
+}
@@ -1,44 +1,107 @@
 #pragma once
 
+//clang-format off
+#include <windows.h>
+//clang-format on
+
 #include <chrono>
 #include <filesystem>
-#include <fstream>
-#include <iomanip>
-#include <sstream>
+#include <string>
+#include <vector>
 
+#include "../../config.h"
 #include "../base/BatchSubscriber.h"
+#include "../formats/KeyEventLogFormat.h"
 #include "../types.h"
 
 /**
- * @brief Batch processor that logs keyboard events to CSV file.
+ * @brief Batch processor that logs keyboard events to a binary log file.
  *
- * KeyEventLogger receives KeyEvent objects and writes them to a CSV file
- * in batches for improved I/O performance. Records timestamp, virtual key code,
- * scan code, and press/release state for each keyboard event.
+ * KeyEventLogger receives KeyEvent objects and appends them as fixed-size
+ * KeyEventRecords to key_events.bin. The file stays open for the whole session
+ * and records are staged in a preallocated buffer, so a batch costs one write
+ * call. Each write is one checksummed block. Data is forced to disk at a
+ * configurable interval rather than on every batch.
  */
-class KeyEventLogger : public BatchSubscriber<KeyEvent, 100> {
+class KeyEventLogger : public BatchSubscriber<KeyEvent> {
 private:
-    /// Path to the CSV log file where events will be written
+    /// Number of records the write buffer holds before it is written out
+    static constexpr size_t WRITE_BUFFER_RECORDS = 4096;
+
+    /// Path to the binary log file where events will be written
     std::filesystem::path logFilePath;
 
-    /// Performance counter frequency for timestamp conversion to milliseconds
+    /// Handle of the open log file
+    HANDLE logFile = INVALID_HANDLE_VALUE;
+
+    /// Preallocated staging buffer for encoded records
+    std::vector<KeyEventRecord> writeBuffer;
+
+    /// Preallocated block header and records as written in one call
+    std::vector<BYTE> blockBuffer;
+
+    /// Performance counter frequency, recorded in the log header
     LARGE_INTEGER frequency;
 
+    /// Minimum time between FlushFileBuffers calls
+    std::chrono::milliseconds syncInterval;
+
+    /// Time of the last FlushFileBuffers call
+    std::chrono::steady_clock::time_point lastSync;
+
+    /// Time the current batch spent in WriteFile and FlushFileBuffers, for the adaptive batch size
+    std::chrono::steady_clock::duration writeTime{};
+
+    /// Number of events written to the log
+    UINT64 eventsLogged = 0;
+
+    /// Number of events missing from the sequence, i.e. dropped before logging
+    UINT64 eventsDropped = 0;
+
+    /// Sequence number expected for the next event
+    UINT64 expectedSequence = 0;
+
+    /**
+     * @brief Builds the batch limits from config.h.
+     */
+    static BatchPolicy batchPolicy();
+
+    /**
+     * @brief Writes the staged records to the log file as one block and empties the buffer.
+     */
+    void writeBufferedRecords();
+
     /**
-     * @brief Processes accumulated batch of key events by writing to CSV file.
+     * @brief Processes accumulated batch of key events by appending binary records.
      *
-     * Inherited from BatchSubscriber. Opens log file in append mode,
-     * drains the flush queue, and writes each event as CSV row with format:
-     * timestamp_ms,virtual_key,scan_code,pressed(1/0)
+     * Inherited from BatchSubscriber. Drains the flush queue into the write buffer,
+     * writes it out and syncs the file if the sync interval has elapsed.
      */
     void processBatch() override;
 
 public:
     /**
-     * @brief Constructs KeyEventLogger with specified output file path.
-     * @param filePath Path to CSV file where key events will be logged
+     * @brief Constructs KeyEventLogger and creates the log file with its header.
+     * @param filePath Path to the binary file where key events will be logged
+     * @param syncInterval Minimum time between forcing logged data to disk
      *
      * Initializes performance counter frequency for accurate timestamp conversion.
      */
-    KeyEventLogger(const std::filesystem::path& filePath);
-};
\ No newline at end of file
+    KeyEventLogger(const std::filesystem::path& filePath,
+                   std::chrono::milliseconds syncInterval = std::chrono::milliseconds(KEY_LOG_SYNC_INTERVAL_MS));
+
+    /**
+     * @brief Number of events written to the log so far.
+     */
+    UINT64 getEventsLogged() const;
+
+    /**
+     * @brief Number of events detected as dropped from gaps in the sequence numbers.
+     */
+    UINT64 getEventsDropped() const;
+
+    /**
+     * @brief Flushes pending events, syncs and closes the log file.
+     */
+    ~KeyEventLogger();
+};
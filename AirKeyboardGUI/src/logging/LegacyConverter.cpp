@@ -0,0 +1,609 @@
+#include "LegacyConverter.h"
+
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <thread>
+
+#include "../base/WorkerPool.h"
+#include "../codec/LosslessCodec.h"
+#include "../formats/Checksum.h"
+#include "../formats/FrameFormat.h"
+#include "../formats/KeyEventLogFormat.h"
+#include "../replay/MappedFile.h"
+#include "AsyncFileWriter.h"
+
+namespace {
+
+/// Frames per chunk for each transform thread; two chunks per stage are in flight
+constexpr size_t CHUNK_FRAMES_PER_THREAD = 2;
+
+/// Key events per block of the converted key log
+constexpr size_t KEY_BLOCK_RECORDS = 4096;
+
+/// Tick rate of converted key logs, whose events only have millisecond times
+constexpr INT64 LEGACY_KEY_FREQUENCY = 1000;
+
+/// A legacy session and what became of it
+struct LegacySession {
+    std::filesystem::path dir;
+    std::vector<std::filesystem::path> frameFiles;  ///< In name order, which is recording order
+    bool hasKeyCsv = false;
+    std::vector<std::filesystem::path> skipped;     ///< Frame files that couldn't be read or failed their checksum
+    std::atomic<size_t> mismatches = 0;             ///< Frames that didn't decode back to the source
+    bool cancelled = false;                         ///< Reading stopped early, set before the last chunk
+};
+
+/// A frame on its way through the pipeline
+struct ConvertFrame {
+    FrameHeader header;                       ///< Header to store, dataSize of the pixels
+    std::vector<BYTE> pixels;                 ///< Frame data as read
+    std::vector<BYTE> encoded;                ///< Encoded pixels, empty if stored as read
+    std::shared_ptr<ConvertFrame> reference;  ///< Frame the encoding may refer to, released once encoded
+    bool duplicate = false;                   ///< Same pixels as the last frame stored
+};
+
+/// Consecutive frames of one session, handed from stage to stage
+struct Chunk {
+    LegacySession* session = nullptr;
+    std::vector<std::shared_ptr<ConvertFrame>> frames;
+    std::vector<KeyEventRecord> keys;  ///< Set on the session's last chunk
+    bool first = false;                ///< First chunk of the session
+    bool last = false;                 ///< Last chunk of the session
+};
+
+/**
+ * @brief Passes a line to LegacyConvertOptions::log or the debugger.
+ */
+void report(const LegacyConvertOptions& options, const std::string& message) {
+    if (options.log) {
+        options.log(message);
+    } else {
+        OutputDebugStringA((message + "\n").c_str());
+    }
+}
+
+double secondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+/**
+ * @brief Bounded queue of chunks between two stages.
+ *
+ * push() blocks while the queue is full and pop() while it is empty, adding the
+ * time to the waiting stage's waitSeconds.
+ */
+class ChunkQueue {
+private:
+    std::deque<std::unique_ptr<Chunk>> chunks;
+    std::mutex lock;
+    std::condition_variable changed;
+    size_t capacity;
+    bool closed = false;
+
+public:
+    explicit ChunkQueue(size_t capacity) : capacity(capacity) {}
+
+    void push(std::unique_ptr<Chunk> chunk, LegacyStageStats& stats) {
+        auto start = std::chrono::steady_clock::now();
+        std::unique_lock<std::mutex> guard(lock);
+        changed.wait(guard, [&] { return chunks.size() < capacity; });
+        chunks.push_back(std::move(chunk));
+        changed.notify_all();
+        stats.waitSeconds += secondsSince(start);
+    }
+
+    /**
+     * @brief Takes the next chunk, nullptr once the queue is closed and empty.
+     */
+    std::unique_ptr<Chunk> pop(LegacyStageStats& stats) {
+        auto start = std::chrono::steady_clock::now();
+        std::unique_lock<std::mutex> guard(lock);
+        changed.wait(guard, [&] { return !chunks.empty() || closed; });
+        stats.waitSeconds += secondsSince(start);
+        if (chunks.empty()) return nullptr;
+
+        std::unique_ptr<Chunk> chunk = std::move(chunks.front());
+        chunks.pop_front();
+        changed.notify_all();
+        return chunk;
+    }
+
+    void close() {
+        std::lock_guard<std::mutex> guard(lock);
+        closed = true;
+        changed.notify_all();
+    }
+};
+
+/**
+ * @brief Path an output is written to until it is complete.
+ */
+std::filesystem::path partialPath(const std::filesystem::path& path) {
+    std::filesystem::path partial = path;
+    partial += ".partial";
+    return partial;
+}
+
+/**
+ * @brief Whether a frame can be stored with the codec: BGR24 with its pixels and no other flags.
+ */
+bool isEncodable(const ConvertFrame& frame) {
+    return frame.header.pixelFormat == PIXEL_FORMAT_BGR24 && frame.header.flags == 0 &&
+           frame.pixels.size() == static_cast<size_t>(frame.header.width) * frame.header.height * 3;
+}
+
+/**
+ * @brief Reads a legacy frame file.
+ * @return nullptr if it is unreadable, truncated or fails its checksum
+ */
+std::shared_ptr<ConvertFrame> readFrameFile(const std::filesystem::path& path, LegacyStageStats& stats) {
+    std::ifstream in(path, std::ios::binary);
+    std::error_code ec;
+    UINT64 fileSize = std::filesystem::file_size(path, ec);
+    if (!in || ec) return nullptr;
+
+    BYTE headerBytes[sizeof(FrameHeader)];
+    size_t available = static_cast<size_t>(std::min<UINT64>(sizeof(headerBytes), fileSize));
+    in.read(reinterpret_cast<char*>(headerBytes), available);
+
+    auto frame = std::make_shared<ConvertFrame>();
+    size_t headerSize = 0;
+    if (!in || !parseFrameHeader(headerBytes, available, frame->header, headerSize) ||
+        headerSize + static_cast<UINT64>(frame->header.dataSize) != fileSize) {
+        return nullptr;
+    }
+
+    frame->pixels.resize(frame->header.dataSize);
+    in.seekg(static_cast<std::streamoff>(headerSize));
+    in.read(reinterpret_cast<char*>(frame->pixels.data()), frame->pixels.size());
+    if (!in) return nullptr;
+
+    if ((frame->header.flags & FRAME_FLAG_CHECKSUM) &&
+        frameRecordChecksum(frame->header, frame->pixels.data()) != frame->header.checksum) {
+        return nullptr;
+    }
+    frame->header.flags &= ~FRAME_FLAG_CHECKSUM;
+    frame->header.checksum = 0;
+
+    // frame_NNNNNN.raw numbers the frames as they were captured
+    if (frame->header.sequence == FRAME_SEQUENCE_UNKNOWN) {
+        std::string stem = path.stem().string();
+        size_t digits = stem.find_last_not_of("0123456789") + 1;
+        UINT64 number = 0;
+        auto result = std::from_chars(stem.data() + digits, stem.data() + stem.size(), number);
+        if (result.ec == std::errc() && result.ptr == stem.data() + stem.size()) frame->header.sequence = number;
+    }
+
+    stats.frames++;
+    stats.bytesIn += fileSize;
+    return frame;
+}
+
+/**
+ * @brief Reads a legacy key_events.csv (timestamp_ms,vkey,scancode,pressed) into key-log records.
+ */
+std::vector<KeyEventRecord> readKeyCsv(const std::filesystem::path& path, LegacyStageStats& stats) {
+    std::vector<KeyEventRecord> records;
+    std::ifstream in(path);
+    std::string line;
+    while (std::getline(in, line)) {
+        stats.bytesIn += line.size() + 1;
+
+        // Lines that don't parse (a header) are skipped, like SessionReplay does
+        INT64 fields[4];
+        const char* position = line.data();
+        const char* end = line.data() + line.size();
+        bool parsed = true;
+        for (int i = 0; i < 4 && parsed; i++) {
+            auto result = std::from_chars(position, end, fields[i]);
+            parsed = result.ec == std::errc();
+            position = result.ptr < end ? result.ptr + 1 : end;
+        }
+        if (!parsed) continue;
+
+        KeyEventRecord record = {};
+        record.sequence = records.size();
+        record.timestampNs = fields[0] * 1000000;
+        record.qpcTicks = fields[0];
+        record.vkey = static_cast<UINT16>(fields[1]);
+        record.scanCode = static_cast<UINT16>(fields[2]);
+        record.flags = fields[3] != 0 ? KEY_RECORD_PRESSED : 0;
+        records.push_back(record);
+    }
+    return records;
+}
+
+/**
+ * @brief Read stage: loads every session's frames in chunks and its key events.
+ */
+void readSessions(std::vector<std::unique_ptr<LegacySession>>& sessions, size_t chunkFrames, ChunkQueue& out,
+                  const LegacyConvertOptions& options, LegacyStageStats& stats) {
+    if (options.background) SetThreadPriority(GetCurrentThread(), THREAD_MODE_BACKGROUND_BEGIN);
+
+    for (auto& session : sessions) {
+        if (options.cancelled && options.cancelled()) break;
+
+        auto chunk = std::make_unique<Chunk>();
+        chunk->session = session.get();
+        chunk->first = true;
+
+        auto start = std::chrono::steady_clock::now();
+        for (const auto& path : session->frameFiles) {
+            if (options.cancelled && options.cancelled()) {
+                session->cancelled = true;
+                break;
+            }
+
+            std::shared_ptr<ConvertFrame> frame = readFrameFile(path, stats);
+            if (!frame) {
+                report(options, path.string() + ": unreadable, skipped");
+                session->skipped.push_back(path);
+                continue;
+            }
+            chunk->frames.push_back(std::move(frame));
+
+            if (chunk->frames.size() == chunkFrames) {
+                stats.busySeconds += secondsSince(start);
+                out.push(std::move(chunk), stats);
+                start = std::chrono::steady_clock::now();
+
+                chunk = std::make_unique<Chunk>();
+                chunk->session = session.get();
+            }
+        }
+
+        if (session->hasKeyCsv && !session->cancelled) {
+            chunk->keys = readKeyCsv(session->dir / "key_events.csv", stats);
+        }
+        chunk->last = true;
+        stats.busySeconds += secondsSince(start);
+        out.push(std::move(chunk), stats);
+        if (session->cancelled) break;
+    }
+    out.close();
+}
+
+/**
+ * @brief Transform stage: marks duplicates, encodes the frames of each chunk on the pool and checks the round trip.
+ */
+void transformChunks(ChunkQueue& in, ChunkQueue& out, const LegacyConvertOptions& options, LegacyStageStats& stats) {
+    WorkerPool pool(options.threads);
+    std::vector<LosslessEncoder> encoders(pool.getThreadCount());
+    std::vector<LosslessDecoder> decoders(pool.getThreadCount());
+    std::vector<std::vector<BYTE>> decoded(pool.getThreadCount());
+
+    std::shared_ptr<ConvertFrame> lastStored;
+    UINT32 gopPosition = 0;
+
+    while (std::unique_ptr<Chunk> chunk = in.pop(stats)) {
+        auto start = std::chrono::steady_clock::now();
+        if (chunk->first) {
+            lastStored = nullptr;
+            gopPosition = 0;
+        }
+
+        // Duplicates and references depend on the frames before, so they are decided in order
+        for (auto& frame : chunk->frames) {
+            if (FRAME_LOG_DEDUPLICATE && lastStored && lastStored->header.width == frame->header.width &&
+                lastStored->header.height == frame->header.height &&
+                lastStored->header.pixelFormat == frame->header.pixelFormat && lastStored->pixels == frame->pixels) {
+                frame->duplicate = true;
+                continue;
+            }
+
+            if (options.compress && isEncodable(*frame)) {
+                bool keyframe = gopPosition == 0 || !lastStored || !isEncodable(*lastStored) ||
+                                lastStored->header.width != frame->header.width ||
+                                lastStored->header.height != frame->header.height;
+                gopPosition = keyframe ? 1 : gopPosition + 1;
+                if (gopPosition >= options.gopLength) gopPosition = 0;
+                if (!keyframe) frame->reference = lastStored;
+            }
+            lastStored = frame;
+        }
+
+        LegacySession* session = chunk->session;
+        pool.parallelFor(chunk->frames.size(), [&](size_t index, unsigned int thread) {
+            ConvertFrame& frame = *chunk->frames[index];
+            if (frame.duplicate || !options.compress || !isEncodable(frame)) return;
+
+            const BYTE* reference = frame.reference ? frame.reference->pixels.data() : nullptr;
+            encoders[thread].encode(frame.pixels.data(), frame.header.width, frame.header.height, frame.encoded,
+                                    reference);
+            if (!options.verify) return;
+
+            std::vector<BYTE>& pixels = decoded[thread];
+            pixels.resize(frame.pixels.size());
+            if (!decoders[thread].decode(frame.encoded.data(), frame.encoded.size(), pixels.data(), pixels.size(),
+                                         reference) ||
+                pixels != frame.pixels) {
+                session->mismatches++;
+            }
+        });
+
+        for (auto& frame : chunk->frames) {
+            frame->reference = nullptr;
+            stats.frames++;
+            stats.bytesIn += frame->pixels.size();
+            stats.bytesOut += frame->duplicate ? 0 : frame->encoded.empty() ? frame->pixels.size() : frame->encoded.size();
+        }
+        stats.busySeconds += secondsSince(start);
+        out.push(std::move(chunk), stats);
+    }
+    out.close();
+}
+
+/**
+ * @brief Writes a key log in the current format.
+ */
+bool writeKeyLog(const std::filesystem::path& path, const std::vector<KeyEventRecord>& records,
+                 LegacyStageStats& stats) {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out) return false;
+
+    KeyEventLogHeader header = {};
+    header.magic = KEY_LOG_MAGIC;
+    header.version = KEY_LOG_VERSION;
+    header.recordSize = sizeof(KeyEventRecord);
+    header.qpcFrequency = LEGACY_KEY_FREQUENCY;
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    stats.bytesOut += sizeof(header);
+
+    for (size_t first = 0; first < records.size(); first += KEY_BLOCK_RECORDS) {
+        size_t count = std::min(KEY_BLOCK_RECORDS, records.size() - first);
+        const BYTE* blockRecords = reinterpret_cast<const BYTE*>(records.data() + first);
+
+        KeyEventBlockHeader block = {};
+        block.magic = KEY_BLOCK_MAGIC;
+        block.recordCount = static_cast<UINT32>(count);
+        block.checksum = keyBlockChecksum(block, blockRecords, count * sizeof(KeyEventRecord));
+        out.write(reinterpret_cast<const char*>(&block), sizeof(block));
+        out.write(reinterpret_cast<const char*>(blockRecords), count * sizeof(KeyEventRecord));
+        stats.bytesOut += sizeof(block) + count * sizeof(KeyEventRecord);
+    }
+    return static_cast<bool>(out);
+}
+
+/**
+ * @brief Reads a written container back and checks every record's checksum.
+ */
+bool verifyContainer(const std::filesystem::path& path, UINT64 expectedRecords) {
+    MappedFile file(path);
+    if (!file.isOpen()) return false;
+
+    UINT64 offset = 0;
+    UINT64 records = 0;
+    while (offset < file.size()) {
+        FrameHeader header;
+        size_t headerSize = 0;
+        size_t available = static_cast<size_t>(std::min<UINT64>(sizeof(FrameHeader), file.size() - offset));
+        if (!parseFrameHeader(file.data() + offset, available, header, headerSize) ||
+            offset + headerSize + header.dataSize > file.size() ||
+            frameRecordChecksum(header, file.data() + offset + headerSize) != header.checksum) {
+            return false;
+        }
+        offset += headerSize + header.dataSize;
+        records++;
+    }
+    return records == expectedRecords;
+}
+
+/**
+ * @brief Reads a written key log back and checks that every block is intact.
+ */
+bool verifyKeyLog(const std::filesystem::path& path, size_t expectedRecords) {
+    MappedFile file(path);
+    if (!file.isOpen()) return false;
+
+    KeyEventLogHeader header;
+    std::vector<KeyEventRecord> records;
+    std::vector<CorruptRange> corrupt;
+    return parseKeyEventLog(file.data(), static_cast<size_t>(file.size()), header, records, &corrupt) &&
+           corrupt.empty() && records.size() == expectedRecords;
+}
+
+/**
+ * @brief Checks a session's outputs and moves them to their final names.
+ * @return false if the session failed verification; its partial outputs are removed
+ */
+bool finishSession(LegacySession& session, UINT64 recordsWritten, size_t keysWritten, bool writeFailed,
+                   const LegacyConvertOptions& options) {
+    std::filesystem::path framesPath = session.dir / "frames.bin";
+    std::filesystem::path keysPath = session.dir / "key_events.bin";
+    bool hasFrames = !session.frameFiles.empty();
+
+    std::string failure;
+    if (session.cancelled) {
+        failure = "cancelled";
+    } else if (writeFailed) {
+        failure = "write failed";
+    } else if (session.mismatches > 0) {
+        failure = std::to_string(session.mismatches) + " frames don't decode to the source";
+    } else if (options.verify && hasFrames && !verifyContainer(partialPath(framesPath), recordsWritten)) {
+        failure = "frames.bin doesn't read back";
+    } else if (options.verify && session.hasKeyCsv && !verifyKeyLog(partialPath(keysPath), keysWritten)) {
+        failure = "key_events.bin doesn't read back";
+    }
+
+    std::error_code ec;
+    if (failure.empty()) {
+        // The container goes last, it marks the session as converted for findLegacySessions()
+        if (session.hasKeyCsv) std::filesystem::rename(partialPath(keysPath), keysPath, ec);
+        if (!ec && hasFrames) std::filesystem::rename(partialPath(framesPath), framesPath, ec);
+        if (ec) failure = "rename failed: " + ec.message();
+    }
+
+    if (!failure.empty()) {
+        report(options, session.dir.string() + ": " + failure);
+        std::filesystem::remove(partialPath(framesPath), ec);
+        std::filesystem::remove(partialPath(keysPath), ec);
+        return false;
+    }
+
+    report(options, session.dir.string() + ": " + std::to_string(recordsWritten) + " frames, " +
+                        std::to_string(keysWritten) + " key events, " + std::to_string(session.skipped.size()) +
+                        " unreadable frames skipped");
+
+    // Frame files that couldn't be converted are kept, and with them the frames directory
+    if (options.removeLegacy) {
+        for (const auto& path : session.frameFiles) {
+            if (std::find(session.skipped.begin(), session.skipped.end(), path) == session.skipped.end()) {
+                std::filesystem::remove(path, ec);
+            }
+        }
+        std::filesystem::remove(session.dir / "frames", ec);
+        if (session.hasKeyCsv) std::filesystem::remove(session.dir / "key_events.csv", ec);
+    }
+    return true;
+}
+
+/**
+ * @brief Write stage: writes the frames of each session to its container and finishes the session.
+ * @return Number of sessions converted
+ */
+size_t writeChunks(ChunkQueue& in, const LegacyConvertOptions& options, LegacyStageStats& stats) {
+    if (options.background) SetThreadPriority(GetCurrentThread(), THREAD_MODE_BACKGROUND_BEGIN);
+
+    std::unique_ptr<AsyncFileWriter> writer;
+    UINT64 recordsWritten = 0;
+    size_t converted = 0;
+
+    while (std::unique_ptr<Chunk> chunk = in.pop(stats)) {
+        auto start = std::chrono::steady_clock::now();
+        LegacySession& session = *chunk->session;
+        std::filesystem::path framesPath = partialPath(session.dir / "frames.bin");
+
+        if (chunk->first && !session.frameFiles.empty()) {
+            writer = std::make_unique<AsyncFileWriter>(framesPath);
+            recordsWritten = 0;
+        }
+
+        for (const auto& frame : chunk->frames) {
+            FrameHeader header = frame->header;
+            const BYTE* data = frame->pixels.data();
+            if (frame->duplicate) {
+                header.flags |= FRAME_FLAG_DUPLICATE;
+                header.dataSize = 0;
+            } else if (!frame->encoded.empty()) {
+                header.flags |= FRAME_FLAG_COMPRESSED;
+                header.dataSize = static_cast<UINT32>(frame->encoded.size());
+                data = frame->encoded.data();
+
+                LosslessFrameHeader codecHeader;
+                if (readLosslessHeader(data, frame->encoded.size(), codecHeader) && losslessNeedsReference(codecHeader)) {
+                    header.flags |= FRAME_FLAG_DELTA;
+                }
+            }
+            header.flags |= FRAME_FLAG_CHECKSUM;
+            header.checksum = frameRecordChecksum(header, data);
+
+            writer->append(&header, sizeof(header));
+            writer->append(data, header.dataSize);
+            stats.frames++;
+            stats.bytesOut += sizeof(header) + header.dataSize;
+            recordsWritten++;
+        }
+
+        if (chunk->last) {
+            bool writeFailed = false;
+            if (writer) {
+                writeFailed = !writer->isOpen();
+                writer->close();
+                writeFailed = writeFailed || writer->hasFailed();
+                writer = nullptr;
+            }
+            if (session.hasKeyCsv && !writeKeyLog(partialPath(session.dir / "key_events.bin"), chunk->keys, stats)) {
+                writeFailed = true;
+            }
+            if (finishSession(session, recordsWritten, chunk->keys.size(), writeFailed, options)) converted++;
+        }
+        stats.busySeconds += secondsSince(start);
+    }
+    return converted;
+}
+
+}  // namespace
+
+size_t findLegacySessions(const std::filesystem::path& dir, std::vector<std::filesystem::path>& sessionDirs) {
+    std::set<std::filesystem::path> candidates;
+    std::error_code ec;
+    if (std::filesystem::is_directory(dir / "frames", ec) || std::filesystem::exists(dir / "key_events.csv", ec)) {
+        candidates.insert(dir);
+    }
+    for (const auto& entry : std::filesystem::recursive_directory_iterator(dir, ec)) {
+        const std::filesystem::path& path = entry.path();
+        if ((entry.is_directory() && path.filename() == "frames") ||
+            (entry.is_regular_file() && path.filename() == "key_events.csv")) {
+            candidates.insert(path.parent_path());
+        }
+    }
+
+    size_t skipped = 0;
+    for (const auto& sessionDir : candidates) {
+        bool hasFrames = false;
+        for (const auto& entry : std::filesystem::directory_iterator(sessionDir / "frames", ec)) {
+            if (entry.path().extension() == ".raw") {
+                hasFrames = true;
+                break;
+            }
+        }
+        bool hasKeyCsv = std::filesystem::exists(sessionDir / "key_events.csv", ec);
+        if (!hasFrames && !hasKeyCsv) continue;
+
+        // Outputs only appear under their final names once complete
+        bool framesDone = !hasFrames || std::filesystem::exists(sessionDir / "frames.bin", ec);
+        bool keysDone = !hasKeyCsv || std::filesystem::exists(sessionDir / "key_events.bin", ec);
+        if (framesDone && keysDone) {
+            skipped++;
+            continue;
+        }
+        sessionDirs.push_back(sessionDir);
+    }
+    return skipped;
+}
+
+LegacyConvertStats convertLegacySessions(const std::vector<std::filesystem::path>& sessionDirs,
+                                         const LegacyConvertOptions& options) {
+    LegacyConvertStats result;
+    std::vector<std::unique_ptr<LegacySession>> sessions;
+    for (const auto& dir : sessionDirs) {
+        auto session = std::make_unique<LegacySession>();
+        session->dir = dir;
+        std::error_code ec;
+        for (const auto& entry : std::filesystem::directory_iterator(dir / "frames", ec)) {
+            if (entry.path().extension() == ".raw") session->frameFiles.push_back(entry.path());
+        }
+        std::sort(session->frameFiles.begin(), session->frameFiles.end());
+        session->hasKeyCsv = std::filesystem::exists(dir / "key_events.csv", ec);
+
+        // Leftovers of an interrupted run are redone from the start
+        std::filesystem::remove(partialPath(dir / "frames.bin"), ec);
+        std::filesystem::remove(partialPath(dir / "key_events.bin"), ec);
+        sessions.push_back(std::move(session));
+    }
+    if (sessions.empty()) return result;
+
+    ChunkQueue readQueue(2);
+    ChunkQueue writeQueue(2);
+    size_t chunkFrames = static_cast<size_t>(std::max(1u, options.threads)) * CHUNK_FRAMES_PER_THREAD;
+
+    auto start = std::chrono::steady_clock::now();
+    std::thread reader([&] { readSessions(sessions, chunkFrames, readQueue, options, result.read); });
+    std::thread writer([&] { result.sessionsConverted = writeChunks(writeQueue, options, result.write); });
+    transformChunks(readQueue, writeQueue, options, result.transform);
+    reader.join();
+    writer.join();
+    result.wallSeconds = secondsSince(start);
+
+    // Sessions a cancelled reader never started count as failed too
+    result.sessionsFailed = sessions.size() - result.sessionsConverted;
+    return result;
+}
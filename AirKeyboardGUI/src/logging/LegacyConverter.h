@@ -0,0 +1,87 @@
+#pragma once
+
+//clang-format off
+#include <windows.h>
+//clang-format on
+
+#include <filesystem>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "../../config.h"
+
+/**
+ * @brief Configuration of a legacy session conversion.
+ */
+struct LegacyConvertOptions {
+    unsigned int threads = 1;                ///< Threads of the transform stage, including the caller
+    UINT32 gopLength = FRAME_LOG_GOP_LENGTH;  ///< Frames per keyframe, 1 for keyframes only
+    bool compress = true;                    ///< Store the frames with the lossless codec
+    bool verify = true;                      ///< Decode every frame again and read the outputs back
+    bool removeLegacy = false;               ///< Delete the .raw files and key_events.csv of sessions once converted
+    bool background = false;                 ///< Run the read and write stages at background priority
+
+    /// Receives a line per session converted or failed; unset sends them to the debugger
+    std::function<void(const std::string&)> log;
+
+    /// Polled between frames; once it returns true the session being read is abandoned and no other is started
+    std::function<bool()> cancelled;
+};
+
+/// Work and waiting time of a conversion stage
+struct LegacyStageStats {
+    UINT64 frames = 0;
+    UINT64 bytesIn = 0;
+    UINT64 bytesOut = 0;
+    double busySeconds = 0;
+    double waitSeconds = 0;
+};
+
+/**
+ * @brief Outcome of a legacy session conversion.
+ */
+struct LegacyConvertStats {
+    size_t sessionsConverted = 0;
+    size_t sessionsFailed = 0;  ///< Sessions that failed or were cancelled, their partial outputs removed
+    LegacyStageStats read;
+    LegacyStageStats transform;
+    LegacyStageStats write;
+    double wallSeconds = 0;
+};
+
+/**
+ * Conversion of legacy sessions to the current session formats.
+ *
+ * Legacy sessions hold one frames/frame_NNNNNN.raw file per frame and a
+ * key_events.csv. Each is rewritten into a frames.bin container, with the
+ * frames compressed by the lossless codec, duplicates stored as such and
+ * checksums on every record, as FrameLogger writes them, and a binary
+ * key_events.bin. The frame number in the file name becomes the sequence
+ * number, so frames missing from the session show up as gaps. Legacy key
+ * events carry millisecond times, so the key log is written with a 1 kHz tick.
+ *
+ * The conversion runs as a pipeline of three stages that overlap: a reader
+ * thread loads the next frames while the transform stage encodes the current
+ * ones on a worker pool and a writer thread writes and checks the previous
+ * ones. Sessions go through one after the other.
+ *
+ * Outputs are written under a .partial name and renamed once complete and
+ * verified, so an interrupted conversion is restarted by running it again.
+ * Used by session_convert and by StorageManager, which converts old sessions
+ * to free space.
+ */
+
+/**
+ * @brief Adds the legacy sessions under dir, dir included, that have not been converted yet.
+ * @return Number of sessions skipped because they already have their outputs
+ */
+size_t findLegacySessions(const std::filesystem::path& dir, std::vector<std::filesystem::path>& sessionDirs);
+
+/**
+ * @brief Converts legacy session directories found by findLegacySessions(), one after the other.
+ *
+ * Leftover partial outputs of an interrupted run are redone from the start.
+ */
+LegacyConvertStats convertLegacySessions(const std::vector<std::filesystem::path>& sessionDirs,
+                                         const LegacyConvertOptions& options);
@@ -0,0 +1,115 @@
+#include "SessionCatalog.h"
+
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <unordered_map>
+
+namespace {
+
+/// Byte range locked while appending, far beyond any catalog so readers are never blocked by it
+constexpr DWORD APPEND_LOCK_OFFSET_HIGH = 0x7FFFFFFF;
+
+}  // namespace
+
+bool SessionCatalog::append(const std::filesystem::path& catalogPath, SessionCatalogEntry entry) {
+    // FILE_APPEND_DATA alone makes every write land at the end, whoever else appends; locking needs read access
+    HANDLE file = CreateFileW(catalogPath.wstring().c_str(), GENERIC_READ | FILE_APPEND_DATA,
+                              FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        std::string message = "SessionCatalog: failed to open " + catalogPath.string() + ", error " +
+                              std::to_string(GetLastError()) + "\n";
+        OutputDebugStringA(message.c_str());
+        return false;
+    }
+
+    entry.magic = SESSION_ENTRY_MAGIC;
+    entry.checksum = sessionEntryChecksum(reinterpret_cast<const BYTE*>(&entry), sizeof(entry));
+
+    BYTE buffer[sizeof(SessionCatalogHeader) + sizeof(SessionCatalogEntry)];
+    DWORD bytes = 0;
+
+    // Appenders take turns, or two of them could both find the catalog empty and both write a header
+    OVERLAPPED lockRange = {};
+    lockRange.OffsetHigh = APPEND_LOCK_OFFSET_HIGH;
+    if (!LockFileEx(file, LOCKFILE_EXCLUSIVE_LOCK, 0, 1, 0, &lockRange)) {
+        std::string message = "SessionCatalog: failed to lock " + catalogPath.string() + ", error " +
+                              std::to_string(GetLastError()) + "\n";
+        OutputDebugStringA(message.c_str());
+        CloseHandle(file);
+        return false;
+    }
+
+    // A new catalog gets its header in the same write as the first entry
+    LARGE_INTEGER size;
+    if (GetFileSizeEx(file, &size) && size.QuadPart == 0) {
+        SessionCatalogHeader header = {};
+        header.magic = SESSION_CATALOG_MAGIC;
+        header.version = SESSION_CATALOG_VERSION;
+        header.entrySize = sizeof(SessionCatalogEntry);
+        memcpy(buffer, &header, sizeof(header));
+        bytes = sizeof(header);
+    }
+    memcpy(buffer + bytes, &entry, sizeof(entry));
+    bytes += sizeof(entry);
+
+    DWORD written = 0;
+    bool ok = WriteFile(file, buffer, bytes, &written, nullptr) && written == bytes;
+    if (!ok) {
+        std::string message = "SessionCatalog: write failed, error " + std::to_string(GetLastError()) + "\n";
+        OutputDebugStringA(message.c_str());
+    }
+
+    UnlockFileEx(file, 0, 1, 0, &lockRange);
+    CloseHandle(file);
+    return ok;
+}
+
+bool SessionCatalog::load(const std::filesystem::path& catalogPath, std::vector<SessionCatalogEntry>& entries,
+                          std::vector<CorruptRange>* corrupt) {
+    std::error_code ec;
+    if (!std::filesystem::exists(catalogPath, ec)) return true;
+
+    std::ifstream file(catalogPath, std::ios::binary | std::ios::ate);
+    if (!file) return false;
+    std::vector<BYTE> data(static_cast<size_t>(file.tellg()));
+    file.seekg(0);
+    if (!file.read(reinterpret_cast<char*>(data.data()), data.size())) return false;
+    if (data.empty()) return true;
+
+    SessionCatalogHeader header;
+    std::vector<SessionCatalogEntry> all;
+    if (!parseSessionCatalog(data.data(), data.size(), header, all, corrupt)) return false;
+
+    std::unordered_map<UINT64, size_t> bySession;
+    bySession.reserve(all.size());
+    entries.reserve(entries.size() + all.size());
+    for (const auto& entry : all) {
+        auto [it, inserted] = bySession.try_emplace(entry.sessionId, entries.size());
+        if (inserted) {
+            entries.push_back(entry);
+        } else {
+            entries[it->second] = entry;
+        }
+    }
+    return true;
+}
+
+void SessionCatalog::measureFiles(const std::filesystem::path& sessionDir, SessionCatalogEntry& entry) {
+    std::error_code ec;
+    entry.frameBytes = 0;
+    entry.keyBytes = 0;
+    entry.totalBytes = 0;
+
+    for (const auto& file : std::filesystem::recursive_directory_iterator(sessionDir, ec)) {
+        if (!file.is_regular_file(ec)) continue;
+
+        UINT64 size = file.file_size(ec);
+        if (ec) continue;
+        entry.totalBytes += size;
+
+        if (file.path().parent_path() != sessionDir) continue;
+        if (file.path().filename() == "frames.bin") entry.frameBytes = size;
+        if (file.path().filename() == "key_events.bin") entry.keyBytes = size;
+    }
+}
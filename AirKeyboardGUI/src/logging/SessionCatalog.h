@@ -0,0 +1,43 @@
+#pragma once
+
+//clang-format off
+#include <windows.h>
+//clang-format on
+
+#include <filesystem>
+#include <vector>
+
+#include "../formats/SessionCatalogFormat.h"
+
+/**
+ * @brief Appends session summaries to the catalog in LOG_DIR.
+ *
+ * ThreadManager appends one SessionCatalogEntry per session when it closes, so
+ * tools list and filter sessions from catalog.bin alone instead of opening
+ * every session directory (see SessionCatalogFormat.h). The catalog is opened
+ * for appending and each entry goes out in a single write, so a crash tears
+ * at most the entry being written. Appenders hold a lock on a byte range past
+ * the end of the file while they write, which readers never touch.
+ */
+class SessionCatalog {
+public:
+    /**
+     * @brief Appends an entry, creating the catalog with its header if needed.
+     * @param entry Entry to append; magic and checksum are filled in
+     * @return false if the catalog couldn't be opened or written
+     */
+    static bool append(const std::filesystem::path& catalogPath, SessionCatalogEntry entry);
+
+    /**
+     * @brief Reads a catalog, keeping the last entry of every session in the order sessions first appear.
+     * @param corrupt Receives the ranges skipped as damaged or truncated, may be nullptr
+     * @return false if the file exists but can't be read or is not a catalog; a missing catalog is empty
+     */
+    static bool load(const std::filesystem::path& catalogPath, std::vector<SessionCatalogEntry>& entries,
+                     std::vector<CorruptRange>* corrupt = nullptr);
+
+    /**
+     * @brief Fills frameBytes, keyBytes and totalBytes of an entry from the files of a session.
+     */
+    static void measureFiles(const std::filesystem::path& sessionDir, SessionCatalogEntry& entry);
+};
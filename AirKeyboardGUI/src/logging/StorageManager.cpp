@@ -0,0 +1,563 @@
+#include "StorageManager.h"
+
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cstdio>
+#include <unordered_map>
+
+#include "../../config.h"
+#include "LegacyConverter.h"
+#include "SessionCatalog.h"
+
+namespace {
+
+constexpr UINT64 MB = 1024 * 1024;
+
+/// Files of a session that can be regenerated from frames.bin, removed first when space runs short: the snapshots
+/// with jpeg_bench --out, the index by SessionReader. postprocess.csv is kept, no tool rebuilds it
+const char* const REGENERABLE_FILES[] = {"snapshots", "frames.idx"};
+
+const char* pressureName(StoragePressure pressure) {
+    switch (pressure) {
+        case StoragePressure::NORMAL:
+            return "normal";
+        case StoragePressure::DEGRADE_CAPTURE:
+            return "degrade capture";
+        case StoragePressure::SHED_FRAMES:
+            return "shed logged frames";
+        default:
+            return "unknown";
+    }
+}
+
+/**
+ * @brief Bytes of every file under a path, or of the path itself if it is a file.
+ */
+UINT64 pathSize(const std::filesystem::path& path) {
+    std::error_code ec;
+    if (std::filesystem::is_regular_file(path, ec)) return std::filesystem::file_size(path, ec);
+
+    UINT64 bytes = 0;
+    for (const auto& file : std::filesystem::recursive_directory_iterator(path, ec)) {
+        if (!file.is_regular_file(ec)) continue;
+        UINT64 size = file.file_size(ec);
+        if (!ec) bytes += size;
+    }
+    return bytes;
+}
+
+INT64 nowUnixMs() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch())
+        .count();
+}
+
+}  // namespace
+
+std::filesystem::path StorageManager::reservePath() const {
+    return logDir / "storage_reserve.bin";
+}
+
+std::filesystem::path StorageManager::catalogPath() const {
+    return logDir / SESSION_CATALOG_NAME;
+}
+
+void StorageManager::monitorLoop() {
+    // Deleting sessions should not compete with the loggers for the disk
+    SetThreadPriority(GetCurrentThread(), THREAD_MODE_BACKGROUND_BEGIN);
+
+    const UINT64 minFree = static_cast<UINT64>(STORAGE_MIN_FREE_MB) * MB;
+    std::unique_lock<std::mutex> lock(stateLock);
+
+    while (!stopping) {
+        bool sizeRequested = reservationPending;
+        bool checkLimits = policyPending;
+        reservationPending = false;
+        policyPending = false;
+        std::filesystem::path active = activeSession;
+        lock.unlock();
+
+        if (pollFreeSpace()) {
+            UINT64 target = updateReservationTarget(sizeRequested, active);
+
+            // Make room for the minimum free space and what the reservation still has to grow by. Reserved space
+            // counts as free here: the session gets it back before any session is deleted for it
+            UINT64 reserved = reservedBytes;
+            UINT64 freeNow = freeBytes;
+            UINT64 wanted = minFree + (target > reserved ? target - reserved : 0);
+            if (checkLimits || freeNow < wanted) {
+                UINT64 usable = freeNow + reserved;
+                enforcePolicy(usable < minFree ? minFree - usable : 0, wanted > freeNow ? wanted - freeNow : 0,
+                              checkLimits, active);
+                pollFreeSpace();
+            }
+
+            adjustReservation(minFree, active);
+            updatePressure();
+        }
+
+        lock.lock();
+        wake.wait_for(lock, std::chrono::milliseconds(STORAGE_POLL_MS),
+                      [this]() { return stopping || reservationPending || policyPending; });
+    }
+}
+
+UINT64 StorageManager::updateReservationTarget(bool sizeRequested, const std::filesystem::path& active) {
+    std::lock_guard<std::mutex> lock(reservationLock);
+
+    // endSession() may have run since active was read, nothing is reserved between sessions
+    if (!isActive(active)) {
+        reservationTarget = 0;
+        return 0;
+    }
+    if (!sizeRequested) return reservationTarget;
+
+    std::vector<SessionCatalogEntry> entries;
+    SessionCatalog::load(catalogPath(), entries);
+    double bytesPerSecond = expectedBytesPerSecond(entries);
+    reservationTarget = static_cast<UINT64>(bytesPerSecond * STORAGE_RESERVE_SECONDS);
+    warnedShort = false;
+
+    char message[200];
+    snprintf(message, sizeof(message), "StorageManager: reserving %.0f MB for %d s at %.1f MB/s\n",
+             reservationTarget / static_cast<double>(MB), STORAGE_RESERVE_SECONDS, bytesPerSecond / MB);
+    OutputDebugStringA(message);
+    return reservationTarget;
+}
+
+void StorageManager::adjustReservation(UINT64 minFree, const std::filesystem::path& active) {
+    std::lock_guard<std::mutex> lock(reservationLock);
+
+    UINT64 reserved = reservedBytes;
+    UINT64 freeNow = freeBytes;
+    if (freeNow < minFree && reserved > 0) {
+        // The session runs short: give it back reserved space rather than let its writes fail
+        UINT64 released = std::min(reserved, minFree - freeNow);
+        if (resizeReservation(reserved - released)) reservationTarget = reservedBytes;
+    } else if (reserved > reservationTarget) {
+        resizeReservation(reservationTarget);
+    } else if (reserved < reservationTarget && freeNow > minFree) {
+        resizeReservation(reserved + std::min(reservationTarget - reserved, freeNow - minFree));
+    }
+    pollFreeSpace();
+
+    if (!active.empty() && reservedBytes < reservationTarget && !warnedShort) {
+        warnedShort = true;
+        char message[200];
+        snprintf(message, sizeof(message), "StorageManager: only %.0f of %.0f MB reserved, %.0f MB free\n",
+                 reservedBytes / static_cast<double>(MB), reservationTarget / static_cast<double>(MB),
+                 freeBytes / static_cast<double>(MB));
+        OutputDebugStringA(message);
+    }
+}
+
+bool StorageManager::pollFreeSpace() {
+    ULARGE_INTEGER available;
+    if (!GetDiskFreeSpaceExW(logDir.wstring().c_str(), &available, nullptr, nullptr)) {
+        if (!failedPoll) {
+            failedPoll = true;
+            std::string message = "StorageManager: failed to query free space of " + logDir.string() + ", error " +
+                                  std::to_string(GetLastError()) + "\n";
+            OutputDebugStringA(message.c_str());
+        }
+        return false;
+    }
+
+    failedPoll = false;
+    freeBytes = available.QuadPart;
+    return true;
+}
+
+double StorageManager::expectedBytesPerSecond(const std::vector<SessionCatalogEntry>& entries) const {
+    // Recent sessions that still have all their files and ran long enough to have a steady rate
+    const size_t sampleSessions = 8;
+    UINT64 bytes = 0;
+    INT64 durationMs = 0;
+    size_t sampled = 0;
+    for (auto it = entries.rbegin(); it != entries.rend() && sampled < sampleSessions; ++it) {
+        if (it->flags & (SESSION_ENTRY_THINNED | SESSION_ENTRY_EVICTED)) continue;
+        if (it->durationMs < 10000) continue;
+        bytes += it->totalBytes;
+        durationMs += it->durationMs;
+        sampled++;
+    }
+
+    if (sampled == 0) return STORAGE_DEFAULT_MBPS * static_cast<double>(MB);
+    return bytes / (durationMs / 1000.0);
+}
+
+bool StorageManager::resizeReservation(UINT64 bytes) {
+    if (bytes == reservedBytes) return true;
+
+    if (bytes == 0) {
+        if (!DeleteFileW(reservePath().wstring().c_str()) && GetLastError() != ERROR_FILE_NOT_FOUND) return false;
+        reservedBytes = 0;
+        return true;
+    }
+
+    HANDLE file = CreateFileW(reservePath().wstring().c_str(), GENERIC_WRITE, 0, nullptr, OPEN_ALWAYS,
+                              FILE_ATTRIBUTE_HIDDEN | FILE_ATTRIBUTE_NOT_CONTENT_INDEXED, nullptr);
+    if (file == INVALID_HANDLE_VALUE) return false;
+
+    // Setting the end of file allocates the clusters without writing them
+    LARGE_INTEGER size;
+    size.QuadPart = static_cast<LONGLONG>(bytes);
+    bool ok = SetFilePointerEx(file, size, nullptr, FILE_BEGIN) && SetEndOfFile(file);
+    if (!ok) {
+        std::string message = "StorageManager: failed to resize the reservation to " + std::to_string(bytes / MB) +
+                              " MB, error " + std::to_string(GetLastError()) + "\n";
+        OutputDebugStringA(message.c_str());
+    }
+    CloseHandle(file);
+
+    if (ok) reservedBytes = bytes;
+    return ok;
+}
+
+std::vector<StorageManager::StoredSession> StorageManager::listSessions(const std::vector<SessionCatalogEntry>& entries,
+                                                                        const std::filesystem::path& active,
+                                                                        bool measure) const {
+    std::unordered_map<UINT64, const SessionCatalogEntry*> byId;
+    for (const auto& entry : entries) {
+        byId[entry.sessionId] = &entry;
+    }
+
+    // Session directories are named after their start time in system_clock ticks
+    std::vector<StoredSession> sessions;
+    std::error_code ec;
+    for (const auto& dir : std::filesystem::directory_iterator(logDir, ec)) {
+        if (!dir.is_directory(ec) || dir.path().filename() == active.filename()) continue;
+
+        std::string name = dir.path().filename().string();
+        UINT64 sessionId = 0;
+        auto result = std::from_chars(name.data(), name.data() + name.size(), sessionId);
+        if (result.ec != std::errc() || result.ptr != name.data() + name.size()) continue;
+
+        auto found = byId.find(sessionId);
+        const SessionCatalogEntry* entry = found != byId.end() ? found->second : nullptr;
+
+        StoredSession session;
+        session.sessionId = sessionId;
+        session.dir = dir.path();
+        session.entry = entry;
+        session.startUnixMs =
+            entry ? entry->startUnixMs
+                  : std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::duration(sessionId))
+                        .count();
+        session.bytes = 0;
+        if (measure) {
+            session.bytes = entry && !(entry->flags & SESSION_ENTRY_EVICTED) ? entry->totalBytes : pathSize(dir.path());
+        }
+        sessions.push_back(session);
+    }
+
+    std::sort(sessions.begin(), sessions.end(),
+              [](const StoredSession& a, const StoredSession& b) { return a.sessionId < b.sessionId; });
+    return sessions;
+}
+
+void StorageManager::enforcePolicy(UINT64 neededBytes, UINT64 thinBytes, bool checkLimits,
+                                   const std::filesystem::path& active) {
+    std::vector<SessionCatalogEntry> entries;
+    SessionCatalog::load(catalogPath(), entries);
+    std::vector<StoredSession> sessions = listSessions(entries, active, checkLimits && STORAGE_QUOTA_GB > 0);
+    std::vector<char> evicted(sessions.size(), 0);
+
+    // Deleting recordings is opt-in, and the newest sessions are only ever thinned
+    size_t evictable = 0;
+    if (STORAGE_EVICT_SESSIONS && sessions.size() > STORAGE_KEEP_SESSIONS) {
+        evictable = sessions.size() - STORAGE_KEEP_SESSIONS;
+    }
+    UINT64 freed = 0;
+
+    if (checkLimits && STORAGE_MAX_AGE_DAYS > 0) {
+        INT64 cutoffMs = nowUnixMs() - static_cast<INT64>(STORAGE_MAX_AGE_DAYS) * 24 * 3600 * 1000;
+        for (size_t i = 0; i < evictable && sessions[i].startUnixMs < cutoffMs; i++) {
+            freed += evictSession(sessions[i]);
+            evicted[i] = 1;
+        }
+    }
+
+    UINT64 quotaExcess = 0;
+    if (checkLimits && STORAGE_QUOTA_GB > 0) {
+        UINT64 total = 0;
+        for (const auto& session : sessions) {
+            total += session.bytes;
+        }
+        UINT64 quota = static_cast<UINT64>(STORAGE_QUOTA_GB) * 1024 * MB;
+        if (total > quota) quotaExcess = total - quota;
+    }
+
+    // Whatever is freed counts towards the free space, the quota and the reservation alike; the reservation is
+    // speculative, so it is only ever made room for by thinning
+    auto remaining = [&]() {
+        UINT64 needed = std::max(neededBytes, quotaExcess);
+        return needed > freed ? needed - freed : 0;
+    };
+    auto remainingThin = [&]() {
+        UINT64 needed = std::max({neededBytes, quotaExcess, thinBytes});
+        return needed > freed ? needed - freed : 0;
+    };
+
+    if (STORAGE_THIN_FIRST) {
+        for (size_t i = 0; i < sessions.size() && remainingThin() > 0; i++) {
+            if (evicted[i] || (sessions[i].entry && (sessions[i].entry->flags & SESSION_ENTRY_THINNED))) continue;
+            freed += thinSession(sessions[i]);
+        }
+    }
+
+    for (size_t i = 0; i < evictable && remaining() > 0; i++) {
+        if (evicted[i]) continue;
+        freed += evictSession(sessions[i]);
+        evicted[i] = 1;
+    }
+
+    // Reported once until a pass succeeds again, the monitor retries every poll
+    if (remaining() > 0 && !warnedExhausted) {
+        warnedExhausted = true;
+        char message[200];
+        snprintf(message, sizeof(message), "StorageManager: %.0f MB short, nothing left to %s\n",
+                 remaining() / static_cast<double>(MB), STORAGE_EVICT_SESSIONS ? "thin or evict" : "thin");
+        OutputDebugStringA(message);
+    } else if (remaining() == 0) {
+        warnedExhausted = false;
+    }
+}
+
+bool StorageManager::isActive(const std::filesystem::path& dir) {
+    std::lock_guard<std::mutex> lock(stateLock);
+    return !activeSession.empty() && dir.filename() == activeSession.filename();
+}
+
+UINT64 StorageManager::convertLegacy(const StoredSession& session) {
+    std::vector<std::filesystem::path> legacyDirs;
+    findLegacySessions(session.dir, legacyDirs);
+    if (legacyDirs.empty() || unconvertible.count(session.dir)) return 0;
+
+    // One transform thread at background priority, so a session being recorded keeps the disk and the cores
+    LegacyConvertOptions options;
+    options.removeLegacy = true;
+    options.background = true;
+
+    // Converting holds up the monitor loop, so the pressure is kept current from the reader's polls
+    auto lastPoll = std::chrono::steady_clock::now();
+    options.cancelled = [this, &lastPoll]() {
+        auto now = std::chrono::steady_clock::now();
+        if (now - lastPoll >= std::chrono::milliseconds(STORAGE_POLL_MS)) {
+            lastPoll = now;
+            if (pollFreeSpace()) updatePressure();
+        }
+
+        std::lock_guard<std::mutex> lock(stateLock);
+        return stopping;
+    };
+
+    UINT64 before = pathSize(session.dir);
+    LegacyConvertStats stats = convertLegacySessions(legacyDirs, options);
+    UINT64 after = pathSize(session.dir);
+
+    // A session that fails verification would fail again, so it is left as it is for the rest of the run
+    if (stats.sessionsFailed > 0) unconvertible.insert(session.dir);
+
+    char message[200];
+    if (stats.sessionsFailed > 0) {
+        snprintf(message, sizeof(message), "StorageManager: legacy session %llu failed to convert, %.1f MB kept\n",
+                 session.sessionId, after / static_cast<double>(MB));
+    } else {
+        snprintf(message, sizeof(message), "StorageManager: converted legacy session %llu, %.1f MB to %.1f MB\n",
+                 session.sessionId, before / static_cast<double>(MB), after / static_cast<double>(MB));
+    }
+    OutputDebugStringA(message);
+
+    return before > after ? before - after : 0;
+}
+
+UINT64 StorageManager::thinSession(const StoredSession& session) {
+    if (isActive(session.dir)) return 0;
+
+    UINT64 freed = 0;
+    bool removed = false;
+
+    // Raw frames are most of a legacy session, stored in frames.bin they take a fraction of the space
+    if (STORAGE_CONVERT_LEGACY) {
+        UINT64 converted = convertLegacy(session);
+        freed += converted;
+        removed = converted > 0;
+    }
+    for (const char* name : REGENERABLE_FILES) {
+        std::filesystem::path path = session.dir / name;
+        std::error_code ec;
+        if (!std::filesystem::exists(path, ec)) continue;
+
+        UINT64 bytes = pathSize(path);
+        std::filesystem::remove_all(path, ec);
+        freed += ec ? bytes - std::min(bytes, pathSize(path)) : bytes;
+        removed = true;
+    }
+    if (!removed) return 0;
+
+    if (session.entry) {
+        SessionCatalogEntry entry = *session.entry;
+        entry.flags |= SESSION_ENTRY_THINNED;
+        SessionCatalog::measureFiles(session.dir, entry);
+        SessionCatalog::append(catalogPath(), entry);
+    }
+
+    sessionsThinned++;
+    bytesReclaimed += freed;
+    return freed;
+}
+
+UINT64 StorageManager::evictSession(const StoredSession& session) {
+    if (isActive(session.dir)) return 0;
+
+    UINT64 bytes = pathSize(session.dir);
+    std::error_code ec;
+    std::filesystem::remove_all(session.dir, ec);
+
+    // A replay tool holding a file open keeps part of the session
+    UINT64 freed = bytes;
+    if (ec) {
+        freed = bytes - std::min(bytes, pathSize(session.dir));
+        std::string message = "StorageManager: failed to delete all of " + session.dir.string() + ": " + ec.message() +
+                              "\n";
+        OutputDebugStringA(message.c_str());
+    }
+
+    if (session.entry) {
+        SessionCatalogEntry entry = *session.entry;
+        entry.flags |= SESSION_ENTRY_EVICTED;
+        entry.frameBytes = 0;
+        entry.keyBytes = 0;
+        entry.totalBytes = 0;
+        SessionCatalog::append(catalogPath(), entry);
+    }
+
+    char message[200];
+    snprintf(message, sizeof(message), "StorageManager: evicted session %llu, %.1f MB\n", session.sessionId,
+             freed / static_cast<double>(MB));
+    OutputDebugStringA(message);
+
+    sessionsEvicted++;
+    bytesReclaimed += freed;
+    return freed;
+}
+
+void StorageManager::updatePressure() {
+    UINT64 usable = getUsableBytes();
+    StoragePressure level = StoragePressure::NORMAL;
+    if (writeFailed || usable < static_cast<UINT64>(STORAGE_SHED_FREE_MB) * MB) {
+        level = StoragePressure::SHED_FRAMES;
+    } else if (usable < static_cast<UINT64>(STORAGE_DEGRADE_FREE_MB) * MB) {
+        level = StoragePressure::DEGRADE_CAPTURE;
+    }
+
+    int previous = pressure.exchange(static_cast<int>(level));
+    if (previous == static_cast<int>(level)) return;
+
+    char message[200];
+    snprintf(message, sizeof(message), "StorageManager: %s at %.0f MB free, %.0f MB reserved\n", pressureName(level),
+             freeBytes / static_cast<double>(MB), reservedBytes / static_cast<double>(MB));
+    OutputDebugStringA(message);
+}
+
+StorageManager& StorageManager::getInstance() {
+    static StorageManager instance;
+    return instance;
+}
+
+void StorageManager::start(const std::filesystem::path& logDirectory) {
+    if (monitor.joinable()) return;
+
+    std::error_code ec;
+    std::filesystem::create_directories(logDirectory, ec);
+    logDir = logDirectory;
+
+    // A reservation left behind by a crash is picked up and resized
+    {
+        std::lock_guard<std::mutex> lock(reservationLock);
+        reservedBytes = std::filesystem::exists(reservePath(), ec) ? std::filesystem::file_size(reservePath(), ec) : 0;
+        reservationTarget = 0;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(stateLock);
+        stopping = false;
+        policyPending = true;
+    }
+    monitor = std::thread(&StorageManager::monitorLoop, this);
+}
+
+void StorageManager::stop() {
+    {
+        std::lock_guard<std::mutex> lock(stateLock);
+        stopping = true;
+    }
+    wake.notify_all();
+    if (monitor.joinable()) monitor.join();
+
+    std::lock_guard<std::mutex> lock(reservationLock);
+    reservationTarget = 0;
+    resizeReservation(0);
+}
+
+void StorageManager::beginSession(const std::filesystem::path& sessionDir) {
+    {
+        std::lock_guard<std::mutex> lock(stateLock);
+        activeSession = sessionDir;
+        reservationPending = true;
+        policyPending = true;
+    }
+    wake.notify_all();
+}
+
+void StorageManager::endSession() {
+    writeFailed = false;
+    {
+        std::lock_guard<std::mutex> lock(stateLock);
+        activeSession.clear();
+        reservationPending = false;
+        policyPending = true;
+    }
+
+    // The reservation only serves the session, keeping it would hold the space until stop()
+    {
+        std::lock_guard<std::mutex> lock(reservationLock);
+        reservationTarget = 0;
+        resizeReservation(0);
+    }
+    wake.notify_all();
+}
+
+void StorageManager::reportWriteFailure() {
+    if (writeFailed.exchange(true)) return;
+
+    // Loggers must shed before the next poll, which may be seconds away
+    if (pressure.exchange(static_cast<int>(StoragePressure::SHED_FRAMES)) != static_cast<int>(StoragePressure::SHED_FRAMES)) {
+        OutputDebugStringA("StorageManager: SHED_FRAMES after a failed write\n");
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(stateLock);
+        policyPending = true;
+    }
+    wake.notify_all();
+}
+
+StoragePressure StorageManager::getPressure() const {
+    return static_cast<StoragePressure>(pressure.load(std::memory_order_relaxed));
+}
+
+UINT64 StorageManager::getUsableBytes() const {
+    return freeBytes.load(std::memory_order_relaxed) + reservedBytes.load(std::memory_order_relaxed);
+}
+
+std::string StorageManager::formatReport() const {
+    char report[400];
+    snprintf(report, sizeof(report),
+             "free %.0f MB, reserved %.0f MB, %s\nthinned %llu sessions, evicted %llu sessions, reclaimed %.1f MB\n",
+             freeBytes.load() / static_cast<double>(MB), reservedBytes.load() / static_cast<double>(MB),
+             pressureName(getPressure()), sessionsThinned.load(), sessionsEvicted.load(),
+             bytesReclaimed.load() / static_cast<double>(MB));
+    return report;
+}
@@ -0,0 +1,273 @@
+#pragma once
+
+//clang-format off
+#include <windows.h>
+//clang-format on
+
+#include <atomic>
+#include <condition_variable>
+#include <filesystem>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../formats/SessionCatalogFormat.h"
+
+/**
+ * @brief Disk pressure level derived from the space a session can still use, or from a failed write.
+ *
+ * Each level includes the measures of the ones below it.
+ */
+enum class StoragePressure {
+    NORMAL = 0,           ///< Enough space, or only the reservation is short: a warning is logged
+    DEGRADE_CAPTURE = 1,  ///< Below STORAGE_DEGRADE_FREE_MB: no snapshots or post-processing, every other frame shed
+    SHED_FRAMES = 2       ///< Below STORAGE_SHED_FREE_MB: FrameLogger writes gap markers only
+};
+
+/**
+ * @brief Singleton keeping LOG_DIR within its disk space policy.
+ *
+ * A background thread polls the free space of the log volume and, when a limit
+ * from config.h is exceeded, thins the oldest sessions, compressing legacy ones, and, only with
+ * STORAGE_EVICT_SESSIONS set, deletes them, recording both in the catalog. At session start it sizes a placeholder file
+ * in LOG_DIR to STORAGE_RESERVE_SECONDS of the expected bitrate, so other
+ * writers on the volume can't take the space the session is going to need,
+ * shrinks it again whenever the session runs short and deletes it when the
+ * session ends.
+ *
+ * Loggers only read getPressure(), an atomic, and call reportWriteFailure()
+ * when a write fails, so eviction and file system calls never run on their
+ * threads. Pressure changes are logged.
+ */
+class StorageManager {
+private:
+    /// A session directory of LOG_DIR, as candidate for thinning or eviction
+    struct StoredSession {
+        UINT64 sessionId;
+        std::filesystem::path dir;
+        UINT64 bytes;
+        INT64 startUnixMs;
+        const SessionCatalogEntry* entry;  ///< Last catalog entry of the session, or nullptr
+    };
+
+    /// Directory the sessions and the catalog are in
+    std::filesystem::path logDir;
+
+    /// Directory of the session being recorded, empty between sessions
+    std::filesystem::path activeSession;
+
+    /// Whether the reservation has to be sized for a new session
+    bool reservationPending = false;
+
+    /// Whether the limits on age and size of LOG_DIR have to be checked
+    bool policyPending = false;
+
+    /// Flag telling the monitor thread to exit
+    bool stopping = false;
+
+    /// Guards activeSession, the pending flags and stopping
+    std::mutex stateLock;
+
+    /// Wakes the monitor thread before its next poll
+    std::condition_variable wake;
+
+    /// Thread polling free space and enforcing the policy
+    std::thread monitor;
+
+    /// Space the reservation should hold for the current session, only lowered while it runs and 0 between sessions
+    UINT64 reservationTarget = 0;
+
+    /// Current size of the placeholder file
+    std::atomic<UINT64> reservedBytes = 0;
+
+    /// Guards reservationTarget, warnedShort and the placeholder file; taken before stateLock
+    std::mutex reservationLock;
+
+    /// Free space of the log volume at the last poll
+    std::atomic<UINT64> freeBytes = 0;
+
+    /// Level of the last poll
+    std::atomic<int> pressure = 0;
+
+    /// Whether the reservation is short of its target, to warn once per session
+    bool warnedShort = false;
+
+    /// Whether the policy ran out of sessions to remove, to warn once until it succeeds again
+    bool warnedExhausted = false;
+
+    /// Whether the free space query failed, to report it once until it succeeds again
+    bool failedPoll = false;
+
+    /// Set by reportWriteFailure(), holds the pressure at SHED_FRAMES until the session ends
+    std::atomic<bool> writeFailed = false;
+
+    /// Legacy sessions whose conversion failed, only used by the monitor thread
+    std::set<std::filesystem::path> unconvertible;
+
+    std::atomic<UINT64> sessionsThinned = 0;
+    std::atomic<UINT64> sessionsEvicted = 0;
+    std::atomic<UINT64> bytesReclaimed = 0;
+
+    /**
+     * @brief Private constructor for singleton pattern.
+     */
+    StorageManager() = default;
+
+    /**
+     * @brief Path of the placeholder file holding the reservation.
+     */
+    std::filesystem::path reservePath() const;
+
+    /**
+     * @brief Path of the session catalog.
+     */
+    std::filesystem::path catalogPath() const;
+
+    /**
+     * @brief Monitor thread body: polls, sizes the reservation and enforces the policy until stop().
+     */
+    void monitorLoop();
+
+    /**
+     * @brief Reads the free space of the log volume into freeBytes.
+     * @return false if the volume can't be queried
+     */
+    bool pollFreeSpace();
+
+    /**
+     * @brief Expected bytes per second of a session, from the catalog's recent sessions.
+     */
+    double expectedBytesPerSecond(const std::vector<SessionCatalogEntry>& entries) const;
+
+    /**
+     * @brief Sizes the reservation for the active session, or drops it to 0 if no session is active.
+     * @param sizeRequested Whether beginSession() asked for a new size
+     * @param active Active session when the monitor last read it
+     * @return New reservationTarget
+     */
+    UINT64 updateReservationTarget(bool sizeRequested, const std::filesystem::path& active);
+
+    /**
+     * @brief Grows the placeholder file towards reservationTarget, or shrinks it when free space falls below minFree.
+     *
+     * Polls the free space again afterwards.
+     */
+    void adjustReservation(UINT64 minFree, const std::filesystem::path& active);
+
+    /**
+     * @brief Resizes the placeholder file, called with reservationLock held.
+     * @return false if the file couldn't be resized; reservedBytes keeps its size
+     */
+    bool resizeReservation(UINT64 bytes);
+
+    /**
+     * @brief Lists the session directories of LOG_DIR other than the active one, oldest first.
+     * @param measure Whether to fill in the size of every session, from the catalog or its files
+     */
+    std::vector<StoredSession> listSessions(const std::vector<SessionCatalogEntry>& entries,
+                                            const std::filesystem::path& active, bool measure) const;
+
+    /**
+     * @brief Thins and, with STORAGE_EVICT_SESSIONS, evicts sessions until the policy's limits hold.
+     * @param neededBytes Free space and reservation together missing to STORAGE_MIN_FREE_MB
+     * @param thinBytes Free space missing to STORAGE_MIN_FREE_MB plus what the reservation still lacks, only made by thinning
+     * @param checkLimits Whether to also apply STORAGE_QUOTA_GB and STORAGE_MAX_AGE_DAYS
+     */
+    void enforcePolicy(UINT64 neededBytes, UINT64 thinBytes, bool checkLimits, const std::filesystem::path& active);
+
+    /**
+     * @brief Whether a directory is the session being recorded, false for an empty path.
+     *
+     * Checked again right before a session is changed, as the session may have
+     * started since the directories were listed.
+     */
+    bool isActive(const std::filesystem::path& dir);
+
+    /**
+     * @brief Converts a legacy session's raw frames and key_events.csv to frames.bin and key_events.bin.
+     *
+     * The legacy files are removed once the outputs are verified. A session that
+     * fails is remembered and not tried again.
+     * @return Bytes freed
+     */
+    UINT64 convertLegacy(const StoredSession& session);
+
+    /**
+     * @brief Thins a session: converts it if legacy and STORAGE_CONVERT_LEGACY is set, then removes its files
+     * that can be regenerated from frames.bin.
+     * @return Bytes freed, 0 for the active session
+     */
+    UINT64 thinSession(const StoredSession& session);
+
+    /**
+     * @brief Deletes a session directory.
+     * @return Bytes freed, 0 for the active session
+     */
+    UINT64 evictSession(const StoredSession& session);
+
+    /**
+     * @brief Derives the pressure from the space the active session can still use and logs changes.
+     */
+    void updatePressure();
+
+public:
+    /**
+     * @brief Gets the singleton instance of StorageManager.
+     * @return Reference to the StorageManager instance
+     */
+    static StorageManager& getInstance();
+
+    /**
+     * @brief Starts the monitor thread for a log directory.
+     */
+    void start(const std::filesystem::path& logDirectory);
+
+    /**
+     * @brief Stops the monitor thread and gives back the reservation.
+     */
+    void stop();
+
+    /**
+     * @brief Announces a session, so its space is reserved and it is never evicted.
+     *
+     * Call before creating the session directory. Returns at once; the monitor
+     * thread sizes the reservation.
+     */
+    void beginSession(const std::filesystem::path& sessionDir);
+
+    /**
+     * @brief Ends the active session, after its catalog entry has been appended, and gives back its reservation.
+     */
+    void endSession();
+
+    /**
+     * @brief Tells the policy that a session file couldn't be written, whatever the free space says.
+     *
+     * Raises the pressure to SHED_FRAMES at once and wakes the monitor thread to
+     * free space. The pressure stays there until endSession().
+     */
+    void reportWriteFailure();
+
+    /**
+     * @brief Current disk pressure level.
+     */
+    StoragePressure getPressure() const;
+
+    /**
+     * @brief Free space of the log volume plus the reservation, in bytes.
+     */
+    UINT64 getUsableBytes() const;
+
+    /**
+     * @brief Free space, reservation and what the policy removed so far.
+     */
+    std::string formatReport() const;
+
+    /// Deleted copy constructor to enforce singleton pattern
+    StorageManager(const StorageManager&) = delete;
+
+    /// Deleted assignment operator to enforce singleton pattern
+    StorageManager& operator=(const StorageManager&) = delete;
+};
@@ -0,0 +1,74 @@
+#include "LatencyHistogram.h"
+
+#include <algorithm>
+#include <bit>
+
+int LatencyHistogram::bucketIndex(UINT64 value) {
+    if (value < SUB_BUCKETS) {
+        return static_cast<int>(value);
+    }
+
+    int shift = static_cast<int>(std::bit_width(value)) - 1 - SUB_BUCKET_BITS;
+    return (shift + 1) * SUB_BUCKETS + static_cast<int>((value >> shift) & (SUB_BUCKETS - 1));
+}
+
+UINT64 LatencyHistogram::bucketValue(int index) {
+    if (index < SUB_BUCKETS) {
+        return static_cast<UINT64>(index);
+    }
+
+    int shift = index / SUB_BUCKETS - 1;
+    UINT64 lower = static_cast<UINT64>(SUB_BUCKETS + index % SUB_BUCKETS) << shift;
+    return lower + ((1ULL << shift) >> 1);
+}
+
+void LatencyHistogram::record(INT64 latencyNs) {
+    UINT64 value = latencyNs > 0 ? static_cast<UINT64>(latencyNs) : 0;
+
+    buckets[bucketIndex(value)].fetch_add(1, std::memory_order_relaxed);
+    count.fetch_add(1, std::memory_order_relaxed);
+    sum.fetch_add(static_cast<double>(value), std::memory_order_relaxed);
+
+    UINT64 previous = maxValue.load(std::memory_order_relaxed);
+    while (value > previous && !maxValue.compare_exchange_weak(previous, value, std::memory_order_relaxed)) {
+    }
+}
+
+UINT64 LatencyHistogram::getCount() const {
+    return count.load(std::memory_order_relaxed);
+}
+
+UINT64 LatencyHistogram::getMax() const {
+    return maxValue.load(std::memory_order_relaxed);
+}
+
+double LatencyHistogram::getMean() const {
+    UINT64 n = getCount();
+    return n > 0 ? sum.load(std::memory_order_relaxed) / n : 0;
+}
+
+UINT64 LatencyHistogram::percentile(double p) const {
+    UINT64 total = getCount();
+    if (total == 0) return 0;
+
+    UINT64 rank = static_cast<UINT64>(p * (total - 1)) + 1;
+    if (rank >= total) return getMax();
+
+    UINT64 seen = 0;
+    for (int i = 0; i < BUCKET_COUNT; i++) {
+        seen += buckets[i].load(std::memory_order_relaxed);
+        if (seen >= rank) {
+            return std::min(bucketValue(i), getMax());
+        }
+    }
+    return getMax();
+}
+
+void LatencyHistogram::reset() {
+    for (auto& bucket : buckets) {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+    count = 0;
+    maxValue = 0;
+    sum = 0;
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+//clang-format off
+#include <windows.h>
+//clang-format on
+
+#include <atomic>
+
+/**
+ * @brief Lock-free log-linear histogram of nanosecond latencies.
+ *
+ * Values below 32 ns have their own bucket; above that every power of two is
+ * split into 32 buckets, so any recorded value is known within about 3% over
+ * the whole 64-bit range. record() is a few relaxed atomic operations and can
+ * be called from any number of threads on hot paths.
+ */
+class LatencyHistogram {
+private:
+    /// Buckets per power of two, as a power of two
+    static constexpr int SUB_BUCKET_BITS = 5;
+    static constexpr int SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+
+    /// Enough buckets for every non-negative 64-bit value
+    static constexpr int BUCKET_COUNT = (64 - SUB_BUCKET_BITS + 1) * SUB_BUCKETS;
+
+    std::atomic<UINT64> buckets[BUCKET_COUNT] = {};
+    std::atomic<UINT64> count = 0;
+    std::atomic<UINT64> maxValue = 0;
+    std::atomic<double> sum = 0;
+
+    /**
+     * @brief Bucket holding a value.
+     */
+    static int bucketIndex(UINT64 value);
+
+    /**
+     * @brief Midpoint of the values a bucket holds.
+     */
+    static UINT64 bucketValue(int index);
+
+public:
+    /**
+     * @brief Adds one latency; negative values count as zero.
+     */
+    void record(INT64 latencyNs);
+
+    /**
+     * @brief Number of recorded values.
+     */
+    UINT64 getCount() const;
+
+    /**
+     * @brief Largest recorded value in nanoseconds.
+     */
+    UINT64 getMax() const;
+
+    /**
+     * @brief Mean of the recorded values in nanoseconds.
+     */
+    double getMean() const;
+
+    /**
+     * @brief Value below which a fraction p of the recorded values lie, in nanoseconds.
+     * @param p Fraction between 0 and 1
+     */
+    UINT64 percentile(double p) const;
+
+    /**
+     * @brief Clears all recorded values. Not atomic with respect to concurrent record() calls.
+     */
+    void reset();
+};
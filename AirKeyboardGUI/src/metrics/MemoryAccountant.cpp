@@ -0,0 +1,159 @@
+#include "MemoryAccountant.h"
+
+#include <cstdio>
+
+#include "../../config.h"
+
+namespace {
+
+const char* pressureName(MemoryPressure pressure) {
+    switch (pressure) {
+        case MemoryPressure::NORMAL:
+            return "normal";
+        case MemoryPressure::DEGRADE_PREVIEW:
+            return "degrade preview";
+        case MemoryPressure::DROP_UNLOGGED:
+            return "drop unlogged frames";
+        case MemoryPressure::SHED_LOGGING:
+            return "shed logged frames";
+        default:
+            return "unknown";
+    }
+}
+
+void updatePeak(std::atomic<INT64>& peak, INT64 value) {
+    INT64 previous = peak.load(std::memory_order_relaxed);
+    while (value > previous && !peak.compare_exchange_weak(previous, value, std::memory_order_relaxed)) {
+    }
+}
+
+}  // namespace
+
+void MemoryAccount::add(INT64 byteCount, INT64 itemCount) {
+    INT64 total = bytes.fetch_add(byteCount, std::memory_order_relaxed) + byteCount;
+    items.fetch_add(itemCount, std::memory_order_relaxed);
+    updatePeak(peakBytes, total);
+
+    if (budgeted) {
+        accountant->updateBudgeted(byteCount);
+    }
+}
+
+void MemoryAccount::remove(INT64 byteCount, INT64 itemCount) {
+    bytes.fetch_sub(byteCount, std::memory_order_relaxed);
+    items.fetch_sub(itemCount, std::memory_order_relaxed);
+
+    if (budgeted) {
+        accountant->updateBudgeted(-byteCount);
+    }
+}
+
+const std::string& MemoryAccount::getName() const {
+    return name;
+}
+
+bool MemoryAccount::isBudgeted() const {
+    return budgeted;
+}
+
+INT64 MemoryAccount::getBytes() const {
+    return bytes.load(std::memory_order_relaxed);
+}
+
+INT64 MemoryAccount::getItems() const {
+    return items.load(std::memory_order_relaxed);
+}
+
+INT64 MemoryAccount::getPeakBytes() const {
+    return peakBytes.load(std::memory_order_relaxed);
+}
+
+MemoryAccount::MemoryAccount(MemoryAccountant* accountant, const std::string& name, bool budgeted)
+    : accountant(accountant), name(name), budgeted(budgeted) {}
+
+MemoryPressure MemoryAccountant::pressureAt(INT64 bytes) const {
+    INT64 soft = softBudget.load(std::memory_order_relaxed);
+    INT64 hard = hardBudget.load(std::memory_order_relaxed);
+
+    if (bytes >= hard) return MemoryPressure::SHED_LOGGING;
+    if (bytes >= soft + (hard - soft) / 2) return MemoryPressure::DROP_UNLOGGED;
+    if (bytes >= soft) return MemoryPressure::DEGRADE_PREVIEW;
+    return MemoryPressure::NORMAL;
+}
+
+void MemoryAccountant::updateBudgeted(INT64 delta) {
+    INT64 total = budgetedBytes.fetch_add(delta, std::memory_order_relaxed) + delta;
+    updatePeak(peakBudgetedBytes, total);
+
+    int pressure = static_cast<int>(pressureAt(total));
+    int previous = reportedPressure.load(std::memory_order_relaxed);
+    if (pressure == previous) return;
+
+    // Rises are reported at once, drops only past the band so a total hovering at a threshold logs once
+    if (pressure < previous && static_cast<int>(pressureAt(total + reportHysteresis)) >= previous) return;
+    if (!reportedPressure.compare_exchange_strong(previous, pressure, std::memory_order_relaxed)) return;
+
+    char line[160];
+    snprintf(line, sizeof(line), "MemoryAccountant: %s at %.1f MB in flight\n",
+             pressureName(static_cast<MemoryPressure>(pressure)), total / (1024.0 * 1024.0));
+    OutputDebugStringA(line);
+
+    // Show who holds the memory when pressure rises
+    if (pressure > previous) {
+        OutputDebugStringA(formatReport().c_str());
+    }
+}
+
+MemoryAccountant& MemoryAccountant::getInstance() {
+    static MemoryAccountant instance;
+    return instance;
+}
+
+MemoryAccount* MemoryAccountant::getAccount(const std::string& name, bool budgeted) {
+    std::lock_guard<std::mutex> lock(accountsLock);
+    for (const auto& account : accounts) {
+        if (account->name == name) return account.get();
+    }
+
+    accounts.push_back(std::unique_ptr<MemoryAccount>(new MemoryAccount(this, name, budgeted)));
+    return accounts.back().get();
+}
+
+void MemoryAccountant::setBudgets(INT64 softBytes, INT64 hardBytes) {
+    softBudget = softBytes;
+    hardBudget = hardBytes > softBytes ? hardBytes : softBytes;
+}
+
+MemoryPressure MemoryAccountant::getPressure() const {
+    return pressureAt(budgetedBytes.load(std::memory_order_relaxed));
+}
+
+INT64 MemoryAccountant::getBudgetedBytes() const {
+    return budgetedBytes.load(std::memory_order_relaxed);
+}
+
+std::string MemoryAccountant::formatReport() const {
+    const double mb = 1024.0 * 1024.0;
+    std::string report;
+    char line[256];
+
+    snprintf(line, sizeof(line), "in flight %.1f MB (peak %.1f MB), soft budget %.0f MB, hard budget %.0f MB, %s\n",
+             getBudgetedBytes() / mb, peakBudgetedBytes.load(std::memory_order_relaxed) / mb, softBudget.load() / mb,
+             hardBudget.load() / mb, pressureName(getPressure()));
+    report += line;
+
+    std::lock_guard<std::mutex> lock(accountsLock);
+    for (const auto& account : accounts) {
+        snprintf(line, sizeof(line), "  %-28s %10.1f MB %8lld items  peak %10.1f MB%s\n", account->name.c_str(),
+                 account->getBytes() / mb, account->getItems(), account->getPeakBytes() / mb,
+                 account->budgeted ? "" : "  (shared, not budgeted)");
+        report += line;
+    }
+
+    return report;
+}
+
+MemoryAccountant::MemoryAccountant()
+    : softBudget(static_cast<INT64>(MEMORY_SOFT_BUDGET_MB) * 1024 * 1024),
+      hardBudget(static_cast<INT64>(MEMORY_HARD_BUDGET_MB) * 1024 * 1024),
+      reportHysteresis(static_cast<INT64>(MEMORY_REPORT_HYSTERESIS_MB) * 1024 * 1024) {}
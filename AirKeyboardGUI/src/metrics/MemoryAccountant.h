@@ -0,0 +1,180 @@
+#pragma once
+
+//clang-format off
+#include <windows.h>
+//clang-format on
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+/**
+ * @brief Backpressure level derived from budgeted memory in flight.
+ *
+ * Each level includes the measures of the ones below it.
+ */
+enum class MemoryPressure {
+    NORMAL = 0,           ///< Below the soft budget
+    DEGRADE_PREVIEW = 1,  ///< Above the soft budget: the preview only keeps the newest frame
+    DROP_UNLOGGED = 2,    ///< Halfway to the hard budget: frames nobody logs are dropped
+    SHED_LOGGING = 3      ///< At the hard budget: FrameLogger sheds frames and writes gap markers
+};
+
+class MemoryAccountant;
+
+/**
+ * @brief Bytes and items held by one component.
+ *
+ * Budgeted accounts own their memory and add up to the total the budgets are
+ * checked against. Unbudgeted accounts report memory owned elsewhere, such as
+ * frames shared by several subscriber queues, and are shown per component only.
+ */
+class MemoryAccount {
+private:
+    friend class MemoryAccountant;
+
+    /// Accountant notified when a budgeted account changes
+    MemoryAccountant* accountant;
+
+    /// Component name shown in reports
+    std::string name;
+
+    /// Whether this account counts towards the budgets
+    bool budgeted;
+
+    std::atomic<INT64> bytes = 0;
+    std::atomic<INT64> items = 0;
+    std::atomic<INT64> peakBytes = 0;
+
+    MemoryAccount(MemoryAccountant* accountant, const std::string& name, bool budgeted);
+
+public:
+    /**
+     * @brief Records memory taken by the component.
+     */
+    void add(INT64 byteCount, INT64 itemCount = 1);
+
+    /**
+     * @brief Records memory given back by the component.
+     */
+    void remove(INT64 byteCount, INT64 itemCount = 1);
+
+    /**
+     * @brief Records the capacity of reusable buffers in place of what the account held, keeping its item count.
+     * @param buffers Containers with capacity() and value_type, such as per-thread std::vector<BYTE> buffers
+     */
+    template <typename Buffers>
+    void setCapacity(const Buffers& buffers) {
+        INT64 capacity = 0;
+        for (const auto& buffer : buffers) {
+            capacity += static_cast<INT64>(buffer.capacity() * sizeof(typename std::decay_t<decltype(buffer)>::value_type));
+        }
+
+        INT64 delta = capacity - getBytes();
+        if (delta > 0) add(delta, 0);
+        if (delta < 0) remove(-delta, 0);
+    }
+
+    const std::string& getName() const;
+    bool isBudgeted() const;
+    INT64 getBytes() const;
+    INT64 getItems() const;
+    INT64 getPeakBytes() const;
+};
+
+/**
+ * @brief Singleton tracking memory held by every queue and buffer pool.
+ *
+ * Components look up their account once and report to it as they take and
+ * release memory. The sum of the budgeted accounts is compared against a soft
+ * and a hard budget; consumers poll getPressure() to decide how much work to
+ * shed. Pressure changes are logged, rises with a per-component breakdown;
+ * drops only once the total is MEMORY_REPORT_HYSTERESIS_MB past the threshold.
+ */
+class MemoryAccountant {
+private:
+    friend class MemoryAccount;
+
+    /// Accounts by registration order, never removed
+    std::vector<std::unique_ptr<MemoryAccount>> accounts;
+
+    /// Guards accounts
+    mutable std::mutex accountsLock;
+
+    /// Sum of the budgeted accounts
+    std::atomic<INT64> budgetedBytes = 0;
+
+    /// Peak of budgetedBytes
+    std::atomic<INT64> peakBudgetedBytes = 0;
+
+    /// Budget above which the preview degrades
+    std::atomic<INT64> softBudget;
+
+    /// Budget at which logging sheds frames
+    std::atomic<INT64> hardBudget;
+
+    /// Level last reported, to log changes only
+    std::atomic<int> reportedPressure = 0;
+
+    /// Bytes the total must fall below a threshold before the lower level is reported
+    const INT64 reportHysteresis;
+
+    /**
+     * @brief Private constructor for singleton pattern, budgets come from config.h.
+     */
+    MemoryAccountant();
+
+    /**
+     * @brief Pressure at a given budgeted total.
+     */
+    MemoryPressure pressureAt(INT64 bytes) const;
+
+    /**
+     * @brief Applies a change of a budgeted account to the total.
+     */
+    void updateBudgeted(INT64 delta);
+
+public:
+    /**
+     * @brief Gets the singleton instance of MemoryAccountant.
+     * @return Reference to the MemoryAccountant instance
+     */
+    static MemoryAccountant& getInstance();
+
+    /**
+     * @brief Finds the account of a component, creating it on first use.
+     * @param name Component name; components sharing a name share the account
+     * @param budgeted Whether the memory counts towards the budgets
+     * @return Account that lives as long as the accountant
+     */
+    MemoryAccount* getAccount(const std::string& name, bool budgeted);
+
+    /**
+     * @brief Replaces the budgets from config.h.
+     */
+    void setBudgets(INT64 softBytes, INT64 hardBytes);
+
+    /**
+     * @brief Current backpressure level.
+     */
+    MemoryPressure getPressure() const;
+
+    /**
+     * @brief Sum of the budgeted accounts in bytes.
+     */
+    INT64 getBudgetedBytes() const;
+
+    /**
+     * @brief Budget totals followed by one line per account.
+     */
+    std::string formatReport() const;
+
+    /// Deleted copy constructor to enforce singleton pattern
+    MemoryAccountant(const MemoryAccountant&) = delete;
+
+    /// Deleted assignment operator to enforce singleton pattern
+    MemoryAccountant& operator=(const MemoryAccountant&) = delete;
+};
@@ -0,0 +1,74 @@
+#include "PipelineMetrics.h"
+
+#include <cstdio>
+
+#include "../capture/Timebase.h"
+
+PipelineMetrics& PipelineMetrics::getInstance() {
+    static PipelineMetrics instance;
+    return instance;
+}
+
+const char* PipelineMetrics::stageName(MetricStage stage) {
+    switch (stage) {
+        case MetricStage::KEY_TEXT_UPDATE:
+            return "key_text_update";
+        case MetricStage::KEY_TRIGGER_UPDATE:
+            return "key_trigger_update";
+        case MetricStage::KEY_LOG_FLUSH:
+            return "key_log_flush";
+        default:
+            return "unknown";
+    }
+}
+
+void PipelineMetrics::record(MetricStage stage, LONGLONG publishQpc) {
+    LARGE_INTEGER perfCounter;
+    QueryPerformanceCounter(&perfCounter);
+
+    const Timebase& timebase = Timebase::getInstance();
+    recordLatency(stage, timebase.fromQpc(perfCounter.QuadPart) - timebase.fromQpc(publishQpc));
+}
+
+void PipelineMetrics::recordLatency(MetricStage stage, INT64 latencyNs) {
+    latency[static_cast<size_t>(stage)].record(latencyNs);
+}
+
+void PipelineMetrics::recordDropped(MetricStage stage, UINT64 count) {
+    dropped[static_cast<size_t>(stage)].fetch_add(count, std::memory_order_relaxed);
+}
+
+const LatencyHistogram& PipelineMetrics::getLatency(MetricStage stage) const {
+    return latency[static_cast<size_t>(stage)];
+}
+
+UINT64 PipelineMetrics::getDropped(MetricStage stage) const {
+    return dropped[static_cast<size_t>(stage)].load(std::memory_order_relaxed);
+}
+
+void PipelineMetrics::reset() {
+    for (size_t i = 0; i < STAGE_COUNT; i++) {
+        latency[i].reset();
+        dropped[i] = 0;
+    }
+}
+
+std::string PipelineMetrics::formatReport() const {
+    std::string report;
+    char line[256];
+
+    snprintf(line, sizeof(line), "%-20s %10s %8s %10s %10s %10s %10s %10s\n", "stage", "handled", "dropped",
+             "mean_us", "p50_us", "p99_us", "p99.9_us", "max_us");
+    report += line;
+
+    for (size_t i = 0; i < STAGE_COUNT; i++) {
+        const LatencyHistogram& histogram = latency[i];
+        snprintf(line, sizeof(line), "%-20s %10llu %8llu %10.1f %10.1f %10.1f %10.1f %10.1f\n",
+                 stageName(static_cast<MetricStage>(i)), histogram.getCount(), getDropped(static_cast<MetricStage>(i)),
+                 histogram.getMean() / 1e3, histogram.percentile(0.50) / 1e3, histogram.percentile(0.99) / 1e3,
+                 histogram.percentile(0.999) / 1e3, histogram.getMax() / 1e3);
+        report += line;
+    }
+
+    return report;
+}
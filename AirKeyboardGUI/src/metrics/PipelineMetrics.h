@@ -0,0 +1,98 @@
+#pragma once
+
+//clang-format off
+#include <windows.h>
+//clang-format on
+
+#include <atomic>
+#include <string>
+
+#include "LatencyHistogram.h"
+
+/**
+ * @brief Points in the pipeline where latency is measured.
+ */
+enum class MetricStage {
+    KEY_TEXT_UPDATE = 0,     ///< Key event published -> TextContainer::update
+    KEY_TRIGGER_UPDATE = 1,  ///< Key event published -> LoggingTrigger::update
+    KEY_LOG_FLUSH = 2,       ///< Key event published -> record written by KeyEventLogger
+    COUNT
+};
+
+/**
+ * @brief Singleton collecting per-stage latency histograms and drop counts.
+ *
+ * Consumers call record() with the event's publish time when they handle it,
+ * which costs a QPC read and a few relaxed atomic operations. The collected
+ * figures are read back with getLatency() or formatReport().
+ */
+class PipelineMetrics {
+private:
+    static constexpr size_t STAGE_COUNT = static_cast<size_t>(MetricStage::COUNT);
+
+    /// Publish-to-handled latency per stage
+    LatencyHistogram latency[STAGE_COUNT];
+
+    /// Events lost before reaching each stage
+    std::atomic<UINT64> dropped[STAGE_COUNT] = {};
+
+    /**
+     * @brief Private constructor for singleton pattern.
+     */
+    PipelineMetrics() = default;
+
+public:
+    /**
+     * @brief Gets the singleton instance of PipelineMetrics.
+     * @return Reference to the PipelineMetrics instance
+     */
+    static PipelineMetrics& getInstance();
+
+    /**
+     * @brief Short lowercase name of a stage, used in reports.
+     */
+    static const char* stageName(MetricStage stage);
+
+    /**
+     * @brief Records that a stage handled an event now.
+     * @param stage Stage that handled the event
+     * @param publishQpc Performance counter value at which the event was published
+     */
+    void record(MetricStage stage, LONGLONG publishQpc);
+
+    /**
+     * @brief Records a latency measured by the caller.
+     */
+    void recordLatency(MetricStage stage, INT64 latencyNs);
+
+    /**
+     * @brief Adds events lost before reaching a stage.
+     */
+    void recordDropped(MetricStage stage, UINT64 count);
+
+    /**
+     * @brief Latency histogram of a stage.
+     */
+    const LatencyHistogram& getLatency(MetricStage stage) const;
+
+    /**
+     * @brief Number of events lost before reaching a stage.
+     */
+    UINT64 getDropped(MetricStage stage) const;
+
+    /**
+     * @brief Clears every histogram and drop count.
+     */
+    void reset();
+
+    /**
+     * @brief One line per stage with count, drops, percentiles and maximum in microseconds.
+     */
+    std::string formatReport() const;
+
+    /// Deleted copy constructor to enforce singleton pattern
+    PipelineMetrics(const PipelineMetrics&) = delete;
+
+    /// Deleted assignment operator to enforce singleton pattern
+    PipelineMetrics& operator=(const PipelineMetrics&) = delete;
+};
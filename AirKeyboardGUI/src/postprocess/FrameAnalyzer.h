@@ -0,0 +1,53 @@
+#pragma once
+
+//clang-format off
+#include <windows.h>
+//clang-format on
+
+#include <string>
+#include <vector>
+
+#include "../types.h"
+
+/**
+ * @brief Per-frame analysis run in-process by PostProcessStage.
+ *
+ * An analyzer turns one frame into a fixed set of named values, the columns of
+ * its part of the stage's output. analyze() runs on several pool threads at
+ * once, so analyzers keep any working state per thread, sized in prepare().
+ * Frames of a batch are analyzed in any order; the stage restores capture
+ * order when writing the results, so analyzers must not depend on seeing the
+ * previous frame.
+ *
+ * A model-backed analyzer implements the same interface, with one inference
+ * session per thread.
+ */
+class FrameAnalyzer {
+public:
+    virtual ~FrameAnalyzer() = default;
+
+    /**
+     * @brief Short name that prefixes the analyzer's columns in the output.
+     */
+    virtual const char* getName() const = 0;
+
+    /**
+     * @brief Names of the values analyze() produces, in order.
+     */
+    virtual std::vector<std::string> getColumns() const = 0;
+
+    /**
+     * @brief Sets up per-thread state, called once before the first frame.
+     * @param threadCount Number of threads that call analyze(), their indices are below it
+     */
+    virtual void prepare(unsigned int threadCount) {}
+
+    /**
+     * @brief Analyzes one frame.
+     * @param frame Frame to analyze, shared with other subscribers and read-only
+     * @param thread Index of the calling thread, below the count passed to prepare()
+     * @param values Receives getColumns().size() values, NaN where a value doesn't apply
+     * @return false if the frame can't be analyzed, e.g. for an unsupported pixel format
+     */
+    virtual bool analyze(const ProcessedFrame& frame, unsigned int thread, double* values) = 0;
+};
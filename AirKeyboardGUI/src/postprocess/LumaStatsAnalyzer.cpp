@@ -0,0 +1,71 @@
+#include "LumaStatsAnalyzer.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+/// Luma below which a pixel counts as crushed
+constexpr int DARK_LUMA = 16;
+
+/// Luma from which a pixel counts as clipped
+constexpr int BRIGHT_LUMA = 240;
+
+}  // namespace
+
+const char* LumaStatsAnalyzer::getName() const {
+    return "luma";
+}
+
+std::vector<std::string> LumaStatsAnalyzer::getColumns() const {
+    return {"mean", "stddev", "min", "max", "dark_fraction", "bright_fraction"};
+}
+
+bool LumaStatsAnalyzer::analyze(const ProcessedFrame& frame, unsigned int thread, double* values) {
+    const FrameHeader& header = frame.header;
+    size_t pixels = static_cast<size_t>(header.width) * header.height;
+    if (!frame.data || header.pixelFormat != PIXEL_FORMAT_BGR24 || pixels == 0 || header.dataSize != pixels * 3) {
+        return false;
+    }
+
+    // Two histograms alternate between pixels, so neighbours of equal luma don't wait on each other's increment
+    UINT32 histograms[2][256] = {};
+    const BYTE* bgr = frame.data.get();
+    size_t i = 0;
+    for (; i + 1 < pixels; i += 2) {
+        const BYTE* p = bgr + i * 3;
+        histograms[0][(29 * p[0] + 150 * p[1] + 77 * p[2] + 128) >> 8]++;
+        histograms[1][(29 * p[3] + 150 * p[4] + 77 * p[5] + 128) >> 8]++;
+    }
+    if (i < pixels) {
+        const BYTE* p = bgr + i * 3;
+        histograms[0][(29 * p[0] + 150 * p[1] + 77 * p[2] + 128) >> 8]++;
+    }
+
+    UINT64 sum = 0;
+    UINT64 sumSquares = 0;
+    UINT64 dark = 0;
+    UINT64 bright = 0;
+    int minimum = -1;
+    int maximum = 0;
+    for (int luma = 0; luma < 256; luma++) {
+        UINT64 count = static_cast<UINT64>(histograms[0][luma]) + histograms[1][luma];
+        if (count == 0) continue;
+
+        if (minimum < 0) minimum = luma;
+        maximum = luma;
+        sum += count * luma;
+        sumSquares += count * luma * luma;
+        if (luma < DARK_LUMA) dark += count;
+        if (luma >= BRIGHT_LUMA) bright += count;
+    }
+
+    double mean = static_cast<double>(sum) / pixels;
+    values[0] = mean;
+    values[1] = std::sqrt(std::max(0.0, static_cast<double>(sumSquares) / pixels - mean * mean));
+    values[2] = minimum;
+    values[3] = maximum;
+    values[4] = static_cast<double>(dark) / pixels;
+    values[5] = static_cast<double>(bright) / pixels;
+    return true;
+}
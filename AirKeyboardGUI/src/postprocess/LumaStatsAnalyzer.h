@@ -0,0 +1,25 @@
+#pragma once
+
+//clang-format off
+#include <windows.h>
+//clang-format on
+
+#include "FrameAnalyzer.h"
+
+/**
+ * @brief Exposure statistics of a frame's luma.
+ *
+ * Computes full-range BT.601 luma for every pixel of a BGR24 frame and reports
+ * its mean, standard deviation, minimum and maximum, and the fractions of
+ * pixels crushed to black (below 16) or clipped to white (240 and above).
+ * Sessions recorded too dark or too bright show up here before the landmark
+ * detector quietly finds no hands. Needs no per-thread state.
+ */
+class LumaStatsAnalyzer : public FrameAnalyzer {
+public:
+    const char* getName() const override;
+
+    std::vector<std::string> getColumns() const override;
+
+    bool analyze(const ProcessedFrame& frame, unsigned int thread, double* values) override;
+};
@@ -0,0 +1,172 @@
+#include "PostProcessStage.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <limits>
+#include <string>
+
+#include "LumaStatsAnalyzer.h"
+#include "SkinMaskAnalyzer.h"
+
+void PostProcessStage::analyzeFrame(size_t index, unsigned int thread) {
+    double* row = values.data() + index * columnCount;
+    std::fill(row, row + columnCount, std::numeric_limits<double>::quiet_NaN());
+    if (!batch[index]) return;
+
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < analyzers.size(); i++) {
+        if (!analyzers[i]->analyze(*batch[index], thread, row + columnOffsets[i])) {
+            // A partial result would read as real values, the columns stay empty instead
+            std::fill(row + columnOffsets[i], row + columnOffsets[i + 1], std::numeric_limits<double>::quiet_NaN());
+            if (analyzeFailures++ == 0) {
+                std::string message = std::string("PostProcessStage: ") + analyzers[i]->getName() +
+                                      " can't analyze sequence " + std::to_string(batch[index]->header.sequence) + "\n";
+                OutputDebugStringA(message.c_str());
+            }
+        }
+    }
+    threadNs[thread] += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+void PostProcessStage::writeHeader() {
+    output << "sequence,capture_ns";
+    for (const auto& analyzer : analyzers) {
+        for (const auto& column : analyzer->getColumns()) {
+            output << ',' << analyzer->getName() << '_' << column;
+        }
+    }
+    output << '\n';
+}
+
+void PostProcessStage::writeRows() {
+    std::string line;
+    char field[32];
+    for (size_t index = 0; index < batch.size(); index++) {
+        if (!batch[index]) continue;
+
+        const FrameHeader& header = batch[index]->header;
+        sprintf_s(field, "%llu,%lld", header.sequence, header.captureNs);
+        line = field;
+
+        // NaN is left empty, which CSV readers take as a missing value
+        const double* row = values.data() + index * columnCount;
+        for (size_t column = 0; column < columnCount; column++) {
+            line += ',';
+            if (std::isnan(row[column])) continue;
+            sprintf_s(field, "%.6g", row[column]);
+            line += field;
+        }
+        line += '\n';
+        output << line;
+    }
+}
+
+void PostProcessStage::enqueue(std::shared_ptr<ProcessedFrame> frame) {
+    // Frames without pixels have nothing to analyze
+    if (!frame || !frame->data) return;
+
+    bool behind = false;
+    {
+        std::lock_guard<std::mutex> lock(queueLock);
+        behind = msgQueue.size() >= POSTPROCESS_MAX_QUEUED;
+    }
+
+    // The analysis is derived from frames.bin and can be redone offline, the logger's frames can't
+    if (behind || MemoryAccountant::getInstance().getPressure() >= MemoryPressure::SHED_LOGGING ||
+        StorageManager::getInstance().getPressure() >= StoragePressure::DEGRADE_CAPTURE) {
+        framesDropped++;
+        return;
+    }
+
+    BatchSubscriber::enqueue(frame);
+}
+
+void PostProcessStage::processBatch() {
+    while (!flushQueue.empty()) {
+        batch.push_back(takeFlushed());
+    }
+
+    values.resize(batch.size() * columnCount);
+    std::fill(threadNs.begin(), threadNs.end(), 0);
+    analyzePool->parallelFor(batch.size(), [this](size_t index, unsigned int thread) { analyzeFrame(index, thread); });
+
+    UINT64 batchNs = 0;
+    for (UINT64 ns : threadNs) {
+        batchNs += ns;
+    }
+    analyzeNs += batchNs;
+    framesAnalyzed += std::count_if(batch.begin(), batch.end(), [](const auto& frame) { return frame != nullptr; });
+
+    if (output.is_open()) writeRows();
+    batch.clear();
+}
+
+UINT64 PostProcessStage::getFramesAnalyzed() const {
+    return framesAnalyzed;
+}
+
+UINT64 PostProcessStage::getFramesDropped() const {
+    return framesDropped;
+}
+
+double PostProcessStage::getAnalyzeFps() const {
+    UINT64 ns = analyzeNs;
+    return ns > 0 ? framesAnalyzed / (ns / 1e9) : 0.0;
+}
+
+unsigned int PostProcessStage::configuredWorkers() {
+    return WorkerPool::configuredThreads(POSTPROCESS_WORKERS);
+}
+
+std::vector<std::unique_ptr<FrameAnalyzer>> PostProcessStage::builtinAnalyzers() {
+    std::vector<std::unique_ptr<FrameAnalyzer>> builtin;
+    builtin.push_back(std::make_unique<LumaStatsAnalyzer>());
+    builtin.push_back(std::make_unique<SkinMaskAnalyzer>());
+    return builtin;
+}
+
+BatchPolicy PostProcessStage::batchPolicy(unsigned int threads) {
+    // A couple of frames per thread keeps every thread busy without delaying rows long
+    BatchPolicy policy;
+    policy.maxItems = std::max(1u, threads) * 2;
+    policy.maxAge = std::chrono::milliseconds(FRAME_LOG_BATCH_AGE_MS);
+    return policy;
+}
+
+PostProcessStage::PostProcessStage(const std::filesystem::path& outputPath,
+                                   std::vector<std::unique_ptr<FrameAnalyzer>> frameAnalyzers, unsigned int threads)
+    : BatchSubscriber(batchPolicy(threads), processedFrameBytes), analyzers(std::move(frameAnalyzers)) {
+    // Frames are shared with the other subscribers, the queue only holds references
+    trackQueue("postprocess_queue", false, processedFrameBytes);
+
+    analyzePool = std::make_unique<WorkerPool>(std::max(1u, threads));
+    threadNs.resize(analyzePool->getThreadCount());
+
+    for (const auto& analyzer : analyzers) {
+        columnOffsets.push_back(columnCount);
+        columnCount += analyzer->getColumns().size();
+        analyzer->prepare(analyzePool->getThreadCount());
+    }
+    columnOffsets.push_back(columnCount);
+
+    if (outputPath.empty()) return;
+    output.open(outputPath);
+    if (!output) {
+        std::string message = "PostProcessStage: failed to create " + outputPath.string() + "\n";
+        OutputDebugStringA(message.c_str());
+        return;
+    }
+    writeHeader();
+}
+
+PostProcessStage::~PostProcessStage() {
+    flush();
+
+    char message[256];
+    sprintf_s(message, "PostProcessStage: %llu frames analyzed, %llu dropped, %llu analyzer failures, %.1f fps per thread on %u threads\n",
+              framesAnalyzed.load(), framesDropped.load(), analyzeFailures.load(), getAnalyzeFps(),
+              analyzePool->getThreadCount());
+    OutputDebugStringA(message);
+}
@@ -0,0 +1,128 @@
+#pragma once
+
+//clang-format off
+#include <windows.h>
+//clang-format on
+
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <vector>
+
+#include "../../config.h"
+#include "../base/BatchSubscriber.h"
+#include "../base/WorkerPool.h"
+#include "../logging/StorageManager.h"
+#include "../metrics/MemoryAccountant.h"
+#include "../types.h"
+#include "FrameAnalyzer.h"
+
+/**
+ * @brief In-process post-processing of session frames.
+ *
+ * Subscribes to FrameProcessor and runs every FrameAnalyzer on each frame, with
+ * the frames of a batch spread over a fixed pool of threads. Once a batch is
+ * done its results are written as CSV rows, one per frame: the sequence and
+ * capture time followed by every analyzer's columns, prefixed with its name.
+ * Rows come out in the order frames were published, which is capture order,
+ * however the threads finished them.
+ *
+ * At most POSTPROCESS_MAX_QUEUED frames wait for the stage; newer frames are
+ * dropped when it falls behind, and under memory pressure, so a slow analyzer
+ * never holds on to frames the logger needs. Dropped frames have no row.
+ */
+class PostProcessStage : public BatchSubscriber<ProcessedFrame> {
+private:
+    std::vector<std::unique_ptr<FrameAnalyzer>> analyzers;  /// Analyzers run on every frame, in column order
+    std::vector<size_t> columnOffsets;                      /// Index of each analyzer's first value in a row, then columnCount
+    size_t columnCount = 0;                                 /// Values per frame, over all analyzers
+    std::ofstream output;                                   /// CSV rows, not open without an output path
+
+    std::unique_ptr<WorkerPool> analyzePool;             /// Threads analyzing the frames of a batch
+    std::vector<std::shared_ptr<ProcessedFrame>> batch;  /// Frames of the batch being analyzed
+    std::vector<double> values;                          /// Results of the batch, columnCount per frame
+    std::vector<UINT64> threadNs;                        /// Time every analyzePool thread spent in the batch
+    std::atomic<UINT64> framesAnalyzed = 0;              /// Frames with a row so far
+    std::atomic<UINT64> framesDropped = 0;               /// Frames dropped because the stage fell behind or memory or disk space ran low
+    std::atomic<UINT64> analyzeFailures = 0;             /// Analyzer calls that couldn't analyze their frame
+    std::atomic<UINT64> analyzeNs = 0;                   /// Thread time spent analyzing so far
+
+    /**
+     * @brief Builds the batch limits for a pool of the given size.
+     */
+    static BatchPolicy batchPolicy(unsigned int threads);
+
+    /**
+     * @brief Runs every analyzer on one frame of the batch.
+     * @param index Position of the frame in the batch, and of its results in values
+     * @param thread Index of the analyzePool thread running it
+     */
+    void analyzeFrame(size_t index, unsigned int thread);
+
+    /**
+     * @brief Writes the CSV header naming every column.
+     */
+    void writeHeader();
+
+    /**
+     * @brief Writes the results of the batch, one row per frame in batch order.
+     */
+    void writeRows();
+
+    /**
+     * @brief Analyzes the frames of the batch in parallel and writes their rows.
+     *
+     * Inherited from BatchSubscriber.
+     */
+    void processBatch() override;
+
+public:
+    /**
+     * @brief Number of analysis threads from config.h.
+     */
+    static unsigned int configuredWorkers();
+
+    /**
+     * @brief Creates the analyzers that ship with the application.
+     */
+    static std::vector<std::unique_ptr<FrameAnalyzer>> builtinAnalyzers();
+
+    /**
+     * @brief Constructs PostProcessStage writing to the specified file.
+     * @param outputPath CSV file to create, empty to only analyze
+     * @param frameAnalyzers Analyzers to run on every frame, in column order
+     * @param threads Size of the analysis pool, the flushing thread included
+     */
+    PostProcessStage(const std::filesystem::path& outputPath, std::vector<std::unique_ptr<FrameAnalyzer>> frameAnalyzers,
+                     unsigned int threads = configuredWorkers());
+
+    /**
+     * @brief Queues a frame unless the stage is behind or memory is short.
+     * @param frame Shared pointer to the published frame
+     */
+    void enqueue(std::shared_ptr<ProcessedFrame> frame) override;
+
+    /**
+     * @brief Number of frames analyzed so far.
+     */
+    UINT64 getFramesAnalyzed() const;
+
+    /**
+     * @brief Number of frames dropped so far.
+     */
+    UINT64 getFramesDropped() const;
+
+    /**
+     * @brief Frames a single thread runs through every analyzer per second, 0 before the first.
+     */
+    double getAnalyzeFps() const;
+
+    /**
+     * @brief Destructor analyzes the remaining frames.
+     *
+     * Calls flush() to process any frames left in the batch queue and reports
+     * the frame counts and analysis speed.
+     */
+    ~PostProcessStage();
+};
@@ -0,0 +1,81 @@
+#include "SkinMaskAnalyzer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+
+/// Rows and columns between classified pixels
+constexpr UINT32 SKIN_MASK_STEP = 2;
+
+/**
+ * @brief Whether a pixel's full-range BT.601 chroma falls in the skin range.
+ */
+inline bool isSkin(int b, int g, int r) {
+    int cb = 128 + ((-43 * r - 85 * g + 128 * b) >> 8);
+    int cr = 128 + ((128 * r - 107 * g - 21 * b) >> 8);
+    return cr >= 133 && cr <= 173 && cb >= 77 && cb <= 127;
+}
+
+}  // namespace
+
+const char* SkinMaskAnalyzer::getName() const {
+    return "skin";
+}
+
+std::vector<std::string> SkinMaskAnalyzer::getColumns() const {
+    return {"fraction", "center_x", "center_y", "spread_x", "spread_y"};
+}
+
+bool SkinMaskAnalyzer::analyze(const ProcessedFrame& frame, unsigned int thread, double* values) {
+    const FrameHeader& header = frame.header;
+    UINT32 width = header.width;
+    UINT32 height = header.height;
+    if (!frame.data || header.pixelFormat != PIXEL_FORMAT_BGR24 || width == 0 || height == 0 ||
+        header.dataSize != static_cast<size_t>(width) * height * 3) {
+        return false;
+    }
+
+    // Sums of the skin pixels' coordinates give the centre and spread without storing the mask
+    UINT64 samples = 0;
+    UINT64 skin = 0;
+    double sumX = 0;
+    double sumY = 0;
+    double sumXX = 0;
+    double sumYY = 0;
+    for (UINT32 y = 0; y < height; y += SKIN_MASK_STEP) {
+        const BYTE* row = frame.data.get() + static_cast<size_t>(y) * width * 3;
+        UINT64 rowSkin = 0;
+        UINT64 rowSumX = 0;
+        UINT64 rowSumXX = 0;
+        for (UINT32 x = 0; x < width; x += SKIN_MASK_STEP) {
+            const BYTE* p = row + static_cast<size_t>(x) * 3;
+            if (!isSkin(p[0], p[1], p[2])) continue;
+            rowSkin++;
+            rowSumX += x;
+            rowSumXX += static_cast<UINT64>(x) * x;
+        }
+
+        samples += (width + SKIN_MASK_STEP - 1) / SKIN_MASK_STEP;
+        skin += rowSkin;
+        sumX += static_cast<double>(rowSumX);
+        sumXX += static_cast<double>(rowSumXX);
+        sumY += static_cast<double>(rowSkin) * y;
+        sumYY += static_cast<double>(rowSkin) * y * y;
+    }
+
+    values[0] = static_cast<double>(skin) / samples;
+    if (skin == 0) {
+        std::fill(values + 1, values + 5, std::numeric_limits<double>::quiet_NaN());
+        return true;
+    }
+
+    double meanX = sumX / skin;
+    double meanY = sumY / skin;
+    values[1] = meanX / width;
+    values[2] = meanY / height;
+    values[3] = std::sqrt(std::max(0.0, sumXX / skin - meanX * meanX)) / width;
+    values[4] = std::sqrt(std::max(0.0, sumYY / skin - meanY * meanY)) / height;
+    return true;
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+//clang-format off
+#include <windows.h>
+//clang-format on
+
+#include "FrameAnalyzer.h"
+
+/**
+ * @brief Coarse hand presence and position from a skin-colour mask.
+ *
+ * Classifies pixels of a BGR24 frame as skin by their chroma, Cr in 133..173
+ * and Cb in 77..127 (Chai and Ngan), on every SKIN_MASK_STEP-th row and
+ * column. Reports the fraction of skin pixels and, when there are any, the
+ * centre and spread of the mask as fractions of the frame's width and height.
+ *
+ * A cheap stand-in for a landmark model: it tells whether hands are in view and
+ * roughly where, which is enough to check the framework and to flag sessions
+ * where the camera lost the hands.
+ */
+class SkinMaskAnalyzer : public FrameAnalyzer {
+public:
+    const char* getName() const override;
+
+    std::vector<std::string> getColumns() const override;
+
+    bool analyze(const ProcessedFrame& frame, unsigned int thread, double* values) override;
+};
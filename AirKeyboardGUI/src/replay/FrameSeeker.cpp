@@ -0,0 +1,154 @@
+#include "FrameSeeker.h"
+
+#include <algorithm>
+
+#include "../formats/FrameFormat.h"
+
+namespace {
+
+/**
+ * @brief Size of a record's pixels once decoded.
+ */
+size_t decodedSize(const FrameHeader& header) {
+    if (header.flags & FRAME_FLAG_COMPRESSED) {
+        return static_cast<size_t>(header.width) * header.height * 3;
+    }
+    return header.dataSize;
+}
+
+}  // namespace
+
+bool FrameSeeker::decodeEntry(size_t index) {
+    const FrameIndexEntry& entry = entries[index];
+
+    stored.resize(entry.header.dataSize);
+    container.clear();
+    container.seekg(static_cast<std::streamoff>(entry.offset));
+    container.read(reinterpret_cast<char*>(stored.data()), entry.header.dataSize);
+    if (!container) return false;
+
+    if (entry.header.flags & FRAME_FLAG_COMPRESSED) {
+        next.resize(decodedSize(entry.header));
+
+        const BYTE* reference = nullptr;
+        if (entry.header.flags & FRAME_FLAG_DELTA) {
+            if (decodedIndex == SIZE_MAX || decoded.size() != next.size()) return false;
+            reference = decoded.data();
+        }
+
+        if (!decoder.decode(stored.data(), stored.size(), next.data(), next.size(), reference)) return false;
+        decoded.swap(next);
+    } else {
+        decoded.swap(stored);
+    }
+
+    decodedIndex = index;
+    recordsDecoded++;
+    return true;
+}
+
+bool FrameSeeker::open(const std::filesystem::path& containerPath) {
+    entries.clear();
+    decodedIndex = SIZE_MAX;
+    container.close();
+    container.clear();
+
+    std::error_code ec;
+    UINT64 containerSize = std::filesystem::file_size(containerPath, ec);
+    if (ec) return false;
+
+    container.open(containerPath, std::ios::binary);
+    if (!container.is_open()) return false;
+
+    UINT64 offset = 0;
+    size_t lastSource = SIZE_MAX;
+    BYTE headerBytes[sizeof(FrameHeader)];
+
+    while (offset < containerSize) {
+        size_t available = static_cast<size_t>(std::min<UINT64>(sizeof(headerBytes), containerSize - offset));
+        container.seekg(static_cast<std::streamoff>(offset));
+        container.read(reinterpret_cast<char*>(headerBytes), available);
+
+        FrameHeader header;
+        size_t headerSize = 0;
+        if (!container || !parseFrameHeader(headerBytes, available, header, headerSize)) break;
+
+        // A truncated last record is still being written or was cut off, like SessionReplay stops there
+        if (offset + headerSize + header.dataSize > containerSize) break;
+
+        size_t index = entries.size();
+        FrameIndexEntry entry = {offset + headerSize, header, index, index};
+        offset += headerSize + header.dataSize;
+
+        // Gap markers have no frame to return
+        if (header.flags & FRAME_FLAG_SHED) continue;
+
+        if (header.flags & FRAME_FLAG_DUPLICATE) {
+            if (lastSource == SIZE_MAX) continue;
+            entry.source = lastSource;
+            entry.keyframe = entries[lastSource].keyframe;
+            entries.push_back(entry);
+            continue;
+        }
+
+        if (header.flags & FRAME_FLAG_DELTA) {
+            // Without a usable reference, neither this record nor the deltas after it can be rebuilt
+            if (lastSource == SIZE_MAX ||
+                decodedSize(entries[lastSource].header) != static_cast<size_t>(header.width) * header.height * 3) {
+                lastSource = SIZE_MAX;
+                continue;
+            }
+            entry.keyframe = entries[lastSource].keyframe;
+        }
+
+        entries.push_back(entry);
+        lastSource = index;
+    }
+
+    container.clear();
+    return true;
+}
+
+size_t FrameSeeker::getFrameCount() const {
+    return entries.size();
+}
+
+const FrameIndexEntry* FrameSeeker::getEntry(size_t index) const {
+    return index < entries.size() ? &entries[index] : nullptr;
+}
+
+bool FrameSeeker::readFrame(size_t index, std::vector<BYTE>& pixels, FrameHeader* header) {
+    if (index >= entries.size()) return false;
+
+    const FrameIndexEntry& entry = entries[index];
+    size_t source = entry.source;
+
+    if (decodedIndex != source) {
+        // Continue from the frame decoded last when it lies between the keyframe and the target
+        size_t first = entries[source].keyframe;
+        if (decodedIndex != SIZE_MAX && decodedIndex >= first && decodedIndex < source) {
+            first = decodedIndex + 1;
+        }
+
+        for (size_t i = first; i <= source; i++) {
+            if (entries[i].source != i) continue;
+            if (!decodeEntry(i)) {
+                decodedIndex = SIZE_MAX;
+                return false;
+            }
+        }
+    }
+
+    pixels.assign(decoded.begin(), decoded.end());
+
+    if (header) {
+        *header = entry.header;
+        header->dataSize = static_cast<UINT32>(decoded.size());
+        header->flags &= ~(FRAME_FLAG_COMPRESSED | FRAME_FLAG_DELTA);
+    }
+    return true;
+}
+
+UINT64 FrameSeeker::getRecordsDecoded() const {
+    return recordsDecoded;
+}
@@ -0,0 +1,98 @@
+#pragma once
+
+//clang-format off
+#include <windows.h>
+//clang-format on
+
+#include <filesystem>
+#include <fstream>
+#include <vector>
+
+#include "../codec/LosslessCodec.h"
+#include "../types.h"
+
+/**
+ * @brief Frame of a container as indexed by FrameSeeker.
+ */
+struct FrameIndexEntry {
+    UINT64 offset;       ///< Offset of the record's data in the container
+    FrameHeader header;  ///< Header as stored
+    size_t source;       ///< Index of the entry holding the pixels: itself, or the entry a duplicate repeats
+    size_t keyframe;     ///< Index of the entry decoding has to start from to reach source
+};
+
+/**
+ * @brief Random access to the frames of a session container.
+ *
+ * open() walks the record headers once and indexes every frame that can be
+ * rebuilt; gap markers and records whose reference is missing are left out.
+ * readFrame() decodes forward from the keyframe before the requested frame, or
+ * from the frame decoded last when that is on the way, so reading in order
+ * decodes each record once and a random read decodes at most one group of
+ * FRAME_LOG_GOP_LENGTH records.
+ *
+ * Not thread-safe; use one seeker per thread.
+ */
+class FrameSeeker {
+private:
+    /// Open frame container
+    std::ifstream container;
+
+    /// Indexed frames in container order
+    std::vector<FrameIndexEntry> entries;
+
+    /// Decoder of compressed records
+    LosslessDecoder decoder;
+
+    /// Stored data of the record being decoded
+    std::vector<BYTE> stored;
+
+    /// Pixels of the entry decoded last, the reference of the delta after it
+    std::vector<BYTE> decoded;
+
+    /// Pixels being decoded
+    std::vector<BYTE> next;
+
+    /// Entry whose pixels are in decoded, SIZE_MAX if none
+    size_t decodedIndex = SIZE_MAX;
+
+    /// Records decoded so far
+    UINT64 recordsDecoded = 0;
+
+    /**
+     * @brief Rebuilds the pixels of a source entry into decoded.
+     *
+     * Deltas must directly follow the entry in decoded.
+     */
+    bool decodeEntry(size_t index);
+
+public:
+    /**
+     * @brief Opens and indexes a frame container.
+     * @return false if it can't be read or holds no current-format records
+     */
+    bool open(const std::filesystem::path& containerPath);
+
+    /**
+     * @brief Number of frames that can be read.
+     */
+    size_t getFrameCount() const;
+
+    /**
+     * @brief Index entry of a frame, nullptr if index is out of range.
+     */
+    const FrameIndexEntry* getEntry(size_t index) const;
+
+    /**
+     * @brief Reads the pixels of a frame.
+     * @param pixels Receives the frame in the pixelFormat of its header
+     * @param header Receives the frame's header describing pixels, or nullptr
+     * @return false if index is out of range or a record on the way is damaged
+     */
+    bool readFrame(size_t index, std::vector<BYTE>& pixels, FrameHeader* header = nullptr);
+
+    /**
+     * @brief Records decoded so far, to tell how much a seek pattern costs.
+     */
+    UINT64 getRecordsDecoded() const;
+};
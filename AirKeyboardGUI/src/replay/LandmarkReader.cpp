@@ -0,0 +1,197 @@
+#include "LandmarkReader.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+namespace {
+
+/**
+ * @brief Offset of the next block magic after offset, or size if there is none.
+ *
+ * Blocks start at multiples of 8 bytes.
+ */
+UINT64 findNextBlock(const BYTE* data, UINT64 size, UINT64 offset) {
+    for (UINT64 i = (offset + 8) & ~static_cast<UINT64>(7); i + sizeof(LandmarkBlockHeader) <= size; i += 8) {
+        UINT32 magic;
+        memcpy(&magic, data + i, sizeof(magic));
+        if (magic == LANDMARK_BLOCK_MAGIC) return i;
+    }
+    return size;
+}
+
+}  // namespace
+
+size_t LandmarkReader::blockOf(size_t index) const {
+    auto it = std::upper_bound(blocks.begin(), blocks.end(), index,
+                               [](size_t value, const Block& block) { return value < block.firstHand; });
+    return static_cast<size_t>(it - blocks.begin()) - 1;
+}
+
+template <typename T>
+size_t LandmarkReader::bound(const T* Block::*column, T key, bool upper) const {
+    auto before = [&](T value) { return upper ? value <= key : value < key; };
+
+    if (!ordered) {
+        for (size_t i = 0; i < handCount; i++) {
+            const Block& block = blocks[blockOf(i)];
+            if (!before((block.*column)[i - block.firstHand])) return i;
+        }
+        return handCount;
+    }
+
+    // The first block whose last hand isn't before the key holds the bound
+    auto it = std::partition_point(blocks.begin(), blocks.end(),
+                                   [&](const Block& block) { return before((block.*column)[block.handCount - 1]); });
+    if (it == blocks.end()) return handCount;
+
+    const T* values = (*it).*column;
+    const T* found = std::partition_point(values, values + it->handCount, before);
+    return it->firstHand + static_cast<size_t>(found - values);
+}
+
+UINT64 LandmarkReader::readBlock(UINT64 offset, bool verify) {
+    const BYTE* view = file.data();
+    UINT64 fileSize = file.size();
+    if (fileSize - offset < sizeof(LandmarkBlockHeader)) return 0;
+
+    LandmarkBlockHeader block;
+    memcpy(&block, view + offset, sizeof(block));
+    if (block.magic != LANDMARK_BLOCK_MAGIC || block.frameCount == 0 || block.lastSequence < block.firstSequence) {
+        return 0;
+    }
+
+    UINT64 columnBytes = landmarkColumnBytes(block.handCount, pointCount);
+    UINT64 columnsOffset = offset + sizeof(block);
+    if (columnBytes > fileSize - columnsOffset) return 0;
+
+    const BYTE* columns = view + columnsOffset;
+    if (verify && (block.flags & LANDMARK_BLOCK_CHECKSUM) &&
+        landmarkBlockChecksum(block, columns, static_cast<size_t>(columnBytes)) != block.checksum) {
+        return 0;
+    }
+
+    frameCount += block.frameCount;
+    if (block.handCount == 0) return columnsOffset + columnBytes;
+
+    UINT64 pointBytes = static_cast<UINT64>(block.handCount) * pointCount * 3 * sizeof(float);
+    Block entry;
+    entry.sequences = reinterpret_cast<const UINT64*>(columns);
+    entry.captureNs = reinterpret_cast<const INT64*>(columns + block.handCount * 8ull);
+    entry.points = reinterpret_cast<const float*>(columns + block.handCount * 16ull);
+    entry.worldPoints = reinterpret_cast<const float*>(columns + block.handCount * 16ull + pointBytes);
+    entry.scores = reinterpret_cast<const float*>(columns + block.handCount * 16ull + 2 * pointBytes);
+    entry.handIndices = columns + block.handCount * 20ull + 2 * pointBytes;
+    entry.handLabels = entry.handIndices + block.handCount;
+    entry.firstHand = handCount;
+    entry.handCount = block.handCount;
+
+    // No hand may go back in sequence or time for the binary searches to hold
+    UINT64 previousSequence = 0;
+    INT64 previousTime = INT64_MIN;
+    if (!blocks.empty()) {
+        previousSequence = blocks.back().sequences[blocks.back().handCount - 1];
+        previousTime = blocks.back().captureNs[blocks.back().handCount - 1];
+    }
+    for (UINT32 i = 0; i < block.handCount && ordered; i++) {
+        ordered = entry.sequences[i] >= previousSequence && entry.captureNs[i] >= previousTime;
+        previousSequence = entry.sequences[i];
+        previousTime = entry.captureNs[i];
+    }
+
+    blocks.push_back(entry);
+    handCount += block.handCount;
+    return columnsOffset + columnBytes;
+}
+
+bool LandmarkReader::open(const std::filesystem::path& path, bool verify) {
+    close();
+
+    if (!file.open(path) || file.size() < sizeof(LandmarkFileHeader)) {
+        close();
+        return false;
+    }
+
+    LandmarkFileHeader header;
+    memcpy(&header, file.data(), sizeof(header));
+    // Another version may lay out its blocks differently
+    if (header.magic != LANDMARK_MAGIC || header.version != LANDMARK_VERSION || header.pointCount == 0) {
+        close();
+        return false;
+    }
+    pointCount = header.pointCount;
+
+    UINT64 offset = sizeof(header);
+    while (offset < file.size()) {
+        UINT64 end = readBlock(offset, verify);
+        if (end > 0) {
+            offset = end;
+            continue;
+        }
+
+        // Damaged or still being written, resume at the next block that checks out
+        UINT64 next = findNextBlock(file.data(), file.size(), offset);
+        corrupt.push_back({offset, next - offset});
+        offset = next;
+    }
+    return true;
+}
+
+void LandmarkReader::close() {
+    file.close();
+    pointCount = 0;
+
+    blocks.clear();
+    handCount = 0;
+    frameCount = 0;
+    ordered = true;
+    corrupt.clear();
+}
+
+UINT16 LandmarkReader::getPointCount() const {
+    return pointCount;
+}
+
+size_t LandmarkReader::getHandCount() const {
+    return handCount;
+}
+
+UINT64 LandmarkReader::getFrameCount() const {
+    return frameCount;
+}
+
+const std::vector<CorruptRange>& LandmarkReader::getCorruptRanges() const {
+    return corrupt;
+}
+
+LandmarkHand LandmarkReader::getHand(size_t index) const {
+    const Block& block = blocks[blockOf(index)];
+    size_t i = index - block.firstHand;
+    size_t values = static_cast<size_t>(pointCount) * 3;
+
+    LandmarkHand hand;
+    hand.sequence = block.sequences[i];
+    hand.captureNs = block.captureNs[i];
+    hand.points = block.points + i * values;
+    hand.worldPoints = block.worldPoints + i * values;
+    hand.score = block.scores[i];
+    hand.handIndex = block.handIndices[i];
+    hand.handLabel = block.handLabels[i];
+    return hand;
+}
+
+std::pair<size_t, size_t> LandmarkReader::findFrame(UINT64 sequence) const {
+    if (!ordered) {
+        // The worker writes the hands of a frame together, so they are adjacent even out of order
+        size_t first = 0;
+        while (first < handCount && getHand(first).sequence != sequence) first++;
+        size_t last = first;
+        while (last < handCount && getHand(last).sequence == sequence) last++;
+        return {first, last};
+    }
+    return {bound(&Block::sequences, sequence, false), bound(&Block::sequences, sequence, true)};
+}
+
+size_t LandmarkReader::findTime(INT64 captureNs) const {
+    return bound(&Block::captureNs, captureNs, false);
+}
@@ -0,0 +1,132 @@
+#pragma once
+
+//clang-format off
+#include <windows.h>
+//clang-format on
+
+#include <filesystem>
+#include <utility>
+#include <vector>
+
+#include "../formats/KeyEventLogFormat.h"
+#include "../formats/LandmarkFormat.h"
+#include "MappedFile.h"
+
+/**
+ * @brief One detected hand, pointing into the mapped file.
+ */
+struct LandmarkHand {
+    UINT64 sequence;           ///< FrameHeader::sequence of the hand's frame
+    INT64 captureNs;           ///< FrameHeader::captureNs of the hand's frame
+    const float* points;       ///< pointCount x, y, z in image coordinates
+    const float* worldPoints;  ///< pointCount x, y, z in metres
+    float score;               ///< Handedness confidence
+    UINT8 handIndex;           ///< Position of the hand in the detector's result
+    UINT8 handLabel;           ///< LANDMARK_HAND_*
+};
+
+/**
+ * @brief Memory-mapped random access to a landmarks.bin.
+ *
+ * open() maps the file and walks the block headers, which for a session of
+ * several hours takes milliseconds since the columns aren't touched; with
+ * verify the blocks' checksums are checked too. Hands are then addressed by
+ * index in sequence order, and looked up by frame sequence or capture time by
+ * binary search over the blocks and within their columns.
+ *
+ * A file the worker is still appending to can be opened; the block being
+ * written is reported as damaged and left out. Hands stay valid until close().
+ */
+class LandmarkReader {
+private:
+    /// Columns of a block with hands, pointing into the mapping
+    struct Block {
+        const UINT64* sequences;
+        const INT64* captureNs;
+        const float* points;
+        const float* worldPoints;
+        const float* scores;
+        const UINT8* handIndices;
+        const UINT8* handLabels;
+        size_t firstHand;  ///< Index of the block's first hand in the file
+        UINT32 handCount;
+    };
+
+    MappedFile file;        /// The mapped landmarks.bin
+    UINT16 pointCount = 0;  /// Landmarks per hand
+
+    std::vector<Block> blocks;          /// Blocks with hands in file order
+    size_t handCount = 0;               /// Hands in all blocks
+    UINT64 frameCount = 0;              /// Frames covered by all blocks, with or without hands
+    bool ordered = true;                /// Whether hands are sorted by sequence and capture time
+    std::vector<CorruptRange> corrupt;  /// Damaged, truncated or unreadable ranges
+
+    /**
+     * @brief Index of the block holding a hand.
+     */
+    size_t blockOf(size_t index) const;
+
+    /**
+     * @brief Index of the first hand whose column value is at least key, or above it with upper.
+     *
+     * Binary search when the hands are ordered, a scan otherwise.
+     */
+    template <typename T>
+    size_t bound(const T* Block::*column, T key, bool upper) const;
+
+    /**
+     * @brief Adds the block at offset if it is intact.
+     * @return Offset after the block, 0 if it isn't a readable block
+     */
+    UINT64 readBlock(UINT64 offset, bool verify);
+
+public:
+    /**
+     * @brief Maps a landmarks.bin and indexes its blocks.
+     * @param verify Also check the blocks' checksums, which reads every column
+     * @return false if the file can't be mapped or isn't a landmark file of LANDMARK_VERSION
+     */
+    bool open(const std::filesystem::path& path, bool verify = false);
+
+    /**
+     * @brief Unmaps the file, invalidating every hand returned.
+     */
+    void close();
+
+    /**
+     * @brief Landmarks per hand.
+     */
+    UINT16 getPointCount() const;
+
+    /**
+     * @brief Number of hands in the file.
+     */
+    size_t getHandCount() const;
+
+    /**
+     * @brief Number of frames analyzed, with or without hands.
+     */
+    UINT64 getFrameCount() const;
+
+    /**
+     * @brief Ranges left out as damaged or incomplete.
+     */
+    const std::vector<CorruptRange>& getCorruptRanges() const;
+
+    /**
+     * @brief Returns a hand by index, below getHandCount().
+     */
+    LandmarkHand getHand(size_t index) const;
+
+    /**
+     * @brief Finds the hands of a frame.
+     * @return Index range [first, last) of its hands, empty if it has none
+     */
+    std::pair<size_t, size_t> findFrame(UINT64 sequence) const;
+
+    /**
+     * @brief Index of the first hand captured at or after captureNs, getHandCount() if none.
+     */
+    size_t findTime(INT64 captureNs) const;
+
+};
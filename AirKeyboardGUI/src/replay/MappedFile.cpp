@@ -0,0 +1,55 @@
+#include "MappedFile.h"
+
+bool MappedFile::open(const std::filesystem::path& path, bool sequential) {
+    close();
+
+    file = CreateFileW(path.wstring().c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr, OPEN_EXISTING,
+                       sequential ? FILE_FLAG_SEQUENTIAL_SCAN : FILE_FLAG_RANDOM_ACCESS, nullptr);
+    if (file == INVALID_HANDLE_VALUE) return false;
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size)) {
+        close();
+        return false;
+    }
+    fileSize = static_cast<UINT64>(size.QuadPart);
+    if (fileSize == 0) return true;
+
+    mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping) view = static_cast<const BYTE*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+    if (!view) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+void MappedFile::close() {
+    if (view) UnmapViewOfFile(view);
+    if (mapping) CloseHandle(mapping);
+    if (file != INVALID_HANDLE_VALUE) CloseHandle(file);
+    file = INVALID_HANDLE_VALUE;
+    mapping = nullptr;
+    view = nullptr;
+    fileSize = 0;
+}
+
+bool MappedFile::isOpen() const {
+    return file != INVALID_HANDLE_VALUE && (view || fileSize == 0);
+}
+
+const BYTE* MappedFile::data() const {
+    return view;
+}
+
+UINT64 MappedFile::size() const {
+    return fileSize;
+}
+
+MappedFile::MappedFile(const std::filesystem::path& path) {
+    open(path, true);
+}
+
+MappedFile::~MappedFile() {
+    close();
+}
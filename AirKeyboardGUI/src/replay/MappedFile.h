@@ -0,0 +1,62 @@
+#pragma once
+
+//clang-format off
+#include <windows.h>
+//clang-format on
+
+#include <filesystem>
+
+/**
+ * @brief Read-only view of a whole file.
+ *
+ * The file is opened shared for writing too, so files a session is still
+ * appending to can be mapped; the view covers the size at open() time.
+ * Mapping an empty file succeeds with a null view.
+ */
+class MappedFile {
+private:
+    HANDLE file = INVALID_HANDLE_VALUE;  /// Open file
+    HANDLE mapping = nullptr;            /// Read-only section of file
+    const BYTE* view = nullptr;          /// The whole file mapped
+    UINT64 fileSize = 0;                 /// Bytes mapped
+
+public:
+    MappedFile() = default;
+
+    /**
+     * @brief Maps a file, check isOpen().
+     */
+    explicit MappedFile(const std::filesystem::path& path);
+
+    /**
+     * @brief Maps a file, unmapping the one mapped before.
+     * @param sequential Hint that the file is read front to back once
+     * @return false if the file can't be opened or mapped
+     */
+    bool open(const std::filesystem::path& path, bool sequential = false);
+
+    /**
+     * @brief Unmaps the file, invalidating data().
+     */
+    void close();
+
+    /**
+     * @brief Whether a file is mapped.
+     */
+    bool isOpen() const;
+
+    /**
+     * @brief Start of the mapped file, nullptr if it is empty.
+     */
+    const BYTE* data() const;
+
+    /**
+     * @brief Bytes mapped.
+     */
+    UINT64 size() const;
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    ~MappedFile();
+};
@@ -0,0 +1,274 @@
+#include "SessionReader.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <string>
+
+#include "../formats/Checksum.h"
+#include "../formats/FrameFormat.h"
+
+bool SessionReader::readHeader(UINT64 offset, FrameHeader& header, size_t& headerSize) const {
+    if (offset >= container.size()) return false;
+    size_t available = static_cast<size_t>(std::min<UINT64>(sizeof(FrameHeader), container.size() - offset));
+    return parseFrameHeader(container.data() + offset, available, header, headerSize);
+}
+
+bool SessionReader::loadIndex(const std::filesystem::path& indexPath) {
+    std::ifstream in(indexPath, std::ios::binary);
+    if (!in.is_open()) return false;
+
+    FrameIndexHeader header;
+    in.read(reinterpret_cast<char*>(&header), sizeof(header));
+    if (!in || header.magic != FRAME_INDEX_MAGIC || header.version != FRAME_INDEX_VERSION ||
+        header.recordSize < sizeof(FrameIndexRecord)) {
+        return false;
+    }
+
+    // An index of a longer container belongs to another recording of the session
+    std::error_code ec;
+    UINT64 indexSize = std::filesystem::file_size(indexPath, ec);
+    if (ec || header.containerSize > container.size() ||
+        indexSize != sizeof(header) + header.recordCount * header.recordSize) {
+        return false;
+    }
+
+    std::vector<FrameIndexRecord> records(static_cast<size_t>(header.recordCount));
+    if (header.recordSize == sizeof(FrameIndexRecord)) {
+        in.read(reinterpret_cast<char*>(records.data()), records.size() * sizeof(FrameIndexRecord));
+    } else {
+        std::vector<char> record(header.recordSize);
+        for (auto& entry : records) {
+            in.read(record.data(), record.size());
+            memcpy(&entry, record.data(), sizeof(FrameIndexRecord));
+        }
+    }
+    if (!in) return false;
+
+    if (crc32c(0, records.data(), records.size() * sizeof(FrameIndexRecord)) != header.checksum) {
+        OutputDebugStringA(("SessionReader: " + indexPath.string() + " fails its checksum, reindexing\n").c_str());
+        return false;
+    }
+
+    // The last record must still be where the index says, ending where the index ends
+    if (!records.empty()) {
+        const FrameIndexRecord& last = records.back();
+        FrameHeader frame;
+        size_t headerSize = 0;
+        if (!readHeader(last.offset, frame, headerSize) || frame.sequence != last.sequence ||
+            frame.captureNs != last.captureNs || last.offset + headerSize + frame.dataSize != header.containerSize) {
+            return false;
+        }
+    } else if (header.containerSize != 0) {
+        return false;
+    }
+
+    frames = std::move(records);
+    indexedSize = header.containerSize;
+    loadedFrames = frames.size();
+    timeOrdered = (header.flags & FRAME_INDEX_TIME_ORDERED) != 0;
+    return true;
+}
+
+void SessionReader::indexRecords() {
+    // Duplicates appended after the indexed part repeat the last record with pixels before it
+    UINT64 lastSource = FRAME_INDEX_NO_SOURCE;
+    for (auto it = frames.rbegin(); it != frames.rend(); ++it) {
+        if (it->sourceOffset != FRAME_INDEX_NO_SOURCE) {
+            lastSource = it->sourceOffset;
+            break;
+        }
+    }
+
+    UINT64 offset = indexedSize;
+    while (offset < container.size()) {
+        FrameHeader header;
+        size_t headerSize = 0;
+        if (!readHeader(offset, header, headerSize)) break;
+
+        // A truncated last record is still being written or was cut off, it's indexed once complete
+        if (offset + headerSize + header.dataSize > container.size()) break;
+
+        FrameIndexRecord record = {header.captureNs, header.sequence, offset, offset};
+        if (header.flags & FRAME_FLAG_SHED) {
+            record.sourceOffset = FRAME_INDEX_NO_SOURCE;
+        } else if (header.flags & FRAME_FLAG_DUPLICATE) {
+            record.sourceOffset = lastSource;
+        } else {
+            lastSource = offset;
+        }
+
+        if (!frames.empty() && header.captureNs < frames.back().captureNs) timeOrdered = false;
+        frames.push_back(record);
+        offset += headerSize + header.dataSize;
+    }
+    indexedSize = offset;
+}
+
+bool SessionReader::saveIndex(const std::filesystem::path& indexPath) const {
+    FrameIndexHeader header = {};
+    header.magic = FRAME_INDEX_MAGIC;
+    header.version = FRAME_INDEX_VERSION;
+    header.recordSize = sizeof(FrameIndexRecord);
+    header.containerSize = indexedSize;
+    header.recordCount = frames.size();
+    header.checksum = crc32c(0, frames.data(), frames.size() * sizeof(FrameIndexRecord));
+    header.flags = timeOrdered ? FRAME_INDEX_TIME_ORDERED : 0;
+
+    // Written aside and renamed, so a reader never loads half an index
+    std::filesystem::path tempPath = indexPath;
+    tempPath += ".tmp";
+    {
+        std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+        if (!out.is_open()) return false;
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.write(reinterpret_cast<const char*>(frames.data()), frames.size() * sizeof(FrameIndexRecord));
+        if (!out) return false;
+    }
+
+    std::error_code ec;
+    std::filesystem::rename(tempPath, indexPath, ec);
+    if (ec) {
+        std::filesystem::remove(tempPath, ec);
+        return false;
+    }
+    return true;
+}
+
+void SessionReader::readKeyEvents(const std::filesystem::path& keyLogPath) {
+    if (!keyLog.open(keyLogPath, true) || keyLog.size() == 0) return;
+
+    KeyEventLogHeader header;
+    if (!parseKeyEventLog(keyLog.data(), static_cast<size_t>(keyLog.size()), header, keyEvents, &keyCorrupt)) {
+        OutputDebugStringA(("SessionReader: " + keyLogPath.string() + " is not a key-event log\n").c_str());
+        keyEvents.clear();
+        return;
+    }
+    qpcFrequency = header.qpcFrequency;
+
+    // Records are in publishing order, event times can step back across the hook and the timebase fit
+    std::stable_sort(keyEvents.begin(), keyEvents.end(),
+                     [](const KeyEventRecord& a, const KeyEventRecord& b) { return a.timestampNs < b.timestampNs; });
+}
+
+bool SessionReader::open(const std::filesystem::path& sessionDir, bool saveIndex) {
+    close();
+
+    std::filesystem::path containerPath = sessionDir / "frames.bin";
+    std::filesystem::path indexPath = sessionDir / "frames.idx";
+    bool hasContainer = std::filesystem::exists(containerPath);
+    if (hasContainer && !container.open(containerPath)) {
+        OutputDebugStringA(("SessionReader: failed to map " + containerPath.string() + "\n").c_str());
+        return false;
+    }
+
+    if (hasContainer) {
+        if (!loadIndex(indexPath)) {
+            frames.clear();
+            indexedSize = 0;
+            loadedFrames = 0;
+            timeOrdered = true;
+        }
+
+        UINT64 loadedSize = indexedSize;
+        indexRecords();
+        if (saveIndex && (indexedSize != loadedSize || loadedFrames == 0)) {
+            if (!this->saveIndex(indexPath)) {
+                OutputDebugStringA(("SessionReader: failed to write " + indexPath.string() + "\n").c_str());
+            }
+        }
+    }
+
+    readKeyEvents(sessionDir / "key_events.bin");
+    return hasContainer || keyLog.isOpen();
+}
+
+void SessionReader::close() {
+    container.close();
+    keyLog.close();
+    frames.clear();
+    keyEvents.clear();
+    keyCorrupt.clear();
+    indexedSize = 0;
+    loadedFrames = 0;
+    timeOrdered = true;
+    qpcFrequency = 0;
+}
+
+size_t SessionReader::getFrameCount() const {
+    return frames.size();
+}
+
+size_t SessionReader::getFramesFromIndex() const {
+    return loadedFrames;
+}
+
+const FrameIndexRecord& SessionReader::getIndexRecord(size_t index) const {
+    return frames[index];
+}
+
+FrameView SessionReader::getFrame(size_t index) const {
+    const FrameIndexRecord& record = frames[index];
+    FrameView view = {};
+    size_t headerSize = 0;
+    readHeader(record.offset, view.header, headerSize);
+    if (record.sourceOffset == FRAME_INDEX_NO_SOURCE) return view;
+
+    FrameHeader source = view.header;
+    if (record.sourceOffset != record.offset && !readHeader(record.sourceOffset, source, headerSize)) return view;
+
+    view.data = container.data() + record.sourceOffset + headerSize;
+    view.dataSize = source.dataSize;
+    view.dataFlags = source.flags & (FRAME_FLAG_COMPRESSED | FRAME_FLAG_DELTA);
+    return view;
+}
+
+std::pair<size_t, size_t> SessionReader::findFrames(INT64 fromNs, INT64 toNs) const {
+    if (toNs <= fromNs) return {0, 0};
+
+    if (!timeOrdered) {
+        // Out-of-order capture times leave no sorted range to search, the matching frames are spread out
+        size_t first = frames.size();
+        size_t last = 0;
+        for (size_t i = 0; i < frames.size(); i++) {
+            if (frames[i].captureNs < fromNs || frames[i].captureNs >= toNs) continue;
+            first = std::min(first, i);
+            last = i + 1;
+        }
+        return first < last ? std::pair<size_t, size_t>{first, last} : std::pair<size_t, size_t>{0, 0};
+    }
+
+    auto byTime = [](const FrameIndexRecord& record, INT64 ns) { return record.captureNs < ns; };
+    size_t first = std::lower_bound(frames.begin(), frames.end(), fromNs, byTime) - frames.begin();
+    size_t last = std::lower_bound(frames.begin() + first, frames.end(), toNs, byTime) - frames.begin();
+    return {first, last};
+}
+
+size_t SessionReader::findSequence(UINT64 sequence) const {
+    // Sequence numbers grow in container order, legacy records all carry FRAME_SEQUENCE_UNKNOWN
+    auto it = std::lower_bound(frames.begin(), frames.end(), sequence,
+                               [](const FrameIndexRecord& record, UINT64 value) { return record.sequence < value; });
+    if (it == frames.end() || it->sequence != sequence || sequence == FRAME_SEQUENCE_UNKNOWN) return frames.size();
+    return it - frames.begin();
+}
+
+size_t SessionReader::getKeyEventCount() const {
+    return keyEvents.size();
+}
+
+std::span<const KeyEventRecord> SessionReader::getKeyEvents(INT64 fromNs, INT64 toNs) const {
+    if (toNs <= fromNs) return {};
+
+    auto byTime = [](const KeyEventRecord& record, INT64 ns) { return record.timestampNs < ns; };
+    auto first = std::lower_bound(keyEvents.begin(), keyEvents.end(), fromNs, byTime);
+    auto last = std::lower_bound(first, keyEvents.end(), toNs, byTime);
+    return {first, last};
+}
+
+INT64 SessionReader::getQpcFrequency() const {
+    return qpcFrequency;
+}
+
+const std::vector<CorruptRange>& SessionReader::getKeyCorruptRanges() const {
+    return keyCorrupt;
+}
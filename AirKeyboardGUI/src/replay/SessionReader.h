@@ -0,0 +1,151 @@
+#pragma once
+
+//clang-format off
+#include <windows.h>
+//clang-format on
+
+#include <filesystem>
+#include <span>
+#include <utility>
+#include <vector>
+
+#include "../formats/FrameIndexFormat.h"
+#include "../formats/KeyEventLogFormat.h"
+#include "../types.h"
+#include "MappedFile.h"
+
+/**
+ * @brief A frame record of a session, pointing into the mapped container.
+ */
+struct FrameView {
+    FrameHeader header;  ///< Header as stored, legacy headers converted
+    const BYTE* data;    ///< Stored data of the record holding the pixels, nullptr for gap markers
+    UINT32 dataSize;     ///< Bytes at data
+    UINT32 dataFlags;    ///< FRAME_FLAG_COMPRESSED and FRAME_FLAG_DELTA of data, see FrameSeeker to decode such data
+};
+
+/**
+ * @brief Memory-mapped read access to a recorded session.
+ *
+ * Maps the session's frames.bin and key_events.bin. The frame records are
+ * indexed by capture time and sequence in frames.idx (see FrameIndexFormat.h):
+ * open() loads the index when it matches the container, indexes only what was
+ * appended since when the container grew, and walks every record header
+ * otherwise, then saves the index for the next reader. Frames are returned as
+ * views of the mapped records without copying, so a session of many GB costs
+ * address space, not memory; the pages read are the ones of the frames used.
+ *
+ * Key events are decoded once, sorted by event time and returned as spans
+ * between two times.
+ *
+ * Views and spans stay valid until close(). Reading is thread-safe.
+ */
+class SessionReader {
+private:
+    MappedFile container;                   /// frames.bin, when the session has one
+    MappedFile keyLog;                      /// key_events.bin, when the session has one
+    std::vector<FrameIndexRecord> frames;   /// Every record of the container, in container order
+    UINT64 indexedSize = 0;                 /// Bytes of the container covered by frames
+    size_t loadedFrames = 0;                /// Records taken from frames.idx rather than the container
+    bool timeOrdered = true;                /// Whether capture times never decrease in container order
+    std::vector<KeyEventRecord> keyEvents;  /// Every intact key event, sorted by timestampNs
+    std::vector<CorruptRange> keyCorrupt;   /// Damaged ranges of key_events.bin
+    INT64 qpcFrequency = 0;                  /// From the key-event log header, 0 without one
+
+    /**
+     * @brief Parses the header of the record at offset.
+     */
+    bool readHeader(UINT64 offset, FrameHeader& header, size_t& headerSize) const;
+
+    /**
+     * @brief Takes the records from an index file that matches the container.
+     * @return false if there is none or it is stale or damaged; frames is left empty
+     */
+    bool loadIndex(const std::filesystem::path& indexPath);
+
+    /**
+     * @brief Indexes the container's records from indexedSize to the last complete one.
+     */
+    void indexRecords();
+
+    /**
+     * @brief Writes frames to an index file, replacing it.
+     */
+    bool saveIndex(const std::filesystem::path& indexPath) const;
+
+    /**
+     * @brief Maps and decodes key_events.bin.
+     */
+    void readKeyEvents(const std::filesystem::path& keyLogPath);
+
+public:
+    /**
+     * @brief Opens a session directory.
+     * @param sessionDir Directory holding frames.bin and key_events.bin
+     * @param saveIndex Write frames.idx when it was built or extended
+     * @return false if the session has neither file or they can't be mapped
+     */
+    bool open(const std::filesystem::path& sessionDir, bool saveIndex = true);
+
+    /**
+     * @brief Unmaps the session, invalidating every view and span returned.
+     */
+    void close();
+
+    /**
+     * @brief Number of frame records, gap markers and duplicates included.
+     */
+    size_t getFrameCount() const;
+
+    /**
+     * @brief Number of frame records taken from frames.idx instead of walking the container.
+     */
+    size_t getFramesFromIndex() const;
+
+    /**
+     * @brief Index record of a frame, index below getFrameCount().
+     */
+    const FrameIndexRecord& getIndexRecord(size_t index) const;
+
+    /**
+     * @brief Returns a view of a frame record, index below getFrameCount().
+     */
+    FrameView getFrame(size_t index) const;
+
+    /**
+     * @brief Finds the frames captured in a time range.
+     *
+     * Exact when capture times never decrease in container order. When they
+     * step back, the range spans from the first to the last matching frame and
+     * also holds frames outside the time range, so callers check captureNs of
+     * every frame in it.
+     *
+     * @return Index range [first, last) covering every frame with fromNs <= captureNs < toNs, empty if there are none
+     */
+    std::pair<size_t, size_t> findFrames(INT64 fromNs, INT64 toNs) const;
+
+    /**
+     * @brief Index of the frame with a sequence number, getFrameCount() if there is none.
+     */
+    size_t findSequence(UINT64 sequence) const;
+
+    /**
+     * @brief Number of key events.
+     */
+    size_t getKeyEventCount() const;
+
+    /**
+     * @brief Key events with fromNs <= timestampNs < toNs, in time order.
+     */
+    std::span<const KeyEventRecord> getKeyEvents(INT64 fromNs, INT64 toNs) const;
+
+    /**
+     * @brief QueryPerformanceFrequency of the recording host, 0 without a key-event log.
+     */
+    INT64 getQpcFrequency() const;
+
+    /**
+     * @brief Ranges of key_events.bin skipped as damaged.
+     */
+    const std::vector<CorruptRange>& getKeyCorruptRanges() const;
+};
@@ -0,0 +1,288 @@
+#include "SessionReplay.h"
+
+#include <algorithm>
+#include <chrono>
+#include <charconv>
+#include <cstdio>
+#include <cstring>
+#include <iterator>
+#include <string>
+#include <thread>
+
+#include "../formats/FrameFormat.h"
+#include "../formats/KeyEventLogFormat.h"
+
+void SessionReplay::report(const std::string& message) const {
+    if (options.log) {
+        options.log(message);
+        return;
+    }
+#ifdef _WIN32
+    OutputDebugStringA(message.c_str());
+#else
+    fputs(message.c_str(), stderr);
+#endif
+}
+
+bool SessionReplay::loadKeyLog(const std::filesystem::path& filePath) {
+    std::ifstream in(filePath, std::ios::binary);
+    if (!in) return false;
+
+    std::vector<BYTE> data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+
+    KeyEventLogHeader header = {};
+    std::vector<KeyEventRecord> records;
+    std::vector<CorruptRange> corrupt;
+    if (!parseKeyEventLog(data.data(), data.size(), header, records, &corrupt)) {
+        std::string message = "SessionReplay: " + filePath.string() + " is not a key-event log\n";
+        report(message);
+        return false;
+    }
+
+    if (!corrupt.empty()) {
+        std::string message = "SessionReplay: " + std::to_string(corrupt.size()) + " damaged ranges skipped in " +
+                              filePath.string() + "\n";
+        report(message);
+    }
+
+    for (const KeyEventRecord& keyRecord : records) {
+        keyEvents.push_back(KeyEvent{
+            keyRecord.vkey,
+            keyRecord.scanCode,
+            (keyRecord.flags & KEY_RECORD_PRESSED) != 0,
+            keyRecord.qpcTicks,
+            keyRecord.sequence,
+            keyRecord.timestampNs});
+    }
+
+    return true;
+}
+
+bool SessionReplay::loadLegacyKeyCsv(const std::filesystem::path& filePath) {
+    std::ifstream in(filePath);
+    if (!in) return false;
+
+    std::string line;
+    UINT64 sequence = 0;
+    while (std::getline(in, line)) {
+        // timestamp_ms,vkey,scancode,pressed; lines that don't parse (a header) are skipped
+        INT64 fields[4];
+        const char* position = line.data();
+        const char* end = line.data() + line.size();
+        bool parsed = true;
+        for (int i = 0; i < 4 && parsed; i++) {
+            auto result = std::from_chars(position, end, fields[i]);
+            parsed = result.ec == std::errc();
+            position = result.ptr < end ? result.ptr + 1 : end;
+        }
+        if (!parsed) continue;
+
+        keyEvents.push_back(KeyEvent{
+            static_cast<USHORT>(fields[1]),
+            static_cast<USHORT>(fields[2]),
+            fields[3] != 0,
+            0,  // The QPC value was not recorded
+            sequence++,
+            fields[0] * 1000000});
+    }
+
+    return true;
+}
+
+std::shared_ptr<ProcessedFrame> SessionReplay::readFrame(UINT64& bytesRead) {
+    auto frame = std::make_shared<ProcessedFrame>();
+    size_t headerSize = 0;
+
+    if (container.is_open()) {
+        BYTE headerBytes[sizeof(FrameHeader)];
+        while (true) {
+            if (containerOffset >= containerSize) return nullptr;
+
+            size_t available = static_cast<size_t>(std::min<UINT64>(sizeof(headerBytes), containerSize - containerOffset));
+            container.seekg(static_cast<std::streamoff>(containerOffset));
+            container.read(reinterpret_cast<char*>(headerBytes), available);
+            if (!container || !parseFrameHeader(headerBytes, available, frame->header, headerSize)) {
+                return nullptr;
+            }
+
+            if (containerOffset + headerSize + frame->header.dataSize > containerSize) {
+                report("SessionReplay: frame container ends in a truncated record\n");
+                return nullptr;
+            }
+
+            // Gap markers stand in for frames shed while recording, there is nothing to replay
+            bool shed = frame->header.flags & FRAME_FLAG_SHED;
+            bool orphanDuplicate = (frame->header.flags & FRAME_FLAG_DUPLICATE) && !lastStoredFrame;
+            // A delta needs the frame before it, and the decoder trusts that it has the same size
+            bool orphanDelta = (frame->header.flags & FRAME_FLAG_DELTA) &&
+                               (!lastStoredFrame ||
+                                lastStoredFrame->header.dataSize != frame->header.width * frame->header.height * 3);
+            if (!shed && !orphanDuplicate && !orphanDelta) break;
+            containerOffset += headerSize + frame->header.dataSize;
+            bytesRead += headerSize + frame->header.dataSize;
+        }
+
+        // Duplicate records repeat the pixels of the last record that has them
+        if (frame->header.flags & FRAME_FLAG_DUPLICATE) {
+            frame->header.dataSize = lastStoredFrame->header.dataSize;
+            frame->data = std::make_unique<BYTE[]>(frame->header.dataSize);
+            memcpy(frame->data.get(), lastStoredFrame->data.get(), frame->header.dataSize);
+
+            containerOffset += headerSize;
+            bytesRead += headerSize;
+            return frame;
+        }
+
+        UINT32 storedSize = frame->header.dataSize;
+        container.seekg(static_cast<std::streamoff>(containerOffset + headerSize));
+
+        if (frame->header.flags & FRAME_FLAG_COMPRESSED) {
+            encodedFrame.resize(storedSize);
+            container.read(reinterpret_cast<char*>(encodedFrame.data()), storedSize);
+            if (!container) return nullptr;
+
+            // Replay frames as they were captured, subscribers don't know the codec
+            const BYTE* reference = (frame->header.flags & FRAME_FLAG_DELTA) ? lastStoredFrame->data.get() : nullptr;
+            frame->header.dataSize = frame->header.width * frame->header.height * 3;
+            frame->header.flags &= ~(FRAME_FLAG_COMPRESSED | FRAME_FLAG_DELTA);
+            frame->data = std::make_unique<BYTE[]>(frame->header.dataSize);
+            if (!decoder.decode(encodedFrame.data(), storedSize, frame->data.get(), frame->header.dataSize, reference)) {
+                report("SessionReplay: failed to decode a compressed frame\n");
+                return nullptr;
+            }
+        } else {
+            frame->data = std::make_unique<BYTE[]>(storedSize);
+            container.read(reinterpret_cast<char*>(frame->data.get()), storedSize);
+            if (!container) return nullptr;
+        }
+
+        containerOffset += headerSize + storedSize;
+        bytesRead += headerSize + storedSize;
+        lastStoredFrame = frame;
+        return frame;
+    }
+
+    while (legacyFrameIndex < legacyFrameFiles.size()) {
+        const std::filesystem::path& filePath = legacyFrameFiles[legacyFrameIndex++];
+
+        std::ifstream in(filePath, std::ios::binary);
+        BYTE headerBytes[FRAME_HEADER_V1_SIZE];
+        in.read(reinterpret_cast<char*>(headerBytes), sizeof(headerBytes));
+        if (!in || !parseFrameHeader(headerBytes, sizeof(headerBytes), frame->header, headerSize)) {
+            continue;  // Skip unreadable files like the live logger skipped failed writes
+        }
+
+        frame->data = std::make_unique<BYTE[]>(frame->header.dataSize);
+        in.read(reinterpret_cast<char*>(frame->data.get()), frame->header.dataSize);
+        if (!in) continue;
+
+        bytesRead += headerSize + frame->header.dataSize;
+        return frame;
+    }
+
+    return nullptr;
+}
+
+bool SessionReplay::isOpen() const {
+    return container.is_open() || !legacyFrameFiles.empty() || !keyEvents.empty();
+}
+
+Publisher<ProcessedFrame>& SessionReplay::getFramePublisher() {
+    return framePublisher;
+}
+
+Publisher<KeyEvent>& SessionReplay::getKeyPublisher() {
+    return keyPublisher;
+}
+
+size_t SessionReplay::getKeyEventCount() const {
+    return keyEvents.size();
+}
+
+ReplayStats SessionReplay::run() {
+    ReplayStats stats;
+    stopRequested = false;
+
+    std::shared_ptr<ProcessedFrame> nextFrame = options.replayFrames ? readFrame(stats.bytesRead) : nullptr;
+    size_t keyIndex = options.replayKeys ? 0 : keyEvents.size();
+
+    bool haveOrigin = false;
+    INT64 originNs = 0;
+    INT64 lastNs = 0;
+
+    auto start = std::chrono::steady_clock::now();
+
+    while (!stopRequested) {
+        bool haveKey = keyIndex < keyEvents.size();
+        if (!nextFrame && !haveKey) break;
+
+        bool frameFirst = nextFrame && (!haveKey || nextFrame->header.captureNs <= keyEvents[keyIndex].captureNs);
+        INT64 eventNs = frameFirst ? nextFrame->header.captureNs : keyEvents[keyIndex].captureNs;
+
+        if (!haveOrigin) {
+            originNs = lastNs = eventNs;
+            haveOrigin = true;
+        }
+        lastNs = std::max(lastNs, eventNs);
+
+        if (options.speed > 0) {
+            auto target = start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                                      std::chrono::duration<double, std::nano>((eventNs - originNs) / options.speed));
+            auto now = std::chrono::steady_clock::now();
+            if (now < target) {
+                std::this_thread::sleep_until(target);
+            } else {
+                stats.maxLagMs = std::max(stats.maxLagMs, std::chrono::duration<double, std::milli>(now - target).count());
+            }
+        }
+
+        if (frameFirst) {
+            framePublisher.publish(nextFrame);
+            stats.framesPublished++;
+            nextFrame = readFrame(stats.bytesRead);
+        } else {
+            keyPublisher.publish(std::make_shared<KeyEvent>(keyEvents[keyIndex++]));
+            stats.keysPublished++;
+        }
+    }
+
+    stats.elapsedSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    stats.recordedSeconds = (lastNs - originNs) / 1e9;
+    return stats;
+}
+
+void SessionReplay::stop() {
+    stopRequested = true;
+}
+
+SessionReplay::SessionReplay(const std::filesystem::path& sessionDir, const ReplayOptions& options)
+    : sessionDir(sessionDir), options(options) {
+    std::error_code ec;
+
+    std::filesystem::path containerPath = sessionDir / "frames.bin";
+    if (std::filesystem::exists(containerPath, ec)) {
+        container.open(containerPath, std::ios::binary);
+        containerSize = std::filesystem::file_size(containerPath, ec);
+    } else {
+        // Legacy sessions stored one zero-padded frame_NNNNNN.raw per frame, so name order is recording order
+        for (const auto& entry : std::filesystem::directory_iterator(sessionDir / "frames", ec)) {
+            if (entry.path().extension() == ".raw") {
+                legacyFrameFiles.push_back(entry.path());
+            }
+        }
+        std::sort(legacyFrameFiles.begin(), legacyFrameFiles.end());
+    }
+
+    if (!loadKeyLog(sessionDir / "key_events.bin")) {
+        loadLegacyKeyCsv(sessionDir / "key_events.csv");
+    }
+
+    // Latency correction can reorder neighbouring events slightly
+    std::stable_sort(keyEvents.begin(), keyEvents.end(),
+                     [](const KeyEvent& a, const KeyEvent& b) { return a.captureNs < b.captureNs; });
+
+    if (!isOpen()) {
+        std::string message = "SessionReplay: nothing to replay in " + sessionDir.string() + "\n";
+        report(message);
+    }
+}
@@ -0,0 +1,171 @@
+#pragma once
+
+//clang-format off
+#include <windows.h>
+//clang-format on
+
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "../base/Publisher.h"
+#include "../codec/LosslessCodec.h"
+#include "../types.h"
+
+/**
+ * @brief Configuration of a SessionReplay run.
+ */
+struct ReplayOptions {
+    double speed = 1.0;      ///< Playback rate relative to the recording; 0 publishes as fast as possible
+    bool replayFrames = true;  ///< Publish the session's frames
+    bool replayKeys = true;    ///< Publish the session's key events
+
+    /// Receives diagnostics such as damaged records; unset sends them to the debugger on Windows, stderr elsewhere
+    std::function<void(const std::string&)> log;
+};
+
+/**
+ * @brief Outcome of a SessionReplay run.
+ */
+struct ReplayStats {
+    UINT64 framesPublished = 0;  ///< Frames handed to frame subscribers
+    UINT64 keysPublished = 0;    ///< Key events handed to key subscribers
+    UINT64 bytesRead = 0;        ///< Frame bytes read from disk
+    double elapsedSeconds = 0;   ///< Wall time of the run
+    double recordedSeconds = 0;  ///< Time span of the replayed events in the recording
+    double maxLagMs = 0;         ///< Worst delay of an event behind its scheduled time, 0 when unpaced
+};
+
+/**
+ * @brief Republishes a recorded session through the live pipeline's message types.
+ *
+ * Reads a session directory and publishes its frames as ProcessedFrame and its
+ * key events as KeyEvent, merged in capture-time order, so the loggers, the
+ * labeler, LoggingTrigger and the views can be driven without a camera or
+ * keyboard. The recorded inter-arrival times are kept, scaled by the replay
+ * speed, or ignored to measure how fast the subscribers can go.
+ *
+ * Current sessions (frames.bin and key_events.bin) and legacy ones (per-frame
+ * .raw files in frames/ and key_events.csv) are both accepted. Recorded
+ * timestamps are published unchanged, so replaying a session into the loggers
+ * reproduces its files.
+ *
+ * The reader does its file I/O and timing with the standard library and reports
+ * diagnostics through ReplayOptions::log, but its types and the record formats
+ * it parses still come from the Win32 headers, so it builds on Windows only.
+ */
+class SessionReplay {
+private:
+    /// Directory of the recorded session
+    std::filesystem::path sessionDir;
+
+    /// Pacing and stream selection
+    ReplayOptions options;
+
+    /// Publisher for replayed frames
+    Publisher<ProcessedFrame> framePublisher;
+
+    /// Publisher for replayed key events
+    Publisher<KeyEvent> keyPublisher;
+
+    /// Every key event of the session, sorted by capture time
+    std::vector<KeyEvent> keyEvents;
+
+    /// Open frame container, when the session has one
+    std::ifstream container;
+
+    /// Read position in the frame container
+    UINT64 containerOffset = 0;
+
+    /// Size of the frame container
+    UINT64 containerSize = 0;
+
+    /// Last container frame read with pixel data, the source of duplicate records
+    std::shared_ptr<ProcessedFrame> lastStoredFrame;
+
+    /// Decoder of compressed container records
+    LosslessDecoder decoder;
+
+    /// Encoded data of the compressed record being read
+    std::vector<BYTE> encodedFrame;
+
+    /// Legacy per-frame files in recording order, when the session has no container
+    std::vector<std::filesystem::path> legacyFrameFiles;
+
+    /// Next legacy frame file to read
+    size_t legacyFrameIndex = 0;
+
+    /// Set by stop() to end run() early
+    std::atomic<bool> stopRequested = false;
+
+    /**
+     * @brief Passes a diagnostic line to ReplayOptions::log or the platform default.
+     */
+    void report(const std::string& message) const;
+
+    /**
+     * @brief Loads key_events.bin into keyEvents.
+     * @return false if the file is missing or not a key-event log
+     */
+    bool loadKeyLog(const std::filesystem::path& filePath);
+
+    /**
+     * @brief Loads a legacy key_events.csv (timestamp_ms,vkey,scancode,pressed) into keyEvents.
+     * @return false if the file is missing
+     */
+    bool loadLegacyKeyCsv(const std::filesystem::path& filePath);
+
+    /**
+     * @brief Reads the next frame of the session.
+     * @return nullptr at the end of the recording or on a truncated record
+     */
+    std::shared_ptr<ProcessedFrame> readFrame(UINT64& bytesRead);
+
+public:
+    /**
+     * @brief Opens a recorded session and loads its key events.
+     * @param sessionDir Session directory, e.g. logs/<session id>
+     * @param options Replay speed and which streams to publish
+     */
+    SessionReplay(const std::filesystem::path& sessionDir, const ReplayOptions& options = {});
+
+    /**
+     * @brief Checks whether the session has anything to replay.
+     */
+    bool isOpen() const;
+
+    /**
+     * @brief Publisher to subscribe frame consumers to before run().
+     */
+    Publisher<ProcessedFrame>& getFramePublisher();
+
+    /**
+     * @brief Publisher to subscribe key-event consumers to before run().
+     */
+    Publisher<KeyEvent>& getKeyPublisher();
+
+    /**
+     * @brief Number of key events loaded from the session.
+     */
+    size_t getKeyEventCount() const;
+
+    /**
+     * @brief Publishes the whole session on the calling thread.
+     * @return Counts, timing and pacing lag of the run
+     *
+     * Blocks until the recording is exhausted or stop() is called.
+     */
+    ReplayStats run();
+
+    /**
+     * @brief Asks a running run() to return after the current event.
+     */
+    void stop();
+
+    SessionReplay(const SessionReplay&) = delete;
+    SessionReplay& operator=(const SessionReplay&) = delete;
+};
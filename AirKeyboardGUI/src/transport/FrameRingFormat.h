@@ -0,0 +1,91 @@
+#pragma once
+
+/*
+ * Shared-memory layout of the frame ring between the application and the
+ * post-processing worker.
+ *
+ * The ring is a named pagefile-backed mapping: a FrameRingHeader, then
+ * slotCount slots of slotSize bytes starting at headerSize. Frame n goes to
+ * slot n % slotCount as the 64-byte FrameHeader of frames.bin followed by its
+ * pixels. There is one writer and one reader: the writer publishes a frame by
+ * advancing writeIndex, the reader frees its slot by advancing readIndex, and
+ * each side only ever writes its own cache line. Two auto-reset events named
+ * after the mapping wake a reader waiting for a frame and a writer waiting for
+ * a slot.
+ *
+ * Plain C, so the reader library and workers in other languages can use it.
+ */
+
+#include <stdint.h>
+
+/* "AKRG" in little-endian byte order */
+#define FRAME_RING_MAGIC 0x47524B41u
+
+/* Current layout version */
+#define FRAME_RING_VERSION 1
+
+/* Offset of the first slot; keeps the slots page aligned */
+#define FRAME_RING_HEADER_SIZE 4096
+
+/* Bytes in front of the pixels of a slot, the FrameHeader of the frame */
+#define FRAME_RING_SLOT_HEADER_SIZE 64
+
+/* Suffixes appended to the mapping name to name the events */
+#define FRAME_RING_FRAME_EVENT_SUFFIX "_frame"
+#define FRAME_RING_SLOT_EVENT_SUFFIX "_slot"
+
+/* writerState */
+#define FRAME_RING_WRITER_OPEN 1
+#define FRAME_RING_WRITER_CLOSED 2 /* No frames follow the ones published; replaces the .shutdown marker file */
+
+/* readerState */
+#define FRAME_RING_READER_NONE 0
+#define FRAME_RING_READER_ATTACHED 1
+#define FRAME_RING_READER_DETACHED 2
+
+typedef struct {
+    /* Set by the writer before the mapping name is handed out, constant afterwards */
+    uint32_t magic;      /* FRAME_RING_MAGIC */
+    uint32_t version;    /* FRAME_RING_VERSION */
+    uint32_t headerSize; /* Offset of the first slot */
+    uint32_t slotCount;  /* Number of slots */
+    uint64_t slotSize;   /* Bytes per slot, slot header included */
+    uint32_t writerPid;  /* Process id of the writer */
+    uint8_t reserved0[36];
+
+    /* Written by the writer only */
+    int64_t writeIndex;    /* Frames published so far */
+    int64_t framesDropped; /* Frames the writer dropped because the ring was full or the frame didn't fit */
+    int32_t writerState;   /* FRAME_RING_WRITER_* */
+    uint8_t reserved1[44];
+
+    /* Written by the reader only */
+    int64_t readIndex;   /* Frames released so far; writeIndex - readIndex frames are waiting */
+    int32_t readerState; /* FRAME_RING_READER_* */
+    uint32_t readerPid;  /* Process id of the attached reader */
+    uint8_t reserved2[48];
+} FrameRingHeader;
+
+/* Start of a slot: the frame's FrameHeader from types.h, declared again for C */
+#pragma pack(push, 1)
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t headerSize;
+    uint32_t pixelFormat; /* PixelFormat of the pixels after the header */
+    uint32_t flags;
+    uint32_t width;
+    uint32_t height;
+    uint32_t dataSize; /* Bytes of pixels after the header */
+    uint32_t checksum;
+    uint64_t sequence;
+    int64_t captureNs;
+    int64_t processedNs;
+    int64_t writeNs;
+} FrameRingSlotHeader;
+#pragma pack(pop)
+
+#ifdef __cplusplus
+static_assert(sizeof(FrameRingSlotHeader) == FRAME_RING_SLOT_HEADER_SIZE, "FrameRingSlotHeader layout changed");
+static_assert(sizeof(FrameRingHeader) == 192, "FrameRingHeader layout changed");
+#endif
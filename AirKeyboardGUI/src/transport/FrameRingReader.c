@@ -0,0 +1,139 @@
+#include "FrameRingReader.h"
+
+//clang-format off
+#include <windows.h>
+//clang-format on
+
+#include <stdio.h>
+#include <stdlib.h>
+
+struct FrameRingReader {
+    HANDLE mapping;          /* Section of the ring */
+    BYTE* view;              /* The whole ring mapped */
+    FrameRingHeader* header; /* Start of view */
+    HANDLE frameEvent;       /* Set by the writer for every frame published and when it closes */
+    HANDLE slotEvent;        /* Set here for every slot freed and on detaching */
+    int64_t readIndex;       /* Frame acquired next */
+    int attached;            /* readerState was set to attached by this reader */
+    int held;                /* A frame is acquired and not yet released */
+};
+
+static HANDLE openRingEvent(const char* name, const char* suffix) {
+    char eventName[MAX_PATH];
+    int length = snprintf(eventName, sizeof(eventName), "%s%s", name, suffix);
+    if (length < 0 || length >= (int)sizeof(eventName)) return NULL;
+    return OpenEventA(EVENT_MODIFY_STATE | SYNCHRONIZE, FALSE, eventName);
+}
+
+/* Whether the mapped header describes a ring that fits the mapping */
+static int isValidRing(const FrameRingHeader* header, SIZE_T mappedSize) {
+    if (header->magic != FRAME_RING_MAGIC || header->version != FRAME_RING_VERSION) return 0;
+    if (header->headerSize < sizeof(FrameRingHeader) || header->slotCount == 0 ||
+        header->slotSize <= FRAME_RING_SLOT_HEADER_SIZE) {
+        return 0;
+    }
+    return header->headerSize + (uint64_t)header->slotCount * header->slotSize <= mappedSize;
+}
+
+FrameRingReader* akRingOpen(const char* name) {
+    if (!name) return NULL;
+
+    FrameRingReader* ring = (FrameRingReader*)calloc(1, sizeof(FrameRingReader));
+    if (!ring) return NULL;
+
+    ring->mapping = OpenFileMappingA(FILE_MAP_READ | FILE_MAP_WRITE, FALSE, name);
+    if (ring->mapping) ring->view = (BYTE*)MapViewOfFile(ring->mapping, FILE_MAP_READ | FILE_MAP_WRITE, 0, 0, 0);
+    ring->frameEvent = openRingEvent(name, FRAME_RING_FRAME_EVENT_SUFFIX);
+    ring->slotEvent = openRingEvent(name, FRAME_RING_SLOT_EVENT_SUFFIX);
+    if (!ring->view || !ring->frameEvent || !ring->slotEvent) {
+        akRingClose(ring);
+        return NULL;
+    }
+
+    MEMORY_BASIC_INFORMATION region;
+    ring->header = (FrameRingHeader*)ring->view;
+    if (!VirtualQuery(ring->view, &region, sizeof(region)) || !isValidRing(ring->header, region.RegionSize)) {
+        akRingClose(ring);
+        return NULL;
+    }
+
+    /* One reader at a time, the indices are not shared between readers */
+    if (InterlockedCompareExchange((volatile LONG*)&ring->header->readerState, FRAME_RING_READER_ATTACHED,
+                                   FRAME_RING_READER_NONE) != FRAME_RING_READER_NONE &&
+        InterlockedCompareExchange((volatile LONG*)&ring->header->readerState, FRAME_RING_READER_ATTACHED,
+                                   FRAME_RING_READER_DETACHED) != FRAME_RING_READER_DETACHED) {
+        akRingClose(ring);
+        return NULL;
+    }
+
+    ring->attached = 1;
+    ring->header->readerPid = GetCurrentProcessId();
+    ring->readIndex = ReadAcquire64((volatile LONG64*)&ring->header->readIndex);
+    return ring;
+}
+
+int akRingAcquire(FrameRingReader* ring, uint32_t timeoutMs, FrameRingFrame* frame) {
+    if (!ring || !frame || ring->held) return AK_RING_CLOSED;
+
+    FrameRingHeader* header = ring->header;
+    ULONGLONG start = GetTickCount64();
+    while (ring->readIndex >= ReadAcquire64((volatile LONG64*)&header->writeIndex)) {
+        if (ReadAcquire((volatile LONG*)&header->writerState) == FRAME_RING_WRITER_CLOSED) {
+            /* The writer publishes its last frames before closing, look once more now that it has */
+            if (ring->readIndex < ReadAcquire64((volatile LONG64*)&header->writeIndex)) break;
+            return AK_RING_CLOSED;
+        }
+
+        ULONGLONG elapsed = GetTickCount64() - start;
+        if (elapsed >= timeoutMs) return AK_RING_TIMEOUT;
+        WaitForSingleObject(ring->frameEvent, (DWORD)(timeoutMs - elapsed));
+    }
+
+    BYTE* slot = ring->view + header->headerSize + (uint64_t)(ring->readIndex % header->slotCount) * header->slotSize;
+    const FrameRingSlotHeader* slotHeader = (const FrameRingSlotHeader*)slot;
+
+    uint64_t capacity = header->slotSize - FRAME_RING_SLOT_HEADER_SIZE;
+    frame->header = slotHeader;
+    frame->data = slot + FRAME_RING_SLOT_HEADER_SIZE;
+    frame->dataSize = slotHeader->dataSize <= capacity ? slotHeader->dataSize : (uint32_t)capacity;
+    frame->pixelFormat = slotHeader->pixelFormat;
+    frame->width = slotHeader->width;
+    frame->height = slotHeader->height;
+    frame->sequence = slotHeader->sequence;
+    frame->captureNs = slotHeader->captureNs;
+
+    ring->held = 1;
+    return AK_RING_FRAME;
+}
+
+void akRingRelease(FrameRingReader* ring) {
+    if (!ring || !ring->held) return;
+
+    ring->held = 0;
+    ring->readIndex++;
+    WriteRelease64((volatile LONG64*)&ring->header->readIndex, ring->readIndex);
+    SetEvent(ring->slotEvent);
+}
+
+uint64_t akRingFramesDropped(const FrameRingReader* ring) {
+    if (!ring) return 0;
+    return (uint64_t)ReadAcquire64((volatile LONG64*)&ring->header->framesDropped);
+}
+
+void akRingClose(FrameRingReader* ring) {
+    if (!ring) return;
+
+    if (ring->attached) {
+        akRingRelease(ring);
+
+        /* The writer stops waiting for slots once nobody frees them */
+        WriteRelease((volatile LONG*)&ring->header->readerState, FRAME_RING_READER_DETACHED);
+        SetEvent(ring->slotEvent);
+    }
+
+    if (ring->view) UnmapViewOfFile(ring->view);
+    if (ring->mapping) CloseHandle(ring->mapping);
+    if (ring->frameEvent) CloseHandle(ring->frameEvent);
+    if (ring->slotEvent) CloseHandle(ring->slotEvent);
+    free(ring);
+}
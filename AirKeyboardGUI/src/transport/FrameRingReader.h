@@ -0,0 +1,77 @@
+#pragma once
+
+/*
+ * Reader side of the frame ring, built as the akring library so post-processing
+ * workers in any language can attach to a session's frames, e.g. through ctypes
+ * from frame_postprocessor.py.
+ *
+ *   FrameRingReader* ring = akRingOpen(name);
+ *   FrameRingFrame frame;
+ *   while (akRingAcquire(ring, 100, &frame) != AK_RING_CLOSED) {
+ *       ... use frame.data, then ...
+ *       akRingRelease(ring);
+ *   }
+ *   akRingClose(ring);
+ *
+ * A frame stays valid until it is released, and the writer waits for its slot
+ * or drops new frames meanwhile, so copy frames that are processed later and
+ * release them right away. One thread per reader.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "FrameRingFormat.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifdef _WIN32
+#define RING_EXPORT __declspec(dllexport)
+#else
+#define RING_EXPORT __attribute__((visibility("default")))
+#endif
+
+/* akRingAcquire() results */
+#define AK_RING_FRAME 1    /* frame holds the next frame */
+#define AK_RING_TIMEOUT 0  /* No frame arrived in time */
+#define AK_RING_CLOSED -1  /* The writer closed the ring and every frame was read */
+
+typedef struct FrameRingReader FrameRingReader;
+
+/* A frame held in the ring until akRingRelease() */
+typedef struct {
+    const FrameRingSlotHeader* header; /* The frame's FrameHeader, as in frames.bin */
+    const uint8_t* data;               /* Pixels */
+    uint32_t dataSize;                 /* Bytes at data */
+    uint32_t pixelFormat;              /* PixelFormat of the pixels, 1 for BGR24 */
+    uint32_t width;
+    uint32_t height;
+    uint64_t sequence;                 /* Capture sequence number; gaps are frames dropped before or by the ring */
+    int64_t captureNs;                 /* Capture time on the session clock */
+} FrameRingFrame;
+
+/*
+ * Attaches to a ring by the name the application passed to the worker.
+ * Returns NULL if there is no such ring or its layout is not understood.
+ */
+RING_EXPORT FrameRingReader* akRingOpen(const char* name);
+
+/*
+ * Waits up to timeoutMs for the next frame. The previous frame must have been released.
+ */
+RING_EXPORT int akRingAcquire(FrameRingReader* ring, uint32_t timeoutMs, FrameRingFrame* frame);
+
+/* Frees the slot of the frame last acquired for the writer */
+RING_EXPORT void akRingRelease(FrameRingReader* ring);
+
+/* Frames the writer has dropped so far because the ring was full or they didn't fit a slot */
+RING_EXPORT uint64_t akRingFramesDropped(const FrameRingReader* ring);
+
+/* Detaches from the ring and frees the reader */
+RING_EXPORT void akRingClose(FrameRingReader* ring);
+
+#ifdef __cplusplus
+}
+#endif
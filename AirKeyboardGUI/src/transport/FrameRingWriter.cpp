@@ -0,0 +1,168 @@
+#include "FrameRingWriter.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+static_assert(sizeof(FrameHeader) == FRAME_RING_SLOT_HEADER_SIZE, "Ring slots start with the FrameHeader");
+
+HANDLE FrameRingWriter::createEvent(const char* suffix) const {
+    std::string eventName = name + suffix;
+    return CreateEventA(nullptr, FALSE, FALSE, eventName.c_str());
+}
+
+bool FrameRingWriter::waitForSlot() {
+    auto start = std::chrono::steady_clock::now();
+    auto deadline = start + std::chrono::milliseconds(FRAME_RING_FULL_WAIT_MS);
+
+    bool freed = false;
+    while (true) {
+        if (writeIndex - ReadAcquire64(&header->readIndex) < static_cast<INT64>(slotCount)) {
+            freed = true;
+            break;
+        }
+
+        // Nobody frees slots before the worker attaches or after it detached
+        if (ReadAcquire(reinterpret_cast<volatile LONG*>(&header->readerState)) != FRAME_RING_READER_ATTACHED) break;
+
+        auto remaining = std::chrono::ceil<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now());
+        if (remaining.count() <= 0) break;
+        WaitForSingleObject(slotEvent, static_cast<DWORD>(remaining.count()));
+    }
+
+    waitNs += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+    return freed;
+}
+
+void FrameRingWriter::dropFrame() {
+    UINT64 dropped = ++framesDropped;
+    WriteRelease64(&header->framesDropped, static_cast<INT64>(dropped));
+}
+
+void FrameRingWriter::publish(const ProcessedFrame& frame) {
+    if (!frame.data) return;
+
+    if (closed || FRAME_RING_SLOT_HEADER_SIZE + static_cast<UINT64>(frame.header.dataSize) > slotSize) {
+        dropFrame();
+        return;
+    }
+
+    bool full = writeIndex - ReadAcquire64(&header->readIndex) >= static_cast<INT64>(slotCount);
+    if (full && !waitForSlot()) {
+        dropFrame();
+        return;
+    }
+
+    BYTE* slot = view + FRAME_RING_HEADER_SIZE + static_cast<UINT64>(writeIndex % slotCount) * slotSize;
+    memcpy(slot, &frame.header, sizeof(FrameHeader));
+    memcpy(slot + FRAME_RING_SLOT_HEADER_SIZE, frame.data.get(), frame.header.dataSize);
+
+    // The release store makes the slot's contents visible before the index that hands it over
+    writeIndex++;
+    WriteRelease64(&header->writeIndex, writeIndex);
+    SetEvent(frameEvent);
+
+    UINT64 occupancy = static_cast<UINT64>(writeIndex - ReadAcquire64(&header->readIndex));
+    if (occupancy > peakOccupancy) peakOccupancy = occupancy;
+}
+
+void FrameRingWriter::processBatch() {
+    while (!flushQueue.empty()) {
+        auto frame = takeFlushed();
+        if (header) {
+            if (frame) publish(*frame);
+        } else {
+            framesDropped++;
+        }
+    }
+}
+
+bool FrameRingWriter::isOpen() const {
+    return header != nullptr;
+}
+
+const std::string& FrameRingWriter::getName() const {
+    return name;
+}
+
+void FrameRingWriter::close() {
+    if (!header || closed) return;
+
+    closed = true;
+    WriteRelease(reinterpret_cast<volatile LONG*>(&header->writerState), FRAME_RING_WRITER_CLOSED);
+    SetEvent(frameEvent);
+}
+
+FrameRingStats FrameRingWriter::getStats() const {
+    FrameRingStats stats;
+    stats.framesDropped = framesDropped;
+    stats.peakOccupancy = peakOccupancy;
+    stats.waitMs = waitNs / 1e6;
+    if (header) {
+        INT64 published = ReadAcquire64(&header->writeIndex);
+        stats.framesPublished = static_cast<UINT64>(published);
+        stats.occupancy = static_cast<UINT64>(published - ReadAcquire64(&header->readIndex));
+        stats.readerAttached = ReadAcquire(reinterpret_cast<volatile LONG*>(&header->readerState)) == FRAME_RING_READER_ATTACHED;
+    }
+    return stats;
+}
+
+FrameRingWriter::FrameRingWriter(const std::string& ringName)
+    : BatchSubscriber(BatchPolicy{1, 0, std::chrono::milliseconds(0)}, processedFrameBytes), name(ringName) {
+    // Frames are shared with the other subscribers, the queue only holds references
+    trackQueue("frame_ring_queue", false, processedFrameBytes);
+
+    // Slots are page aligned so a frame's pixels never share a page with the next slot's header
+    UINT64 frameBytes = static_cast<UINT64>(FRAME_RING_SLOT_MB) * 1024 * 1024;
+    slotSize = (FRAME_RING_SLOT_HEADER_SIZE + frameBytes + 4095) & ~static_cast<UINT64>(4095);
+    slotCount = std::max(1, FRAME_RING_SLOTS);
+    UINT64 ringSize = FRAME_RING_HEADER_SIZE + slotCount * slotSize;
+
+    mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE, static_cast<DWORD>(ringSize >> 32),
+                                 static_cast<DWORD>(ringSize), name.c_str());
+    if (mapping && GetLastError() == ERROR_ALREADY_EXISTS) {
+        // Another ring of that name would be written by two processes
+        CloseHandle(mapping);
+        mapping = nullptr;
+    }
+    if (mapping) view = static_cast<BYTE*>(MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, 0));
+    frameEvent = createEvent(FRAME_RING_FRAME_EVENT_SUFFIX);
+    slotEvent = createEvent(FRAME_RING_SLOT_EVENT_SUFFIX);
+
+    if (!view || !frameEvent || !slotEvent) {
+        std::string message = "FrameRingWriter: failed to create ring " + name + ", error " +
+                              std::to_string(GetLastError()) + "\n";
+        OutputDebugStringA(message.c_str());
+        return;
+    }
+
+    // A new section is zeroed, so only the constant fields need to be set before the name is handed out
+    header = reinterpret_cast<FrameRingHeader*>(view);
+    header->magic = FRAME_RING_MAGIC;
+    header->version = FRAME_RING_VERSION;
+    header->headerSize = FRAME_RING_HEADER_SIZE;
+    header->slotCount = slotCount;
+    header->slotSize = slotSize;
+    header->writerPid = GetCurrentProcessId();
+    WriteRelease(reinterpret_cast<volatile LONG*>(&header->writerState), FRAME_RING_WRITER_OPEN);
+
+    ringAccount = MemoryAccountant::getInstance().getAccount("frame_ring", false);
+    ringAccount->add(static_cast<INT64>(ringSize), 0);
+}
+
+FrameRingWriter::~FrameRingWriter() {
+    flush();
+    close();
+
+    FrameRingStats stats = getStats();
+    char message[256];
+    sprintf_s(message, "FrameRingWriter: %llu frames published, %llu dropped, peak %llu of %u slots, %.1f ms waiting for the reader\n",
+              stats.framesPublished, stats.framesDropped, stats.peakOccupancy, slotCount, stats.waitMs);
+    OutputDebugStringA(message);
+
+    if (ringAccount) ringAccount->remove(ringAccount->getBytes(), 0);
+    if (view) UnmapViewOfFile(view);
+    if (mapping) CloseHandle(mapping);
+    if (frameEvent) CloseHandle(frameEvent);
+    if (slotEvent) CloseHandle(slotEvent);
+}
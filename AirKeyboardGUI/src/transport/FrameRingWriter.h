@@ -0,0 +1,125 @@
+#pragma once
+
+//clang-format off
+#include <windows.h>
+//clang-format on
+
+#include <atomic>
+#include <string>
+
+#include "../../config.h"
+#include "../base/BatchSubscriber.h"
+#include "../metrics/MemoryAccountant.h"
+#include "../types.h"
+#include "FrameRingFormat.h"
+
+/**
+ * @brief Backpressure figures of a frame ring, as seen by the writer.
+ */
+struct FrameRingStats {
+    UINT64 framesPublished = 0;   ///< Frames handed to the reader
+    UINT64 framesDropped = 0;     ///< Frames dropped because the ring stayed full or the frame didn't fit a slot
+    UINT64 occupancy = 0;         ///< Frames published and not yet released by the reader
+    UINT64 peakOccupancy = 0;     ///< Highest occupancy seen when publishing
+    double waitMs = 0;            ///< Total time spent waiting for the reader to free a slot
+    bool readerAttached = false;  ///< Whether a reader is attached to the ring
+};
+
+/**
+ * @brief Publishes processed frames to the post-processing worker through shared memory.
+ *
+ * FrameRingWriter creates a named ring of FRAME_RING_SLOTS slots (see
+ * FrameRingFormat.h), subscribes to FrameProcessor and copies each frame with
+ * its FrameHeader into the next slot, so the worker reads frames without them
+ * touching disk. Workers attach by name with the akring reader library.
+ *
+ * When every slot holds a frame the reader hasn't released, the writer waits up
+ * to FRAME_RING_FULL_WAIT_MS for a slot and then drops the frame; frames.bin
+ * still has it. The waits, drops and occupancy are counted, see getStats().
+ * The wait only blocks this subscriber's thread, frames queue up behind it.
+ */
+class FrameRingWriter : public BatchSubscriber<ProcessedFrame> {
+private:
+    std::string name;                      /// Name of the mapping, the events append their suffixes
+    HANDLE mapping = nullptr;              /// Pagefile-backed section of the ring
+    BYTE* view = nullptr;                  /// The whole ring mapped
+    FrameRingHeader* header = nullptr;     /// Start of view
+    HANDLE frameEvent = nullptr;           /// Set for every frame published and on closing
+    HANDLE slotEvent = nullptr;            /// Set by the reader for every slot freed and on detaching
+    UINT64 slotSize = 0;                   /// Bytes per slot, slot header included
+    UINT32 slotCount = 0;                  /// Slots in the ring
+    INT64 writeIndex = 0;                  /// Frames published, mirrors header->writeIndex
+    MemoryAccount* ringAccount = nullptr;  /// Size of the mapping
+    bool closed = false;                   /// close() was called
+
+    std::atomic<UINT64> framesDropped = 0;  /// Frames dropped because the ring stayed full or they didn't fit
+    std::atomic<UINT64> peakOccupancy = 0;  /// Highest occupancy seen when publishing
+    std::atomic<UINT64> waitNs = 0;         /// Time spent waiting for free slots
+
+    /**
+     * @brief Creates an event named after the ring.
+     */
+    HANDLE createEvent(const char* suffix) const;
+
+    /**
+     * @brief Waits until the reader frees a slot.
+     * @return false if the wait timed out or no reader is attached
+     */
+    bool waitForSlot();
+
+    /**
+     * @brief Counts a dropped frame, in the ring header too so the reader can tell.
+     */
+    void dropFrame();
+
+    /**
+     * @brief Copies a frame into the next slot and publishes it.
+     */
+    void publish(const ProcessedFrame& frame);
+
+    /**
+     * @brief Publishes the frames of the batch in order.
+     *
+     * Inherited from BatchSubscriber.
+     */
+    void processBatch() override;
+
+public:
+    /**
+     * @brief Creates the ring with slots for frames of up to FRAME_RING_SLOT_MB.
+     * @param ringName Name of the mapping, unique to the session
+     *
+     * Check isOpen(); a ring that can't be created drops every frame.
+     */
+    FrameRingWriter(const std::string& ringName);
+
+    /**
+     * @brief Whether the ring was created.
+     */
+    bool isOpen() const;
+
+    /**
+     * @brief Name workers attach to the ring by.
+     */
+    const std::string& getName() const;
+
+    /**
+     * @brief Tells the reader no frames follow the ones published so far.
+     *
+     * The reader reads the remaining frames and then sees the ring closed, the
+     * end-of-session signal for the worker. Frames arriving later are dropped.
+     */
+    void close();
+
+    /**
+     * @brief Returns the backpressure figures of the ring so far.
+     */
+    FrameRingStats getStats() const;
+
+    /**
+     * @brief Destructor closes the ring and reports its backpressure figures.
+     *
+     * The mapping stays valid for a reader that is still attached until it detaches.
+     */
+    ~FrameRingWriter();
+};
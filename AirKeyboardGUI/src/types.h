@@ -8,19 +8,86 @@ typedef struct {
     USHORT vkey;         // Virtual key code
     USHORT scanCode;     // Scan code of the key
     bool pressed;        // True if pressed, false if released
-    LONGLONG timestamp;  // Event
+    LONGLONG timestamp;  // QueryPerformanceCounter value when the hook received the event
+    UINT64 sequence;     // Publisher sequence number, gaps mean dropped events
+    INT64 captureNs;     // Estimated time of the key event on the session clock, see Timebase
 } KeyEvent;
 
+/// "AKFR" in little-endian byte order, marks a versioned FrameHeader
+constexpr UINT32 FRAME_MAGIC = 0x52464B41;
+
+/// Current frame header version
+constexpr UINT16 FRAME_FORMAT_VERSION = 2;
+
+/**
+ * @brief Layout of the pixel data following a FrameHeader.
+ */
+enum PixelFormat : UINT32 {
+    PIXEL_FORMAT_UNKNOWN = 0,
+    PIXEL_FORMAT_BGR24 = 1,  ///< Interleaved 8-bit blue, green, red
+    PIXEL_FORMAT_NV12 = 2,   ///< 8-bit Y plane followed by interleaved half-resolution UV
+};
+
+/// Header-only record written in place of a frame FrameLogger shed under memory pressure
+constexpr UINT32 FRAME_FLAG_SHED = 0x1;
+
+/// Header-only record of a frame identical to the most recent record with pixel data
+constexpr UINT32 FRAME_FLAG_DUPLICATE = 0x2;
+
+/// FrameHeader::checksum holds frameRecordChecksum() of the record
+constexpr UINT32 FRAME_FLAG_CHECKSUM = 0x4;
+
+/// Data is the pixelFormat frame encoded by LosslessEncoder; dataSize is the encoded size
+constexpr UINT32 FRAME_FLAG_COMPRESSED = 0x8;
+
+/// Compressed data was coded against the pixels of the previous record with pixel data; records without
+/// it are keyframes decoding can start from
+constexpr UINT32 FRAME_FLAG_DELTA = 0x10;
+
 #pragma pack(push, 1)
 typedef struct {
-    UINT64 timestamp;  // Frame timestamp in milliseconds
-    UINT32 width;      // Frame width
-    UINT32 height;     // Frame height
-    UINT32 dataSize;   // Size of frame data in bytes
+    UINT32 magic;        // FRAME_MAGIC
+    UINT16 version;      // FRAME_FORMAT_VERSION
+    UINT16 headerSize;   // sizeof(FrameHeader), lets readers skip fields they don't know
+    UINT32 pixelFormat;  // PixelFormat of the frame data
+    UINT32 flags;        // FRAME_FLAG_* bits
+    UINT32 width;        // Frame width
+    UINT32 height;       // Frame height
+    UINT32 dataSize;     // Size of frame data in bytes
+    UINT32 checksum;     // CRC-32C of the record if FRAME_FLAG_CHECKSUM is set, otherwise zero
+    UINT64 sequence;     // Capture sequence number, gaps mean dropped frames
+    INT64 captureNs;     // Estimated exposure time on the session clock, see Timebase
+    INT64 processedNs;   // Time FrameProcessor finished converting the frame
+    INT64 writeNs;       // Time FrameLogger handed the frame to the writer
 } FrameHeader;
 #pragma pack(pop)
 
+static_assert(sizeof(FrameHeader) == 64, "FrameHeader layout changed");
+
 typedef struct {
     FrameHeader header;
     std::unique_ptr<BYTE[]> data;  // RGB data
-} ProcessedFrame;
\ No newline at end of file
+} ProcessedFrame;
+
+/**
+ * @brief Bytes a queued ProcessedFrame is reported as to MemoryAccountant.
+ */
+inline size_t processedFrameBytes(const ProcessedFrame& frame) {
+    return sizeof(ProcessedFrame) + frame.header.dataSize;
+}
+
+/**
+ * @brief Bytes a queued KeyEvent is reported as to MemoryAccountant.
+ */
+inline size_t keyEventBytes(const KeyEvent&) {
+    return sizeof(KeyEvent);
+}
+
+/**
+ * @brief Converts a QueryPerformanceCounter value to nanoseconds without losing precision.
+ *
+ * Splits the division so the multiplication can't overflow for any realistic uptime.
+ */
+inline INT64 qpcToNanoseconds(INT64 ticks, INT64 frequency) {
+    return (ticks / frequency) * 1000000000LL + ((ticks % frequency) * 1000000000LL) / frequency;
+}
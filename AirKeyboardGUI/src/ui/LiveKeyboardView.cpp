@@ -46,6 +46,30 @@ void LiveKeyboardView::update(std::shared_ptr<ProcessedFrame> frame) {
     UpdateWindow(handle);
 }
 
+void LiveKeyboardView::enqueue(std::shared_ptr<ProcessedFrame> frame) {
+    MemoryPressure pressure = MemoryAccountant::getInstance().getPressure();
+    if (pressure >= MemoryPressure::DROP_UNLOGGED) {
+        framesSkipped++;
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(queueLock);
+    if (pressure >= MemoryPressure::DEGRADE_PREVIEW) {
+        // Frames not yet drawn are outdated by this one
+        while (!msgQueue.empty()) {
+            accountQueued(msgQueue.front(), false);
+            msgQueue.pop();
+            framesSkipped++;
+        }
+    }
+    msgQueue.push(frame);
+    accountQueued(frame, true);
+}
+
+UINT64 LiveKeyboardView::getFramesSkipped() const {
+    return framesSkipped;
+}
+
 int LiveKeyboardView::calculateX() {
     RECT rootWindowRect;
     GetClientRect(g_hMainWindow, &rootWindowRect);
@@ -64,6 +88,7 @@ LiveKeyboardView::LiveKeyboardView() : UIView(calculateX(), calculateY(), viewWi
     registerWindowClass();
 
     frameBuffer = std::make_unique<BYTE[]>(viewWidth * viewHeight * 3);
+    trackQueue("preview_queue", false, processedFrameBytes);
 
     handle = CreateWindowExW(
         WS_EX_COMPOSITED, className, nullptr,
@@ -16,6 +16,7 @@
 
 #include "../base/StreamSubscriber.h"
 #include "../base/UIView.h"
+#include "../metrics/MemoryAccountant.h"
 #include "../types.h"
 
 /**
@@ -45,6 +46,9 @@ private:
     /// Flag indicating frame buffer contains new data requiring redraw
     std::atomic<bool> frameDirty = false;
 
+    /// Frames never shown because of memory pressure
+    std::atomic<UINT64> framesSkipped = 0;
+
     /**
      * @brief Registers the Windows class for LiveKeyboardView instances.
      * Only registers once per application lifetime to avoid duplicate registration.
@@ -90,6 +94,20 @@ public:
      */
     LiveKeyboardView();
 
+    /**
+     * @brief Queues a frame for display, giving way under memory pressure.
+     * @param frame Shared pointer to the published frame
+     *
+     * Above the soft budget only the newest frame is kept queued; from
+     * MemoryPressure::DROP_UNLOGGED on no frames are taken at all.
+     */
+    void enqueue(std::shared_ptr<ProcessedFrame> frame) override;
+
+    /**
+     * @brief Number of frames never shown because of memory pressure.
+     */
+    UINT64 getFramesSkipped() const;
+
     /**
      * @brief Renders the current video frame to the device context.
      * @param hdc Handle to the device context for drawing
@@ -1,5 +1,7 @@
 #include "TextContainer.h"
 
+#include "../metrics/PipelineMetrics.h"
+
 bool TextContainer::classRegistered = false;
 
 void TextContainer::registerWindowClass() {
@@ -74,6 +76,8 @@ void TextContainer::computeCharPositions() {
 }
 
 void TextContainer::update(std::shared_ptr<KeyEvent> ke) {
+    PipelineMetrics::getInstance().record(MetricStage::KEY_TEXT_UPDATE, ke->timestamp);
+
     if (!ke->pressed) return;
 
     if (caretPosition == children.size() && ke->vkey != VK_BACK) {
@@ -166,6 +170,7 @@ void TextContainer::requestTextChunk() {
 TextContainer::TextContainer() : UIView(hPad, vPad, calculateWidth(), calculateHeight()) {
     registerWindowClass();
     updateDPIScale();
+    trackQueue("text_queue", false, keyEventBytes);
 
     float scaledSize = fontSize * dpiScale;
     font = CreateFontW(
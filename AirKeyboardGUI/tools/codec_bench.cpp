@@ -0,0 +1,358 @@
+// Measures the lossless frame codec on recorded sessions.
+//
+// Reads every frame stored with pixel data from the given frame containers,
+// decoding compressed records first, then encodes and decodes each one again
+// with a keyframe every --gop frames, checks that the round trip is exact and
+// reports the compression ratio and the encode and decode throughput of a
+// single thread. With --threads the frames are additionally encoded in batches
+// on a worker pool, as FrameLogger does, to report the throughput of the whole
+// pool. With --seek, frames are read in random order through FrameSeeker to
+// report the cost of random access.
+//
+// Usage: codec_bench <session_dir|frames.bin>... [--gop N] [--threads N] [--limit N] [--seek N]
+//   --gop N      Frames per keyframe of the re-encoding (default: FRAME_LOG_GOP_LENGTH, 1 for keyframes only)
+//   --threads N  Threads of the batch encoding run (default: half the hardware threads, 1 skips it)
+//   --limit N    Stop after N frames per container (default: all)
+//   --seek N     Random frame reads per container (default 0)
+//
+// Exits with 0 when every frame round-tripped, 2 when one didn't and 1 on errors.
+
+//clang-format off
+#include <windows.h>
+//clang-format on
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "../config.h"
+#include "../src/base/WorkerPool.h"
+#include "../src/codec/LosslessCodec.h"
+#include "../src/formats/Checksum.h"
+#include "../src/formats/FrameFormat.h"
+#include "../src/replay/FrameSeeker.h"
+
+namespace {
+
+/// Frames encoded together in the batch run, about what FrameLogger gets per batch
+constexpr size_t BATCH_FRAMES = 8;
+
+struct BenchOptions {
+    UINT32 gopLength = FRAME_LOG_GOP_LENGTH;
+    size_t limit = SIZE_MAX;
+    size_t seeks = 0;
+};
+
+struct BenchTotals {
+    size_t frames = 0;
+    size_t keyframes = 0;
+    size_t mismatches = 0;
+    UINT64 rawBytes = 0;
+    UINT64 encodedBytes = 0;
+    UINT64 storedBytes = 0;  ///< Bytes the frames take in the container as recorded
+    double encodeSeconds = 0;
+    double decodeSeconds = 0;
+    double batchSeconds = 0;
+    UINT64 batchBytes = 0;
+    size_t seeks = 0;
+    UINT64 seekDecodes = 0;
+    double seekSeconds = 0;
+};
+
+/// Frame of the batch run
+struct BatchFrame {
+    std::vector<BYTE> pixels;
+    UINT32 width;
+    UINT32 height;
+    bool delta;  ///< Coded against the frame before it
+};
+
+double secondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+/**
+ * @brief Encodes a batch of frames on the pool and adds the elapsed time to the totals.
+ * @param previous Last frame of the previous batch, the reference of a leading delta
+ */
+void encodeBatch(WorkerPool& pool, std::vector<LosslessEncoder>& encoders, std::vector<BatchFrame>& frames,
+                 std::vector<BYTE>& previous, std::vector<std::vector<BYTE>>& encoded, BenchTotals& totals) {
+    auto start = std::chrono::steady_clock::now();
+    pool.parallelFor(frames.size(), [&](size_t index, unsigned int thread) {
+        const BatchFrame& frame = frames[index];
+        const BYTE* reference = nullptr;
+        if (frame.delta) reference = index > 0 ? frames[index - 1].pixels.data() : previous.data();
+        encoders[thread].encode(frame.pixels.data(), frame.width, frame.height, encoded[index], reference);
+    });
+    totals.batchSeconds += secondsSince(start);
+
+    for (const auto& frame : frames) {
+        totals.batchBytes += frame.pixels.size();
+    }
+    previous.swap(frames.back().pixels);
+    frames.clear();
+}
+
+/**
+ * @brief Reads random frames through FrameSeeker and checks them against the sequential pass.
+ * @param checksums CRC-32C of each frame's pixels by sequence number
+ */
+void benchSeeks(const std::filesystem::path& path, size_t seeks, const std::unordered_map<UINT64, UINT32>& checksums,
+                BenchTotals& totals) {
+    FrameSeeker seeker;
+    if (!seeker.open(path) || seeker.getFrameCount() == 0) return;
+
+    std::mt19937_64 random(seeker.getFrameCount());
+    std::uniform_int_distribution<size_t> pick(0, seeker.getFrameCount() - 1);
+    std::vector<BYTE> pixels;
+    UINT64 decodesBefore = seeker.getRecordsDecoded();
+
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < seeks; i++) {
+        FrameHeader header;
+        if (!seeker.readFrame(pick(random), pixels, &header)) {
+            fprintf(stderr, "%s: random read failed\n", path.string().c_str());
+            totals.mismatches++;
+            continue;
+        }
+
+        auto expected = checksums.find(header.sequence);
+        if (expected != checksums.end() && crc32c(0, pixels.data(), pixels.size()) != expected->second) {
+            fprintf(stderr, "%s: random read of sequence %llu differs\n", path.string().c_str(), header.sequence);
+            totals.mismatches++;
+        }
+    }
+
+    totals.seekSeconds += secondsSince(start);
+    totals.seekDecodes += seeker.getRecordsDecoded() - decodesBefore;
+    totals.seeks += seeks;
+}
+
+/**
+ * @brief Round-trips every BGR24 frame of a container through the codec.
+ * @return false if the container couldn't be read
+ */
+bool benchContainer(const std::filesystem::path& path, const BenchOptions& options, WorkerPool* pool,
+                    BenchTotals& totals) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        fprintf(stderr, "%s: failed to open\n", path.string().c_str());
+        return false;
+    }
+
+    UINT64 fileSize = std::filesystem::file_size(path);
+    UINT64 offset = 0;
+    size_t frames = 0;
+    UINT32 gopPosition = 0;
+
+    LosslessEncoder encoder;
+    LosslessDecoder decoder;
+    std::vector<BYTE> stored;
+    std::vector<BYTE> raw;
+    std::vector<BYTE> previousRaw;  // Pixels of the previous record with pixel data, as recorded
+    std::vector<BYTE> encoded;
+    std::vector<BYTE> decoded;
+    std::unordered_map<UINT64, UINT32> checksums;
+
+    std::vector<LosslessEncoder> poolEncoders(pool ? pool->getThreadCount() : 0);
+    std::vector<BatchFrame> batchFrames;
+    std::vector<BYTE> batchPrevious;
+    std::vector<std::vector<BYTE>> batchEncoded(BATCH_FRAMES);
+
+    BYTE headerBytes[sizeof(FrameHeader)];
+    while (offset < fileSize && frames < options.limit) {
+        size_t available = static_cast<size_t>(std::min<UINT64>(sizeof(headerBytes), fileSize - offset));
+        in.seekg(static_cast<std::streamoff>(offset));
+        in.read(reinterpret_cast<char*>(headerBytes), available);
+
+        FrameHeader header;
+        size_t headerSize = 0;
+        if (!in || !parseFrameHeader(headerBytes, available, header, headerSize) ||
+            offset + headerSize + header.dataSize > fileSize) {
+            fprintf(stderr, "%s: unreadable record at offset %llu, stopping\n", path.string().c_str(), offset);
+            break;
+        }
+
+        UINT64 recordEnd = offset + headerSize + header.dataSize;
+        size_t rawSize = static_cast<size_t>(header.width) * header.height * 3;
+        bool hasPixels = header.dataSize > 0 && !(header.flags & (FRAME_FLAG_SHED | FRAME_FLAG_DUPLICATE));
+        if (!hasPixels) {
+            offset = recordEnd;
+            continue;
+        }
+
+        stored.resize(header.dataSize);
+        in.seekg(static_cast<std::streamoff>(offset + headerSize));
+        in.read(reinterpret_cast<char*>(stored.data()), header.dataSize);
+        if (!in) break;
+        offset = recordEnd;
+
+        if (header.flags & FRAME_FLAG_COMPRESSED) {
+            bool delta = header.flags & FRAME_FLAG_DELTA;
+            raw.resize(rawSize);
+            if ((delta && previousRaw.size() != rawSize) ||
+                !decoder.decode(stored.data(), stored.size(), raw.data(), raw.size(),
+                                delta ? previousRaw.data() : nullptr)) {
+                fprintf(stderr, "%s: sequence %llu does not decode\n", path.string().c_str(), header.sequence);
+                totals.mismatches++;
+                previousRaw.clear();
+                continue;
+            }
+        } else {
+            raw.swap(stored);
+        }
+
+        // Only BGR24 frames are coded; the others still serve as the reference of the next record
+        if (header.pixelFormat != PIXEL_FORMAT_BGR24 || raw.size() != rawSize || rawSize == 0) {
+            previousRaw.swap(raw);
+            gopPosition = 0;
+            continue;
+        }
+
+        if (options.seeks > 0) checksums[header.sequence] = crc32c(0, raw.data(), raw.size());
+
+        // Same group structure as FrameLogger
+        bool keyframe = gopPosition == 0 || previousRaw.size() != rawSize;
+        gopPosition = keyframe ? 1 : gopPosition + 1;
+        if (gopPosition >= options.gopLength) gopPosition = 0;
+        const BYTE* reference = keyframe ? nullptr : previousRaw.data();
+
+        auto start = std::chrono::steady_clock::now();
+        encoder.encode(raw.data(), header.width, header.height, encoded, reference);
+        totals.encodeSeconds += secondsSince(start);
+
+        decoded.resize(rawSize);
+        start = std::chrono::steady_clock::now();
+        bool decodedOk = decoder.decode(encoded.data(), encoded.size(), decoded.data(), decoded.size(), reference);
+        totals.decodeSeconds += secondsSince(start);
+
+        if (!decodedOk || memcmp(decoded.data(), raw.data(), rawSize) != 0) {
+            fprintf(stderr, "%s: sequence %llu does not round-trip\n", path.string().c_str(), header.sequence);
+            totals.mismatches++;
+        }
+
+        totals.frames++;
+        totals.keyframes += keyframe;
+        totals.rawBytes += rawSize;
+        totals.encodedBytes += encoded.size();
+        totals.storedBytes += header.dataSize;
+        frames++;
+
+        if (pool) {
+            batchFrames.push_back({raw, header.width, header.height, !keyframe});
+            if (batchFrames.size() == BATCH_FRAMES) {
+                encodeBatch(*pool, poolEncoders, batchFrames, batchPrevious, batchEncoded, totals);
+            }
+        }
+
+        previousRaw.swap(raw);
+    }
+
+    if (pool && !batchFrames.empty()) {
+        encodeBatch(*pool, poolEncoders, batchFrames, batchPrevious, batchEncoded, totals);
+    }
+
+    printf("%s: %zu frames\n", path.string().c_str(), frames);
+
+    if (options.seeks > 0) benchSeeks(path, options.seeks, checksums, totals);
+    return true;
+}
+
+/**
+ * @brief Adds the frame containers at path, searching directories recursively.
+ */
+void collectContainers(const std::filesystem::path& path, std::vector<std::filesystem::path>& containers) {
+    if (!std::filesystem::is_directory(path)) {
+        containers.push_back(path);
+        return;
+    }
+
+    for (const auto& entry : std::filesystem::recursive_directory_iterator(path)) {
+        if (entry.is_regular_file() && entry.path().filename() == "frames.bin") {
+            containers.push_back(entry.path());
+        }
+    }
+}
+
+double megabytesPerSecond(UINT64 bytes, double seconds) {
+    return seconds > 0 ? bytes / (1024.0 * 1024.0) / seconds : 0.0;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    std::vector<std::filesystem::path> inputs;
+    unsigned int threads = std::max(1u, std::thread::hardware_concurrency() / 2);
+    BenchOptions options;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--gop" && i + 1 < argc) {
+            options.gopLength = std::max(1, std::stoi(argv[++i]));
+        } else if (arg == "--threads" && i + 1 < argc) {
+            threads = std::max(1, std::stoi(argv[++i]));
+        } else if (arg == "--limit" && i + 1 < argc) {
+            options.limit = std::stoull(argv[++i]);
+        } else if (arg == "--seek" && i + 1 < argc) {
+            options.seeks = std::stoull(argv[++i]);
+        } else {
+            inputs.push_back(arg);
+        }
+    }
+
+    if (inputs.empty()) {
+        fprintf(stderr, "Usage: codec_bench <session_dir|frames.bin>... [--gop N] [--threads N] [--limit N] [--seek N]\n");
+        return 1;
+    }
+
+    std::vector<std::filesystem::path> containers;
+    for (const auto& input : inputs) {
+        if (!std::filesystem::exists(input)) {
+            fprintf(stderr, "%s does not exist\n", input.string().c_str());
+            return 1;
+        }
+        collectContainers(input, containers);
+    }
+    std::sort(containers.begin(), containers.end());
+
+    std::unique_ptr<WorkerPool> pool;
+    if (threads > 1) pool = std::make_unique<WorkerPool>(threads);
+
+    BenchTotals totals;
+    for (const auto& container : containers) {
+        if (!benchContainer(container, options, pool.get(), totals)) return 1;
+    }
+
+    if (totals.frames == 0) {
+        fprintf(stderr, "No BGR24 frames with pixel data found\n");
+        return 1;
+    }
+
+    printf("\n%zu frames (%zu keyframes, GOP %u), %.1f MB raw, %.1f MB encoded, %.1f MB as recorded\n", totals.frames,
+           totals.keyframes, options.gopLength, totals.rawBytes / (1024.0 * 1024.0),
+           totals.encodedBytes / (1024.0 * 1024.0), totals.storedBytes / (1024.0 * 1024.0));
+    printf("ratio %.2f, encode %.1f MB/s, decode %.1f MB/s per thread\n",
+           static_cast<double>(totals.rawBytes) / totals.encodedBytes,
+           megabytesPerSecond(totals.rawBytes, totals.encodeSeconds),
+           megabytesPerSecond(totals.rawBytes, totals.decodeSeconds));
+    if (pool) {
+        printf("batch encode on %u threads: %.1f MB/s\n", pool->getThreadCount(),
+               megabytesPerSecond(totals.batchBytes, totals.batchSeconds));
+    }
+    if (totals.seeks > 0) {
+        printf("random access: %zu reads, %.2f ms and %.1f records decoded per read\n", totals.seeks,
+               totals.seekSeconds * 1000 / totals.seeks, static_cast<double>(totals.seekDecodes) / totals.seeks);
+    }
+    printf("%zu frames failed to round-trip\n", totals.mismatches);
+
+    return totals.mismatches > 0 ? 2 : 0;
+}
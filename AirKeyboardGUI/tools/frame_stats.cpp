@@ -0,0 +1,191 @@
+// Reports dropped frames and per-stage latency of a recorded frame container.
+//
+// Walks every record header in a session's frames.bin (current or legacy layout)
+// without reading pixel data, then prints sequence gaps, frames shed under memory
+// pressure, frames stored as duplicates of the previous frame, the compression ratio of compressed frames
+// and how many of them are deltas of the frame before,
+// capture-to-processed and processed-to-write latency percentiles and frame interval jitter.
+//
+// Usage: frame_stats <frames.bin> [--gaps]
+//   --gaps  List every sequence gap instead of only the count
+
+//clang-format off
+#include <windows.h>
+//clang-format on
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "../src/formats/FrameFormat.h"
+
+namespace {
+
+struct SequenceGap {
+    UINT64 after;    ///< Last sequence number before the gap
+    UINT64 missing;  ///< Number of frames missing
+};
+
+double percentile(std::vector<double>& values, double p) {
+    if (values.empty()) return 0;
+    size_t index = static_cast<size_t>(p * (values.size() - 1));
+    std::nth_element(values.begin(), values.begin() + index, values.end());
+    return values[index];
+}
+
+void printDistribution(const char* label, std::vector<double>& valuesMs) {
+    if (valuesMs.empty()) {
+        printf("%-20s n/a\n", label);
+        return;
+    }
+
+    double sum = 0;
+    for (double v : valuesMs) sum += v;
+    double mean = sum / valuesMs.size();
+
+    double variance = 0;
+    for (double v : valuesMs) variance += (v - mean) * (v - mean);
+    double stddev = std::sqrt(variance / valuesMs.size());
+
+    printf("%-20s mean %8.3f ms  stddev %8.3f ms  p50 %8.3f ms  p99 %8.3f ms  max %8.3f ms\n",
+           label, mean, stddev, percentile(valuesMs, 0.50), percentile(valuesMs, 0.99),
+           *std::max_element(valuesMs.begin(), valuesMs.end()));
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    std::filesystem::path containerPath;
+    bool listGaps = false;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--gaps") {
+            listGaps = true;
+        } else {
+            containerPath = arg;
+        }
+    }
+
+    if (containerPath.empty()) {
+        fprintf(stderr, "Usage: frame_stats <frames.bin> [--gaps]\n");
+        return 1;
+    }
+
+    std::ifstream in(containerPath, std::ios::binary);
+    if (!in) {
+        fprintf(stderr, "Failed to open %s\n", containerPath.string().c_str());
+        return 1;
+    }
+
+    UINT64 fileSize = std::filesystem::file_size(containerPath);
+    UINT64 offset = 0;
+
+    size_t frames = 0;
+    size_t legacyFrames = 0;
+    std::vector<SequenceGap> gaps;
+    UINT64 droppedFrames = 0;
+    UINT64 lastSequence = FRAME_SEQUENCE_UNKNOWN;
+    UINT64 shedFrames = 0;
+    UINT64 duplicateFrames = 0;
+    UINT64 compressedFrames = 0;
+    UINT64 deltaFrames = 0;
+    UINT64 compressedBytes = 0;
+    UINT64 uncompressedBytes = 0;
+    INT64 lastCaptureNs = 0;
+
+    std::vector<double> processMs;
+    std::vector<double> writeMs;
+    std::vector<double> intervalMs;
+
+    BYTE headerBytes[sizeof(FrameHeader)];
+    while (offset < fileSize) {
+        size_t available = static_cast<size_t>(std::min<UINT64>(sizeof(headerBytes), fileSize - offset));
+        in.seekg(static_cast<std::streamoff>(offset));
+        in.read(reinterpret_cast<char*>(headerBytes), available);
+
+        FrameHeader header;
+        size_t headerSize = 0;
+        if (!in || !parseFrameHeader(headerBytes, available, header, headerSize)) {
+            fprintf(stderr, "Truncated header at offset %llu\n", offset);
+            break;
+        }
+
+        UINT64 recordEnd = offset + headerSize + header.dataSize;
+        if (recordEnd > fileSize) {
+            fprintf(stderr, "Truncated frame data at offset %llu\n", offset);
+            break;
+        }
+
+        if (header.sequence == FRAME_SEQUENCE_UNKNOWN) {
+            legacyFrames++;
+        } else {
+            if (lastSequence != FRAME_SEQUENCE_UNKNOWN && header.sequence > lastSequence + 1) {
+                UINT64 missing = header.sequence - lastSequence - 1;
+                gaps.push_back({lastSequence, missing});
+                droppedFrames += missing;
+            }
+            lastSequence = header.sequence;
+
+            if (header.flags & FRAME_FLAG_SHED) {
+                // Gap marker written by FrameLogger under memory pressure, the frame itself is missing
+                shedFrames++;
+                offset = recordEnd;
+                continue;
+            }
+
+            if (header.flags & FRAME_FLAG_DUPLICATE) {
+                duplicateFrames++;
+            }
+
+            if (header.flags & FRAME_FLAG_COMPRESSED) {
+                // Only BGR24 frames are compressed, so the raw size follows from the dimensions
+                compressedFrames++;
+                compressedBytes += header.dataSize;
+                uncompressedBytes += static_cast<UINT64>(header.width) * header.height * 3;
+                if (header.flags & FRAME_FLAG_DELTA) deltaFrames++;
+            }
+
+            if (header.processedNs != 0) {
+                processMs.push_back((header.processedNs - header.captureNs) / 1e6);
+            }
+            if (header.writeNs != 0 && header.processedNs != 0) {
+                writeMs.push_back((header.writeNs - header.processedNs) / 1e6);
+            }
+        }
+
+        if (frames > 0) {
+            intervalMs.push_back((header.captureNs - lastCaptureNs) / 1e6);
+        }
+        lastCaptureNs = header.captureNs;
+
+        frames++;
+        offset = recordEnd;
+    }
+
+    printf("%s: %zu frames (%zu legacy), %.1f MB\n", containerPath.string().c_str(), frames, legacyFrames,
+           offset / (1024.0 * 1024.0));
+    printf("sequence gaps: %zu, dropped frames: %llu, shed frames: %llu, duplicate frames: %llu\n", gaps.size(), droppedFrames,
+           shedFrames, duplicateFrames);
+    if (listGaps) {
+        for (const auto& gap : gaps) {
+            printf("  after %llu: %llu missing\n", gap.after, gap.missing);
+        }
+    }
+
+    if (compressedFrames > 0) {
+        printf("compressed frames: %llu (%llu keyframes, %llu deltas), %.1f MB of %.1f MB raw, ratio %.2f\n",
+               compressedFrames, compressedFrames - deltaFrames, deltaFrames, compressedBytes / (1024.0 * 1024.0),
+               uncompressedBytes / (1024.0 * 1024.0), static_cast<double>(uncompressedBytes) / compressedBytes);
+    }
+
+    printDistribution("capture->processed", processMs);
+    printDistribution("processed->write", writeMs);
+    printDistribution("frame interval", intervalMs);
+
+    return 0;
+}
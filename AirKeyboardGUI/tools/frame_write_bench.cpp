@@ -0,0 +1,172 @@
+// Benchmarks buffered against direct-I/O frame container writes.
+//
+// Writes synthetic frames the size FrameProcessor produces through AsyncFileWriter,
+// once per mode, and reports throughput, per-frame append latency and how much the
+// system file cache grew during the run.
+//
+// Usage: frame_write_bench [output_dir] [--seconds N] [--fps N] [--keep]
+//   --seconds N  Duration of each run (default 600)
+//   --fps N      Frame rate to pace writes at; 0 writes as fast as possible (default 0)
+//   --keep       Keep the written files instead of deleting them
+
+//clang-format off
+#include <windows.h>
+//clang-format on
+
+#include <psapi.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../src/formats/FrameFormat.h"
+#include "../src/logging/AsyncFileWriter.h"
+
+#pragma comment(lib, "psapi.lib")
+
+namespace {
+
+struct BenchResult {
+    size_t frames = 0;
+    double seconds = 0;
+    AsyncWriterStats writer;
+    double appendP50Ms = 0;
+    double appendP99Ms = 0;
+    double appendMaxMs = 0;
+    double cacheGrowthMB = 0;
+};
+
+double systemCacheMB() {
+    PERFORMANCE_INFORMATION info = {};
+    info.cb = sizeof(info);
+    if (!GetPerformanceInfo(&info, sizeof(info))) {
+        return 0;
+    }
+    return static_cast<double>(info.SystemCache) * info.PageSize / (1024.0 * 1024.0);
+}
+
+double percentile(std::vector<double>& values, double p) {
+    if (values.empty()) return 0;
+    size_t index = static_cast<size_t>(p * (values.size() - 1));
+    std::nth_element(values.begin(), values.begin() + index, values.end());
+    return values[index];
+}
+
+BenchResult runBench(const std::filesystem::path& path, bool directIo, double seconds, int fps) {
+    // FrameProcessor::CROP_WIDTH x CROP_HEIGHT, kept local so the tool needs no CUDA headers
+    constexpr UINT32 width = 912;
+    constexpr UINT32 height = 600;
+    constexpr UINT32 dataSize = width * height * 3;
+
+    std::vector<BYTE> pixels(dataSize);
+    for (size_t i = 0; i < pixels.size(); i++) {
+        pixels[i] = static_cast<BYTE>(i * 31);
+    }
+
+    FrameHeader header;
+    initFrameHeader(header, PIXEL_FORMAT_BGR24, width, height, dataSize);
+
+    BenchResult result;
+    std::vector<double> appendMs;
+
+    double cacheBefore = systemCacheMB();
+    auto start = std::chrono::steady_clock::now();
+    auto deadline = start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                                std::chrono::duration<double>(seconds));
+    auto interval = fps > 0 ? std::chrono::nanoseconds(1000000000LL / fps) : std::chrono::nanoseconds(0);
+    auto nextFrame = start;
+
+    {
+        AsyncWriterOptions options;
+        options.directIo = directIo;
+        AsyncFileWriter writer(path, options);
+        if (!writer.isOpen()) {
+            fprintf(stderr, "Failed to open %s\n", path.string().c_str());
+            return result;
+        }
+
+        while (std::chrono::steady_clock::now() < deadline) {
+            header.sequence = result.frames;
+            pixels[result.frames % dataSize]++;  // Keep every frame distinct
+
+            auto before = std::chrono::steady_clock::now();
+            writer.append(&header, sizeof(header));
+            writer.append(pixels.data(), pixels.size());
+            auto after = std::chrono::steady_clock::now();
+            appendMs.push_back(std::chrono::duration<double, std::milli>(after - before).count());
+
+            result.frames++;
+            if (fps > 0) {
+                nextFrame += interval;
+                std::this_thread::sleep_until(nextFrame);
+            }
+        }
+
+        writer.close();
+        result.writer = writer.getStats();
+    }
+
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    result.cacheGrowthMB = systemCacheMB() - cacheBefore;
+    result.appendP50Ms = percentile(appendMs, 0.50);
+    result.appendP99Ms = percentile(appendMs, 0.99);
+    result.appendMaxMs = appendMs.empty() ? 0 : *std::max_element(appendMs.begin(), appendMs.end());
+    return result;
+}
+
+void printResult(const char* label, const BenchResult& r) {
+    printf("%-9s %8zu frames %9.1f MB %8.1f MB/s  append p50 %6.3f ms p99 %7.3f ms max %8.3f ms  "
+           "queue avg %6.2f ms max %7.2f ms  stalls %6llu  cache %+.0f MB\n",
+           label, r.frames, r.writer.bytesWritten / (1024.0 * 1024.0), r.writer.throughputMBps,
+           r.appendP50Ms, r.appendP99Ms, r.appendMaxMs,
+           r.writer.avgQueueDelayMs, r.writer.maxQueueDelayMs, r.writer.appendStalls,
+           r.cacheGrowthMB);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    std::filesystem::path outputDir = std::filesystem::current_path();
+    double seconds = 600;
+    int fps = 0;
+    bool keep = false;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--seconds" && i + 1 < argc) {
+            seconds = std::stod(argv[++i]);
+        } else if (arg == "--fps" && i + 1 < argc) {
+            fps = std::stoi(argv[++i]);
+        } else if (arg == "--keep") {
+            keep = true;
+        } else {
+            outputDir = arg;
+        }
+    }
+
+    std::filesystem::create_directories(outputDir);
+    std::filesystem::path bufferedPath = outputDir / "bench_buffered.bin";
+    std::filesystem::path directPath = outputDir / "bench_direct.bin";
+
+    printf("Writing %.0f s per mode to %s%s\n", seconds, outputDir.string().c_str(),
+           fps > 0 ? (" at " + std::to_string(fps) + " fps").c_str() : " as fast as possible");
+
+    BenchResult buffered = runBench(bufferedPath, false, seconds, fps);
+    printResult("buffered", buffered);
+
+    BenchResult direct = runBench(directPath, true, seconds, fps);
+    printResult(direct.writer.directIo ? "direct" : "fallback", direct);
+
+    if (!keep) {
+        std::error_code ec;
+        std::filesystem::remove(bufferedPath, ec);
+        std::filesystem::remove(directPath, ec);
+    }
+
+    return 0;
+}
@@ -0,0 +1,236 @@
+// Measures the in-tree JPEG encoder on recorded sessions.
+//
+// Reads every BGR24 frame stored with pixel data from the given frame
+// containers, decoding compressed records first, and encodes each one as a
+// snapshot would be at the given quality. Reports the frames per second of a
+// single thread, which is the rate per core, and the size of the snapshots.
+// With --threads the frames are additionally encoded in batches on a worker
+// pool, as FrameSnapshotWriter does, to report the throughput of the whole pool.
+//
+// Usage: jpeg_bench <session_dir|frames.bin>... [--quality N] [--threads N] [--limit N] [--out dir]
+//   --quality N  Quality on libjpeg's scale (default: FRAME_SNAPSHOT_QUALITY)
+//   --threads N  Threads of the batch encoding run (default: half the hardware threads, 1 skips it)
+//   --limit N    Stop after N frames per container (default: all)
+//   --out dir    Also write the encoded frames there as <sequence>.jpg, to inspect them
+//
+// Exits with 0 when every frame was encoded and 1 on errors.
+
+//clang-format off
+#include <windows.h>
+//clang-format on
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../config.h"
+#include "../src/base/WorkerPool.h"
+#include "../src/codec/JpegEncoder.h"
+#include "../src/formats/FrameFormat.h"
+#include "../src/replay/FrameSeeker.h"
+
+namespace {
+
+/// Frames encoded together in the batch run, about what FrameSnapshotWriter gets per batch
+constexpr size_t BATCH_FRAMES = 8;
+
+struct BenchOptions {
+    int quality = FRAME_SNAPSHOT_QUALITY;
+    size_t limit = SIZE_MAX;
+    std::filesystem::path outputDir;
+};
+
+struct BenchTotals {
+    size_t frames = 0;
+    size_t failures = 0;
+    UINT64 pixels = 0;
+    UINT64 encodedBytes = 0;
+    double encodeSeconds = 0;
+    size_t batchFrames = 0;
+    double batchSeconds = 0;
+};
+
+/// Frame of the batch run
+struct BatchFrame {
+    std::vector<BYTE> pixels;
+    UINT32 width;
+    UINT32 height;
+};
+
+double secondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+/**
+ * @brief Encodes a batch of frames on the pool and adds the elapsed time to the totals.
+ */
+void encodeBatch(WorkerPool& pool, std::vector<JpegEncoder>& encoders, std::vector<BatchFrame>& frames,
+                 std::vector<std::vector<BYTE>>& encoded, int quality, BenchTotals& totals) {
+    auto start = std::chrono::steady_clock::now();
+    pool.parallelFor(frames.size(), [&](size_t index, unsigned int thread) {
+        const BatchFrame& frame = frames[index];
+        encoders[thread].encode(frame.pixels.data(), frame.width, frame.height, quality, encoded[index]);
+    });
+    totals.batchSeconds += secondsSince(start);
+    totals.batchFrames += frames.size();
+    frames.clear();
+}
+
+/**
+ * @brief Encodes every BGR24 frame of a container.
+ * @return false if the container couldn't be read
+ */
+bool benchContainer(const std::filesystem::path& path, const BenchOptions& options, WorkerPool* pool,
+                    BenchTotals& totals) {
+    FrameSeeker seeker;
+    if (!seeker.open(path)) {
+        fprintf(stderr, "%s: failed to open\n", path.string().c_str());
+        return false;
+    }
+
+    JpegEncoder encoder;
+    std::vector<BYTE> pixels;
+    std::vector<BYTE> encoded;
+    size_t frames = 0;
+
+    std::vector<JpegEncoder> poolEncoders(pool ? pool->getThreadCount() : 0);
+    std::vector<BatchFrame> batchFrames;
+    std::vector<std::vector<BYTE>> batchEncoded(BATCH_FRAMES);
+
+    for (size_t i = 0; i < seeker.getFrameCount() && frames < options.limit; i++) {
+        // Duplicates would encode the same pixels again
+        const FrameIndexEntry* entry = seeker.getEntry(i);
+        if (entry->source != i) continue;
+
+        FrameHeader header;
+        if (!seeker.readFrame(i, pixels, &header)) {
+            fprintf(stderr, "%s: sequence %llu does not decode\n", path.string().c_str(), entry->header.sequence);
+            continue;
+        }
+        if (header.pixelFormat != PIXEL_FORMAT_BGR24 || pixels.empty() ||
+            pixels.size() != static_cast<size_t>(header.width) * header.height * 3) {
+            continue;
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        bool ok = encoder.encode(pixels.data(), header.width, header.height, options.quality, encoded);
+        totals.encodeSeconds += secondsSince(start);
+
+        if (!ok) {
+            fprintf(stderr, "%s: sequence %llu does not encode\n", path.string().c_str(), header.sequence);
+            totals.failures++;
+            continue;
+        }
+
+        if (!options.outputDir.empty()) {
+            std::ofstream out(options.outputDir / (std::to_string(header.sequence) + ".jpg"), std::ios::binary);
+            out.write(reinterpret_cast<const char*>(encoded.data()), encoded.size());
+        }
+
+        totals.frames++;
+        totals.pixels += static_cast<UINT64>(header.width) * header.height;
+        totals.encodedBytes += encoded.size();
+        frames++;
+
+        if (pool) {
+            batchFrames.push_back({pixels, header.width, header.height});
+            if (batchFrames.size() == BATCH_FRAMES) {
+                encodeBatch(*pool, poolEncoders, batchFrames, batchEncoded, options.quality, totals);
+            }
+        }
+    }
+
+    if (pool && !batchFrames.empty()) {
+        encodeBatch(*pool, poolEncoders, batchFrames, batchEncoded, options.quality, totals);
+    }
+
+    printf("%s: %zu frames\n", path.string().c_str(), frames);
+    return true;
+}
+
+/**
+ * @brief Adds the frame containers at path, searching directories recursively.
+ */
+void collectContainers(const std::filesystem::path& path, std::vector<std::filesystem::path>& containers) {
+    if (!std::filesystem::is_directory(path)) {
+        containers.push_back(path);
+        return;
+    }
+
+    for (const auto& entry : std::filesystem::recursive_directory_iterator(path)) {
+        if (entry.is_regular_file() && entry.path().filename() == "frames.bin") {
+            containers.push_back(entry.path());
+        }
+    }
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    std::vector<std::filesystem::path> inputs;
+    unsigned int threads = std::max(1u, std::thread::hardware_concurrency() / 2);
+    BenchOptions options;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--quality" && i + 1 < argc) {
+            options.quality = std::clamp(std::stoi(argv[++i]), 1, 100);
+        } else if (arg == "--threads" && i + 1 < argc) {
+            threads = std::max(1, std::stoi(argv[++i]));
+        } else if (arg == "--limit" && i + 1 < argc) {
+            options.limit = std::stoull(argv[++i]);
+        } else if (arg == "--out" && i + 1 < argc) {
+            options.outputDir = argv[++i];
+        } else {
+            inputs.push_back(arg);
+        }
+    }
+
+    if (inputs.empty()) {
+        fprintf(stderr, "Usage: jpeg_bench <session_dir|frames.bin>... [--quality N] [--threads N] [--limit N] [--out dir]\n");
+        return 1;
+    }
+
+    std::vector<std::filesystem::path> containers;
+    for (const auto& input : inputs) {
+        if (!std::filesystem::exists(input)) {
+            fprintf(stderr, "%s does not exist\n", input.string().c_str());
+            return 1;
+        }
+        collectContainers(input, containers);
+    }
+    std::sort(containers.begin(), containers.end());
+
+    if (!options.outputDir.empty()) std::filesystem::create_directories(options.outputDir);
+
+    std::unique_ptr<WorkerPool> pool;
+    if (threads > 1) pool = std::make_unique<WorkerPool>(threads);
+
+    BenchTotals totals;
+    for (const auto& container : containers) {
+        if (!benchContainer(container, options, pool.get(), totals)) return 1;
+    }
+
+    if (totals.frames == 0) {
+        fprintf(stderr, "No BGR24 frames with pixel data found\n");
+        return 1;
+    }
+
+    printf("\n%zu frames at quality %d, %.1f KB per frame, %.2f bits per pixel\n", totals.frames, options.quality,
+           totals.encodedBytes / 1024.0 / totals.frames, totals.encodedBytes * 8.0 / totals.pixels);
+    printf("encode %.1f fps per core, %.1f megapixels/s\n", totals.frames / totals.encodeSeconds,
+           totals.pixels / 1e6 / totals.encodeSeconds);
+    if (pool) {
+        printf("batch encode on %u threads: %.1f fps\n", pool->getThreadCount(),
+               totals.batchSeconds > 0 ? totals.batchFrames / totals.batchSeconds : 0.0);
+    }
+    printf("%zu frames failed to encode\n", totals.failures);
+
+    return totals.failures > 0 ? 1 : 0;
+}
@@ -0,0 +1,132 @@
+// Exports a binary key-event log (key_events.bin) to CSV.
+//
+// Usage: key_log_export <key_events.bin> [output.csv] [--legacy]
+//   output.csv  Output file; CSV goes to stdout when omitted
+//   --legacy    Write the old key_events.csv layout: timestamp_ms,vkey,scancode,pressed
+//
+// Gaps in the sequence numbers (events dropped before they were logged) and
+// blocks that fail their checksum are reported on stderr.
+
+#include <windows.h>
+
+#include <algorithm>
+#include <charconv>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "../src/formats/KeyEventLogFormat.h"
+
+namespace {
+
+/// Appends an integer followed by a separator to a line buffer
+template <typename T>
+char* putField(char* out, T value, char separator) {
+    out = std::to_chars(out, out + 24, value).ptr;
+    *out++ = separator;
+    return out;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    const char* inputPath = nullptr;
+    const char* outputPath = nullptr;
+    bool legacy = false;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--legacy") {
+            legacy = true;
+        } else if (!inputPath) {
+            inputPath = argv[i];
+        } else {
+            outputPath = argv[i];
+        }
+    }
+
+    if (!inputPath) {
+        fprintf(stderr, "Usage: key_log_export <key_events.bin> [output.csv] [--legacy]\n");
+        return 1;
+    }
+
+    FILE* input = fopen(inputPath, "rb");
+    if (!input) {
+        fprintf(stderr, "Failed to open %s\n", inputPath);
+        return 1;
+    }
+
+    // Key logs grow by a few hundred bytes per second, reading them whole is cheap
+    std::vector<BYTE> data;
+    BYTE chunk[1 << 16];
+    size_t read;
+    while ((read = fread(chunk, 1, sizeof(chunk), input)) > 0) {
+        data.insert(data.end(), chunk, chunk + read);
+    }
+    fclose(input);
+
+    KeyEventLogHeader header = {};
+    std::vector<KeyEventRecord> records;
+    std::vector<CorruptRange> corrupt;
+    if (!parseKeyEventLog(data.data(), data.size(), header, records, &corrupt) || header.qpcFrequency <= 0) {
+        fprintf(stderr, "%s is not a key-event log\n", inputPath);
+        return 1;
+    }
+
+    for (const CorruptRange& range : corrupt) {
+        fprintf(stderr, "Damaged: bytes %llu to %llu skipped\n", range.offset, range.offset + range.size);
+    }
+
+    FILE* output = outputPath ? fopen(outputPath, "wb") : stdout;
+    if (!output) {
+        fprintf(stderr, "Failed to create %s\n", outputPath);
+        return 1;
+    }
+
+    fputs(legacy ? "timestamp_ms,vkey,scancode,pressed\n"
+                 : "sequence,timestamp_ns,qpc_ticks,vkey,scancode,pressed\n",
+          output);
+
+    // Format in large blocks so the output is written in few calls
+    constexpr size_t LINES_PER_WRITE = 8192;
+    std::vector<char> lines(LINES_PER_WRITE * 128);
+
+    UINT64 exported = 0;
+    UINT64 dropped = 0;
+    UINT64 expectedSequence = 0;
+
+    for (size_t first = 0; first < records.size(); first += LINES_PER_WRITE) {
+        size_t last = std::min(records.size(), first + LINES_PER_WRITE);
+        char* out = lines.data();
+        for (size_t i = first; i < last; i++) {
+            const KeyEventRecord& record = records[i];
+
+            if (exported > 0 && record.sequence != expectedSequence) {
+                fprintf(stderr, "Gap: sequence %llu to %llu (%llu events missing)\n",
+                        expectedSequence, record.sequence, record.sequence - expectedSequence);
+                dropped += record.sequence - expectedSequence;
+            }
+            expectedSequence = record.sequence + 1;
+            exported++;
+
+            if (legacy) {
+                out = putField(out, record.qpcTicks * 1000 / header.qpcFrequency, ',');
+            } else {
+                out = putField(out, record.sequence, ',');
+                out = putField(out, record.timestampNs, ',');
+                out = putField(out, record.qpcTicks, ',');
+            }
+            out = putField(out, record.vkey, ',');
+            out = putField(out, record.scanCode, ',');
+            out = putField(out, (record.flags & KEY_RECORD_PRESSED) ? 1 : 0, '\n');
+        }
+        fwrite(lines.data(), 1, out - lines.data(), output);
+    }
+
+    if (output != stdout) {
+        fclose(output);
+    }
+
+    fprintf(stderr, "%llu events exported, %llu dropped, %zu damaged ranges\n", exported, dropped, corrupt.size());
+    return 0;
+}
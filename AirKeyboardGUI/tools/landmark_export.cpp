@@ -0,0 +1,200 @@
+// Exports the hand landmarks of a session (landmarks.bin) to CSV.
+//
+// Usage: landmark_export <landmarks.bin> [output.csv] [--wide] [--legacy] [--from N] [--to N] [--verify]
+//   output.csv  Output file; CSV goes to stdout when omitted
+//   --wide      One row per hand with a column per coordinate, the layout columnar tools load fastest
+//   --legacy    Write the old landmarks.csv layout, one row per landmark with millisecond timestamps
+//   --from N    Only frames from sequence N on
+//   --to N      Only frames up to sequence N
+//   --verify    Check the blocks' checksums before exporting
+//
+// Without --wide or --legacy there is one row per landmark with sequence numbers
+// and nanosecond capture times. Damaged ranges and the time taken to open the
+// file are reported on stderr.
+
+#include <windows.h>
+
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "../src/replay/LandmarkReader.h"
+
+namespace {
+
+/// Appends a number followed by a separator to a line buffer
+template <typename T>
+char* putField(char* out, T value, char separator) {
+    out = std::to_chars(out, out + 32, value).ptr;
+    *out++ = separator;
+    return out;
+}
+
+char* putText(char* out, const char* text, char separator) {
+    while (*text) *out++ = *text++;
+    *out++ = separator;
+    return out;
+}
+
+const char* handLabelName(UINT8 label) {
+    return label == LANDMARK_HAND_LEFT ? "left" : "right";
+}
+
+/**
+ * @brief Writes the CSV header of the selected layout.
+ */
+void writeHeader(FILE* output, bool wide, bool legacy, UINT16 pointCount) {
+    if (legacy) {
+        fputs("session_frame,timestamp,hand_index,hand_label,hand_score,landmark_index,x,y,z,world_x,world_y,world_z\n", output);
+        return;
+    }
+    if (!wide) {
+        fputs("sequence,capture_ns,hand_index,hand_label,hand_score,landmark_index,x,y,z,world_x,world_y,world_z\n", output);
+        return;
+    }
+
+    std::string header = "sequence,capture_ns,hand_index,hand_label,hand_score";
+    for (const char* prefix : {"", "world_"}) {
+        for (UINT16 point = 0; point < pointCount; point++) {
+            for (const char* axis : {"x", "y", "z"}) {
+                header += ',';
+                header += prefix;
+                header += axis;
+                header += std::to_string(point);
+            }
+        }
+    }
+    header += '\n';
+    fputs(header.c_str(), output);
+}
+
+/**
+ * @brief Formats the rows of one hand.
+ * @return End of the formatted rows
+ */
+char* formatHand(char* out, const LandmarkHand& hand, UINT16 pointCount, bool wide, bool legacy) {
+    if (wide) {
+        out = putField(out, hand.sequence, ',');
+        out = putField(out, hand.captureNs, ',');
+        out = putField(out, hand.handIndex, ',');
+        out = putText(out, handLabelName(hand.handLabel), ',');
+        out = putField(out, hand.score, ',');
+        for (UINT32 i = 0; i < pointCount * 3u; i++) {
+            out = putField(out, hand.points[i], ',');
+        }
+        for (UINT32 i = 0; i < pointCount * 3u; i++) {
+            out = putField(out, hand.worldPoints[i], i + 1 < pointCount * 3u ? ',' : '\n');
+        }
+        return out;
+    }
+
+    for (UINT16 point = 0; point < pointCount; point++) {
+        if (legacy) {
+            char frame[24];
+            snprintf(frame, sizeof(frame), "%06llu", hand.sequence);
+            out = putText(out, frame, ',');
+            out = putField(out, hand.captureNs / 1000000, ',');
+        } else {
+            out = putField(out, hand.sequence, ',');
+            out = putField(out, hand.captureNs, ',');
+        }
+        out = putField(out, hand.handIndex, ',');
+        out = putText(out, handLabelName(hand.handLabel), ',');
+        out = putField(out, hand.score, ',');
+        out = putField(out, point, ',');
+        const float* xyz = hand.points + point * 3;
+        const float* world = hand.worldPoints + point * 3;
+        out = putField(out, xyz[0], ',');
+        out = putField(out, xyz[1], ',');
+        out = putField(out, xyz[2], ',');
+        out = putField(out, world[0], ',');
+        out = putField(out, world[1], ',');
+        out = putField(out, world[2], '\n');
+    }
+    return out;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    const char* inputPath = nullptr;
+    const char* outputPath = nullptr;
+    bool wide = false;
+    bool legacy = false;
+    bool verify = false;
+    UINT64 fromSequence = 0;
+    UINT64 toSequence = UINT64_MAX;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--wide") {
+            wide = true;
+        } else if (arg == "--legacy") {
+            legacy = true;
+        } else if (arg == "--verify") {
+            verify = true;
+        } else if (arg == "--from" && i + 1 < argc) {
+            fromSequence = std::stoull(argv[++i]);
+        } else if (arg == "--to" && i + 1 < argc) {
+            toSequence = std::stoull(argv[++i]);
+        } else if (!inputPath) {
+            inputPath = argv[i];
+        } else {
+            outputPath = argv[i];
+        }
+    }
+
+    if (!inputPath || (wide && legacy)) {
+        fprintf(stderr, "Usage: landmark_export <landmarks.bin> [output.csv] [--wide] [--legacy] [--from N] [--to N] [--verify]\n");
+        return 1;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    LandmarkReader reader;
+    if (!reader.open(inputPath, verify)) {
+        fprintf(stderr, "%s is not a landmark file\n", inputPath);
+        return 1;
+    }
+    double openMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    for (const CorruptRange& range : reader.getCorruptRanges()) {
+        fprintf(stderr, "Damaged: bytes %llu to %llu skipped\n", range.offset, range.offset + range.size);
+    }
+
+    FILE* output = outputPath ? fopen(outputPath, "wb") : stdout;
+    if (!output) {
+        fprintf(stderr, "Failed to create %s\n", outputPath);
+        return 1;
+    }
+
+    UINT16 pointCount = reader.getPointCount();
+    writeHeader(output, wide, legacy, pointCount);
+
+    size_t first = reader.findFrame(fromSequence).first;
+    size_t last = toSequence == UINT64_MAX ? reader.getHandCount() : reader.findFrame(toSequence).second;
+
+    // Format in large blocks so the output is written in few calls
+    constexpr size_t HANDS_PER_WRITE = 512;
+    size_t handChars = (wide ? 1 : pointCount) * (96 + 6 * 16) + (wide ? pointCount * 6 * 16 : 0);
+    std::vector<char> lines(HANDS_PER_WRITE * handChars);
+
+    for (size_t block = first; block < last; block += HANDS_PER_WRITE) {
+        size_t blockEnd = std::min(last, block + HANDS_PER_WRITE);
+        char* out = lines.data();
+        for (size_t i = block; i < blockEnd; i++) {
+            out = formatHand(out, reader.getHand(i), pointCount, wide, legacy);
+        }
+        fwrite(lines.data(), 1, out - lines.data(), output);
+    }
+
+    if (output != stdout) {
+        fclose(output);
+    }
+
+    fprintf(stderr, "%zu hands exported, %llu frames analyzed, file opened in %.2f ms, %zu damaged ranges\n",
+            last > first ? last - first : 0, reader.getFrameCount(), openMs, reader.getCorruptRanges().size());
+    return 0;
+}
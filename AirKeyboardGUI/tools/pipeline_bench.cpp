@@ -0,0 +1,241 @@
+// Benchmarks the capture pipeline without a camera.
+//
+// Drives SyntheticFrameSource -> FrameProcessor -> FrameLogger at each requested
+// frame rate, with the same thread loops ThreadManager uses, and reports how many
+// frames every stage handled, frames published out of capture order,
+// capture-to-processed latency and write throughput.
+//
+// Usage: pipeline_bench [output_dir] [--seconds N] [--rates 30,60,120,240]
+//                       [--size WxH] [--pattern bars|gradient|loop] [--loop FILE] [--no-log] [--keep]
+//   --seconds N   Duration of each run (default 10)
+//   --rates LIST  Comma-separated frame rates to run (default 30,60,120,240)
+//   --size WxH    Source frame size, even and at least the crop (default 1920x1080)
+//   --pattern P   Synthetic content (default gradient)
+//   --loop FILE   Raw NV12 frames of the source size for --pattern loop
+//   --no-log      Measure conversion and fan-out only, without FrameLogger
+//   --keep        Keep the written containers
+
+//clang-format off
+#include <windows.h>
+//clang-format on
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../src/capture/FrameProcessor.h"
+#include "../src/capture/SyntheticFrameSource.h"
+#include "../src/logging/FrameLogger.h"
+
+namespace {
+
+/// Records capture-to-processed latency and order of every frame FrameProcessor publishes
+class LatencyProbe : public Subscriber<ProcessedFrame> {
+private:
+    std::vector<double> latencyMs;
+    std::mutex latencyLock;
+
+    /// Sequence of the last frame received, and whether one was
+    UINT64 lastSequence = 0;
+    bool received = false;
+
+    /// Frames whose sequence wasn't above the previous frame's
+    size_t outOfOrder = 0;
+
+public:
+    explicit LatencyProbe(size_t expectedFrames) {
+        latencyMs.reserve(expectedFrames);
+    }
+
+    void enqueue(std::shared_ptr<ProcessedFrame> frame) override {
+        std::lock_guard<std::mutex> lock(latencyLock);
+        latencyMs.push_back((frame->header.processedNs - frame->header.captureNs) / 1e6);
+
+        if (received && frame->header.sequence <= lastSequence) {
+            outOfOrder++;
+        }
+        lastSequence = frame->header.sequence;
+        received = true;
+    }
+
+    size_t countOutOfOrder() {
+        std::lock_guard<std::mutex> lock(latencyLock);
+        return outOfOrder;
+    }
+
+    size_t count() {
+        std::lock_guard<std::mutex> lock(latencyLock);
+        return latencyMs.size();
+    }
+
+    double percentile(double p) {
+        std::lock_guard<std::mutex> lock(latencyLock);
+        if (latencyMs.empty()) return 0;
+        size_t index = static_cast<size_t>(p * (latencyMs.size() - 1));
+        std::nth_element(latencyMs.begin(), latencyMs.begin() + index, latencyMs.end());
+        return latencyMs[index];
+    }
+};
+
+struct BenchConfig {
+    std::filesystem::path outputDir;
+    double seconds = 10;
+    SyntheticSourceOptions source;
+    bool log = true;
+    bool keep = false;
+};
+
+void runBench(const BenchConfig& config, double fps) {
+    SyntheticSourceOptions sourceOptions = config.source;
+    sourceOptions.fps = fps;
+
+    SyntheticFrameSource source(sourceOptions);
+    FrameProcessor& processor = FrameProcessor::getInstance();
+    LatencyProbe probe(static_cast<size_t>(fps * config.seconds) + 64);
+
+    // Every run's source numbers frames from zero
+    processor.restartSequence();
+
+    std::filesystem::path containerPath = config.outputDir / ("pipeline_" + std::to_string(static_cast<int>(fps)) + "fps.bin");
+    std::unique_ptr<FrameLogger> logger;
+    if (config.log) {
+        logger = std::make_unique<FrameLogger>(containerPath);
+        processor.subscribe(logger.get());
+        processor.setLoggingActive(true);
+    }
+    processor.subscribe(&probe);
+    source.subscribe(&processor);
+
+    std::atomic<bool> capturing = true;
+    std::atomic<bool> processing = true;
+    std::atomic<bool> logging = true;
+
+    std::thread sourceThread([&]() {
+        const auto interval = source.getFrameInterval();
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                                                               std::chrono::duration<double>(config.seconds));
+        auto nextTime = std::chrono::steady_clock::now();
+        while (capturing && std::chrono::steady_clock::now() < deadline) {
+            source.captureFrame();
+            nextTime += interval;
+            std::this_thread::sleep_until(nextTime);
+        }
+        capturing = false;
+    });
+
+    std::thread processorThread([&]() {
+        while (processing) {
+            processor.dequeue();
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    });
+
+    std::thread loggerThread([&]() {
+        if (!logger) return;
+        while (logging) {
+            if (logger->waitForBatch(std::chrono::milliseconds(100))) {
+                logger->flush();
+            }
+        }
+        logger->flush();
+    });
+
+    sourceThread.join();
+
+    // Give the processor a moment to finish the frames still queued
+    auto drainDeadline = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+    while (probe.count() < source.getFramesProduced() && std::chrono::steady_clock::now() < drainDeadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    processing = false;
+    processorThread.join();
+    source.unsubscribe(&processor);
+
+    logging = false;
+    loggerThread.join();
+
+    processor.unsubscribe(&probe);
+    size_t framesLogged = 0;
+    UINT64 framesShed = 0;
+    AsyncWriterStats writerStats;
+    double compressionRatio = 0;
+    if (logger) {
+        processor.setLoggingActive(false);
+        processor.unsubscribe(logger.get());
+        logger->drain();
+        framesLogged = logger->getFrameCount();
+        framesShed = logger->getFramesShed();
+        writerStats = logger->getWriterStats();
+        compressionRatio = logger->getCompressionRatio();
+        logger.reset();
+    }
+
+    printf("%5.0f fps: %7llu produced %6llu source drops %7zu processed %4zu out of order %7zu logged %6llu shed  "
+           "latency p50 %6.2f ms p99 %6.2f ms  write %7.1f MB/s  compression %5.2fx\n",
+           fps, source.getFramesProduced(), source.getFramesDropped(), probe.count(), probe.countOutOfOrder(), framesLogged,
+           framesShed, probe.percentile(0.50), probe.percentile(0.99), writerStats.throughputMBps, compressionRatio);
+
+    if (!config.keep) {
+        std::error_code ec;
+        std::filesystem::remove(containerPath, ec);
+    }
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    BenchConfig config;
+    config.outputDir = std::filesystem::current_path();
+    std::vector<double> rates = {30, 60, 120, 240};
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--seconds" && i + 1 < argc) {
+            config.seconds = std::stod(argv[++i]);
+        } else if (arg == "--rates" && i + 1 < argc) {
+            rates.clear();
+            std::string list = argv[++i];
+            size_t start = 0;
+            while (start < list.size()) {
+                size_t end = list.find(',', start);
+                if (end == std::string::npos) end = list.size();
+                rates.push_back(std::stod(list.substr(start, end - start)));
+                start = end + 1;
+            }
+        } else if (arg == "--size" && i + 1 < argc) {
+            std::string size = argv[++i];
+            size_t separator = size.find('x');
+            if (separator != std::string::npos) {
+                config.source.width = static_cast<UINT32>(std::stoul(size.substr(0, separator)));
+                config.source.height = static_cast<UINT32>(std::stoul(size.substr(separator + 1)));
+            }
+        } else if (arg == "--pattern" && i + 1 < argc) {
+            std::string pattern = argv[++i];
+            config.source.pattern = pattern == "bars"   ? SyntheticPattern::COLOR_BARS
+                                    : pattern == "loop" ? SyntheticPattern::RECORDED_LOOP
+                                                        : SyntheticPattern::MOVING_GRADIENT;
+        } else if (arg == "--loop" && i + 1 < argc) {
+            config.source.loopFile = argv[++i];
+        } else if (arg == "--no-log") {
+            config.log = false;
+        } else if (arg == "--keep") {
+            config.keep = true;
+        } else {
+            config.outputDir = arg;
+        }
+    }
+
+    std::filesystem::create_directories(config.outputDir);
+
+    for (double fps : rates) {
+        runBench(config, fps);
+    }
+
+    return 0;
+}
@@ -0,0 +1,207 @@
+// Measures the in-process post-processing stage on recorded sessions.
+//
+// Reads every BGR24 frame stored with pixel data from the given frame
+// containers, decoding compressed records first, and runs each built-in
+// analyzer on it on a single thread, to report every analyzer's frames per
+// second per core. The frames are then fed through a PostProcessStage in
+// batches, as during a session, to report the throughput of the whole pool.
+// Decoding is not timed.
+//
+// The Python worker reports its rate on the same sessions with
+//   python frame_postprocessor.py <session_dir>/frames --once --workers N
+//
+// Usage: postprocess_bench <session_dir|frames.bin>... [--threads N] [--limit N] [--out file]
+//   --threads N  Threads of the stage (default: POSTPROCESS_WORKERS)
+//   --limit N    Stop after N frames per container (default: all)
+//   --out file   Also write the stage's rows there, as postprocess.csv would be
+//
+// Exits with 0 when every frame was analyzed and 1 on errors.
+
+//clang-format off
+#include <windows.h>
+//clang-format on
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "../config.h"
+#include "../src/formats/FrameFormat.h"
+#include "../src/postprocess/PostProcessStage.h"
+#include "../src/replay/FrameSeeker.h"
+
+namespace {
+
+struct BenchTotals {
+    size_t frames = 0;
+    UINT64 pixels = 0;
+    std::vector<double> analyzerSeconds;
+    double stageSeconds = 0;
+};
+
+double secondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+/**
+ * @brief Runs every BGR24 frame of a container through the analyzers and the stage.
+ * @return false if the container couldn't be read
+ */
+bool benchContainer(const std::filesystem::path& path, size_t limit, size_t batchFrames,
+                    std::vector<std::unique_ptr<FrameAnalyzer>>& analyzers, PostProcessStage& stage,
+                    BenchTotals& totals) {
+    FrameSeeker seeker;
+    if (!seeker.open(path)) {
+        fprintf(stderr, "%s: failed to open\n", path.string().c_str());
+        return false;
+    }
+
+    std::vector<BYTE> pixels;
+    std::vector<double> values;
+    size_t frames = 0;
+    size_t queued = 0;
+
+    for (size_t i = 0; i < seeker.getFrameCount() && frames < limit; i++) {
+        // Duplicates would analyze the same pixels again
+        const FrameIndexEntry* entry = seeker.getEntry(i);
+        if (entry->source != i) continue;
+
+        FrameHeader header;
+        if (!seeker.readFrame(i, pixels, &header)) {
+            fprintf(stderr, "%s: sequence %llu does not decode\n", path.string().c_str(), entry->header.sequence);
+            continue;
+        }
+        if (header.pixelFormat != PIXEL_FORMAT_BGR24 || pixels.empty() ||
+            pixels.size() != static_cast<size_t>(header.width) * header.height * 3) {
+            continue;
+        }
+
+        auto frame = std::make_shared<ProcessedFrame>();
+        frame->header = header;
+        frame->header.dataSize = static_cast<UINT32>(pixels.size());
+        frame->data = std::make_unique<BYTE[]>(pixels.size());
+        memcpy(frame->data.get(), pixels.data(), pixels.size());
+
+        for (size_t a = 0; a < analyzers.size(); a++) {
+            values.resize(analyzers[a]->getColumns().size());
+            auto start = std::chrono::steady_clock::now();
+            analyzers[a]->analyze(*frame, 0, values.data());
+            totals.analyzerSeconds[a] += secondsSince(start);
+        }
+
+        stage.enqueue(frame);
+        if (++queued == batchFrames) {
+            auto start = std::chrono::steady_clock::now();
+            stage.flush();
+            totals.stageSeconds += secondsSince(start);
+            queued = 0;
+        }
+
+        totals.frames++;
+        totals.pixels += static_cast<UINT64>(header.width) * header.height;
+        frames++;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    stage.flush();
+    totals.stageSeconds += secondsSince(start);
+
+    printf("%s: %zu frames\n", path.string().c_str(), frames);
+    return true;
+}
+
+/**
+ * @brief Adds the frame containers at path, searching directories recursively.
+ */
+void collectContainers(const std::filesystem::path& path, std::vector<std::filesystem::path>& containers) {
+    if (!std::filesystem::is_directory(path)) {
+        containers.push_back(path);
+        return;
+    }
+
+    for (const auto& entry : std::filesystem::recursive_directory_iterator(path)) {
+        if (entry.is_regular_file() && entry.path().filename() == "frames.bin") {
+            containers.push_back(entry.path());
+        }
+    }
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    std::vector<std::filesystem::path> inputs;
+    unsigned int threads = PostProcessStage::configuredWorkers();
+    size_t limit = SIZE_MAX;
+    std::filesystem::path outputPath;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--threads" && i + 1 < argc) {
+            threads = std::max(1, std::stoi(argv[++i]));
+        } else if (arg == "--limit" && i + 1 < argc) {
+            limit = std::stoull(argv[++i]);
+        } else if (arg == "--out" && i + 1 < argc) {
+            outputPath = argv[++i];
+        } else {
+            inputs.push_back(arg);
+        }
+    }
+
+    if (inputs.empty()) {
+        fprintf(stderr, "Usage: postprocess_bench <session_dir|frames.bin>... [--threads N] [--limit N] [--out file]\n");
+        return 1;
+    }
+
+    std::vector<std::filesystem::path> containers;
+    for (const auto& input : inputs) {
+        if (!std::filesystem::exists(input)) {
+            fprintf(stderr, "%s does not exist\n", input.string().c_str());
+            return 1;
+        }
+        collectContainers(input, containers);
+    }
+    std::sort(containers.begin(), containers.end());
+
+    // The single-thread run uses its own analyzers, the stage prepares its set for the pool
+    std::vector<std::unique_ptr<FrameAnalyzer>> analyzers = PostProcessStage::builtinAnalyzers();
+    for (auto& analyzer : analyzers) {
+        analyzer->prepare(1);
+    }
+
+    BenchTotals totals;
+    totals.analyzerSeconds.resize(analyzers.size());
+    {
+        PostProcessStage stage(outputPath, PostProcessStage::builtinAnalyzers(), threads);
+
+        // Flushing every few frames per thread matches the session batches and stays below POSTPROCESS_MAX_QUEUED
+        size_t batchFrames = std::min<size_t>(static_cast<size_t>(threads) * 2, POSTPROCESS_MAX_QUEUED);
+        for (const auto& container : containers) {
+            if (!benchContainer(container, limit, batchFrames, analyzers, stage, totals)) return 1;
+        }
+
+        if (totals.frames == 0) {
+            fprintf(stderr, "No BGR24 frames with pixel data found\n");
+            return 1;
+        }
+
+        printf("\n%zu frames, %.2f megapixels per frame\n", totals.frames, totals.pixels / 1e6 / totals.frames);
+        double allSeconds = 0;
+        for (size_t a = 0; a < analyzers.size(); a++) {
+            allSeconds += totals.analyzerSeconds[a];
+            printf("%-8s %.1f fps per core\n", analyzers[a]->getName(), totals.frames / totals.analyzerSeconds[a]);
+        }
+        printf("%-8s %.1f fps per core\n", "all", totals.frames / allSeconds);
+        printf("stage on %u threads: %.1f fps, %llu frames analyzed, %llu dropped\n", threads,
+               totals.stageSeconds > 0 ? totals.frames / totals.stageSeconds : 0.0, stage.getFramesAnalyzed(),
+               stage.getFramesDropped());
+
+        if (stage.getFramesAnalyzed() != totals.frames) return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,353 @@
+// Lists the sessions recorded in a log directory from its catalog.
+//
+// Reads catalog.bin (see SessionCatalogFormat.h), which ThreadManager appends
+// to at the end of every session, and prints the sessions that pass the
+// filters, one line each, without opening any session directory. Times are
+// UTC. When a session has several entries the last one counts.
+//
+// Usage: session_catalog [log_dir] [filters] [--sort key] [--limit N] [--count] [--backfill]
+//   log_dir            Log directory (default: LOG_DIR)
+//   --since DATE       Sessions started at or after DATE, as YYYY-MM-DD or YYYY-MM-DDTHH:MM
+//   --until DATE       Sessions started before DATE
+//   --min-duration S   Sessions of at least S seconds; --max-duration S likewise
+//   --min-frames N     Sessions with at least N frames stored; --max-frames N likewise
+//   --min-keys N       Sessions with at least N key events; --max-keys N likewise
+//   --with-drops       Sessions that lost frames or key events
+//   --sort key         start (default), duration, frames, keys or size; largest first except for start
+//   --limit N          Print at most N sessions
+//   --count            Only print the totals
+//   --backfill         First add entries for the session directories the catalog doesn't list,
+//                      counted from their files; they are marked with a '*'
+//
+// Sessions StorageManager thinned are marked "thinned", those it deleted "evicted" (with no size).
+//
+// Exits with 0 on success and 1 on errors.
+
+//clang-format off
+#include <windows.h>
+//clang-format on
+
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <span>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "../config.h"
+#include "../src/formats/FrameFormat.h"
+#include "../src/logging/SessionCatalog.h"
+#include "../src/replay/SessionReader.h"
+
+namespace {
+
+struct CatalogFilter {
+    INT64 sinceMs = std::numeric_limits<INT64>::min();
+    INT64 untilMs = std::numeric_limits<INT64>::max();
+    INT64 minDurationMs = 0;
+    INT64 maxDurationMs = std::numeric_limits<INT64>::max();
+    UINT64 minFrames = 0;
+    UINT64 maxFrames = std::numeric_limits<UINT64>::max();
+    UINT64 minKeys = 0;
+    UINT64 maxKeys = std::numeric_limits<UINT64>::max();
+    bool withDrops = false;
+};
+
+UINT64 framesDropped(const SessionCatalogEntry& entry) {
+    return entry.framesShed + entry.framesMissing + entry.framesLost;
+}
+
+/**
+ * @brief Marks printed after a session's line.
+ */
+std::string entryMarks(const SessionCatalogEntry& entry) {
+    std::string marks;
+    if (entry.flags & SESSION_ENTRY_BACKFILLED) marks += " *";
+    if (entry.flags & SESSION_ENTRY_EVICTED) {
+        marks += " evicted";
+    } else if (entry.flags & SESSION_ENTRY_THINNED) {
+        marks += " thinned";
+    }
+    return marks;
+}
+
+bool matches(const SessionCatalogEntry& entry, const CatalogFilter& filter) {
+    return entry.startUnixMs >= filter.sinceMs && entry.startUnixMs < filter.untilMs &&
+           entry.durationMs >= filter.minDurationMs && entry.durationMs <= filter.maxDurationMs &&
+           entry.frames >= filter.minFrames && entry.frames <= filter.maxFrames && entry.keyEvents >= filter.minKeys &&
+           entry.keyEvents <= filter.maxKeys && (!filter.withDrops || framesDropped(entry) + entry.keysDropped > 0);
+}
+
+/**
+ * @brief Parses YYYY-MM-DD or YYYY-MM-DDTHH:MM as UTC milliseconds since 1970.
+ */
+bool parseDate(const std::string& text, INT64& unixMs) {
+    int year = 0;
+    unsigned month = 0;
+    unsigned day = 0;
+    int hour = 0;
+    int minute = 0;
+    int fields = sscanf(text.c_str(), "%d-%u-%uT%d:%d", &year, &month, &day, &hour, &minute);
+    if (fields != 3 && fields != 5) return false;
+
+    std::chrono::year_month_day date{std::chrono::year(year), std::chrono::month(month), std::chrono::day(day)};
+    if (!date.ok()) return false;
+
+    auto time = std::chrono::sys_days(date) + std::chrono::hours(hour) + std::chrono::minutes(minute);
+    unixMs = std::chrono::duration_cast<std::chrono::milliseconds>(time.time_since_epoch()).count();
+    return true;
+}
+
+std::string formatDate(INT64 unixMs) {
+    std::chrono::sys_time<std::chrono::milliseconds> time{std::chrono::milliseconds(unixMs)};
+    std::chrono::sys_days day = std::chrono::floor<std::chrono::days>(time);
+    std::chrono::year_month_day date{day};
+    std::chrono::hh_mm_ss<std::chrono::milliseconds> clock{time - day};
+
+    char text[32];
+    snprintf(text, sizeof(text), "%04d-%02u-%02u %02d:%02d:%02d", static_cast<int>(date.year()),
+             static_cast<unsigned>(date.month()), static_cast<unsigned>(date.day()), static_cast<int>(clock.hours().count()),
+             static_cast<int>(clock.minutes().count()), static_cast<int>(clock.seconds().count()));
+    return text;
+}
+
+/**
+ * @brief Reads a catalog, keeping the last entry of every session and reporting damaged ranges.
+ * @return false if the file exists but is not a catalog
+ */
+bool loadCatalog(const std::filesystem::path& path, std::vector<SessionCatalogEntry>& entries) {
+    std::vector<CorruptRange> corrupt;
+    if (!SessionCatalog::load(path, entries, &corrupt)) return false;
+    for (const auto& range : corrupt) {
+        fprintf(stderr, "%s: %llu damaged bytes at offset %llu skipped\n", path.string().c_str(), range.size,
+                range.offset);
+    }
+    return true;
+}
+
+/**
+ * @brief Counts what a session recorded from its files, for sessions the catalog doesn't list.
+ */
+SessionCatalogEntry summarizeSession(const std::filesystem::path& sessionDir, UINT64 sessionId) {
+    SessionCatalogEntry entry = {};
+    entry.sessionId = sessionId;
+    entry.flags = SESSION_ENTRY_BACKFILLED;
+    entry.startUnixMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+                            std::chrono::system_clock::duration(static_cast<std::chrono::system_clock::rep>(sessionId)))
+                            .count();
+
+    INT64 firstNs = std::numeric_limits<INT64>::max();
+    INT64 lastNs = std::numeric_limits<INT64>::min();
+
+    SessionReader reader;
+    if (reader.open(sessionDir, false)) {
+        UINT64 expectedSequence = 0;
+        for (size_t i = 0; i < reader.getFrameCount(); i++) {
+            FrameHeader header = reader.getFrame(i).header;
+            if (header.flags & FRAME_FLAG_SHED) {
+                entry.framesShed++;
+            } else if (header.flags & FRAME_FLAG_DUPLICATE) {
+                entry.framesDuplicate++;
+            } else {
+                entry.frames++;
+            }
+
+            if (header.sequence != FRAME_SEQUENCE_UNKNOWN) {
+                if (expectedSequence != 0 && header.sequence > expectedSequence) {
+                    entry.framesMissing += header.sequence - expectedSequence;
+                }
+                expectedSequence = header.sequence + 1;
+            }
+            firstNs = std::min(firstNs, header.captureNs);
+            lastNs = std::max(lastNs, header.captureNs);
+        }
+
+        std::span<const KeyEventRecord> keys =
+            reader.getKeyEvents(std::numeric_limits<INT64>::min(), std::numeric_limits<INT64>::max());
+        entry.keyEvents = keys.size();
+        if (!keys.empty()) {
+            firstNs = std::min(firstNs, keys.front().timestampNs);
+            lastNs = std::max(lastNs, keys.back().timestampNs);
+
+            // Sorted by time rather than sequence, so the events missing come from the span of sequence numbers
+            UINT64 firstSequence = std::numeric_limits<UINT64>::max();
+            UINT64 lastSequence = 0;
+            for (const auto& key : keys) {
+                firstSequence = std::min(firstSequence, key.sequence);
+                lastSequence = std::max(lastSequence, key.sequence);
+            }
+            UINT64 span = lastSequence - firstSequence + 1;
+            entry.keysDropped = span > keys.size() ? span - keys.size() : 0;
+        }
+    }
+
+    // Without the wall-clock stop time, the span of what was captured stands in for the duration
+    if (lastNs >= firstNs) entry.durationMs = (lastNs - firstNs) / 1000000;
+
+    std::ifstream ringReport(sessionDir / "frame_ring.txt");
+    std::string key;
+    UINT64 value = 0;
+    while (ringReport >> key >> value) {
+        if (key == "dropped") entry.framesRingDropped = value;
+    }
+
+    // Lost frames left no record in frames.bin, only the logger's report counts them
+    std::ifstream frameReport(sessionDir / "frame_log.txt");
+    while (frameReport >> key >> value) {
+        if (key == "lost") entry.framesLost = value;
+    }
+
+    SessionCatalog::measureFiles(sessionDir, entry);
+    return entry;
+}
+
+/**
+ * @brief Adds catalog entries for the session directories of logDir the catalog doesn't list.
+ * @return Number of sessions added
+ */
+size_t backfill(const std::filesystem::path& logDir, const std::filesystem::path& catalogPath,
+                std::vector<SessionCatalogEntry>& entries) {
+    std::unordered_set<UINT64> listed;
+    for (const auto& entry : entries) {
+        listed.insert(entry.sessionId);
+    }
+
+    // Session directories are named after their start time in system_clock ticks
+    std::vector<std::pair<UINT64, std::filesystem::path>> missing;
+    std::error_code ec;
+    for (const auto& dir : std::filesystem::directory_iterator(logDir, ec)) {
+        if (!dir.is_directory()) continue;
+        std::string name = dir.path().filename().string();
+        UINT64 sessionId = 0;
+        auto result = std::from_chars(name.data(), name.data() + name.size(), sessionId);
+        if (result.ec != std::errc() || result.ptr != name.data() + name.size()) continue;
+        if (!listed.contains(sessionId)) missing.emplace_back(sessionId, dir.path());
+    }
+    std::sort(missing.begin(), missing.end());
+
+    for (const auto& [sessionId, dir] : missing) {
+        SessionCatalogEntry entry = summarizeSession(dir, sessionId);
+        if (!SessionCatalog::append(catalogPath, entry)) break;
+        entries.push_back(entry);
+    }
+    return missing.size();
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    std::filesystem::path logDir = LOG_DIR;
+    CatalogFilter filter;
+    std::string sortKey = "start";
+    size_t limit = SIZE_MAX;
+    bool countOnly = false;
+    bool fill = false;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if ((arg == "--since" || arg == "--until") && hasValue) {
+            if (!parseDate(argv[++i], arg == "--since" ? filter.sinceMs : filter.untilMs)) {
+                fprintf(stderr, "%s: expected YYYY-MM-DD or YYYY-MM-DDTHH:MM\n", argv[i]);
+                return 1;
+            }
+        } else if (arg == "--min-duration" && hasValue) {
+            filter.minDurationMs = static_cast<INT64>(std::stod(argv[++i]) * 1000);
+        } else if (arg == "--max-duration" && hasValue) {
+            filter.maxDurationMs = static_cast<INT64>(std::stod(argv[++i]) * 1000);
+        } else if (arg == "--min-frames" && hasValue) {
+            filter.minFrames = std::stoull(argv[++i]);
+        } else if (arg == "--max-frames" && hasValue) {
+            filter.maxFrames = std::stoull(argv[++i]);
+        } else if (arg == "--min-keys" && hasValue) {
+            filter.minKeys = std::stoull(argv[++i]);
+        } else if (arg == "--max-keys" && hasValue) {
+            filter.maxKeys = std::stoull(argv[++i]);
+        } else if (arg == "--with-drops") {
+            filter.withDrops = true;
+        } else if (arg == "--sort" && hasValue) {
+            sortKey = argv[++i];
+            if (sortKey != "start" && sortKey != "duration" && sortKey != "frames" && sortKey != "keys" &&
+                sortKey != "size") {
+                fprintf(stderr, "%s: expected start, duration, frames, keys or size\n", sortKey.c_str());
+                return 1;
+            }
+        } else if (arg == "--limit" && hasValue) {
+            limit = std::stoull(argv[++i]);
+        } else if (arg == "--count") {
+            countOnly = true;
+        } else if (arg == "--backfill") {
+            fill = true;
+        } else if (arg.starts_with("--")) {
+            fprintf(stderr, "Usage: session_catalog [log_dir] [filters] [--sort key] [--limit N] [--count] [--backfill]\n");
+            return 1;
+        } else {
+            logDir = arg;
+        }
+    }
+
+    std::filesystem::path catalogPath = logDir / SESSION_CATALOG_NAME;
+    auto start = std::chrono::steady_clock::now();
+    std::vector<SessionCatalogEntry> entries;
+    if (!loadCatalog(catalogPath, entries)) {
+        fprintf(stderr, "%s is not a session catalog\n", catalogPath.string().c_str());
+        return 1;
+    }
+
+    double loadMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    if (fill) {
+        size_t added = backfill(logDir, catalogPath, entries);
+        printf("%zu sessions added to %s\n", added, catalogPath.string().c_str());
+    }
+
+    start = std::chrono::steady_clock::now();
+
+    std::vector<const SessionCatalogEntry*> selected;
+    for (const auto& entry : entries) {
+        if (matches(entry, filter)) selected.push_back(&entry);
+    }
+
+    auto byField = [&](const SessionCatalogEntry* entry) -> INT64 {
+        if (sortKey == "duration") return entry->durationMs;
+        if (sortKey == "frames") return static_cast<INT64>(entry->frames);
+        if (sortKey == "keys") return static_cast<INT64>(entry->keyEvents);
+        if (sortKey == "size") return static_cast<INT64>(entry->totalBytes);
+        return -entry->startUnixMs;
+    };
+    std::stable_sort(selected.begin(), selected.end(),
+                     [&](const SessionCatalogEntry* a, const SessionCatalogEntry* b) { return byField(a) > byField(b); });
+    double queryMs = loadMs + std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    UINT64 frames = 0;
+    UINT64 keys = 0;
+    UINT64 bytes = 0;
+    INT64 durationMs = 0;
+    for (const auto* entry : selected) {
+        frames += entry->frames;
+        keys += entry->keyEvents;
+        bytes += entry->totalBytes;
+        durationMs += entry->durationMs;
+    }
+
+    if (!countOnly) {
+        printf("%-20s %-19s %10s %9s %7s %7s %8s %7s %10s\n", "session", "start (UTC)", "duration", "frames", "dup",
+               "dropped", "keys", "k.drop", "MB");
+        for (size_t i = 0; i < selected.size() && i < limit; i++) {
+            const SessionCatalogEntry& entry = *selected[i];
+            printf("%-20llu %-19s %9.1fs %9llu %7llu %7llu %8llu %7llu %10.1f%s\n", entry.sessionId,
+                   formatDate(entry.startUnixMs).c_str(), entry.durationMs / 1000.0, entry.frames,
+                   entry.framesDuplicate, framesDropped(entry), entry.keyEvents, entry.keysDropped,
+                   entry.totalBytes / 1e6, entryMarks(entry).c_str());
+        }
+    }
+
+    printf("%zu of %zu sessions, %.1f h, %llu frames, %llu key events, %.1f GB; catalog read and filtered in %.1f ms\n",
+           selected.size(), entries.size(), durationMs / 3.6e6, frames, keys, bytes / 1e9, queryMs);
+    return 0;
+}
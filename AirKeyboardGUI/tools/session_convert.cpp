@@ -0,0 +1,116 @@
+// Converts legacy sessions to the current session formats in bulk.
+//
+// Legacy sessions hold one frames/frame_NNNNNN.raw file per frame and a
+// key_events.csv. Each one found under the given directories is rewritten into
+// a frames.bin container, with the frames compressed by the lossless codec,
+// duplicates stored as such and checksums on every record, as FrameLogger
+// writes them, and a binary key_events.bin. The frame number in the file name
+// becomes the sequence number, so frames missing from the session show up as
+// gaps. Legacy key events carry millisecond times, so the key log is written
+// with a 1 kHz tick and key_log_export --legacy gives back the original CSV.
+//
+// The conversion runs as a pipeline of three stages that overlap: a reader
+// thread loads the next frames while the transform stage encodes the current
+// ones on a worker pool and a writer thread writes and checks the previous
+// ones. Sessions go through one after the other, each on every core. The
+// conversion is LegacyConverter's, which StorageManager also runs to thin old
+// sessions.
+//
+// Outputs are written under a .partial name and renamed once complete and
+// verified, so an interrupted run is restarted by running it again: sessions
+// that have their outputs are skipped and partial files are redone. With
+// verification, every encoded frame is decoded again and compared with the
+// source, and the written files are read back and their checksums checked.
+// Source frames that carry a checksum are checked when read; frame files that
+// fail it or can't be read are skipped, reported and kept by --remove-legacy.
+//
+// Usage: session_convert <dir>... [--threads N] [--gop N] [--no-compress] [--no-verify] [--remove-legacy]
+//   --threads N      Threads of the transform stage (default: every hardware thread)
+//   --gop N          Frames per keyframe (default: FRAME_LOG_GOP_LENGTH, 1 for keyframes only)
+//   --no-compress    Store the frames uncompressed
+//   --no-verify      Skip the round trip and read-back checks
+//   --remove-legacy  Delete the .raw files and key_events.csv of sessions once converted
+//
+// Every stage's throughput and the time it spent waiting on the others are
+// printed at the end. Exits with 0 when every session was converted, 2 when
+// one failed verification and 1 on errors.
+
+//clang-format off
+#include <windows.h>
+//clang-format on
+
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../src/logging/LegacyConverter.h"
+
+namespace {
+
+void printStage(const char* name, const LegacyStageStats& stats, double wallSeconds) {
+    printf("%-9s %8llu frames  %9.1f MB in  %9.1f MB out  %7.1f s busy  %8.1f fps  %7.1f MB/s  %5.1f%% waiting\n", name,
+           stats.frames, stats.bytesIn / 1e6, stats.bytesOut / 1e6, stats.busySeconds,
+           stats.busySeconds > 0 ? stats.frames / stats.busySeconds : 0.0,
+           stats.busySeconds > 0 ? std::max(stats.bytesIn, stats.bytesOut) / 1e6 / stats.busySeconds : 0.0,
+           wallSeconds > 0 ? 100.0 * stats.waitSeconds / wallSeconds : 0.0);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    std::vector<std::filesystem::path> inputs;
+    LegacyConvertOptions options;
+    // Nothing else is capturing, so unlike FrameLogger the converter takes every hardware thread
+    options.threads = std::max(1u, std::thread::hardware_concurrency());
+    options.log = [](const std::string& message) { printf("%s\n", message.c_str()); };
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--threads" && i + 1 < argc) {
+            options.threads = std::max(1, std::stoi(argv[++i]));
+        } else if (arg == "--gop" && i + 1 < argc) {
+            options.gopLength = std::max(1, std::stoi(argv[++i]));
+        } else if (arg == "--no-compress") {
+            options.compress = false;
+        } else if (arg == "--no-verify") {
+            options.verify = false;
+        } else if (arg == "--remove-legacy") {
+            options.removeLegacy = true;
+        } else {
+            inputs.push_back(arg);
+        }
+    }
+
+    if (inputs.empty()) {
+        fprintf(stderr, "Usage: session_convert <dir>... [--threads N] [--gop N] [--no-compress] [--no-verify] [--remove-legacy]\n");
+        return 1;
+    }
+
+    std::vector<std::filesystem::path> sessions;
+    size_t skipped = 0;
+    for (const auto& input : inputs) {
+        if (!std::filesystem::is_directory(input)) {
+            fprintf(stderr, "%s is not a directory\n", input.string().c_str());
+            return 1;
+        }
+        skipped += findLegacySessions(input, sessions);
+    }
+    printf("%zu legacy sessions to convert, %zu already converted\n", sessions.size(), skipped);
+    if (sessions.empty()) return 0;
+
+    LegacyConvertStats stats = convertLegacySessions(sessions, options);
+    double wallSeconds = stats.wallSeconds;
+
+    printf("\n%zu sessions converted, %zu failed, %.1f s, %.1f fps overall\n", stats.sessionsConverted,
+           stats.sessionsFailed, wallSeconds, wallSeconds > 0 ? stats.write.frames / wallSeconds : 0.0);
+    printStage("read", stats.read, wallSeconds);
+    printStage("transform", stats.transform, wallSeconds);
+    printStage("write", stats.write, wallSeconds);
+    printf("transform on %u threads, frames stored at %.1f%% of their size\n", options.threads,
+           stats.transform.bytesIn > 0 ? 100.0 * stats.transform.bytesOut / stats.transform.bytesIn : 0.0);
+
+    return stats.sessionsFailed > 0 ? 2 : 0;
+}
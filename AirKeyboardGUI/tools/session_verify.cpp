@@ -0,0 +1,275 @@
+// Verifies the checksums of recorded sessions.
+//
+// Finds frames.bin and key_events.bin in every given session or log directory,
+// checks the CRC-32C of every frame record and key-event block and reports the
+// byte ranges that fail it or can't be parsed. Files are memory-mapped and frame
+// records verified on every core, so a scan is limited by the disk.
+//
+// Usage: session_verify <session_dir|logs_dir|file>... [--threads N]
+//   --threads N  Verification threads (default: all hardware threads)
+//
+// Exits with 0 when everything checked out, 2 when damage was found and 1 on errors.
+
+//clang-format off
+#include <windows.h>
+//clang-format on
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../src/formats/Checksum.h"
+#include "../src/formats/FrameFormat.h"
+#include "../src/formats/KeyEventLogFormat.h"
+#include "../src/replay/MappedFile.h"
+
+namespace {
+
+/// A frame record found while walking the container
+struct FrameRecord {
+    UINT64 offset;
+    UINT64 size;
+    UINT64 sequence;
+};
+
+/// Damaged range of a frame container, with the frames it covers where known
+struct FrameDamage {
+    CorruptRange range;
+    UINT64 firstSequence;
+    UINT64 lastSequence;
+    size_t records;  ///< Records in the range whose checksum failed, 0 where the structure was unreadable
+};
+
+/**
+ * @brief Offset of the next plausible versioned frame header after offset, or size if there is none.
+ */
+UINT64 findNextFrame(const BYTE* data, UINT64 size, UINT64 offset) {
+    for (UINT64 i = offset + 1; i + sizeof(FrameHeader) <= size; i++) {
+        UINT32 magic;
+        memcpy(&magic, data + i, sizeof(magic));
+        if (magic != FRAME_MAGIC) continue;
+
+        FrameHeader header;
+        size_t headerSize = 0;
+        if (parseFrameHeader(data + i, static_cast<size_t>(size - i), header, headerSize) && header.version >= 2) {
+            return i;
+        }
+    }
+    return size;
+}
+
+/**
+ * @brief Verifies every record of a frame container.
+ * @return false if damage was found
+ */
+bool verifyFrames(const std::filesystem::path& path, unsigned int threads) {
+    MappedFile file(path);
+    if (!file.isOpen()) {
+        fprintf(stderr, "%s: failed to open\n", path.string().c_str());
+        return false;
+    }
+
+    const BYTE* data = file.data();
+    UINT64 size = file.size();
+    auto start = std::chrono::steady_clock::now();
+
+    UINT32 magic = 0;
+    if (size >= sizeof(magic)) memcpy(&magic, data, sizeof(magic));
+    if (magic != FRAME_MAGIC) {
+        printf("%s: legacy or empty container, no checksums to verify\n", path.string().c_str());
+        return true;
+    }
+
+    // Walk the headers, which only touches the first page of every record
+    std::vector<FrameRecord> checked;
+    std::vector<FrameDamage> damage;
+    size_t records = 0;
+    size_t unchecked = 0;
+    UINT64 offset = 0;
+    UINT64 lastSequence = FRAME_SEQUENCE_UNKNOWN;
+
+    while (offset < size) {
+        FrameHeader header;
+        size_t headerSize = 0;
+        bool parsed = parseFrameHeader(data + offset, static_cast<size_t>(size - offset), header, headerSize) &&
+                      header.version >= 2 && headerSize + header.dataSize <= size - offset;
+        if (!parsed) {
+            UINT64 next = findNextFrame(data, size, offset);
+            damage.push_back({{offset, next - offset}, lastSequence, FRAME_SEQUENCE_UNKNOWN, 0});
+            offset = next;
+            continue;
+        }
+
+        UINT64 recordSize = headerSize + header.dataSize;
+        records++;
+        if (header.flags & FRAME_FLAG_CHECKSUM) {
+            checked.push_back({offset, recordSize, header.sequence});
+        } else {
+            unchecked++;
+        }
+
+        // Structural damage is reported up to the sequence after it
+        if (!damage.empty() && damage.back().records == 0 && damage.back().lastSequence == FRAME_SEQUENCE_UNKNOWN) {
+            damage.back().lastSequence = header.sequence;
+        }
+        lastSequence = header.sequence;
+        offset += recordSize;
+    }
+
+    // Verify the records on every thread; each claims small runs so threads read neighbouring data
+    std::vector<char> valid(checked.size(), 1);
+    std::atomic<size_t> nextRecord = 0;
+    auto verify = [&]() {
+        constexpr size_t RUN = 8;
+        size_t first;
+        while ((first = nextRecord.fetch_add(RUN)) < checked.size()) {
+            size_t last = std::min(checked.size(), first + RUN);
+            for (size_t i = first; i < last; i++) {
+                FrameHeader header;
+                memcpy(&header, data + checked[i].offset, sizeof(header));
+                const BYTE* pixels = data + checked[i].offset + checked[i].size - header.dataSize;
+                valid[i] = frameRecordChecksum(header, pixels) == header.checksum;
+            }
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for (unsigned int i = 1; i < threads; i++) {
+        workers.emplace_back(verify);
+    }
+    verify();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+
+    // Merge adjacent failed records into ranges
+    for (size_t i = 0; i < checked.size(); i++) {
+        if (valid[i]) continue;
+
+        const FrameRecord& record = checked[i];
+        FrameDamage* previous = damage.empty() ? nullptr : &damage.back();
+        if (previous && previous->records > 0 && previous->range.offset + previous->range.size == record.offset) {
+            previous->range.size += record.size;
+            previous->lastSequence = record.sequence;
+            previous->records++;
+        } else {
+            damage.push_back({{record.offset, record.size}, record.sequence, record.sequence, 1});
+        }
+    }
+
+    std::sort(damage.begin(), damage.end(), [](const FrameDamage& a, const FrameDamage& b) {
+        return a.range.offset < b.range.offset;
+    });
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    printf("%s: %zu records, %zu without checksum, %.1f MB at %.0f MB/s: %s\n", path.string().c_str(), records, unchecked,
+           size / (1024.0 * 1024.0), seconds > 0 ? size / (1024.0 * 1024.0) / seconds : 0.0,
+           damage.empty() ? "OK" : "DAMAGED");
+
+    for (const FrameDamage& entry : damage) {
+        printf("  bytes %llu to %llu: ", entry.range.offset, entry.range.offset + entry.range.size);
+        if (entry.records > 0) {
+            printf("%zu records failed their checksum, sequences %llu to %llu\n", entry.records, entry.firstSequence,
+                   entry.lastSequence);
+        } else if (entry.lastSequence == FRAME_SEQUENCE_UNKNOWN) {
+            printf("unreadable to the end of the file\n");
+        } else {
+            printf("unreadable, between sequences %llu and %llu\n", entry.firstSequence, entry.lastSequence);
+        }
+    }
+
+    return damage.empty();
+}
+
+/**
+ * @brief Verifies every block of a key-event log.
+ * @return false if damage was found
+ */
+bool verifyKeyLog(const std::filesystem::path& path) {
+    MappedFile file(path);
+    if (!file.isOpen() || !file.data()) {
+        fprintf(stderr, "%s: failed to open\n", path.string().c_str());
+        return false;
+    }
+
+    KeyEventLogHeader header = {};
+    std::vector<KeyEventRecord> records;
+    std::vector<CorruptRange> corrupt;
+    if (!parseKeyEventLog(file.data(), static_cast<size_t>(file.size()), header, records, &corrupt)) {
+        printf("%s: not a key-event log\n", path.string().c_str());
+        return false;
+    }
+
+    printf("%s: %zu events%s: %s\n", path.string().c_str(), records.size(),
+           header.version < 2 ? " (version 1, no checksums)" : "", corrupt.empty() ? "OK" : "DAMAGED");
+    for (const CorruptRange& range : corrupt) {
+        printf("  bytes %llu to %llu: unreadable or failed its checksum\n", range.offset, range.offset + range.size);
+    }
+
+    return corrupt.empty();
+}
+
+/**
+ * @brief Adds the session files at path, searching directories recursively.
+ */
+void collectFiles(const std::filesystem::path& path, std::vector<std::filesystem::path>& files) {
+    if (!std::filesystem::is_directory(path)) {
+        files.push_back(path);
+        return;
+    }
+
+    for (const auto& entry : std::filesystem::recursive_directory_iterator(path)) {
+        if (!entry.is_regular_file()) continue;
+
+        std::string name = entry.path().filename().string();
+        if (name == "frames.bin" || name == "key_events.bin") {
+            files.push_back(entry.path());
+        }
+    }
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    std::vector<std::filesystem::path> inputs;
+    unsigned int threads = std::max(1u, std::thread::hardware_concurrency());
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--threads" && i + 1 < argc) {
+            threads = std::max(1, std::stoi(argv[++i]));
+        } else {
+            inputs.push_back(arg);
+        }
+    }
+
+    if (inputs.empty()) {
+        fprintf(stderr, "Usage: session_verify <session_dir|logs_dir|file>... [--threads N]\n");
+        return 1;
+    }
+
+    std::vector<std::filesystem::path> files;
+    for (const auto& input : inputs) {
+        if (!std::filesystem::exists(input)) {
+            fprintf(stderr, "%s does not exist\n", input.string().c_str());
+            return 1;
+        }
+        collectFiles(input, files);
+    }
+    std::sort(files.begin(), files.end());
+
+    size_t damaged = 0;
+    for (const auto& file : files) {
+        bool intact = file.filename() == "key_events.bin" ? verifyKeyLog(file) : verifyFrames(file, threads);
+        if (!intact) damaged++;
+    }
+
+    printf("%zu files verified, %zu damaged\n", files.size(), damaged);
+    return damaged > 0 ? 2 : 0;
+}
@@ -0,0 +1,290 @@
+// Exports the frames of a recorded session as a Y4M video.
+//
+// Streams every frame of a session's frames.bin, decoding compressed records,
+// converts it to planar 4:2:0 and writes it to a Y4M file or to stdout, from
+// where any encoder reads it without intermediate files:
+//
+//   y4m_export <session_dir> | ffmpeg -f yuv4mpegpipe -i - -c:v libx264 output.mp4
+//
+// Frames the camera repeated are written again, and frames missing from the
+// sequence (shed under memory pressure or dropped) repeat the frame before
+// them, so the video keeps the timing of the capture. With --landmarks the
+// hands the post-processing worker detected are drawn into the frames.
+//
+// Usage: y4m_export <session_dir|frames.bin> [output.y4m|-] [--fps N] [--no-fill] [--landmarks file]
+//   output.y4m       Output file; "-" or omitted writes to stdout
+//   --fps N          Frame rate of the video (default: measured from the capture timestamps)
+//   --no-fill        Don't repeat frames over sequence gaps
+//   --landmarks file Draw the hands of a landmarks.bin over their frames
+//
+// Exits with 0 when every frame was exported, 2 when frames had to be skipped and 1 on errors.
+
+//clang-format off
+#include <windows.h>
+//clang-format on
+
+#include <fcntl.h>
+#include <io.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <numeric>
+#include <string>
+#include <vector>
+
+#include "../src/codec/I420Converter.h"
+#include "../src/formats/FrameFormat.h"
+#include "../src/formats/Y4mWriter.h"
+#include "../src/replay/FrameSeeker.h"
+#include "../src/replay/LandmarkReader.h"
+
+namespace {
+
+/// Frame rate used when the capture timestamps don't tell, that of the camera configuration
+constexpr double DEFAULT_FRAME_RATE = 30.0;
+
+/// Landmark pairs joined by a line, the bones of the MediaPipe hand model
+constexpr UINT8 HAND_CONNECTIONS[][2] = {
+    {0, 1},  {1, 2},   {2, 3},   {3, 4},   {0, 5},   {5, 6},   {6, 7},   {7, 8},   {5, 9},   {9, 10},  {10, 11},
+    {11, 12}, {9, 13}, {13, 14}, {14, 15}, {15, 16}, {13, 17}, {0, 17},  {17, 18}, {18, 19}, {19, 20},
+};
+
+/// Overlay colors in BGR, those of MediaPipe's default hand style
+constexpr BYTE CONNECTION_COLOR[3] = {224, 224, 224};
+constexpr BYTE LANDMARK_COLOR[3] = {48, 48, 255};
+
+/**
+ * @brief Fills a square of BGR24 pixels around a point, clipped to the frame.
+ */
+void fillSquare(BYTE* pixels, UINT32 width, UINT32 height, int x, int y, int radius, const BYTE color[3]) {
+    for (int row = std::max(0, y - radius); row <= std::min(static_cast<int>(height) - 1, y + radius); row++) {
+        for (int column = std::max(0, x - radius); column <= std::min(static_cast<int>(width) - 1, x + radius);
+             column++) {
+            memcpy(pixels + (static_cast<size_t>(row) * width + column) * 3, color, 3);
+        }
+    }
+}
+
+/**
+ * @brief Draws the landmarks and bones of a frame's hands into its BGR24 pixels.
+ * @return Number of hands drawn
+ */
+size_t drawHands(const LandmarkReader& landmarks, UINT64 sequence, BYTE* pixels, UINT32 width, UINT32 height) {
+    auto [first, last] = landmarks.findFrame(sequence);
+    UINT16 pointCount = landmarks.getPointCount();
+
+    for (size_t i = first; i < last; i++) {
+        LandmarkHand hand = landmarks.getHand(i);
+
+        // Points are stored as fractions of the frame
+        auto pointX = [&](UINT8 point) { return static_cast<int>(std::lround(hand.points[point * 3] * width)); };
+        auto pointY = [&](UINT8 point) { return static_cast<int>(std::lround(hand.points[point * 3 + 1] * height)); };
+
+        for (const auto& connection : HAND_CONNECTIONS) {
+            if (connection[0] >= pointCount || connection[1] >= pointCount) continue;
+
+            int x0 = pointX(connection[0]);
+            int y0 = pointY(connection[0]);
+            int x1 = pointX(connection[1]);
+            int y1 = pointY(connection[1]);
+            int steps = std::max({std::abs(x1 - x0), std::abs(y1 - y0), 1});
+            for (int step = 0; step <= steps; step++) {
+                fillSquare(pixels, width, height, x0 + (x1 - x0) * step / steps, y0 + (y1 - y0) * step / steps, 1,
+                           CONNECTION_COLOR);
+            }
+        }
+
+        for (UINT8 point = 0; point < pointCount; point++) {
+            fillSquare(pixels, width, height, pointX(point), pointY(point), 3, LANDMARK_COLOR);
+        }
+    }
+
+    return last - first;
+}
+
+/**
+ * @brief Frame rate from the median capture interval of consecutive frames, 0 if there are too few.
+ */
+double measureFrameRate(const FrameSeeker& seeker) {
+    std::vector<INT64> intervals;
+    for (size_t i = 1; i < seeker.getFrameCount(); i++) {
+        const FrameHeader& previous = seeker.getEntry(i - 1)->header;
+        const FrameHeader& current = seeker.getEntry(i)->header;
+        if (current.sequence == previous.sequence + 1 && current.captureNs > previous.captureNs) {
+            intervals.push_back(current.captureNs - previous.captureNs);
+        }
+    }
+    if (intervals.empty()) return 0.0;
+
+    auto median = intervals.begin() + intervals.size() / 2;
+    std::nth_element(intervals.begin(), median, intervals.end());
+    return 1e9 / *median;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    const char* inputPath = nullptr;
+    const char* outputPath = nullptr;
+    const char* landmarkPath = nullptr;
+    double frameRate = 0.0;
+    bool fillGaps = true;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--fps" && i + 1 < argc) {
+            frameRate = std::stod(argv[++i]);
+        } else if (arg == "--no-fill") {
+            fillGaps = false;
+        } else if (arg == "--landmarks" && i + 1 < argc) {
+            landmarkPath = argv[++i];
+        } else if (!inputPath) {
+            inputPath = argv[i];
+        } else {
+            outputPath = argv[i];
+        }
+    }
+
+    if (!inputPath) {
+        fprintf(stderr, "Usage: y4m_export <session_dir|frames.bin> [output.y4m|-] [--fps N] [--no-fill] [--landmarks file]\n");
+        return 1;
+    }
+
+    std::filesystem::path containerPath = inputPath;
+    if (std::filesystem::is_directory(containerPath)) containerPath /= "frames.bin";
+
+    FrameSeeker seeker;
+    if (!seeker.open(containerPath)) {
+        fprintf(stderr, "Failed to open %s\n", containerPath.string().c_str());
+        return 1;
+    }
+
+    LandmarkReader landmarks;
+    if (landmarkPath && !landmarks.open(landmarkPath)) {
+        fprintf(stderr, "%s is not a landmark file\n", landmarkPath);
+        return 1;
+    }
+
+    if (frameRate <= 0) frameRate = measureFrameRate(seeker);
+    if (frameRate <= 0) frameRate = DEFAULT_FRAME_RATE;
+
+    // Y4M wants a fraction; thousandths cover rates like 29.97
+    UINT32 rateNumerator = static_cast<UINT32>(std::lround(frameRate * 1000));
+    UINT32 rateDenominator = 1000;
+    UINT32 divisor = std::gcd(rateNumerator, rateDenominator);
+    rateNumerator /= divisor;
+    rateDenominator /= divisor;
+
+    bool toStdout = !outputPath || std::string(outputPath) == "-";
+    FILE* output = stdout;
+    if (toStdout) {
+        // Text mode would expand every 0x0A byte of the pixels
+        _setmode(_fileno(stdout), _O_BINARY);
+    } else {
+        output = fopen(outputPath, "wb");
+        if (!output) {
+            fprintf(stderr, "Failed to create %s\n", outputPath);
+            return 1;
+        }
+    }
+
+    std::unique_ptr<Y4mWriter> writer;
+    std::vector<BYTE> pixels;
+    std::vector<BYTE> annotated;
+    UINT32 width = 0;
+    UINT32 height = 0;
+    UINT64 lastSequence = FRAME_SEQUENCE_UNKNOWN;
+    size_t lastSource = SIZE_MAX;
+    UINT64 repeated = 0;
+    UINT64 skipped = 0;
+    UINT64 handsDrawn = 0;
+    bool failed = false;
+
+    // Writes the decoded pixels, with the hands of sequence drawn over a copy when there are any
+    auto writePixels = [&](UINT64 sequence) {
+        if (landmarkPath) {
+            annotated = pixels;
+            size_t hands = drawHands(landmarks, sequence, annotated.data(), width, height);
+            if (hands > 0) {
+                handsDrawn += hands;
+                return writer->writeFrame(annotated.data());
+            }
+        }
+        return writer->writeFrame(pixels.data());
+    };
+
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < seeker.getFrameCount() && !failed; i++) {
+        const FrameIndexEntry* entry = seeker.getEntry(i);
+        const FrameHeader& stored = entry->header;
+
+        // The video has one size, the first frame's; other formats have no pixels to convert
+        if (writer && (stored.width != width || stored.height != height)) {
+            skipped++;
+            continue;
+        }
+
+        if (fillGaps && writer && lastSequence != FRAME_SEQUENCE_UNKNOWN && stored.sequence != FRAME_SEQUENCE_UNKNOWN &&
+            stored.sequence > lastSequence + 1) {
+            for (UINT64 missing = stored.sequence - lastSequence - 1; missing > 0 && !failed; missing--) {
+                failed = !writer->repeatFrame();
+                repeated++;
+            }
+        }
+
+        // A duplicate converts to the frame just written, unless its own hands are drawn over it
+        if (writer && entry->source == lastSource) {
+            failed = failed || !(landmarkPath ? writePixels(stored.sequence) : writer->repeatFrame());
+            lastSequence = stored.sequence;
+            continue;
+        }
+
+        FrameHeader header;
+        if (!seeker.readFrame(i, pixels, &header)) {
+            fprintf(stderr, "Sequence %llu is damaged or follows a damaged frame, skipping\n", stored.sequence);
+            skipped++;
+            lastSource = SIZE_MAX;  // pixels no longer hold the last frame written
+            continue;
+        }
+
+        if (header.pixelFormat != PIXEL_FORMAT_BGR24 ||
+            pixels.size() != static_cast<size_t>(header.width) * header.height * 3 || pixels.empty()) {
+            skipped++;
+            lastSource = SIZE_MAX;
+            continue;
+        }
+
+        if (!writer) {
+            width = header.width;
+            height = header.height;
+            writer = std::make_unique<Y4mWriter>(output, width, height, rateNumerator, rateDenominator);
+        }
+
+        failed = failed || !writePixels(header.sequence);
+        lastSequence = header.sequence;
+        lastSource = entry->source;
+    }
+
+    if (fflush(output) != 0) failed = true;
+    if (!toStdout && fclose(output) != 0) failed = true;
+    if (failed) {
+        fprintf(stderr, "Failed to write the video\n");
+        return 1;
+    }
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    UINT64 frames = writer ? writer->getFramesWritten() : 0;
+    double megabytes = frames * (i420FrameSize(width, height) / (1024.0 * 1024.0));
+    fprintf(stderr, "%llu frames of %ux%u at %u/%u fps (%llu repeated over gaps, %llu skipped), %.1f MB in %.2f s, %.1f MB/s\n",
+            frames, width, height, rateNumerator, rateDenominator, repeated, skipped, megabytes, seconds,
+            seconds > 0 ? megabytes / seconds : 0.0);
+    if (landmarkPath) fprintf(stderr, "%llu hands drawn\n", handsDrawn);
+
+    return skipped > 0 ? 2 : 0;
+}